@@ -0,0 +1,59 @@
+#include "bench_gen.h"
+
+#include "utils.h"
+
+uint64_t BenchRandom(uint64_t *seed)
+{
+	uint64_t z = (*seed += 0x9e3779b97f4a7c15u);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+	return z ^ (z >> 31);
+}
+
+/**
+ * Losuje niezerowy współczynnik z przedziału [-range, range]
+ * @param[in] range : zakres współczynników
+ * @param[in] seed : stan generatora
+ * @return wylosowany współczynnik
+ */
+static poly_coeff_t BenchRandomCoeff(poly_coeff_t range, uint64_t *seed)
+{
+	if(range < 1)
+	{
+		range = 1;
+	}
+	poly_coeff_t c = (poly_coeff_t)(BenchRandom(seed) % (uint64_t)range) + 1;
+	return (BenchRandom(seed) & 1) ? -c : c;
+}
+
+/**
+ * Losuje wielomian o zadanym kształcie i głębokości @p depth
+ * @param[in] shape : kształt wielomianu
+ * @param[in] depth : pozostała głębokość zagnieżdżenia
+ * @param[in] seed : stan generatora
+ * @return wylosowany wielomian
+ */
+static Poly BenchRandomPolyAtDepth(const BenchShape *shape, unsigned depth, uint64_t *seed)
+{
+	if(depth == 0 || shape->terms == 0)
+	{
+		return PolyFromCoeff(BenchRandomCoeff(shape->coeffRange, seed));
+	}
+	Mono *monos = malloc(shape->terms * sizeof(Mono));
+	assert(monos != NULL);
+	for(unsigned i = 0; i < shape->terms; i++)
+	{
+		Poly coeff = BenchRandomPolyAtDepth(shape, depth - 1, seed);
+		poly_exp_t exp = shape->dense ? (poly_exp_t)i :
+			(poly_exp_t)(BenchRandom(seed) % ((uint64_t)shape->maxExp + 1));
+		monos[i] = MonoFromPoly(&coeff, exp);
+	}
+	Poly res = PolyAddMonos(shape->terms, monos);
+	free(monos);
+	return res;
+}
+
+Poly BenchRandomPoly(const BenchShape *shape, uint64_t *seed)
+{
+	return BenchRandomPolyAtDepth(shape, shape->depth, seed);
+}
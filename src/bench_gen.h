@@ -0,0 +1,49 @@
+/** @file
+   Interfejs generatorów syntetycznych wielomianów do testów wydajności
+
+   Wielomiany są losowane deterministycznie (z ziarna) według kształtu:
+   głębokości zagnieżdżenia (liczby zmiennych), liczby jednomianów
+   na każdym poziomie, największego wykładnika i zakresu współczynników.
+   Wielomian rzadki ma wykładniki losowane z przedziału [0, maxExp],
+   a gęsty – wszystkie kolejne wykładniki od 0.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-25
+*/
+#ifndef __BENCH_GEN_H__
+#define __BENCH_GEN_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "poly.h"
+
+/**
+ * Kształt losowanego wielomianu
+ */
+typedef struct BenchShape
+{
+	unsigned depth; ///< głębokość zagnieżdżenia (0 oznacza stałą)
+	unsigned terms; ///< liczba jednomianów na każdym poziomie
+	poly_exp_t maxExp; ///< największy wykładnik (dla wielomianu rzadkiego)
+	poly_coeff_t coeffRange; ///< współczynniki są z przedziału [-coeffRange, coeffRange]
+	bool dense; ///< czy wykładniki są kolejnymi liczbami od 0
+} BenchShape;
+
+/**
+ * Losuje kolejną liczbę pseudolosową (SplitMix64)
+ * @param[in] seed : stan generatora
+ * @return liczba pseudolosowa
+ */
+uint64_t BenchRandom(uint64_t *seed);
+
+/**
+ * Losuje wielomian o zadanym kształcie. Jednomiany o powtórzonych
+ * wykładnikach są sumowane, więc wielomian rzadki może mieć ich mniej.
+ * @param[in] shape : kształt wielomianu
+ * @param[in] seed : stan generatora
+ * @return wylosowany wielomian
+ */
+Poly BenchRandomPoly(const BenchShape *shape, uint64_t *seed);
+
+#endif /* __BENCH_GEN_H__ */
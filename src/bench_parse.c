@@ -0,0 +1,429 @@
+/** @file
+   Test przepustowości parsowania i wypisywania wielomianów przez kalkulator
+
+   Program generuje korpus wierszy z wielomianami (zob. bench_gen.h):
+   szerokie wielomiany jednej zmiennej z wieloma jednomianami, głęboko
+   zagnieżdżone wielomiany wielu zmiennych i wielomiany mieszane, wszystkie
+   z długimi współczynnikami. Następnie uruchamia na nim kalkulator
+   i mierzy przepustowość (MB/s zapisu wielomianów) w trybach:
+   - `parse` – samo parsowanie (każdy wielomian jest zdejmowany przez POP),
+   - `parse_print` – parsowanie i PRINT,
+   - `roundtrip` – parsowanie i PRINT, a następnie ponowne parsowanie
+     i PRINT wypisanych wielomianów, przy czym oba wyniki muszą być równe.
+
+   Każdy tryb jest mierzony osobno dla wejścia z pliku (standardowe wejście
+   przekierowane z pliku) i z potoku. Wyniki są wypisywane na standardowe
+   wyjście w formacie JSON.
+
+   Użycie: `bench_parse KALKULATOR [--size MB] [--seed N] [--runs N] [--dir KATALOG]`
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-25
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "poly.h"
+#include "bench_gen.h"
+#include "serialize.h"
+
+#include "utils.h"
+
+/** Domyślny rozmiar korpusu (w megabajtach) */
+#define BENCH_DEFAULT_SIZE_MB 256
+/** Domyślne ziarno generatora */
+#define BENCH_DEFAULT_SEED 2017
+/** Maksymalna długość ścieżki pliku roboczego */
+#define BENCH_PATH_SIZE 4096
+/** Rozmiar bufora kopiowania plików */
+#define BENCH_COPY_SIZE (1 << 16)
+
+/** Kształty kolejnych wierszy korpusu (powtarzane cyklicznie) */
+static const BenchShape benchCorpusShapes[] = {
+	/* szeroki: jedna zmienna, wiele jednomianów (parsowany równolegle) */
+	{1, 20000, 1 << 24, LONG_MAX, false},
+	/* głęboki: 7 zmiennych, po 3 jednomiany na poziomie */
+	{7, 3, 1000, LONG_MAX, false},
+	/* mieszany */
+	{3, 20, 100000, LONG_MAX / 1000, false},
+	{2, 200, 1000, 1000, true}
+};
+
+/**
+ * Pliki robocze testu
+ */
+typedef struct BenchFiles
+{
+	char parse[BENCH_PATH_SIZE]; ///< wejście trybu parse
+	char print[BENCH_PATH_SIZE]; ///< wejście trybu parse_print (i pierwszego przebiegu roundtrip)
+	char printed[BENCH_PATH_SIZE]; ///< wynik pierwszego przebiegu roundtrip
+	char reparse[BENCH_PATH_SIZE]; ///< wejście drugiego przebiegu roundtrip
+	char reprinted[BENCH_PATH_SIZE]; ///< wynik drugiego przebiegu roundtrip
+} BenchFiles;
+
+/**
+ * Zwraca bieżący czas (w sekundach)
+ * @return czas w sekundach
+ */
+static double BenchNow()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/**
+ * Zapisuje do pliku cały bufor
+ * @param[in] file : plik
+ * @param[in] data : dane
+ * @param[in] size : rozmiar danych
+ * @return Czy zapis się udał
+ */
+static bool BenchWrite(FILE *file, const void *data, size_t size)
+{
+	return fwrite(data, 1, size, file) == size;
+}
+
+/**
+ * Generuje korpus: zapisuje wejścia trybów parse i parse_print
+ * @param[in] files : pliki robocze
+ * @param[in] sizeBytes : docelowy łączny rozmiar zapisów wielomianów
+ * @param[in] seed : stan generatora
+ * @param[out] polyBytes : łączny rozmiar zapisów wielomianów (bez znaków końca wiersza)
+ * @param[out] lines : liczba wielomianów
+ * @return Czy udało się zapisać pliki
+ */
+static bool BenchGenerateCorpus(const BenchFiles *files, size_t sizeBytes, uint64_t *seed,
+	size_t *polyBytes, size_t *lines)
+{
+	FILE *parse = fopen(files->parse, "w");
+	FILE *print = fopen(files->print, "w");
+	bool ok = (parse != NULL && print != NULL);
+	*polyBytes = *lines = 0;
+	size_t shapeCount = sizeof(benchCorpusShapes) / sizeof(benchCorpusShapes[0]);
+	while(ok && *polyBytes < sizeBytes)
+	{
+		Poly p = BenchRandomPoly(&(benchCorpusShapes[*lines % shapeCount]), seed);
+		ByteBuffer text = EmptyByteBuffer();
+		PolyToText(&p, &text);
+		PolyDestroy(&p);
+		ok = BenchWrite(parse, text.data, text.size) && BenchWrite(parse, "\nPOP\n", 5) &&
+			BenchWrite(print, text.data, text.size) && BenchWrite(print, "\nPRINT\nPOP\n", 11);
+		*polyBytes += text.size;
+		(*lines)++;
+		ByteBufferDestroy(&text);
+	}
+	if(parse != NULL && fclose(parse) != 0)
+	{
+		ok = false;
+	}
+	if(print != NULL && fclose(print) != 0)
+	{
+		ok = false;
+	}
+	return ok;
+}
+
+/**
+ * Zamienia wynik kalkulatora (po jednym wielomianie w wierszu)
+ * na wejście, które go ponownie parsuje i wypisuje
+ * @param[in] printedPath : wynik kalkulatora
+ * @param[in] inputPath : tworzone wejście
+ * @return Czy udało się zapisać plik
+ */
+static bool BenchMakeReparseInput(const char *printedPath, const char *inputPath)
+{
+	FILE *in = fopen(printedPath, "r");
+	FILE *out = fopen(inputPath, "w");
+	bool ok = (in != NULL && out != NULL);
+	char *line = NULL;
+	size_t capacity = 0;
+	ssize_t length;
+	while(ok && (length = getline(&line, &capacity, in)) > 0)
+	{
+		ok = BenchWrite(out, line, (size_t)length) && BenchWrite(out, "PRINT\nPOP\n", 10);
+	}
+	free(line);
+	if(in != NULL)
+	{
+		fclose(in);
+	}
+	if(out != NULL && fclose(out) != 0)
+	{
+		ok = false;
+	}
+	return ok;
+}
+
+/**
+ * Sprawdza, czy dwa pliki mają taką samą zawartość
+ * @param[in] path1 : pierwszy plik
+ * @param[in] path2 : drugi plik
+ * @return Czy pliki są równe
+ */
+static bool BenchFilesEqual(const char *path1, const char *path2)
+{
+	FILE *f1 = fopen(path1, "r");
+	FILE *f2 = fopen(path2, "r");
+	bool equal = (f1 != NULL && f2 != NULL);
+	char *buf1 = malloc(BENCH_COPY_SIZE), *buf2 = malloc(BENCH_COPY_SIZE);
+	assert(buf1 != NULL && buf2 != NULL);
+	while(equal)
+	{
+		size_t size1 = fread(buf1, 1, BENCH_COPY_SIZE, f1);
+		size_t size2 = fread(buf2, 1, BENCH_COPY_SIZE, f2);
+		equal = (size1 == size2 && memcmp(buf1, buf2, size1) == 0);
+		if(size1 == 0)
+		{
+			break;
+		}
+	}
+	free(buf1);
+	free(buf2);
+	if(f1 != NULL)
+	{
+		fclose(f1);
+	}
+	if(f2 != NULL)
+	{
+		fclose(f2);
+	}
+	return equal;
+}
+
+/**
+ * Przepisuje zawartość pliku do deskryptora (w procesie zasilającym potok)
+ * @param[in] path : plik
+ * @param[in] fd : deskryptor
+ */
+static void BenchFeed(const char *path, int fd)
+{
+	int in = open(path, O_RDONLY);
+	char *buf = malloc(BENCH_COPY_SIZE);
+	ssize_t size;
+	while(in >= 0 && buf != NULL && (size = read(in, buf, BENCH_COPY_SIZE)) > 0)
+	{
+		for(ssize_t written = 0, res; written < size; written += res)
+		{
+			res = write(fd, buf + written, (size_t)(size - written));
+			if(res < 0)
+			{
+				_exit(1);
+			}
+		}
+	}
+	_exit(0);
+}
+
+/**
+ * Uruchamia kalkulator i czeka na jego zakończenie
+ * @param[in] calcPath : ścieżka kalkulatora
+ * @param[in] inputPath : wejście kalkulatora
+ * @param[in] outputPath : plik na standardowe wyjście kalkulatora (NULL oznacza /dev/null)
+ * @param[in] fromPipe : czy podać wejście przez potok (zamiast przekierowania z pliku)
+ * @param[out] seconds : czas działania kalkulatora
+ * @return Czy kalkulator zakończył się poprawnie
+ */
+static bool BenchRunCalc(const char *calcPath, const char *inputPath, const char *outputPath,
+	bool fromPipe, double *seconds)
+{
+	int pipeFds[2] = {-1, -1};
+	pid_t feeder = -1;
+	double start = BenchNow();
+	if(fromPipe)
+	{
+		if(pipe(pipeFds) != 0)
+		{
+			return false;
+		}
+		feeder = fork();
+		if(feeder == 0)
+		{
+			close(pipeFds[0]);
+			BenchFeed(inputPath, pipeFds[1]);
+		}
+		close(pipeFds[1]);
+	}
+	pid_t calc = fork();
+	if(calc == 0)
+	{
+		int in = fromPipe ? pipeFds[0] : open(inputPath, O_RDONLY);
+		int out = open(outputPath != NULL ? outputPath : "/dev/null", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		int err = open("/dev/null", O_WRONLY);
+		if(in < 0 || out < 0 || err < 0)
+		{
+			_exit(127);
+		}
+		dup2(in, STDIN_FILENO);
+		dup2(out, STDOUT_FILENO);
+		dup2(err, STDERR_FILENO);
+		execl(calcPath, calcPath, (char*)NULL);
+		_exit(127);
+	}
+	if(fromPipe)
+	{
+		close(pipeFds[0]);
+	}
+	int status = 1;
+	bool ok = (calc > 0 && waitpid(calc, &status, 0) == calc && WIFEXITED(status) &&
+		WEXITSTATUS(status) == 0);
+	*seconds = BenchNow() - start;
+	if(feeder > 0)
+	{
+		waitpid(feeder, &status, 0);
+	}
+	return ok;
+}
+
+/**
+ * Mierzy tryb (najlepszy z @p runs przebiegów) i wypisuje wynik jako obiekt JSON
+ * @param[in] calcPath : ścieżka kalkulatora
+ * @param[in] files : pliki robocze
+ * @param[in] mode : nazwa trybu ("parse", "parse_print" lub "roundtrip")
+ * @param[in] fromPipe : czy podać wejście przez potok
+ * @param[in] polyBytes : łączny rozmiar zapisów wielomianów w korpusie
+ * @param[in] runs : liczba przebiegów
+ * @param[in] first : czy to pierwszy wypisywany wynik
+ * @return Czy wszystkie przebiegi się udały
+ */
+static bool BenchMode(const char *calcPath, const BenchFiles *files, const char *mode,
+	bool fromPipe, size_t polyBytes, unsigned runs, bool first)
+{
+	bool roundtrip = (strcmp(mode, "roundtrip") == 0);
+	const char *input = (strcmp(mode, "parse") == 0) ? files->parse : files->print;
+	double best = 0.0;
+	bool ok = true;
+	for(unsigned run = 0; run < runs && ok; run++)
+	{
+		double seconds, seconds2 = 0.0;
+		ok = BenchRunCalc(calcPath, input, roundtrip ? files->printed : NULL, fromPipe, &seconds);
+		if(ok && roundtrip)
+		{
+			ok = BenchMakeReparseInput(files->printed, files->reparse) &&
+				BenchRunCalc(calcPath, files->reparse, files->reprinted, fromPipe, &seconds2) &&
+				BenchFilesEqual(files->printed, files->reprinted);
+		}
+		seconds += seconds2;
+		if(run == 0 || seconds < best)
+		{
+			best = seconds;
+		}
+	}
+	/* w trybie roundtrip korpus jest parsowany dwukrotnie */
+	double bytes = (double)polyBytes * (roundtrip ? 2 : 1);
+	printf("%s\n    {\"mode\":\"%s\",\"input\":\"%s\",\"ok\":%s,\"seconds\":%.3f,\"mb_per_s\":%.2f}",
+		first ? "" : ",", mode, fromPipe ? "stdin" : "file", ok ? "true" : "false", best,
+		best > 0 ? bytes / 1e6 / best : 0.0);
+	fflush(stdout);
+	return ok;
+}
+
+/**
+ * Parsuje nieujemną liczbę całkowitą (argument opcji)
+ * @param[in] s : napis
+ * @param[out] value : wczytana liczba
+ * @return Czy napis jest poprawną liczbą
+ */
+static bool BenchParseNumber(const char *s, uint64_t *value)
+{
+	char *end;
+	*value = strtoull(s, &end, 10);
+	return *s != '\0' && *s != '-' && *end == '\0';
+}
+
+/**
+ * Wypisuje sposób użycia programu
+ * @param[in] programName : nazwa programu
+ */
+static void BenchPrintUsage(const char *programName)
+{
+	fprintf(stderr, "Użycie: %s KALKULATOR [--size MB] [--seed N] [--runs N] [--dir KATALOG]\n",
+		programName);
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		BenchPrintUsage(argv[0]);
+		return 1;
+	}
+	const char *calcPath = argv[1];
+	uint64_t sizeMb = BENCH_DEFAULT_SIZE_MB, runs = 1, seed = BENCH_DEFAULT_SEED;
+	const char *dir = ".";
+	for(int i = 2; i < argc; i++)
+	{
+		bool valid = (i + 1 < argc);
+		if(valid && strcmp(argv[i], "--size") == 0)
+		{
+			valid = BenchParseNumber(argv[++i], &sizeMb);
+		}
+		else if(valid && strcmp(argv[i], "--seed") == 0)
+		{
+			valid = BenchParseNumber(argv[++i], &seed);
+		}
+		else if(valid && strcmp(argv[i], "--runs") == 0)
+		{
+			valid = BenchParseNumber(argv[++i], &runs) && runs > 0;
+		}
+		else if(valid && strcmp(argv[i], "--dir") == 0)
+		{
+			dir = argv[++i];
+		}
+		else
+		{
+			valid = false;
+		}
+		if(!valid)
+		{
+			BenchPrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	BenchFiles files;
+	snprintf(files.parse, BENCH_PATH_SIZE, "%s/bench_parse_input.txt", dir);
+	snprintf(files.print, BENCH_PATH_SIZE, "%s/bench_parse_print_input.txt", dir);
+	snprintf(files.printed, BENCH_PATH_SIZE, "%s/bench_parse_printed.txt", dir);
+	snprintf(files.reparse, BENCH_PATH_SIZE, "%s/bench_parse_reparse_input.txt", dir);
+	snprintf(files.reprinted, BENCH_PATH_SIZE, "%s/bench_parse_reprinted.txt", dir);
+
+	size_t polyBytes, lines;
+	uint64_t startSeed = seed;
+	if(!BenchGenerateCorpus(&files, (size_t)sizeMb << 20, &seed, &polyBytes, &lines))
+	{
+		fprintf(stderr, "Nie udało się zapisać korpusu w katalogu %s\n", dir);
+		return 1;
+	}
+
+	printf("{\"benchmark\":\"bench_parse\",\"seed\":%llu,\"lines\":%zu,\"poly_bytes\":%zu,\"results\":[",
+		(unsigned long long)startSeed, lines, polyBytes);
+	const char *modes[] = {"parse", "parse_print", "roundtrip"};
+	bool ok = true, first = true;
+	for(size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+	{
+		for(int fromPipe = 0; fromPipe <= 1; fromPipe++)
+		{
+			ok = BenchMode(calcPath, &files, modes[m], fromPipe, polyBytes, (unsigned)runs, first) && ok;
+			first = false;
+		}
+	}
+	printf("\n]}\n");
+
+	remove(files.parse);
+	remove(files.print);
+	remove(files.printed);
+	remove(files.reparse);
+	remove(files.reprinted);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,395 @@
+/** @file
+   Testy wydajności operacji na wielomianach
+
+   Program mierzy czas operacji na wielomianach (PolyAdd(), PolyMul(),
+   PolyAt(), PolyCompose(), PolyClone(), PolyIsEq()) oraz parsowania
+   i wypisywania wielomianów na siatce kształtów losowych wielomianów
+   (zob. bench_gen.h). Każda operacja jest powtarzana, aż łączny czas
+   przekroczy zadany próg, a wyniki (czas na operację i na jednomian oraz
+   przepustowość) są wypisywane na standardowe wyjście w formacie JSON.
+
+   Użycie: `bench_poly [--quick] [--seed N] [--min-time MS]`
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-25
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "poly.h"
+#include "bench_gen.h"
+#include "serialize.h"
+#include "read.h"
+#include "output.h"
+#include "error.h"
+
+#include "utils.h"
+
+/** Domyślny minimalny łączny czas pomiaru jednej operacji (w milisekundach) */
+#define BENCH_DEFAULT_MIN_TIME_MS 200
+/** Domyślne ziarno generatora */
+#define BENCH_DEFAULT_SEED 2017
+/** Największy iloczyn liczby jednomianów i stopnia, dla którego mierzone jest PolyCompose() */
+#define BENCH_COMPOSE_MAX_WORK (1 << 16)
+/** Argument, w którym obliczana jest wartość wielomianów */
+#define BENCH_AT_ARG 2
+
+/**
+ * Dane wejściowe mierzonych operacji
+ */
+typedef struct BenchInput
+{
+	Poly p; ///< pierwszy argument
+	Poly q; ///< drugi argument (tego samego kształtu)
+	Poly pClone; ///< kopia pierwszego argumentu (dla PolyIsEq())
+	unsigned count; ///< liczba wielomianów podstawianych w PolyCompose()
+	Poly *x; ///< wielomiany podstawiane w PolyCompose()
+	ByteBuffer text; ///< zapis tekstowy pierwszego argumentu
+} BenchInput;
+
+/**
+ * Mierzona operacja: wykonuje operację raz i zwraca liczbę jednomianów
+ * wyniku (co również zapobiega usunięciu jej przez kompilator)
+ */
+typedef uint64_t (*BenchOp)(BenchInput *in);
+
+/**
+ * Opis mierzonej operacji
+ */
+typedef struct BenchOpInfo
+{
+	const char *name; ///< nazwa operacji w wynikach
+	BenchOp op; ///< mierzona operacja
+	bool binary; ///< czy operacja ma dwa argumenty (p i q)
+	bool textual; ///< czy operacja przetwarza zapis tekstowy (raportowane są MB/s)
+} BenchOpInfo;
+
+/** Kształty wielomianów w pełnym przebiegu */
+static const BenchShape benchGrid[] = {
+	{1, 16, 64, 1000, false}, {1, 16, 64, 1000, true},
+	{1, 256, 1024, 1000, false}, {1, 256, 1024, 1000, true},
+	{1, 4096, 16384, 1000, false}, {1, 4096, 16384, 1000, true},
+	{2, 8, 32, 1000, false}, {2, 8, 32, 1000, true},
+	{2, 32, 128, 1000, false}, {2, 32, 128, 1000, true},
+	{2, 64, 256, 1000, false}, {2, 64, 256, 1000, true},
+	{3, 4, 16, 1000, false}, {3, 4, 16, 1000, true},
+	{3, 8, 32, 1000, false}, {3, 8, 32, 1000, true},
+	{3, 16, 64, 1000, false}, {3, 16, 64, 1000, true}
+};
+
+/** Kształty wielomianów w szybkim przebiegu (opcja --quick) */
+static const BenchShape benchQuickGrid[] = {
+	{1, 64, 256, 1000, false}, {1, 64, 256, 1000, true},
+	{2, 16, 64, 1000, false}, {3, 4, 16, 1000, true}
+};
+
+/**
+ * Zwraca bieżący czas (w nanosekundach)
+ * @return czas w nanosekundach
+ */
+static uint64_t BenchNowNs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * Mierzy PolyAdd()
+ * @param[in] in : dane wejściowe
+ * @return liczba jednomianów wyniku
+ */
+static uint64_t BenchAdd(BenchInput *in)
+{
+	Poly res = PolyAdd(&(in->p), &(in->q));
+	uint64_t terms = PolyMonoCountDeep(&res);
+	PolyDestroy(&res);
+	return terms;
+}
+
+/**
+ * Mierzy PolyMul()
+ * @param[in] in : dane wejściowe
+ * @return liczba jednomianów wyniku
+ */
+static uint64_t BenchMul(BenchInput *in)
+{
+	Poly res = PolyMul(&(in->p), &(in->q));
+	uint64_t terms = PolyMonoCountDeep(&res);
+	PolyDestroy(&res);
+	return terms;
+}
+
+/**
+ * Mierzy PolyAt()
+ * @param[in] in : dane wejściowe
+ * @return liczba jednomianów wyniku
+ */
+static uint64_t BenchAt(BenchInput *in)
+{
+	Poly res = PolyAt(&(in->p), BENCH_AT_ARG);
+	uint64_t terms = PolyMonoCountDeep(&res);
+	PolyDestroy(&res);
+	return terms;
+}
+
+/**
+ * Mierzy PolyCompose()
+ * @param[in] in : dane wejściowe
+ * @return liczba jednomianów wyniku
+ */
+static uint64_t BenchCompose(BenchInput *in)
+{
+	Poly res = PolyCompose(&(in->p), in->count, in->x);
+	uint64_t terms = PolyMonoCountDeep(&res);
+	PolyDestroy(&res);
+	return terms;
+}
+
+/**
+ * Mierzy PolyClone()
+ * @param[in] in : dane wejściowe
+ * @return liczba jednomianów wyniku
+ */
+static uint64_t BenchClone(BenchInput *in)
+{
+	Poly res = PolyClone(&(in->p));
+	uint64_t terms = PolyMonoCountDeep(&res);
+	PolyDestroy(&res);
+	return terms;
+}
+
+/**
+ * Mierzy PolyIsEq() dla równych wielomianów (porównywane są wszystkie jednomiany)
+ * @param[in] in : dane wejściowe
+ * @return 1, jeśli wielomiany są równe, 0 w przeciwnym wypadku
+ */
+static uint64_t BenchIsEq(BenchInput *in)
+{
+	return PolyIsEq(&(in->p), &(in->pClone)) ? 1 : 0;
+}
+
+/**
+ * Mierzy parsowanie zapisu tekstowego wielomianu przez ReadPoly()
+ * @param[in] in : dane wejściowe
+ * @return liczba jednomianów wyniku
+ */
+static uint64_t BenchParse(BenchInput *in)
+{
+	ParseError error = NoParseError();
+	int columnNumber = 1;
+	ReadSetSource((const char*)in->text.data, in->text.size);
+	Poly res = ReadPoly(1, &columnNumber, &error);
+	bool atEnd = ReadSourceAtEnd();
+	ReadSetSource(NULL, 0);
+	assert(!error.hasError && atEnd);
+	(void)atEnd;
+	uint64_t terms = PolyMonoCountDeep(&res);
+	PolyDestroy(&res);
+	return terms;
+}
+
+/**
+ * Mierzy wypisywanie wielomianu przez PrintPoly() (do wyciszonego bufora wyjścia)
+ * @param[in] in : dane wejściowe
+ * @return liczba jednomianów wypisanego wielomianu
+ */
+static uint64_t BenchPrint(BenchInput *in)
+{
+	PrintPoly(&(in->p));
+	OutputFlush();
+	return PolyMonoCountDeep(&(in->p));
+}
+
+/** Mierzone operacje */
+static const BenchOpInfo benchOps[] = {
+	{"PolyAdd", BenchAdd, true, false},
+	{"PolyMul", BenchMul, true, false},
+	{"PolyAt", BenchAt, false, false},
+	{"PolyCompose", BenchCompose, false, false},
+	{"PolyClone", BenchClone, false, false},
+	{"PolyIsEq", BenchIsEq, false, false},
+	{"parse", BenchParse, false, true},
+	{"print", BenchPrint, false, true}
+};
+
+/**
+ * Przygotowuje dane wejściowe dla kształtu @p shape
+ * @param[out] in : dane wejściowe
+ * @param[in] shape : kształt wielomianów
+ * @param[in] seed : stan generatora
+ */
+static void BenchInputInit(BenchInput *in, const BenchShape *shape, uint64_t *seed)
+{
+	in->p = BenchRandomPoly(shape, seed);
+	in->q = BenchRandomPoly(shape, seed);
+	in->pClone = PolyClone(&(in->p));
+	/* podstawiamy wielomiany liniowe od pierwszej zmiennej: (c0,0)+(c1,1) */
+	BenchShape linear = {.depth = 1, .terms = 2, .maxExp = 1, .coeffRange = shape->coeffRange,
+		.dense = true};
+	in->count = shape->depth;
+	in->x = malloc((in->count + 1) * sizeof(Poly));
+	assert(in->x != NULL);
+	for(unsigned i = 0; i < in->count; i++)
+	{
+		in->x[i] = BenchRandomPoly(&linear, seed);
+	}
+	in->text = EmptyByteBuffer();
+	PolyToText(&(in->p), &(in->text));
+}
+
+/**
+ * Usuwa z pamięci dane wejściowe
+ * @param[in] in : dane wejściowe
+ */
+static void BenchInputDestroy(BenchInput *in)
+{
+	PolyDestroy(&(in->p));
+	PolyDestroy(&(in->q));
+	PolyDestroy(&(in->pClone));
+	for(unsigned i = 0; i < in->count; i++)
+	{
+		PolyDestroy(&(in->x[i]));
+	}
+	free(in->x);
+	ByteBufferDestroy(&(in->text));
+}
+
+/**
+ * Sprawdza, czy PolyCompose() dla kształtu @p shape skończy się w rozsądnym czasie
+ * (podstawienie wielomianu liniowego w jednomian stopnia n daje n+1 jednomianów)
+ * @param[in] in : dane wejściowe
+ * @param[in] shape : kształt wielomianów
+ * @return Czy mierzyć PolyCompose()
+ */
+static bool BenchComposeFeasible(const BenchInput *in, const BenchShape *shape)
+{
+	uint64_t degree = shape->dense ? shape->terms : (uint64_t)shape->maxExp;
+	return PolyMonoCountDeep(&(in->p)) * (degree + 1) <= BENCH_COMPOSE_MAX_WORK;
+}
+
+/**
+ * Mierzy operację i wypisuje wynik jako obiekt JSON
+ * @param[in] info : mierzona operacja
+ * @param[in] in : dane wejściowe
+ * @param[in] shape : kształt wielomianów
+ * @param[in] minNs : minimalny łączny czas pomiaru (w nanosekundach)
+ * @param[in] first : czy to pierwszy wypisywany wynik
+ */
+static void BenchRun(const BenchOpInfo *info, BenchInput *in, const BenchShape *shape,
+	uint64_t minNs, bool first)
+{
+	uint64_t inputTerms = PolyMonoCountDeep(&(in->p));
+	if(info->binary)
+	{
+		inputTerms += PolyMonoCountDeep(&(in->q));
+	}
+	/* pierwsze wykonanie rozgrzewa pamięć podręczną i alokator */
+	uint64_t outputTerms = info->op(in);
+	uint64_t iterations = 0;
+	uint64_t start = BenchNowNs(), elapsed;
+	do
+	{
+		info->op(in);
+		iterations++;
+		elapsed = BenchNowNs() - start;
+	}
+	while(elapsed < minNs);
+
+	double nsPerOp = (double)elapsed / (double)iterations;
+	double nsPerTerm = inputTerms > 0 ? nsPerOp / (double)inputTerms : 0.0;
+	double termsPerS = nsPerOp > 0 ? (double)inputTerms * 1e9 / nsPerOp : 0.0;
+	printf("%s\n    {\"op\":\"%s\",\"shape\":\"%s\",\"depth\":%u,\"terms\":%u,\"max_exp\":%d,"
+		"\"coeff_range\":%ld,\"input_terms\":%llu,\"output_terms\":%llu,\"iterations\":%llu,"
+		"\"ns_per_op\":%.1f,\"ns_per_term\":%.3f,\"terms_per_s\":%.0f", first ? "" : ",",
+		info->name, shape->dense ? "dense" : "sparse", shape->depth, shape->terms, shape->maxExp,
+		shape->coeffRange, (unsigned long long)inputTerms, (unsigned long long)outputTerms,
+		(unsigned long long)iterations, nsPerOp, nsPerTerm, termsPerS);
+	if(info->textual)
+	{
+		double mbPerS = nsPerOp > 0 ? (double)in->text.size * 1e3 / nsPerOp : 0.0;
+		printf(",\"bytes\":%zu,\"mb_per_s\":%.2f", in->text.size, mbPerS);
+	}
+	printf("}");
+	fflush(stdout);
+}
+
+/**
+ * Wypisuje sposób użycia programu
+ * @param[in] programName : nazwa programu
+ */
+static void BenchPrintUsage(const char *programName)
+{
+	fprintf(stderr, "Użycie: %s [--quick] [--seed N] [--min-time MS]\n", programName);
+}
+
+int main(int argc, char *argv[])
+{
+	bool quick = false;
+	uint64_t seed = BENCH_DEFAULT_SEED;
+	unsigned long minTimeMs = BENCH_DEFAULT_MIN_TIME_MS;
+	for(int i = 1; i < argc; i++)
+	{
+		char *end;
+		if(strcmp(argv[i], "--quick") == 0)
+		{
+			quick = true;
+		}
+		else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+		{
+			seed = strtoull(argv[++i], &end, 10);
+			if(*end != '\0')
+			{
+				BenchPrintUsage(argv[0]);
+				return 1;
+			}
+		}
+		else if(strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+		{
+			minTimeMs = strtoul(argv[++i], &end, 10);
+			if(*end != '\0')
+			{
+				BenchPrintUsage(argv[0]);
+				return 1;
+			}
+		}
+		else
+		{
+			BenchPrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	const BenchShape *grid = quick ? benchQuickGrid : benchGrid;
+	size_t gridSize = quick ? sizeof(benchQuickGrid) / sizeof(benchQuickGrid[0]) :
+		sizeof(benchGrid) / sizeof(benchGrid[0]);
+	uint64_t minNs = (uint64_t)minTimeMs * 1000000u;
+
+	/* wypisywane wielomiany nie trafiają na standardowe wyjście */
+	OutputSetSuppressed(true);
+	printf("{\"benchmark\":\"bench_poly\",\"seed\":%llu,\"min_time_ms\":%lu,\"results\":[",
+		(unsigned long long)seed, minTimeMs);
+	bool first = true;
+	for(size_t s = 0; s < gridSize; s++)
+	{
+		BenchInput in;
+		BenchInputInit(&in, &(grid[s]), &seed);
+		for(size_t o = 0; o < sizeof(benchOps) / sizeof(benchOps[0]); o++)
+		{
+			if(benchOps[o].op == BenchCompose && !BenchComposeFeasible(&in, &(grid[s])))
+			{
+				continue;
+			}
+			BenchRun(&(benchOps[o]), &in, &(grid[s]), minNs, first);
+			first = false;
+		}
+		BenchInputDestroy(&in);
+	}
+	printf("\n]}\n");
+	return 0;
+}
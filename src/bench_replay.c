@@ -0,0 +1,399 @@
+/** @file
+   Odtwarzanie zapisanych sesji kalkulatora wielomianów w celu pomiaru wydajności
+
+   Program wielokrotnie wykonuje w jednym procesie skrypt kalkulatora
+   (lub łańcuch plików, jak chain_poly.sh – zob. chain.h), za każdym razem
+   na nowym stosie, i wypisuje na standardowe wyjście w formacie JSON:
+   percentyle czasu wykonania wiersza (dla łańcucha – całego przebiegu),
+   łączny czas, szczytowe zużycie pamięci procesu (RSS), liczbę
+   zaalokowanych jednomianów i szczytowy rozmiar węzłów (zob. memstat.h).
+   Wyjście kalkulatora trafia do /dev/null.
+
+   W trybie porównania program uruchamia dwie zbudowane wersje siebie
+   (np. przed zmianą i po niej) z tymi samymi argumentami i wypisuje
+   ich wyniki obok siebie.
+
+   Użycie:
+   - `bench_replay [--runs N] SKRYPT`
+   - `bench_replay [--runs N] --chain KATALOG`
+   - `bench_replay --compare STARY NOWY [--runs N] (SKRYPT | --chain KATALOG)`
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-26
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "poly.h"
+#include "polystack.h"
+#include "operation.h"
+#include "read.h"
+#include "checkpoint.h"
+#include "output.h"
+#include "chain.h"
+#include "memo.h"
+#include "memstat.h"
+#include "serialize.h"
+
+#include "utils.h"
+
+/** Domyślna liczba przebiegów */
+#define BENCH_DEFAULT_RUNS 10
+/** Maksymalna liczba wyników wczytywanych w trybie porównania */
+#define BENCH_MAX_METRICS 32
+/** Maksymalna długość nazwy wyniku */
+#define BENCH_METRIC_NAME_SIZE 32
+
+/**
+ * Operacje kalkulatora
+ */
+typedef struct BenchCalc
+{
+	Operation operation[OPER_WITHOUT_ARG_AMOUNT]; ///< bezargumentowe operacje
+	OperationWithArg opWithArg[OPER_WITH_ARG_AMOUNT]; ///< jednoargumentowe operacje
+	OperationWithStringArg opWithStrArg[OPER_WITH_STRING_ARG_AMOUNT]; ///< operacje z argumentem tekstowym
+} BenchCalc;
+
+/**
+ * Zmierzone czasy (w nanosekundach)
+ */
+typedef struct BenchLatencies
+{
+	uint64_t *ns; ///< kolejne czasy
+	size_t count; ///< liczba czasów
+	size_t capacity; ///< rozmiar zaalokowanej tablicy
+} BenchLatencies;
+
+/**
+ * Wynik wczytany z wyjścia jednej z porównywanych wersji
+ */
+typedef struct BenchMetric
+{
+	char name[BENCH_METRIC_NAME_SIZE]; ///< nazwa wyniku
+	double value; ///< wartość
+} BenchMetric;
+
+/**
+ * Zwraca bieżący czas (w nanosekundach)
+ * @return czas w nanosekundach
+ */
+static uint64_t BenchNowNs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * Dopisuje czas do zmierzonych czasów
+ * @param[in] lat : zmierzone czasy
+ * @param[in] ns : czas (w nanosekundach)
+ */
+static void BenchLatenciesAppend(BenchLatencies *lat, uint64_t ns)
+{
+	if(lat->count == lat->capacity)
+	{
+		lat->capacity = lat->capacity == 0 ? 1024 : 2 * lat->capacity;
+		lat->ns = realloc(lat->ns, lat->capacity * sizeof(uint64_t));
+		assert(lat->ns != NULL);
+	}
+	lat->ns[lat->count++] = ns;
+}
+
+/**
+ * Porównuje czasy (do qsort())
+ * @param[in] a : czas
+ * @param[in] b : czas
+ * @return wynik porównania
+ */
+static int BenchCompareNs(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * Zwraca percentyl posortowanych czasów (metodą najbliższej pozycji)
+ * @param[in] lat : posortowane czasy
+ * @param[in] fraction : percentyl jako ułamek z przedziału (0, 1]
+ * @return czas (w nanosekundach)
+ */
+static uint64_t BenchPercentile(const BenchLatencies *lat, double fraction)
+{
+	if(lat->count == 0)
+	{
+		return 0;
+	}
+	size_t rank = (size_t)(fraction * (double)lat->count + 0.999999);
+	return lat->ns[rank == 0 ? 0 : rank - 1];
+}
+
+/**
+ * Wykonuje raz skrypt, mierząc czas każdego wiersza
+ * @param[in] calc : operacje kalkulatora
+ * @param[in] script : skrypt
+ * @param[in] lat : zmierzone czasy
+ */
+static void BenchReplayScript(BenchCalc *calc, FILE *script, BenchLatencies *lat)
+{
+	PolyStack stack = EmptyPolyStack();
+	CheckpointSetOperations(&stack, calc->operation, calc->opWithArg, calc->opWithStrArg);
+	rewind(script);
+	ReadSetInput(script);
+	for(int lineNumber = 1; ; lineNumber++)
+	{
+		ParsedLine line;
+		uint64_t start = BenchNowNs();
+		if(!ParseLine(lineNumber, calc->operation, calc->opWithArg, calc->opWithStrArg, &line))
+		{
+			break;
+		}
+		ExecuteParsedLine(&stack, &line);
+		BenchLatenciesAppend(lat, BenchNowNs() - start);
+	}
+	ReadSetInput(NULL);
+	DestroyStack(&stack);
+}
+
+/**
+ * Wykonuje raz łańcuch plików, mierząc czas całego przebiegu
+ * @param[in] calc : operacje kalkulatora
+ * @param[in] dir : katalog z łańcuchem
+ * @param[in] lat : zmierzone czasy
+ * @return Czy udało się wykonać łańcuch
+ */
+static bool BenchReplayChain(BenchCalc *calc, const char *dir, BenchLatencies *lat)
+{
+	PolyStack stack = EmptyPolyStack();
+	CheckpointSetOperations(&stack, calc->operation, calc->opWithArg, calc->opWithStrArg);
+	uint64_t start = BenchNowNs();
+	bool ok = RunChain(&stack, dir, calc->operation, calc->opWithArg, calc->opWithStrArg);
+	BenchLatenciesAppend(lat, BenchNowNs() - start);
+	DestroyStack(&stack);
+	return ok;
+}
+
+/**
+ * Odtwarza skrypt lub łańcuch @p runs razy i wypisuje wyniki
+ * @param[in] path : skrypt lub katalog z łańcuchem
+ * @param[in] chain : czy @p path to łańcuch
+ * @param[in] runs : liczba przebiegów
+ * @return kod wyjścia programu
+ */
+static int BenchReplay(const char *path, bool chain, unsigned long runs)
+{
+	FILE *script = NULL;
+	if(!chain && (script = fopen(path, "r")) == NULL)
+	{
+		fprintf(stderr, "Nie udało się otworzyć pliku %s\n", path);
+		return 1;
+	}
+	/* wyjście kalkulatora trafia do /dev/null, a wyniki na zachowane standardowe wyjście */
+	int resultFd = dup(STDOUT_FILENO);
+	int nullFd = open("/dev/null", O_WRONLY);
+	FILE *result = resultFd >= 0 ? fdopen(resultFd, "w") : NULL;
+	if(result == NULL || nullFd < 0 || dup2(nullFd, STDOUT_FILENO) < 0)
+	{
+		fprintf(stderr, "Nie udało się przekierować standardowego wyjścia\n");
+		return 1;
+	}
+	close(nullFd);
+
+	BenchCalc calc;
+	InitStandardOperations(calc.operation, calc.opWithArg, calc.opWithStrArg);
+	BenchLatencies lat = {.ns = NULL, .count = 0, .capacity = 0};
+	uint64_t monoAllocs = MonoAllocCount();
+	bool ok = true;
+	uint64_t start = BenchNowNs();
+	for(unsigned long run = 0; run < runs && ok; run++)
+	{
+		if(chain)
+		{
+			ok = BenchReplayChain(&calc, path, &lat);
+		}
+		else
+		{
+			BenchReplayScript(&calc, script, &lat);
+		}
+		MemoClear();
+		OutputFlush();
+	}
+	uint64_t totalNs = BenchNowNs() - start;
+	monoAllocs = MonoAllocCount() - monoAllocs;
+	MemStats mem = MemStatGet();
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	qsort(lat.ns, lat.count, sizeof(uint64_t), BenchCompareNs);
+	fprintf(result, "{\n  \"benchmark\":\"bench_replay\",\n  \"path\":\"%s\",\n  \"mode\":\"%s\",\n"
+		"  \"ok\":%s,\n  \"runs\":%lu,\n  \"samples\":%zu,\n  \"total_ns\":%llu,\n"
+		"  \"p50_ns\":%llu,\n  \"p90_ns\":%llu,\n  \"p99_ns\":%llu,\n  \"p999_ns\":%llu,\n"
+		"  \"max_ns\":%llu,\n  \"peak_rss_kb\":%ld,\n  \"mono_allocs\":%llu,\n"
+		"  \"peak_node_bytes\":%lld\n}\n", path, chain ? "chain" : "script", ok ? "true" : "false",
+		runs, lat.count, (unsigned long long)totalNs,
+		(unsigned long long)BenchPercentile(&lat, 0.5), (unsigned long long)BenchPercentile(&lat, 0.9),
+		(unsigned long long)BenchPercentile(&lat, 0.99), (unsigned long long)BenchPercentile(&lat, 0.999),
+		(unsigned long long)BenchPercentile(&lat, 1.0), usage.ru_maxrss,
+		(unsigned long long)monoAllocs, (long long)mem.peakBytes);
+	fclose(result);
+	free(lat.ns);
+	if(script != NULL)
+	{
+		fclose(script);
+	}
+	return ok ? 0 : 1;
+}
+
+/**
+ * Uruchamia wersję programu @p binary z argumentami @p argv i wczytuje
+ * wyniki liczbowe (pary `"nazwa":liczba`) z jej standardowego wyjścia
+ * @param[in] binary : ścieżka do programu
+ * @param[in] argv : argumenty (argv[0] jest zastępowany przez @p binary)
+ * @param[out] metrics : wczytane wyniki
+ * @return liczba wczytanych wyników lub -1 w przypadku błędu
+ */
+static int BenchRunVersion(const char *binary, char *argv[], BenchMetric metrics[BENCH_MAX_METRICS])
+{
+	int fds[2];
+	if(pipe(fds) != 0)
+	{
+		return -1;
+	}
+	pid_t child = fork();
+	if(child == 0)
+	{
+		close(fds[0]);
+		dup2(fds[1], STDOUT_FILENO);
+		argv[0] = (char*)binary;
+		execv(binary, argv);
+		_exit(127);
+	}
+	close(fds[1]);
+	FILE *output = fdopen(fds[0], "r");
+	int count = 0;
+	char *line = NULL;
+	size_t capacity = 0;
+	while(output != NULL && getline(&line, &capacity, output) > 0)
+	{
+		/* nazwa wyniku bez cudzysłowów i wartość liczbowa (pola tekstowe są pomijane) */
+		char name[BENCH_METRIC_NAME_SIZE];
+		double value;
+		if(count < BENCH_MAX_METRICS && sscanf(line, " \"%31[^\"]\":%lf", name, &value) == 2)
+		{
+			snprintf(metrics[count].name, BENCH_METRIC_NAME_SIZE, "%s", name);
+			metrics[count++].value = value;
+		}
+	}
+	free(line);
+	if(output != NULL)
+	{
+		fclose(output);
+	}
+	int status;
+	if(child < 0 || waitpid(child, &status, 0) != child || !WIFEXITED(status) ||
+		WEXITSTATUS(status) != 0)
+	{
+		return -1;
+	}
+	return count;
+}
+
+/**
+ * Uruchamia dwie wersje programu z tymi samymi argumentami i wypisuje ich wyniki obok siebie
+ * @param[in] oldBinary : ścieżka do starej wersji
+ * @param[in] newBinary : ścieżka do nowej wersji
+ * @param[in] argv : argumenty dla obu wersji (argv[0] jest zastępowany)
+ * @return kod wyjścia programu
+ */
+static int BenchCompare(const char *oldBinary, const char *newBinary, char *argv[])
+{
+	BenchMetric oldMetrics[BENCH_MAX_METRICS], newMetrics[BENCH_MAX_METRICS];
+	int oldCount = BenchRunVersion(oldBinary, argv, oldMetrics);
+	int newCount = BenchRunVersion(newBinary, argv, newMetrics);
+	if(oldCount < 0 || newCount < 0)
+	{
+		fprintf(stderr, "Nie udało się wykonać %s\n", oldCount < 0 ? oldBinary : newBinary);
+		return 1;
+	}
+	printf("%-16s %16s %16s %9s\n", "metric", "old", "new", "change");
+	for(int i = 0; i < oldCount; i++)
+	{
+		for(int j = 0; j < newCount; j++)
+		{
+			if(strcmp(oldMetrics[i].name, newMetrics[j].name) == 0)
+			{
+				double change = oldMetrics[i].value != 0 ?
+					100.0 * (newMetrics[j].value - oldMetrics[i].value) / oldMetrics[i].value : 0.0;
+				printf("%-16s %16.0f %16.0f %+8.1f%%\n", oldMetrics[i].name, oldMetrics[i].value,
+					newMetrics[j].value, change);
+				break;
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * Wypisuje sposób użycia programu
+ * @param[in] programName : nazwa programu
+ */
+static void BenchPrintUsage(const char *programName)
+{
+	fprintf(stderr, "Użycie: %s [--compare STARY NOWY] [--runs N] (SKRYPT | --chain KATALOG)\n",
+		programName);
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc >= 4 && strcmp(argv[1], "--compare") == 0)
+	{
+		/* obie wersje dostają pozostałe argumenty (argv[3] zostaje zastąpiony nazwą programu) */
+		return BenchCompare(argv[2], argv[3], argv + 3);
+	}
+	unsigned long runs = BENCH_DEFAULT_RUNS;
+	const char *path = NULL;
+	bool chain = false;
+	for(int i = 1; i < argc; i++)
+	{
+		char *end;
+		if(strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+		{
+			runs = strtoul(argv[++i], &end, 10);
+			if(*end != '\0' || runs == 0)
+			{
+				path = NULL;
+				break;
+			}
+		}
+		else if(strcmp(argv[i], "--chain") == 0 && i + 1 < argc && path == NULL)
+		{
+			chain = true;
+			path = argv[++i];
+		}
+		else if(argv[i][0] != '-' && path == NULL)
+		{
+			path = argv[i];
+		}
+		else
+		{
+			path = NULL;
+			break;
+		}
+	}
+	if(path == NULL)
+	{
+		BenchPrintUsage(argv[0]);
+		return 1;
+	}
+	return BenchReplay(path, chain, runs);
+}
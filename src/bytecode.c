@@ -0,0 +1,470 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bytecode.h"
+
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "read.h"
+
+#include "utils.h"
+
+/** Minimalny rozmiar zaalokowanej tablicy instrukcji i puli stałych */
+#define BYTECODE_MIN_CAPACITY 16
+/** Rozmiar porcji, w jakich wczytywane jest wejście i pliki pamięci podręcznej (w bajtach) */
+#define BYTECODE_READ_CHUNK (1 << 16)
+/** Rozmiar sumy kontrolnej w zapisie programu */
+#define BYTECODE_CHECKSUM_SIZE 4
+
+/** Typy błędów poleceń, które mogą wystąpić w zapisanym programie */
+static char *const bytecodeErrorTypes[] = {WRONG_COMMAND, WRONG_VALUE, WRONG_VARIABLE,
+	STACK_UNDERFLOW, WRONG_COUNT, WRONG_FILE, WRONG_REGISTER};
+/** Liczba typów błędów poleceń, które mogą wystąpić w zapisanym programie */
+#define BYTECODE_ERROR_TYPES_AMOUNT (sizeof(bytecodeErrorTypes) / sizeof(bytecodeErrorTypes[0]))
+
+void BytecodeDestroy(BytecodeProgram *program)
+{
+	for(size_t i = 0; i < program->constCount; i++)
+	{
+		PolyDestroy(&(program->constants[i]));
+	}
+	for(size_t i = 0; i < program->size; i++)
+	{
+		free(program->code[i].strArg);
+	}
+	free(program->constants);
+	free(program->code);
+	*program = EmptyBytecodeProgram();
+}
+
+/**
+ * Dodaje na koniec programu nową instrukcję
+ * @param[in] program : program
+ * @param[in] opcode : kod instrukcji
+ * @param[in] lineNumber : numer wiersza skryptu
+ * @return wskaźnik na nową instrukcję (z wyzerowanymi pozostałymi polami)
+ */
+static Instruction *BytecodeAppend(BytecodeProgram *program, Opcode opcode, int lineNumber)
+{
+	if(program->size == program->capacity)
+	{
+		program->capacity = (program->capacity == 0) ? BYTECODE_MIN_CAPACITY : 2 * program->capacity;
+		program->code = realloc(program->code, program->capacity * sizeof(Instruction));
+		assert(program->code != NULL);
+	}
+	Instruction *instr = &(program->code[program->size++]);
+	*instr = (Instruction) {.opcode = opcode, .lineNumber = lineNumber, .index = 0,
+		.arg = 0, .strArg = NULL, .errorType = NULL};
+	return instr;
+}
+
+/**
+ * Dodaje wielomian do puli stałych programu, przejmując go na własność
+ * @param[in] program : program
+ * @param[in] p : wielomian
+ * @return numer stałej
+ */
+static size_t BytecodeAddConstant(BytecodeProgram *program, Poly *p)
+{
+	if(program->constCount == program->constCapacity)
+	{
+		program->constCapacity = (program->constCapacity == 0) ?
+			BYTECODE_MIN_CAPACITY : 2 * program->constCapacity;
+		program->constants = realloc(program->constants, program->constCapacity * sizeof(Poly));
+		assert(program->constants != NULL);
+	}
+	program->constants[program->constCount] = *p;
+	return program->constCount++;
+}
+
+BytecodeProgram BytecodeCompile(FILE *input, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[])
+{
+	BytecodeProgram program = EmptyBytecodeProgram();
+	ParsedLine line;
+	int currLine = 1;
+
+	ReadSetInput(input);
+	while(ParseLine(currLine, operation, opWithArg, opWithStrArg, &line))
+	{
+		Instruction *instr;
+		if(line.type == PARSED_POLY && line.parseError.hasError)
+		{
+			instr = BytecodeAppend(&program, OPCODE_PARSE_ERROR, line.parseError.line);
+			instr->index = (size_t)line.parseError.column;
+		}
+		else if(line.type == PARSED_POLY)
+		{
+			instr = BytecodeAppend(&program, OPCODE_PUSH_CONST, currLine);
+			instr->index = BytecodeAddConstant(&program, &(line.p));
+			line.p = PolyZero();
+		}
+		else if(line.errorType != NULL)
+		{
+			instr = BytecodeAppend(&program, OPCODE_COMMAND_ERROR, line.lineNumber);
+			instr->errorType = line.errorType;
+		}
+		else if(line.operation != NULL)
+		{
+			instr = BytecodeAppend(&program, OPCODE_OPERATION, line.lineNumber);
+			instr->index = (size_t)(line.operation - operation);
+		}
+		else if(line.opWithArg != NULL)
+		{
+			instr = BytecodeAppend(&program, OPCODE_OPERATION_WITH_ARG, line.lineNumber);
+			instr->index = (size_t)(line.opWithArg - opWithArg);
+			instr->arg = line.arg;
+		}
+		else
+		{
+			instr = BytecodeAppend(&program, OPCODE_OPERATION_WITH_STRING_ARG, line.lineNumber);
+			instr->index = (size_t)(line.opWithStrArg - opWithStrArg);
+			instr->strArg = line.strArg;
+			line.strArg = NULL;
+		}
+		ParsedLineDestroy(&line);
+		currLine++;
+	}
+	ReadSetInput(NULL);
+	return program;
+}
+
+void BytecodeRun(PolyStack *pStack, BytecodeProgram *program, Operation operation[],
+	OperationWithArg opWithArg[], OperationWithStringArg opWithStrArg[])
+{
+	for(size_t i = 0; i < program->size; i++)
+	{
+		Instruction *instr = &(program->code[i]);
+		ParsedLine line = EmptyParsedLine();
+		line.lineNumber = instr->lineNumber;
+		line.type = PARSED_COMMAND;
+		switch(instr->opcode)
+		{
+			case OPCODE_PUSH_CONST:
+				line.type = PARSED_POLY;
+				line.p = program->constants[instr->index];
+				program->constants[instr->index] = PolyZero();
+				break;
+			case OPCODE_PARSE_ERROR:
+				line.type = PARSED_POLY;
+				ErrorParse(instr->lineNumber, (int)instr->index, &(line.parseError));
+				break;
+			case OPCODE_COMMAND_ERROR:
+				line.errorType = instr->errorType;
+				break;
+			case OPCODE_OPERATION:
+				line.operation = &(operation[instr->index]);
+				break;
+			case OPCODE_OPERATION_WITH_ARG:
+				line.opWithArg = &(opWithArg[instr->index]);
+				line.arg = instr->arg;
+				break;
+			default:
+				line.opWithStrArg = &(opWithStrArg[instr->index]);
+				line.strArg = instr->strArg;
+				instr->strArg = NULL;
+				break;
+		}
+		ExecuteParsedLine(pStack, &line);
+	}
+	BytecodeDestroy(program);
+}
+
+uint64_t BytecodeOperationsHash(Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[])
+{
+	ByteBuffer names = EmptyByteBuffer();
+	for(int i = 0; i < OPER_WITHOUT_ARG_AMOUNT; i++)
+	{
+		ByteBufferAppend(&names, operation[i].name, strlen(operation[i].name) + 1);
+	}
+	for(int i = 0; i < OPER_WITH_ARG_AMOUNT; i++)
+	{
+		ByteBufferAppend(&names, opWithArg[i].name, strlen(opWithArg[i].name) + 1);
+	}
+	for(int i = 0; i < OPER_WITH_STRING_ARG_AMOUNT; i++)
+	{
+		ByteBufferAppend(&names, opWithStrArg[i].name, strlen(opWithStrArg[i].name) + 1);
+	}
+	uint64_t hash = Fnv1a64(names.data, names.size);
+	ByteBufferDestroy(&names);
+	return hash;
+}
+
+bool BytecodeSerialize(const BytecodeProgram *program, uint64_t operationsHash,
+	const unsigned char *source, size_t sourceSize, ByteBuffer *buf)
+{
+	size_t start = buf->size;
+	unsigned char version = BYTECODE_VERSION;
+	ByteBufferAppend(buf, BYTECODE_MAGIC, BYTECODE_MAGIC_SIZE);
+	ByteBufferAppend(buf, &version, 1);
+	ByteBufferAppendVarint(buf, operationsHash);
+	ByteBufferAppendVarint(buf, sourceSize);
+	ByteBufferAppendVarint(buf, Fnv1a64(source, sourceSize));
+
+	ByteBufferAppendVarint(buf, program->constCount);
+	for(size_t i = 0; i < program->constCount; i++)
+	{
+		PolySerialize(&(program->constants[i]), buf);
+	}
+
+	ByteBufferAppendVarint(buf, program->size);
+	for(size_t i = 0; i < program->size; i++)
+	{
+		const Instruction *instr = &(program->code[i]);
+		unsigned char opcode = (unsigned char)instr->opcode;
+		size_t index = instr->index;
+		if(instr->opcode == OPCODE_COMMAND_ERROR)
+		{
+			for(index = 0; index < BYTECODE_ERROR_TYPES_AMOUNT &&
+				strcmp(bytecodeErrorTypes[index], instr->errorType) != 0; index++);
+			if(index == BYTECODE_ERROR_TYPES_AMOUNT)
+			{
+				buf->size = start;
+				return false;
+			}
+		}
+		ByteBufferAppend(buf, &opcode, 1);
+		ByteBufferAppendVarint(buf, (uint64_t)instr->lineNumber);
+		ByteBufferAppendVarint(buf, index);
+		if(instr->opcode == OPCODE_OPERATION_WITH_ARG)
+		{
+			ByteBufferAppendVarint(buf, (uint64_t)instr->arg);
+		}
+		else if(instr->opcode == OPCODE_OPERATION_WITH_STRING_ARG)
+		{
+			size_t length = strlen(instr->strArg);
+			ByteBufferAppendVarint(buf, length);
+			ByteBufferAppend(buf, instr->strArg, length);
+		}
+	}
+
+	uint32_t checksum = Fnv1a32(buf->data + start, buf->size - start);
+	unsigned char checksumBytes[BYTECODE_CHECKSUM_SIZE];
+	for(int i = 0; i < BYTECODE_CHECKSUM_SIZE; i++)
+	{
+		checksumBytes[i] = (unsigned char)(checksum >> (8 * i));
+	}
+	ByteBufferAppend(buf, checksumBytes, BYTECODE_CHECKSUM_SIZE);
+	return true;
+}
+
+/**
+ * Odczytuje instrukcję zapisu programu
+ * @param[in] data : zapis programu
+ * @param[in] size : długość zapisu
+ * @param[in] pos : pozycja odczytu, przesuwana za odczytaną instrukcję
+ * @param[in] constCount : liczba stałych programu
+ * @param[out] instr : odczytana instrukcja
+ * @return Czy odczyt się powiódł
+ */
+static bool BytecodeReadInstruction(const unsigned char *data, size_t size, size_t *pos,
+	size_t constCount, Instruction *instr)
+{
+	uint64_t lineNumber, index, arg, length;
+	if(*pos >= size || data[*pos] >= OPCODE_AMOUNT)
+	{
+		return false;
+	}
+	*instr = (Instruction) {.opcode = (Opcode)data[(*pos)++], .lineNumber = 0, .index = 0,
+		.arg = 0, .strArg = NULL, .errorType = NULL};
+	if(!ReadVarint(data, size, pos, &lineNumber) || lineNumber > INT_MAX ||
+		!ReadVarint(data, size, pos, &index))
+	{
+		return false;
+	}
+	instr->lineNumber = (int)lineNumber;
+	instr->index = (size_t)index;
+
+	switch(instr->opcode)
+	{
+		case OPCODE_PUSH_CONST:
+			return index < constCount;
+		case OPCODE_PARSE_ERROR:
+			return index <= INT_MAX;
+		case OPCODE_COMMAND_ERROR:
+			if(index >= BYTECODE_ERROR_TYPES_AMOUNT)
+			{
+				return false;
+			}
+			instr->errorType = bytecodeErrorTypes[index];
+			instr->index = 0;
+			return true;
+		case OPCODE_OPERATION:
+			return index < OPER_WITHOUT_ARG_AMOUNT;
+		case OPCODE_OPERATION_WITH_ARG:
+			if(index >= OPER_WITH_ARG_AMOUNT || !ReadVarint(data, size, pos, &arg))
+			{
+				return false;
+			}
+			instr->arg = (long)arg;
+			return true;
+		default:
+			if(index >= OPER_WITH_STRING_ARG_AMOUNT || !ReadVarint(data, size, pos, &length) ||
+				length > size - *pos || memchr(data + *pos, '\0', length) != NULL)
+			{
+				return false;
+			}
+			instr->strArg = malloc(length + 1);
+			assert(instr->strArg != NULL);
+			memcpy(instr->strArg, data + *pos, length);
+			instr->strArg[length] = '\0';
+			*pos += length;
+			return true;
+	}
+}
+
+bool BytecodeDeserialize(const unsigned char *data, size_t size, uint64_t operationsHash,
+	const unsigned char *source, size_t sourceSize, BytecodeProgram *program)
+{
+	*program = EmptyBytecodeProgram();
+	if(size < BYTECODE_MAGIC_SIZE + 1 + BYTECODE_CHECKSUM_SIZE ||
+		memcmp(data, BYTECODE_MAGIC, BYTECODE_MAGIC_SIZE) != 0 ||
+		data[BYTECODE_MAGIC_SIZE] != BYTECODE_VERSION)
+	{
+		return false;
+	}
+	size -= BYTECODE_CHECKSUM_SIZE;
+	uint32_t checksum = 0;
+	for(int i = 0; i < BYTECODE_CHECKSUM_SIZE; i++)
+	{
+		checksum |= (uint32_t)data[size + i] << (8 * i);
+	}
+	if(checksum != Fnv1a32(data, size))
+	{
+		return false;
+	}
+
+	size_t pos = BYTECODE_MAGIC_SIZE + 1;
+	uint64_t storedOperationsHash, storedSourceSize, storedSourceHash, count;
+	bool ok = ReadVarint(data, size, &pos, &storedOperationsHash) &&
+		ReadVarint(data, size, &pos, &storedSourceSize) &&
+		ReadVarint(data, size, &pos, &storedSourceHash) &&
+		storedOperationsHash == operationsHash && storedSourceSize == sourceSize &&
+		storedSourceHash == Fnv1a64(source, sourceSize) &&
+		ReadVarint(data, size, &pos, &count);
+
+	for(uint64_t i = 0; i < count && ok; i++)
+	{
+		Poly p;
+		size_t consumed;
+		ok = PolyDeserialize(data + pos, size - pos, &p, &consumed);
+		if(ok)
+		{
+			BytecodeAddConstant(program, &p);
+			pos += consumed;
+		}
+	}
+
+	ok = ok && ReadVarint(data, size, &pos, &count);
+	for(uint64_t i = 0; i < count && ok; i++)
+	{
+		Instruction instr;
+		ok = BytecodeReadInstruction(data, size, &pos, program->constCount, &instr);
+		if(ok)
+		{
+			*BytecodeAppend(program, instr.opcode, instr.lineNumber) = instr;
+		}
+	}
+
+	ok = ok && (pos == size);
+	if(!ok)
+	{
+		BytecodeDestroy(program);
+	}
+	return ok;
+}
+
+/**
+ * Wczytuje do pamięci całą zawartość strumienia
+ * @param[in] stream : strumień
+ * @param[out] content : zawartość strumienia
+ * @return Czy odczyt się powiódł
+ */
+static bool ReadWholeStream(FILE *stream, ByteBuffer *content)
+{
+	*content = EmptyByteBuffer();
+	char chunk[BYTECODE_READ_CHUNK];
+	size_t read;
+	while((read = fread(chunk, 1, BYTECODE_READ_CHUNK, stream)) > 0)
+	{
+		ByteBufferAppend(content, chunk, read);
+	}
+	return !ferror(stream);
+}
+
+/**
+ * Zapisuje program do pamięci podręcznej (atomowo – przez plik tymczasowy).
+ * Niepowodzenie zapisu jest ignorowane.
+ * @param[in] program : program
+ * @param[in] operationsHash : skrót tablic operacji
+ * @param[in] source : wejście
+ * @param[in] path : ścieżka do pliku w pamięci podręcznej
+ */
+static void BytecodeCacheStore(const BytecodeProgram *program, uint64_t operationsHash,
+	const ByteBuffer *source, const char *path)
+{
+	ByteBuffer buf = EmptyByteBuffer();
+	if(BytecodeSerialize(program, operationsHash, source->data, source->size, &buf))
+	{
+		size_t tmpPathSize = strlen(path) + 32;
+		char *tmpPath = malloc(tmpPathSize);
+		assert(tmpPath != NULL);
+		snprintf(tmpPath, tmpPathSize, "%s.%ld.tmp", path, (long)getpid());
+		FILE *file = fopen(tmpPath, "wb");
+		if(file != NULL)
+		{
+			bool ok = (fwrite(buf.data, 1, buf.size, file) == buf.size);
+			ok = (fclose(file) == 0) && ok;
+			if(!ok || rename(tmpPath, path) != 0)
+			{
+				unlink(tmpPath);
+			}
+		}
+		free(tmpPath);
+	}
+	ByteBufferDestroy(&buf);
+}
+
+void RunBytecodeCached(PolyStack *pStack, const char *cacheDir, Operation operation[],
+	OperationWithArg opWithArg[], OperationWithStringArg opWithStrArg[])
+{
+	ByteBuffer source;
+	ReadWholeStream(stdin, &source);
+	uint64_t operationsHash = BytecodeOperationsHash(operation, opWithArg, opWithStrArg);
+
+	size_t pathSize = strlen(cacheDir) + 64;
+	char *path = malloc(pathSize);
+	assert(path != NULL);
+	snprintf(path, pathSize, "%s/%016" PRIx64 "-%zx" BYTECODE_CACHE_SUFFIX, cacheDir,
+		Fnv1a64(source.data, source.size), source.size);
+
+	BytecodeProgram program;
+	ByteBuffer cached;
+	FILE *file = fopen(path, "rb");
+	bool hit = false;
+	if(file != NULL)
+	{
+		hit = ReadWholeStream(file, &cached) && BytecodeDeserialize(cached.data, cached.size,
+			operationsHash, source.data, source.size, &program);
+		fclose(file);
+		ByteBufferDestroy(&cached);
+	}
+	if(!hit)
+	{
+		program = EmptyBytecodeProgram();
+		if(source.size > 0)
+		{
+			FILE *input = fmemopen(source.data, source.size, "r");
+			assert(input != NULL);
+			program = BytecodeCompile(input, operation, opWithArg, opWithStrArg);
+			fclose(input);
+		}
+		BytecodeCacheStore(&program, operationsHash, &source, path);
+	}
+	free(path);
+	ByteBufferDestroy(&source);
+
+	BytecodeRun(pStack, &program, operation, opWithArg, opWithStrArg);
+}
@@ -0,0 +1,175 @@
+/** @file
+   Interfejs kodu bajtowego kalkulatora wielomianów
+
+   Skrypt kalkulatora można skompilować do programu: tablicy instrukcji
+   i puli stałych z gotowymi wielomianami. Instrukcja to numer polecenia
+   w tablicach operacji kalkulatora (z argumentem), wstawienie stałej z puli
+   albo błąd wykryty podczas parsowania. Skompilowany program zapisany
+   w pamięci podręcznej (zob. RunBytecodeCached()) pozwala przy kolejnym
+   uruchomieniu z tym samym wejściem pominąć parsowanie.
+
+   Format zapisu programu:
+   - 4 bajty: sygnatura `IPPC`,
+   - 1 bajt: numer wersji formatu,
+   - varinty: skrót tablic operacji, długość i skrót FNV-1a skryptu,
+   - varint: liczba stałych, a po nim stałe w formacie PolySerialize(),
+   - varint: liczba instrukcji, a po nim instrukcje (kod, numer wiersza,
+     indeks oraz, zależnie od kodu, argument liczbowy lub tekstowy),
+   - 4 bajty: suma kontrolna FNV-1a całego zapisu.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-20
+*/
+#ifndef __BYTECODE_H__
+#define __BYTECODE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "poly.h"
+#include "polystack.h"
+#include "operation.h"
+#include "serialize.h"
+
+/** Sygnatura zapisu skompilowanego programu */
+#define BYTECODE_MAGIC "IPPC"
+/** Długość sygnatury zapisu skompilowanego programu */
+#define BYTECODE_MAGIC_SIZE 4
+/** Wersja formatu zapisu skompilowanego programu */
+#define BYTECODE_VERSION 1
+/** Rozszerzenie plików w katalogu pamięci podręcznej */
+#define BYTECODE_CACHE_SUFFIX ".ipc"
+
+/**
+ * Kody instrukcji
+ */
+typedef enum Opcode
+{
+	OPCODE_PUSH_CONST, ///< wstawienie na stos stałej z puli o numerze index
+	OPCODE_OPERATION, ///< polecenie bezargumentowe o numerze index
+	OPCODE_OPERATION_WITH_ARG, ///< polecenie jednoargumentowe o numerze index z argumentem arg
+	OPCODE_OPERATION_WITH_STRING_ARG, ///< polecenie o numerze index z argumentem tekstowym strArg
+	OPCODE_COMMAND_ERROR, ///< błąd polecenia errorType
+	OPCODE_PARSE_ERROR, ///< błąd parsowania wielomianu w kolumnie index
+	OPCODE_AMOUNT ///< liczba kodów instrukcji
+} Opcode;
+
+/**
+ * Instrukcja skompilowanego programu
+ */
+typedef struct Instruction
+{
+	Opcode opcode; ///< kod instrukcji
+	int lineNumber; ///< numer wiersza skryptu (do komunikatów o błędach)
+	size_t index; ///< numer stałej, numer polecenia w tablicy operacji lub numer kolumny
+	long arg; ///< argument polecenia jednoargumentowego
+	char *strArg; ///< argument polecenia z argumentem tekstowym (lub NULL)
+	char *errorType; ///< typ błędu polecenia (lub NULL)
+} Instruction;
+
+/**
+ * Skompilowany program
+ */
+typedef struct BytecodeProgram
+{
+	Poly *constants; ///< pula stałych
+	size_t constCount; ///< liczba stałych
+	size_t constCapacity; ///< rozmiar zaalokowanej puli stałych
+	Instruction *code; ///< instrukcje
+	size_t size; ///< liczba instrukcji
+	size_t capacity; ///< rozmiar zaalokowanej tablicy instrukcji
+} BytecodeProgram;
+
+/**
+ * Zwraca pusty program
+ * @return pusty program
+ */
+static inline BytecodeProgram EmptyBytecodeProgram()
+{
+	return (BytecodeProgram) {.constants = NULL, .constCount = 0, .constCapacity = 0,
+		.code = NULL, .size = 0, .capacity = 0};
+}
+
+/**
+ * Usuwa program z pamięci
+ * @param[in] program : program
+ */
+void BytecodeDestroy(BytecodeProgram *program);
+
+/**
+ * Kompiluje skrypt wczytywany ze strumienia @p input
+ * @param[in] input : strumień ze skryptem
+ * @param[in] operation : bezargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithArg : jednoargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym udostępnione przez kalkulator
+ * @return skompilowany program
+ */
+BytecodeProgram BytecodeCompile(FILE *input, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[]);
+
+/**
+ * Wykonuje program na stosie @p pStack. Przejmuje zawartość programu
+ * (stałe trafiają na stos bez kopiowania) i zostawia go pustym.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] program : program
+ * @param[in] operation : bezargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithArg : jednoargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym udostępnione przez kalkulator
+ */
+void BytecodeRun(PolyStack *pStack, BytecodeProgram *program, Operation operation[],
+	OperationWithArg opWithArg[], OperationWithStringArg opWithStrArg[]);
+
+/**
+ * Liczy skrót tablic operacji kalkulatora; program skompilowany dla innych
+ * tablic (np. przez inną wersję kalkulatora) nie może zostać wykonany
+ * @param[in] operation : bezargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithArg : jednoargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym udostępnione przez kalkulator
+ * @return skrót tablic operacji
+ */
+uint64_t BytecodeOperationsHash(Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[]);
+
+/**
+ * Dopisuje na koniec tablicy @p buf zapis programu
+ * @param[in] program : program
+ * @param[in] operationsHash : skrót tablic operacji (zob. BytecodeOperationsHash())
+ * @param[in] source : tekst skryptu
+ * @param[in] sourceSize : długość tekstu skryptu
+ * @param[in] buf : tablica bajtów
+ * @return Czy program dało się zapisać
+ */
+bool BytecodeSerialize(const BytecodeProgram *program, uint64_t operationsHash,
+	const unsigned char *source, size_t sourceSize, ByteBuffer *buf);
+
+/**
+ * Odczytuje program zapisany przez BytecodeSerialize(). Odczyt się nie
+ * powiedzie, jeśli zapis jest uszkodzony albo dotyczy innego skryptu
+ * lub innych tablic operacji.
+ * @param[in] data : zapis programu
+ * @param[in] size : długość zapisu
+ * @param[in] operationsHash : skrót bieżących tablic operacji
+ * @param[in] source : tekst skryptu
+ * @param[in] sourceSize : długość tekstu skryptu
+ * @param[out] program : odczytany program
+ * @return Czy odczyt się powiódł
+ */
+bool BytecodeDeserialize(const unsigned char *data, size_t size, uint64_t operationsHash,
+	const unsigned char *source, size_t sourceSize, BytecodeProgram *program);
+
+/**
+ * Wczytuje całe standardowe wejście i wykonuje je jako skompilowany program.
+ * Program jest brany z katalogu @p cacheDir (plik o nazwie wyznaczonej przez
+ * skrót wejścia), a jeśli go tam nie ma – kompilowany i tam zapisywany.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] cacheDir : katalog pamięci podręcznej
+ * @param[in] operation : bezargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithArg : jednoargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym udostępnione przez kalkulator
+ */
+void RunBytecodeCached(PolyStack *pStack, const char *cacheDir, Operation operation[],
+	OperationWithArg opWithArg[], OperationWithStringArg opWithStrArg[]);
+
+#endif /* __BYTECODE_H__ */
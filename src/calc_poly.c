@@ -1,24 +1,120 @@
 #include "polystack.h"
 #include "operation.h"
 #include "read.h"
+#include "output.h"
+#include "options.h"
+#include "pipeline.h"
+#include "checkpoint.h"
+#include "chain.h"
+#include "bytecode.h"
+#include "memo.h"
+#include "stats.h"
+#include "memstat.h"
+#include "trace.h"
+#include "perfcount.h"
+#include "server.h"
+#include "libpoly.h"
 
 #include "utils.h"
 
-int main()
+int main(int argc, char *argv[])
 {
+	CalcOptions options; //opcje wywołania kalkulatora
+	
+	if(!ParseCalcOptions(argc, argv, &options))
+	{
+		return 1;
+	}
+	
 	PolyStack polyStack = EmptyPolyStack(); //stos kalkulatora
 	Operation operation[OPER_WITHOUT_ARG_AMOUNT]; //bezargumentowe operacje kalkulatora
 	OperationWithArg operWithArg[OPER_WITH_ARG_AMOUNT]; //jednoargumentowe operacje kalkulatora
+	OperationWithStringArg operWithStrArg[OPER_WITH_STRING_ARG_AMOUNT]; //operacje z argumentem tekstowym
 	
-	InitStandardOperations(operation, operWithArg);
+	InitStandardOperations(operation, operWithArg, operWithStrArg);
+	CheckpointSetOperations(&polyStack, operation, operWithArg, operWithStrArg);
+	if(options.lazy)
+	{
+		InitLazyOperations(operation);
+	}
+	MemoSetBudget(options.memoBudget);
+	StatsEnable(options.stats);
+	if(options.perfCounters)
+	{
+		if(!PerfCountersOpen())
+		{
+			fprintf(stderr, "Nie udało się otworzyć sprzętowych liczników wydajności\n");
+			return 1;
+		}
+		StatsEnablePerfCounters(true);
+	}
+	MemStatSetInterval(options.memStatInterval);
+	if(options.tracePath != NULL && !TraceOpenChrome(options.tracePath))
+	{
+		fprintf(stderr, "Nie udało się utworzyć pliku %s\n", options.tracePath);
+		return 1;
+	}
+	if(options.traceMarkers && !TraceOpenMarkers())
+	{
+		fprintf(stderr, "Nie udało się otworzyć pliku trace_marker jądra\n");
+		TraceClose();
+		return 1;
+	}
 	
-	int currLine = 1;
+	if(options.restorePath != NULL && !CheckpointRestore(&polyStack, options.restorePath))
+	{
+		fprintf(stderr, "Nie udało się odtworzyć stanu z pliku %s\n", options.restorePath);
+		DestroyStack(&polyStack);
+		TraceClose();
+		return 1;
+	}
 	
-	while(ReadLine(&polyStack, currLine, operation, operWithArg))
+	if(options.servePath != NULL)
+	{
+		if(!ServeUnixSocket(options.servePath, options.lazy ? POLY_CALC_LAZY : 0,
+			(unsigned)options.workers))
+		{
+			fprintf(stderr, "Nie udało się utworzyć gniazda %s\n", options.servePath);
+			DestroyStack(&polyStack);
+			StatsFinish();
+			TraceClose();
+			return 1;
+		}
+	}
+	else if(options.chainDir != NULL)
+	{
+		if(!RunChain(&polyStack, options.chainDir, operation, operWithArg, operWithStrArg))
+		{
+			DestroyStack(&polyStack);
+			StatsFinish();
+			TraceClose();
+			return 1;
+		}
+	}
+	else if(options.bytecodeCacheDir != NULL)
+	{
+		RunBytecodeCached(&polyStack, options.bytecodeCacheDir, operation, operWithArg, operWithStrArg);
+	}
+	else if(options.pipeline)
+	{
+		RunPipelined(&polyStack, operation, operWithArg, operWithStrArg);
+	}
+	else
 	{
-		currLine++;
+		int currLine = 1;
+		
+		while(ReadLine(&polyStack, currLine, operation, operWithArg, operWithStrArg))
+		{
+			currLine++;
+		}
 	}
 	DestroyStack(&polyStack);
+	MemoClear();
+	MonoPoolRelease();
+	OutputFlush();
+	StatsFinish();
+	PerfCountersClose();
+	TraceClose();
 	   
     return 0;
 }
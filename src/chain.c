@@ -0,0 +1,405 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "chain.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "read.h"
+#include "output.h"
+#include "serialize.h"
+
+#include "utils.h"
+
+/** Rozmiar porcji, w jakich wczytywane są pliki łańcucha (w bajtach) */
+#define CHAIN_READ_CHUNK (1 << 16)
+
+/**
+ * Miejsce wierszy raportu w wyjściu pośredniego pliku łańcucha
+ */
+typedef struct ChainTextMark
+{
+	size_t position; ///< liczba wyników wypisanych przed wierszami
+	size_t end; ///< koniec wierszy w tekście wyjścia (początkiem jest koniec poprzednich)
+} ChainTextMark;
+
+/**
+ * Wyjście pośredniego pliku łańcucha: wyniki i wiersze raportów w kolejności wypisania
+ */
+typedef struct ChainOutput
+{
+	PolyStack results; ///< wypisane wielomiany i liczby (od pierwszego)
+	ByteBuffer text; ///< wypisane wiersze raportów
+	ByteBuffer marks; ///< tablica ChainTextMark – miejsca wierszy raportów
+} ChainOutput;
+
+/**
+ * Wyjście, do którego trafia to, co wypisuje bieżący plik łańcucha
+ * (NULL, gdy wyniki są wypisywane na standardowe wyjście)
+ */
+static _Thread_local ChainOutput *chainResults = NULL;
+
+/**
+ * Zwraca puste wyjście pliku łańcucha
+ * @return puste wyjście
+ */
+static ChainOutput EmptyChainOutput()
+{
+	ChainOutput output;
+	output.results = EmptyPolyStack();
+	output.text = EmptyByteBuffer();
+	output.marks = EmptyByteBuffer();
+	return output;
+}
+
+/**
+ * Usuwa z pamięci wyjście pliku łańcucha
+ * @param[in] output : wyjście
+ */
+static void ChainOutputDestroy(ChainOutput *output)
+{
+	DestroyStack(&(output->results));
+	ByteBufferDestroy(&(output->text));
+	ByteBufferDestroy(&(output->marks));
+}
+
+void ChainRecordPoly(const Poly *p)
+{
+	if(chainResults != NULL)
+	{
+		Poly clone = PolyClone(p);
+		PolyStackPush(&(chainResults->results), &clone);
+	}
+}
+
+void ChainRecordMapped(MappedStore *store)
+{
+	if(chainResults != NULL)
+	{
+		PolyStackPushMapped(&(chainResults->results), MappedStoreRetain(store));
+	}
+}
+
+void ChainRecordCoeff(poly_coeff_t c)
+{
+	if(chainResults != NULL)
+	{
+		Poly p = PolyFromCoeff(c);
+		PolyStackPush(&(chainResults->results), &p);
+	}
+}
+
+void ChainRecordText(const char *text, size_t size)
+{
+	if(chainResults != NULL && size > 0)
+	{
+		ByteBufferAppend(&(chainResults->text), text, size);
+		ChainTextMark mark;
+		mark.position = PolyStackSize(&(chainResults->results));
+		mark.end = chainResults->text.size;
+		ByteBufferAppend(&(chainResults->marks), &mark, sizeof(mark));
+	}
+}
+
+/**
+ * Tworzy (nowo zaalokowaną) ścieżkę do pliku @p name w katalogu @p dirPath
+ * @param[in] dirPath : ścieżka do katalogu
+ * @param[in] name : nazwa pliku
+ * @param[in] nameLength : długość nazwy pliku
+ * @return ścieżka do pliku
+ */
+static char *ChainPath(const char *dirPath, const char *name, size_t nameLength)
+{
+	size_t dirLength = strlen(dirPath);
+	char *path = malloc(dirLength + 1 + nameLength + 1);
+	assert(path != NULL);
+	memcpy(path, dirPath, dirLength);
+	path[dirLength] = '/';
+	memcpy(path + dirLength + 1, name, nameLength);
+	path[dirLength + 1 + nameLength] = '\0';
+	return path;
+}
+
+/**
+ * Wczytuje do pamięci całą zawartość pliku @p path
+ * @param[in] path : ścieżka do pliku
+ * @param[out] content : zawartość pliku
+ * @return Czy odczyt się powiódł
+ */
+static bool ChainReadFile(const char *path, ByteBuffer *content)
+{
+	FILE *file = fopen(path, "rb");
+	if(file == NULL)
+	{
+		return false;
+	}
+	*content = EmptyByteBuffer();
+	char chunk[CHAIN_READ_CHUNK];
+	size_t read;
+	while((read = fread(chunk, 1, CHAIN_READ_CHUNK, file)) > 0)
+	{
+		ByteBufferAppend(content, chunk, read);
+	}
+	bool ok = !ferror(file);
+	fclose(file);
+	if(!ok)
+	{
+		ByteBufferDestroy(content);
+	}
+	return ok;
+}
+
+/**
+ * Sprawdza, czy pierwszym wierszem pliku @p path jest CHAIN_START
+ * @param[in] path : ścieżka do pliku
+ * @return Czy plik jest początkiem łańcucha
+ */
+static bool ChainIsStartFile(const char *path)
+{
+	struct stat st;
+	if(stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		return false;
+	}
+	FILE *file = fopen(path, "rb");
+	if(file == NULL)
+	{
+		return false;
+	}
+	size_t startLength = strlen(CHAIN_START);
+	char firstLine[sizeof(CHAIN_START)];
+	size_t read = fread(firstLine, 1, startLength + 1, file);
+	fclose(file);
+	return read >= startLength && memcmp(firstLine, CHAIN_START, startLength) == 0 &&
+		(read == startLength || firstLine[startLength] == '\n');
+}
+
+/**
+ * Znajduje pierwszy (w kolejności alfabetycznej, tak jak wzorzec `*` w powłoce)
+ * plik łańcucha zaczynający się wierszem CHAIN_START; pomija pliki ukryte
+ * @param[in] dirPath : ścieżka do katalogu z łańcuchem
+ * @return nowo zaalokowana ścieżka do pliku lub NULL, jeśli takiego pliku nie ma
+ */
+static char *ChainFindStart(const char *dirPath)
+{
+	DIR *dir = opendir(dirPath);
+	if(dir == NULL)
+	{
+		return NULL;
+	}
+	char *startPath = NULL;
+	const char *startName = NULL;
+	struct dirent *entry;
+	while((entry = readdir(dir)) != NULL)
+	{
+		if(entry->d_name[0] == '.' ||
+			(startName != NULL && strcoll(entry->d_name, startName) >= 0))
+		{
+			continue;
+		}
+		size_t nameLength = strlen(entry->d_name);
+		char *path = ChainPath(dirPath, entry->d_name, nameLength);
+		if(ChainIsStartFile(path))
+		{
+			free(startPath);
+			startPath = path;
+			startName = path + strlen(dirPath) + 1;
+		}
+		else
+		{
+			free(path);
+		}
+	}
+	closedir(dir);
+	return startPath;
+}
+
+/**
+ * Wykonuje wiersze z fragmentu pamięci na stosie @p pStack
+ * @param[in] pStack : stos wielomianów
+ * @param[in] text : wiersze do wykonania
+ * @param[in] size : długość fragmentu pamięci
+ * @param[in] firstLine : numer pierwszego wiersza (do komunikatów o błędach)
+ * @param[in] operation : bezargumentowe operacje
+ * @param[in] opWithArg : jednoargumentowe operacje
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym
+ * @return numer wiersza następującego po wykonanych wierszach
+ */
+static int ChainExecute(PolyStack *pStack, char *text, size_t size, int firstLine,
+	Operation operation[], OperationWithArg opWithArg[], OperationWithStringArg opWithStrArg[])
+{
+	if(size == 0)
+	{
+		return firstLine;
+	}
+	FILE *input = fmemopen(text, size, "r");
+	assert(input != NULL);
+	ReadSetInput(input);
+	int currLine = firstLine;
+	while(ReadLine(pStack, currLine, operation, opWithArg, opWithStrArg))
+	{
+		currLine++;
+	}
+	ReadSetInput(NULL);
+	fclose(input);
+	return currLine;
+}
+
+/**
+ * Umieszcza na pustym stosie @p pStack wyjście poprzedniego pliku łańcucha:
+ * wyniki trafiają na stos, a wiersze raportów są wykonywane w miejscu,
+ * w którym zostały wypisane (tak jak wiersze wejścia w skrypcie chain_poly.sh)
+ * @param[in] pStack : pusty stos kolejnego pliku
+ * @param[in] output : wyjście poprzedniego pliku (jest opróżniane)
+ * @param[in] operation : bezargumentowe operacje
+ * @param[in] opWithArg : jednoargumentowe operacje
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym
+ * @return numer pierwszego wiersza kolejnego pliku
+ */
+static int ChainReplayOutput(PolyStack *pStack, ChainOutput *output, Operation operation[],
+	OperationWithArg opWithArg[], OperationWithStringArg opWithStrArg[])
+{
+	PolyStack *results = &(output->results);
+	size_t markCount = output->marks.size / sizeof(ChainTextMark);
+	if(markCount == 0)
+	{
+		/* bez wierszy raportów stos wyników staje się stosem kolejnego pliku */
+		results->checkpoint = pStack->checkpoint;
+		pStack->checkpoint.walFd = -1;
+		DestroyStack(pStack);
+		*pStack = *results;
+		*results = EmptyPolyStack();
+		return (int)PolyStackSize(pStack) + 1;
+	}
+
+	int line = 1;
+	size_t textBegin = 0;
+	size_t mark = 0;
+	for(size_t i = 0; i <= PolyStackSize(results); i++)
+	{
+		for(; mark < markCount; mark++)
+		{
+			ChainTextMark textMark;
+			memcpy(&textMark, output->marks.data + mark * sizeof(textMark), sizeof(textMark));
+			if(textMark.position != i)
+			{
+				break;
+			}
+			line = ChainExecute(pStack, (char*)output->text.data + textBegin, textMark.end - textBegin,
+				line, operation, opWithArg, opWithStrArg);
+			textBegin = textMark.end;
+		}
+		if(i < PolyStackSize(results))
+		{
+			PolyStackElem *elem = PolyStackPeek(results, PolyStackSize(results) - 1 - i);
+			if(elem->mapped != NULL)
+			{
+				PolyStackPushMapped(pStack, MappedStoreRetain(elem->mapped));
+			}
+			else
+			{
+				Poly clone = PolyClone(&(elem->p));
+				PolyStackPush(pStack, &clone);
+			}
+			line++;
+		}
+	}
+	DestroyStack(results);
+	*results = EmptyPolyStack();
+	return line;
+}
+
+bool RunChain(PolyStack *pStack, const char *dirPath, Operation operation[],
+	OperationWithArg opWithArg[], OperationWithStringArg opWithStrArg[])
+{
+	char *path = ChainFindStart(dirPath);
+	if(path == NULL)
+	{
+		fprintf(stderr, "Błąd: w katalogu %s nie ma pliku zaczynającego się wierszem %s\n",
+			dirPath, CHAIN_START);
+		return false;
+	}
+
+	bool isFirst = true;
+	/* wyjście poprzedniego pliku – skrypt podaje je jako pierwsze wiersze wejścia */
+	ChainOutput previous = EmptyChainOutput();
+	while(1)
+	{
+		ByteBuffer content;
+		if(!ChainReadFile(path, &content))
+		{
+			fprintf(stderr, "Błąd: nie udało się wczytać pliku %s\n", path);
+			ChainOutputDestroy(&previous);
+			free(path);
+			return false;
+		}
+		char *text = (char*)content.data;
+		size_t begin = 0;
+		if(isFirst)
+		{
+			while(begin < content.size && text[begin++] != '\n');
+		}
+		size_t end = content.size;
+		if(end > begin && text[end - 1] == '\n')
+		{
+			end--;
+		}
+		size_t lastLine = end;
+		while(lastLine > begin && text[lastLine - 1] != '\n')
+		{
+			lastLine--;
+		}
+
+		size_t fileLength = strlen(CHAIN_FILE);
+		bool isLast = (end - lastLine == strlen(CHAIN_STOP) &&
+			memcmp(text + lastLine, CHAIN_STOP, end - lastLine) == 0);
+		if(!isLast && (end - lastLine <= fileLength || memcmp(text + lastLine, CHAIN_FILE, fileLength) != 0))
+		{
+			fprintf(stderr, "Błąd: plik %s nie kończy się wierszem %s ani %s\n",
+				path, CHAIN_STOP, CHAIN_FILE "...");
+			ByteBufferDestroy(&content);
+			ChainOutputDestroy(&previous);
+			free(path);
+			return false;
+		}
+
+		/* wyniki pośrednich plików trafiają od razu na stos kolejnego pliku */
+		ChainOutput output = EmptyChainOutput();
+		if(!isLast)
+		{
+			chainResults = &output;
+			OutputSetSuppressed(true);
+		}
+		int firstLine = 1;
+		if(!isFirst)
+		{
+			firstLine = ChainReplayOutput(pStack, &previous, operation, opWithArg, opWithStrArg);
+		}
+		ChainExecute(pStack, text + begin, lastLine - begin, firstLine,
+			operation, opWithArg, opWithStrArg);
+		chainResults = NULL;
+		OutputSetSuppressed(false);
+		ChainOutputDestroy(&previous);
+
+		free(path);
+		if(isLast)
+		{
+			ChainOutputDestroy(&output);
+			ByteBufferDestroy(&content);
+			return true;
+		}
+		path = ChainPath(dirPath, text + lastLine + fileLength, end - lastLine - fileLength);
+		ByteBufferDestroy(&content);
+
+		/* kolejny plik zaczyna od pustego stosu, na który przechodzi punkt kontrolny */
+		PolyStack next = EmptyPolyStack();
+		next.checkpoint = pStack->checkpoint;
+		pStack->checkpoint.walFd = -1;
+		DestroyStack(pStack);
+		*pStack = next;
+		previous = output;
+		isFirst = false;
+	}
+}
@@ -0,0 +1,81 @@
+/** @file
+   Interfejs wykonywania łańcucha plików z poleceniami kalkulatora wielomianów
+
+   Łańcuch to katalog z plikami, z których pierwszy zaczyna się wierszem
+   `START`, a każdy kończy się wierszem `FILE nazwa` (nazwa kolejnego pliku
+   w tym samym katalogu) lub `STOP`. Wykonanie łańcucha daje taki sam wynik
+   jak skrypt chain_poly.sh: wiersze każdego pliku (bez wiersza kończącego)
+   są wykonywane na stosie złożonym z wyników wypisanych przez poprzedni plik,
+   a na standardowe wyjście trafia tylko to, co wypisze ostatni plik.
+   W odróżnieniu od skryptu wszystko dzieje się w jednym procesie, a wyniki
+   pośrednich plików trafiają na nowy stos bez wypisywania i ponownego parsowania.
+   Tylko wiersze raportów (STATS, MEMO_STATS, MEMSTAT) pośredniego pliku są,
+   tak jak w skrypcie, wykonywane jako wiersze kolejnego pliku – w tym samym
+   miejscu względem wyników i z tymi samymi numerami wierszy w komunikatach
+   o błędach.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-19
+*/
+#ifndef __CHAIN_H__
+#define __CHAIN_H__
+
+#include <stdbool.h>
+#include "poly.h"
+#include "polystack.h"
+#include "operation.h"
+
+/** Pierwszy wiersz pierwszego pliku łańcucha */
+#define CHAIN_START "START"
+/** Ostatni wiersz ostatniego pliku łańcucha */
+#define CHAIN_STOP "STOP"
+/** Początek ostatniego wiersza pliku, po którym następuje kolejny plik łańcucha */
+#define CHAIN_FILE "FILE "
+
+/**
+ * Wykonuje łańcuch plików z katalogu @p dirPath. Pierwszy plik jest
+ * wykonywany na stosie @p pStack, po wykonaniu łańcucha na stosie są
+ * wielomiany ostatniego pliku. W przypadku błędu wypisuje na standardowy
+ * strumień błędów komunikat.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] dirPath : ścieżka do katalogu z łańcuchem
+ * @param[in] operation : bezargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithArg : jednoargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym udostępnione przez kalkulator
+ * @return Czy udało się wykonać cały łańcuch
+ */
+bool RunChain(PolyStack *pStack, const char *dirPath, Operation operation[],
+	OperationWithArg opWithArg[], OperationWithStringArg opWithStrArg[]);
+
+/**
+ * Zapisuje wielomian wypisany przez polecenie kalkulatora jako wynik
+ * bieżącego pliku łańcucha (jeśli jest wykonywany plik inny niż ostatni)
+ * @param[in] p : wypisany wielomian
+ */
+void ChainRecordPoly(const Poly *p);
+
+/**
+ * Zapisuje wypisany odwzorowany wielomian jako wynik bieżącego pliku
+ * łańcucha (zob. ChainRecordPoly()), bez tworzenia jego kopii
+ * @param[in] store : odwzorowany plik z wypisanym wielomianem
+ */
+void ChainRecordMapped(MappedStore *store);
+
+/**
+ * Zapisuje liczbę wypisaną przez polecenie kalkulatora jako wynik
+ * bieżącego pliku łańcucha (jeśli jest wykonywany plik inny niż ostatni)
+ * @param[in] c : wypisana liczba
+ */
+void ChainRecordCoeff(poly_coeff_t c);
+
+/**
+ * Zapisuje wiersze raportu wypisane przez polecenie kalkulatora jako wyjście
+ * bieżącego pliku łańcucha (jeśli jest wykonywany plik inny niż ostatni);
+ * kolejny plik wykonuje je jak swoje wiersze
+ * @param[in] text : wypisane wiersze (zakończone znakiem końca wiersza)
+ * @param[in] size : długość tekstu
+ */
+void ChainRecordText(const char *text, size_t size);
+
+#endif /* __CHAIN_H__ */
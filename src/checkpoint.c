@@ -0,0 +1,560 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "checkpoint.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "output.h"
+#include "serialize.h"
+
+#include "utils.h"
+
+/** Rodzaj wpisu dziennika: wielomian */
+#define WAL_POLY 'P'
+/** Rodzaj wpisu dziennika: polecenie bezargumentowe */
+#define WAL_OPERATION 'O'
+/** Rodzaj wpisu dziennika: polecenie jednoargumentowe */
+#define WAL_OPERATION_WITH_ARG 'A'
+/** Rodzaj wpisu dziennika: polecenie z argumentem tekstowym */
+#define WAL_OPERATION_WITH_STRING_ARG 'S'
+/** Rozmiar sumy kontrolnej wpisu dziennika */
+#define WAL_CHECKSUM_SIZE 4
+/** Rozszerzenie pliku tymczasowego, do którego zapisywany jest obraz stosu */
+#define CHECKPOINT_TMP_SUFFIX ".tmp"
+
+void CheckpointSetOperations(PolyStack *pStack, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[])
+{
+	pStack->checkpoint.operation = operation;
+	pStack->checkpoint.opWithArg = opWithArg;
+	pStack->checkpoint.opWithStrArg = opWithStrArg;
+}
+
+void CheckpointClose(PolyStack *pStack)
+{
+	if(pStack->checkpoint.walFd >= 0)
+	{
+		close(pStack->checkpoint.walFd);
+		pStack->checkpoint.walFd = -1;
+	}
+}
+
+/**
+ * Tworzy nowy napis będący złączeniem @p path i @p suffix
+ * @param[in] path : ścieżka
+ * @param[in] suffix : przyrostek
+ * @return nowo zaalokowany napis
+ */
+static char *PathWithSuffix(const char *path, const char *suffix)
+{
+	size_t pathLength = strlen(path);
+	char *res = malloc(pathLength + strlen(suffix) + 1);
+	assert(res != NULL);
+	memcpy(res, path, pathLength);
+	strcpy(res + pathLength, suffix);
+	return res;
+}
+
+/**
+ * Zapisuje do pliku @p size bajtów (ponawiając zapis po częściowym powodzeniu)
+ * @param[in] fd : deskryptor pliku
+ * @param[in] data : bajty
+ * @param[in] size : liczba bajtów
+ * @return Czy zapis się powiódł
+ */
+static bool WriteAll(int fd, const unsigned char *data, size_t size)
+{
+	while(size > 0)
+	{
+		ssize_t res = write(fd, data, size);
+		if(res < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+		data += res;
+		size -= (size_t)res;
+	}
+	return true;
+}
+
+/**
+ * Odwzorowuje w pamięci (tylko do odczytu) cały plik
+ * @param[in] path : ścieżka do pliku
+ * @param[out] size : rozmiar pliku
+ * @return początek odwzorowanej pamięci, NULL, jeśli plik jest pusty
+ * lub nie udało się go odwzorować
+ */
+static unsigned char *MapFile(const char *path, size_t *size)
+{
+	*size = 0;
+	int fd = open(path, O_RDONLY);
+	if(fd < 0)
+	{
+		return NULL;
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		close(fd);
+		return NULL;
+	}
+	void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED)
+	{
+		return NULL;
+	}
+	*size = (size_t)st.st_size;
+	return data;
+}
+
+/**
+ * Dopisuje do tablicy @p buf sumę kontrolną FNV-1a bajtów @p data (little endian)
+ * @param[in] buf : tablica bajtów
+ * @param[in] data : bajty
+ * @param[in] size : liczba bajtów
+ */
+static void AppendChecksum(ByteBuffer *buf, const unsigned char *data, size_t size)
+{
+	uint32_t checksum = Fnv1a32(data, size);
+	unsigned char checksumBytes[WAL_CHECKSUM_SIZE];
+	for(int i = 0; i < WAL_CHECKSUM_SIZE; i++)
+	{
+		checksumBytes[i] = (unsigned char)(checksum >> (8 * i));
+	}
+	ByteBufferAppend(buf, checksumBytes, WAL_CHECKSUM_SIZE);
+}
+
+/**
+ * Sprawdza sumę kontrolną zapisaną za bajtami @p data
+ * @param[in] data : bajty (po których następuje suma kontrolna)
+ * @param[in] size : liczba bajtów (bez sumy kontrolnej)
+ * @return Czy suma kontrolna się zgadza
+ */
+static bool ChecksumMatches(const unsigned char *data, size_t size)
+{
+	uint32_t checksum = 0;
+	for(int i = 0; i < WAL_CHECKSUM_SIZE; i++)
+	{
+		checksum |= (uint32_t)data[size + i] << (8 * i);
+	}
+	return (checksum == Fnv1a32(data, size));
+}
+
+/**
+ * Zapisuje zawartość bufora do pliku, jeśli zebrała się w nim pełna porcja
+ * (obraz zapisujemy dużymi porcjami, nie trzymając go całego w pamięci)
+ * @param[in] fd : deskryptor pliku
+ * @param[in] buf : bufor (opróżniany po zapisie)
+ * @return Czy zapis się powiódł
+ */
+static bool WriteChunk(int fd, ByteBuffer *buf)
+{
+	if(buf->size < CHECKPOINT_WRITE_CHUNK)
+	{
+		return true;
+	}
+	bool ok = WriteAll(fd, buf->data, buf->size);
+	buf->size = 0;
+	return ok;
+}
+
+bool CheckpointSave(PolyStack *pStack, const char *path)
+{
+	assert(pStack->checkpoint.operation != NULL);
+	char *tmpPath = PathWithSuffix(path, CHECKPOINT_TMP_SUFFIX);
+	int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+	{
+		free(tmpPath);
+		return false;
+	}
+
+	ByteBuffer buf = EmptyByteBuffer();
+	unsigned char version = CHECKPOINT_VERSION;
+	size_t size = PolyStackSize(pStack);
+	PolyStackForce(pStack, (long)size);
+	ByteBufferAppend(&buf, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_SIZE);
+	ByteBufferAppend(&buf, &version, 1);
+	ByteBufferAppendVarint(&buf, size);
+
+	bool ok = true;
+	for(size_t i = 0; i < size && ok; i++)
+	{
+		PolyStackElem *elem = PolyStackPeek(pStack, size - 1 - i);
+		if(elem->mapped != NULL)
+		{
+			MappedPolySerialize(&(elem->mapped->root), &buf);
+		}
+		else
+		{
+			PolySerialize(&(elem->p), &buf);
+		}
+		ok = WriteChunk(fd, &buf);
+	}
+
+	RegisterTable *registers = &(pStack->registers);
+	ByteBufferAppendVarint(&buf, registers->size);
+	for(size_t i = 0; i < registers->capacity && ok; i++)
+	{
+		RegisterEntry *entry = &(registers->entries[i]);
+		if(entry->name != NULL)
+		{
+			size_t nameLength = strlen(entry->name);
+			ByteBufferAppendVarint(&buf, nameLength);
+			ByteBufferAppend(&buf, entry->name, nameLength);
+			PolySerialize(&(entry->value->p), &buf);
+			ok = WriteChunk(fd, &buf);
+		}
+	}
+	ok = ok && WriteAll(fd, buf.data, buf.size);
+	ok = (fsync(fd) == 0) && ok;
+	ok = (close(fd) == 0) && ok;
+	ok = ok && (rename(tmpPath, path) == 0);
+	if(!ok)
+	{
+		unlink(tmpPath);
+	}
+	ByteBufferDestroy(&buf);
+	free(tmpPath);
+
+	if(ok)
+	{
+		char *walPath = PathWithSuffix(path, CHECKPOINT_WAL_SUFFIX);
+		int walFd = open(walPath, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+		free(walPath);
+		ok = (walFd >= 0);
+		CheckpointClose(pStack);
+		pStack->checkpoint.walFd = walFd;
+	}
+	return ok;
+}
+
+/**
+ * Wczytuje obraz stosu i rejestrów z pliku @p path na (pusty) stos @p pStack
+ * @param[in] path : ścieżka do pliku
+ * @param[in] pStack : stos wielomianów
+ * @return Czy odczyt się powiódł
+ */
+static bool CheckpointLoadImage(const char *path, PolyStack *pStack)
+{
+	size_t size;
+	unsigned char *data = MapFile(path, &size);
+	if(data == NULL)
+	{
+		return false;
+	}
+
+	size_t pos = CHECKPOINT_MAGIC_SIZE + 1;
+	uint64_t count;
+	bool ok = (size >= pos && memcmp(data, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_SIZE) == 0 &&
+		data[CHECKPOINT_MAGIC_SIZE] == CHECKPOINT_VERSION && ReadVarint(data, size, &pos, &count));
+
+	for(uint64_t i = 0; i < count && ok; i++)
+	{
+		Poly p;
+		size_t consumed;
+		ok = PolyDeserialize(data + pos, size - pos, &p, &consumed);
+		if(ok)
+		{
+			PolyStackPush(pStack, &p);
+			pos += consumed;
+		}
+	}
+
+	ok = ok && ReadVarint(data, size, &pos, &count);
+	for(uint64_t i = 0; i < count && ok; i++)
+	{
+		uint64_t nameLength;
+		ok = ReadVarint(data, size, &pos, &nameLength) && nameLength <= size - pos &&
+			memchr(data + pos, '\0', nameLength) == NULL;
+		if(!ok)
+		{
+			break;
+		}
+		char *name = malloc(nameLength + 1);
+		assert(name != NULL);
+		memcpy(name, data + pos, nameLength);
+		name[nameLength] = '\0';
+		pos += nameLength;
+
+		Poly p;
+		size_t consumed;
+		ok = PolyDeserialize(data + pos, size - pos, &p, &consumed);
+		if(ok)
+		{
+			RegisterTableSet(&(pStack->registers), name, SharedPolyCreate(&p));
+			pos += consumed;
+		}
+		free(name);
+	}
+	ok = ok && (pos == size);
+	munmap(data, size);
+	return ok;
+}
+
+/**
+ * Odtwarza wczytany wiersz z treści wpisu dziennika
+ * @param[in] checkpoint : punkt kontrolny z tablicami operacji kalkulatora
+ * @param[in] data : treść wpisu
+ * @param[in] size : długość treści wpisu
+ * @param[out] line : wczytany wiersz
+ * @return Czy treść wpisu jest poprawna
+ */
+static bool WalDecodeLine(const CheckpointLog *checkpoint, const unsigned char *data, size_t size, ParsedLine *line)
+{
+	*line = EmptyParsedLine();
+	if(size == 0)
+	{
+		return false;
+	}
+
+	size_t pos = 1;
+	uint64_t index, arg, length;
+	if(data[0] == WAL_POLY)
+	{
+		size_t consumed;
+		line->type = PARSED_POLY;
+		return PolyDeserialize(data + pos, size - pos, &(line->p), &consumed) && consumed == size - pos;
+	}
+
+	line->type = PARSED_COMMAND;
+	if(!ReadVarint(data, size, &pos, &index))
+	{
+		return false;
+	}
+	if(data[0] == WAL_OPERATION && index < OPER_WITHOUT_ARG_AMOUNT)
+	{
+		line->operation = &(checkpoint->operation[index]);
+	}
+	else if(data[0] == WAL_OPERATION_WITH_ARG && index < OPER_WITH_ARG_AMOUNT &&
+		ReadVarint(data, size, &pos, &arg))
+	{
+		line->opWithArg = &(checkpoint->opWithArg[index]);
+		line->arg = (long)arg;
+	}
+	else if(data[0] == WAL_OPERATION_WITH_STRING_ARG && index < OPER_WITH_STRING_ARG_AMOUNT &&
+		ReadVarint(data, size, &pos, &length) && length <= size - pos)
+	{
+		line->opWithStrArg = &(checkpoint->opWithStrArg[index]);
+		line->strArg = malloc(length + 1);
+		assert(line->strArg != NULL);
+		memcpy(line->strArg, data + pos, length);
+		line->strArg[length] = '\0';
+		pos += length;
+	}
+	else
+	{
+		return false;
+	}
+	return (pos == size);
+}
+
+/**
+ * Wykonuje na stosie @p pStack wiersze zapisane w dzienniku @p walPath,
+ * aż do końca dziennika lub pierwszego niepełnego (uszkodzonego) wpisu
+ * @param[in] pStack : stos wielomianów
+ * @param[in] walPath : ścieżka do dziennika
+ * @return długość poprawnej części dziennika (w bajtach)
+ */
+static size_t CheckpointReplayWal(PolyStack *pStack, const char *walPath)
+{
+	size_t size;
+	unsigned char *data = MapFile(walPath, &size);
+	if(data == NULL)
+	{
+		return 0;
+	}
+
+	size_t pos = 0;
+	while(pos < size)
+	{
+		size_t recordPos = pos;
+		uint64_t length;
+		ParsedLine line;
+		if(!ReadVarint(data, size, &recordPos, &length) || length > size - recordPos ||
+			WAL_CHECKSUM_SIZE > size - recordPos - length ||
+			!ChecksumMatches(data + recordPos, length))
+		{
+			break;
+		}
+		if(!WalDecodeLine(&(pStack->checkpoint), data + recordPos, length, &line))
+		{
+			ParsedLineDestroy(&line);
+			break;
+		}
+		ExecuteParsedLine(pStack, &line);
+		pos = recordPos + length + WAL_CHECKSUM_SIZE;
+	}
+	munmap(data, size);
+	return pos;
+}
+
+bool CheckpointRestore(PolyStack *pStack, const char *path)
+{
+	assert(pStack->checkpoint.operation != NULL);
+	/* nowy stos nie ma dziennika, więc wiersze z dziennika nie trafią do żadnego dziennika */
+	PolyStack restored = EmptyPolyStack();
+	CheckpointSetOperations(&restored, pStack->checkpoint.operation, pStack->checkpoint.opWithArg,
+		pStack->checkpoint.opWithStrArg);
+	if(!CheckpointLoadImage(path, &restored))
+	{
+		DestroyStack(&restored);
+		return false;
+	}
+
+	char *walPath = PathWithSuffix(path, CHECKPOINT_WAL_SUFFIX);
+	int walFd = open(walPath, O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if(walFd < 0)
+	{
+		free(walPath);
+		DestroyStack(&restored);
+		return false;
+	}
+
+	bool wasSuppressed = OutputIsSuppressed();
+	bool errorWasSuppressed = ErrorIsSuppressed();
+	OutputSetSuppressed(true);
+	ErrorSetSuppressed(true);
+	size_t validSize = CheckpointReplayWal(&restored, walPath);
+	OutputSetSuppressed(wasSuppressed);
+	ErrorSetSuppressed(errorWasSuppressed);
+	/* kolejne wpisy dopisujemy za ostatnim poprawnym */
+	if(ftruncate(walFd, (off_t)validSize) != 0)
+	{
+		close(walFd);
+		walFd = -1;
+	}
+	free(walPath);
+
+	DestroyStack(pStack);
+	*pStack = restored;
+	pStack->checkpoint.walFd = walFd;
+	return true;
+}
+
+/**
+ * Dopisuje wpis do dziennika punktu kontrolnego stosu @p pStack
+ * @param[in] pStack : stos wielomianów (z otwartym dziennikiem)
+ * @param[in] payload : treść wpisu
+ */
+static void CheckpointAppendRecord(PolyStack *pStack, const ByteBuffer *payload)
+{
+	ByteBuffer record = EmptyByteBuffer();
+	ByteBufferAppendVarint(&record, payload->size);
+	ByteBufferAppend(&record, payload->data, payload->size);
+	AppendChecksum(&record, payload->data, payload->size);
+	/* dziennik z luką byłby odtwarzany błędnie, więc po nieudanym zapisie go porzucamy */
+	if(!WriteAll(pStack->checkpoint.walFd, record.data, record.size))
+	{
+		CheckpointClose(pStack);
+	}
+	ByteBufferDestroy(&record);
+}
+
+/**
+ * Sprawdza, czy polecenie czyta lub zapisuje plik z wielomianem
+ * @param[in] name : nazwa polecenia
+ * @param[in] load : czy chodzi o polecenia czytające (LOAD, LOAD_MAPPED),
+ * czy zapisujące (SAVE, SAVE_MAPPED)
+ * @return Czy polecenie jest jednym z nich
+ */
+static bool IsFileCommand(const char *name, bool load)
+{
+	return load ? (strcmp(name, LOAD) == 0 || strcmp(name, LOAD_MAPPED) == 0) :
+		(strcmp(name, SAVE) == 0 || strcmp(name, SAVE_MAPPED) == 0);
+}
+
+void CheckpointLogLine(PolyStack *pStack, const ParsedLine *line)
+{
+	CheckpointLog *checkpoint = &(pStack->checkpoint);
+	if(checkpoint->walFd < 0)
+	{
+		return;
+	}
+
+	ByteBuffer payload = EmptyByteBuffer();
+	unsigned char kind;
+	if(line->type == PARSED_POLY)
+	{
+		if(line->parseError.hasError)
+		{
+			return;
+		}
+		kind = WAL_POLY;
+		ByteBufferAppend(&payload, &kind, 1);
+		PolySerialize(&(line->p), &payload);
+	}
+	else if(line->errorType != NULL)
+	{
+		return;
+	}
+	else if(line->operation != NULL)
+	{
+		kind = WAL_OPERATION;
+		ByteBufferAppend(&payload, &kind, 1);
+		ByteBufferAppendVarint(&payload, (uint64_t)(line->operation - checkpoint->operation));
+	}
+	else if(line->opWithArg != NULL)
+	{
+		kind = WAL_OPERATION_WITH_ARG;
+		ByteBufferAppend(&payload, &kind, 1);
+		ByteBufferAppendVarint(&payload, (uint64_t)(line->opWithArg - checkpoint->opWithArg));
+		ByteBufferAppendVarint(&payload, (uint64_t)line->arg);
+	}
+	else if(line->opWithStrArg != NULL)
+	{
+		/* zawartość plików mogła się zmienić – wczytany wielomian dopisuje CheckpointLogLoad() */
+		const char *name = line->opWithStrArg->name;
+		if(strcmp(name, CHECKPOINT) == 0 || strcmp(name, RESTORE) == 0 ||
+			IsFileCommand(name, true) || IsFileCommand(name, false))
+		{
+			return;
+		}
+		size_t length = strlen(line->strArg);
+		kind = WAL_OPERATION_WITH_STRING_ARG;
+		ByteBufferAppend(&payload, &kind, 1);
+		ByteBufferAppendVarint(&payload, (uint64_t)(line->opWithStrArg - checkpoint->opWithStrArg));
+		ByteBufferAppendVarint(&payload, length);
+		ByteBufferAppend(&payload, line->strArg, length);
+	}
+	else
+	{
+		return;
+	}
+
+	CheckpointAppendRecord(pStack, &payload);
+	ByteBufferDestroy(&payload);
+}
+
+void CheckpointLogLoad(PolyStack *pStack, const ParsedLine *line)
+{
+	if(pStack->checkpoint.walFd < 0 || line->opWithStrArg == NULL ||
+		!IsFileCommand(line->opWithStrArg->name, true))
+	{
+		return;
+	}
+	ByteBuffer payload = EmptyByteBuffer();
+	unsigned char kind = WAL_POLY;
+	ByteBufferAppend(&payload, &kind, 1);
+	PolyStackElem *top = PolyStackPeek(pStack, 0);
+	if(top->mapped != NULL)
+	{
+		MappedPolySerialize(&(top->mapped->root), &payload);
+	}
+	else
+	{
+		PolySerialize(&(top->p), &payload);
+	}
+	CheckpointAppendRecord(pStack, &payload);
+	ByteBufferDestroy(&payload);
+}
@@ -0,0 +1,101 @@
+/** @file
+   Interfejs punktów kontrolnych stosu kalkulatora wielomianów
+
+   Punkt kontrolny to plik z binarnym obrazem całego stosu i rejestrów:
+   - 4 bajty: sygnatura `IPPS`,
+   - 1 bajt: numer wersji formatu,
+   - varint: liczba wielomianów na stosie,
+   - kolejne wielomiany (od dna do szczytu stosu) w formacie PolySerialize(),
+   - varint: liczba niepustych rejestrów,
+   - kolejne rejestry: varint z długością nazwy, nazwa i wielomian w formacie PolySerialize().
+
+   Od chwili zapisania (lub odtworzenia) punktu kontrolnego `plik` każdy
+   poprawnie wczytany wiersz jest, przed wykonaniem, dopisywany do dziennika
+   `plik.wal`; wiersz wczytujący plik z wielomianem jest dopisywany (po
+   wykonaniu) jako wczytany wielomian, a wiersze zapisujące takie pliki są
+   pomijane. Wpis dziennika to varint z długością treści, treść (rodzaj
+   wiersza, a następnie wielomian albo numer polecenia i jego argument)
+   oraz 4 bajty sumy kontrolnej FNV-1a treści. Przy odtwarzaniu stanu
+   wczytuje się obraz stosu, a potem wykonuje (bez wypisywania czegokolwiek)
+   wiersze zapisane w dzienniku, aż do pierwszego niepełnego wpisu.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-17
+*/
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <stdbool.h>
+#include "polystack.h"
+#include "operation.h"
+#include "read.h"
+
+/** Sygnatura pliku z punktem kontrolnym */
+#define CHECKPOINT_MAGIC "IPPS"
+/** Długość sygnatury pliku z punktem kontrolnym */
+#define CHECKPOINT_MAGIC_SIZE 4
+/** Wersja formatu pliku z punktem kontrolnym */
+#define CHECKPOINT_VERSION 2
+/** Rozszerzenie dodawane do ścieżki punktu kontrolnego, by otrzymać ścieżkę dziennika */
+#define CHECKPOINT_WAL_SUFFIX ".wal"
+/** Rozmiar porcji, w jakich zapisywany jest obraz stosu (w bajtach) */
+#define CHECKPOINT_WRITE_CHUNK (1 << 20)
+
+/**
+ * Ustawia tablice operacji, względem których numerowane są polecenia
+ * w dzienniku punktu kontrolnego stosu @p pStack. Bez tego stos nie może
+ * zapisać ani odtworzyć punktu kontrolnego.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] operation : bezargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithArg : jednoargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym udostępnione przez kalkulator
+ */
+void CheckpointSetOperations(PolyStack *pStack, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[]);
+
+/**
+ * Zapisuje obraz stosu do pliku @p path (atomowo – przez plik tymczasowy)
+ * i rozpoczyna nowy, pusty dziennik `path.wal`.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] path : ścieżka do pliku
+ * @return Czy zapis się powiódł
+ */
+bool CheckpointSave(PolyStack *pStack, const char *path);
+
+/**
+ * Zastępuje zawartość stosu obrazem zapisanym w pliku @p path, wykonuje
+ * wiersze z dziennika `path.wal` i kontynuuje dopisywanie do tego dziennika.
+ * W przypadku błędu stos nie zmienia się.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] path : ścieżka do pliku
+ * @return Czy odtworzenie się powiodło
+ */
+bool CheckpointRestore(PolyStack *pStack, const char *path);
+
+/**
+ * Dopisuje wiersz do dziennika bieżącego punktu kontrolnego stosu @p pStack
+ * (jeśli taki jest). Pomija wiersze z błędami oraz polecenia CHECKPOINT,
+ * RESTORE i polecenia operujące na plikach z wielomianami (SAVE, SAVE_MAPPED,
+ * LOAD, LOAD_MAPPED), bo ich odtworzenie zależałoby od bieżącej zawartości plików.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] line : wczytany wiersz (przed wykonaniem)
+ */
+void CheckpointLogLine(PolyStack *pStack, const ParsedLine *line);
+
+/**
+ * Jeśli wiersz był poleceniem LOAD lub LOAD_MAPPED, dopisuje do dziennika
+ * bieżącego punktu kontrolnego stosu @p pStack wczytany wielomian (tak jakby
+ * został podany w osobnym wierszu)
+ * @param[in] pStack : stos wielomianów (z wczytanym wielomianem na szczycie)
+ * @param[in] line : wiersz wykonany bez błędu
+ */
+void CheckpointLogLoad(PolyStack *pStack, const ParsedLine *line);
+
+/**
+ * Zamyka dziennik bieżącego punktu kontrolnego stosu @p pStack
+ * @param[in] pStack : stos wielomianów
+ */
+void CheckpointClose(PolyStack *pStack);
+
+#endif /* __CHECKPOINT_H__ */
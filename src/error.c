@@ -1,17 +1,103 @@
 #include "error.h"
 
+#include "output.h"
+
 #include "utils.h"
 
+/** Maksymalna długość komunikatu o błędzie zapisywanego do bufora */
+#define ERROR_TEXT_SIZE 64
+
+/** Czy komunikaty o błędach w bieżącym wątku są wyciszone (zob. ErrorSetSuppressed()) */
+static _Thread_local bool errorSuppressed = false;
+/** Bufor w pamięci, do którego trafiają komunikaty (zob. ErrorSetSink()) */
+static _Thread_local ByteBuffer *errorSink = NULL;
+/** Liczba komunikatów o błędach zgłoszonych w bieżącym wątku (zob. ErrorCount()) */
+static _Thread_local unsigned long errorCount = 0;
+
+void ErrorSetSuppressed(bool suppressed)
+{
+	errorSuppressed = suppressed;
+}
+
+bool ErrorIsSuppressed()
+{
+	return errorSuppressed;
+}
+
+ByteBuffer *ErrorSetSink(ByteBuffer *sink)
+{
+	ByteBuffer *previous = errorSink;
+	errorSink = sink;
+	return previous;
+}
+
+unsigned long ErrorCount()
+{
+	return errorCount;
+}
+
+/**
+ * Dopisuje sformatowany komunikat do bufora komunikatów o błędach
+ * @param[in] text : komunikat
+ * @param[in] size : wynik snprintf() (długość komunikatu bez obcięcia)
+ */
+static void ErrorAppendToSink(const char *text, int size)
+{
+	if(size < 0)
+	{
+		return;
+	}
+	if(size >= ERROR_TEXT_SIZE)
+	{
+		size = ERROR_TEXT_SIZE - 1;
+	}
+	/* bufor może być też buforem wyjścia – wcześniejsze wyjście musi go poprzedzić */
+	OutputFlush();
+	ByteBufferAppend(errorSink, text, (size_t)size);
+}
+
 void ErrorCommand(int r, char *type)
 {
-	fprintf(stderr, "ERROR %d %s\n", r, type);
+	if(errorSuppressed)
+	{
+		return;
+	}
+	errorCount++;
+	if(errorSink != NULL)
+	{
+		char text[ERROR_TEXT_SIZE];
+		ErrorAppendToSink(text, snprintf(text, ERROR_TEXT_SIZE, "ERROR %d %s\n", r, type));
+	}
+	else
+	{
+		fprintf(stderr, "ERROR %d %s\n", r, type);
+	}
+}
+
+void ErrorParse(int r, int c, ParseError *error)
+{
+	if(!(error->hasError))
+	{
+		error->hasError = true;
+		error->line = r;
+		error->column = c;
+	}
 }
 
-void ErrorParse(int r, int c, bool *hasError)
+void ErrorParseReport(const ParseError *error)
 {
-	if(!(*hasError))
+	if(!error->hasError || errorSuppressed)
+	{
+		return;
+	}
+	errorCount++;
+	if(errorSink != NULL)
+	{
+		char text[ERROR_TEXT_SIZE];
+		ErrorAppendToSink(text, snprintf(text, ERROR_TEXT_SIZE, "ERROR %d %d\n", error->line, error->column));
+	}
+	else
 	{
-		fprintf(stderr, "ERROR %d %d\n", r, c); 
-		(*hasError) = true;
+		fprintf(stderr, "ERROR %d %d\n", error->line, error->column);
 	}
 }
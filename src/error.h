@@ -11,11 +11,43 @@
 #include <stdio.h>
 #include <stdbool.h>
 
+#include "serialize.h"
+
 #define WRONG_COMMAND "WRONG COMMAND"
 #define WRONG_VALUE "WRONG VALUE"
 #define WRONG_VARIABLE "WRONG VARIABLE"
 #define STACK_UNDERFLOW "STACK UNDERFLOW"
 #define WRONG_COUNT "WRONG COUNT"
+#define WRONG_FILE "WRONG FILE"
+#define WRONG_REGISTER "WRONG REGISTER"
+
+/**
+ * Włącza lub wyłącza wyciszenie komunikatów o błędach w bieżącym wątku
+ * @param[in] suppressed : czy komunikaty o błędach mają nie być wypisywane
+ */
+void ErrorSetSuppressed(bool suppressed);
+
+/**
+ * Sprawdza, czy komunikaty o błędach są wyciszone
+ * @return Czy komunikaty o błędach są wyciszone
+ */
+bool ErrorIsSuppressed();
+
+/**
+ * Kieruje komunikaty o błędach do bufora w pamięci zamiast na standardowe
+ * wyjście błędów (np. dla kontekstów z libpoly.h). Ustawienie dotyczy tylko
+ * bieżącego wątku.
+ * @param[in] sink : bufor lub NULL, jeśli komunikaty mają trafiać na standardowe wyjście błędów
+ * @return poprzedni bufor (lub NULL)
+ */
+ByteBuffer *ErrorSetSink(ByteBuffer *sink);
+
+/**
+ * Zwraca liczbę komunikatów o błędach zgłoszonych (i nie wyciszonych)
+ * w bieżącym wątku
+ * @return liczba komunikatów
+ */
+unsigned long ErrorCount();
 
 /**
  * Wypisuje na standardowy strumień błędów informację o błędzie 
@@ -26,13 +58,40 @@
 void ErrorCommand(int r, char *type);
 
 /**
- * Wypisuje na standardowy strumień błędów informację o błędzie 
- * związanym z parsowaniem wielomianu
- * Działa tylko w przypadku, gdy dla danego wiersza nie został jeszcze zgłoszony błąd
+ * Informacja o pierwszym błędzie parsowania, który wystąpił w wierszu
+ */
+typedef struct ParseError
+{
+	bool hasError; ///< czy w danym wierszu wystąpił już błąd
+	int line; ///< numer wiersza, w którym wystąpił błąd
+	int column; ///< numer kolumny, w której wystąpił błąd
+} ParseError;
+
+/**
+ * Zwraca informację o braku błędu parsowania
+ * @return brak błędu
+ */
+static inline ParseError NoParseError()
+{
+	return (ParseError) {.hasError = false, .line = 0, .column = 0};
+}
+
+/**
+ * Zapamiętuje błąd związany z parsowaniem wielomianu.
+ * Działa tylko w przypadku, gdy dla danego wiersza nie został jeszcze zgłoszony błąd.
+ * Błąd jest wypisywany dopiero przez ErrorParseReport(), dzięki czemu parsowanie
+ * nie musi odbywać się w tym samym miejscu, co wykonywanie poleceń.
  * @param[in] r : numer wiersza, w którym wystąpił błąd
  * @param[in] c : numer kolumny, w której wystąpił błąd
- * @param[in] hasError : czy w danym wierszu wystąpił już błąd
+ * @param[in] error : pierwszy błąd parsowania w danym wierszu
+ */
+void ErrorParse(int r, int c, ParseError *error);
+
+/**
+ * Wypisuje na standardowy strumień błędów informację o błędzie 
+ * związanym z parsowaniem wielomianu (o ile taki wystąpił)
+ * @param[in] error : pierwszy błąd parsowania w danym wierszu
  */
-void ErrorParse(int r, int c, bool *hasError);
+void ErrorParseReport(const ParseError *error);
 
 #endif /* __ERROR_H__ */
@@ -0,0 +1,202 @@
+#include "lazy.h"
+#include "memo.h"
+#include "oracle.h"
+
+#include "utils.h"
+
+/**
+ * Tworzy nowy węzeł wyrażenia (z jednym odwołaniem)
+ * @param[in] kind : rodzaj węzła
+ * @param[in] a : pierwszy argument (lub NULL)
+ * @param[in] b : drugi argument (lub NULL)
+ * @return węzeł
+ */
+static LazyExpr *LazyNew(LazyKind kind, LazyExpr *a, LazyExpr *b)
+{
+	LazyExpr *e = malloc(sizeof(LazyExpr));
+	assert(e != NULL);
+	e->kind = kind;
+	e->refCount = 1;
+	e->depth = 1;
+	e->value = PolyZero();
+	e->args[0] = a;
+	e->args[1] = b;
+	if(a != NULL && a->depth + 1 > e->depth)
+	{
+		e->depth = a->depth + 1;
+	}
+	if(b != NULL && b->depth + 1 > e->depth)
+	{
+		e->depth = b->depth + 1;
+	}
+	return e;
+}
+
+/**
+ * Zwraca wartość obliczonego argumentu: bez kopiowania, jeśli nikt poza
+ * obliczanym węzłem się do niego nie odwołuje, a w przeciwnym razie – kopię
+ * @param[in] arg : obliczony argument
+ * @return wartość argumentu
+ */
+static Poly LazyTakeValue(LazyExpr *arg)
+{
+	assert(arg->kind == LAZY_VALUE);
+	if(arg->refCount == 1)
+	{
+		Poly value = arg->value;
+		arg->value = PolyZero();
+		return value;
+	}
+	return PolyClone(&(arg->value));
+}
+
+/**
+ * Oblicza wyrażenie i zamienia jego węzeł w obliczoną wartość
+ * (tak, by kolejne odwołania do niego nie liczyły go ponownie)
+ * @param[in] e : wyrażenie
+ */
+static void LazyEvaluate(LazyExpr *e)
+{
+	LazyExpr *a = e->args[0], *b = e->args[1];
+	Poly value;
+	switch(e->kind)
+	{
+		case LAZY_VALUE:
+			return;
+		case LAZY_ADD:
+			if(b->kind == LAZY_MUL && b->refCount == 1)
+			{
+				a = e->args[1];
+				b = e->args[0];
+			}
+			if(a->kind == LAZY_MUL && a->refCount == 1)
+			{
+				/* a * b + c w jednym przebiegu, bez tworzenia iloczynu */
+				LazyEvaluate(a->args[0]);
+				LazyEvaluate(a->args[1]);
+				LazyEvaluate(b);
+				value = PolyMulAdd(&(a->args[0]->value), &(a->args[1]->value), &(b->value));
+			}
+			else
+			{
+				LazyEvaluate(a);
+				LazyEvaluate(b);
+				value = LazyTakeValue(a);
+				Poly addend = LazyTakeValue(b);
+				PolyAddInPlace(&value, &addend);
+			}
+			break;
+		case LAZY_MUL:
+			LazyEvaluate(a);
+			LazyEvaluate(b);
+			if(PolyIsCoeff(&(a->value)))
+			{
+				value = LazyTakeValue(b);
+				PolyScaleInPlace(&value, a->value.c);
+			}
+			else if(PolyIsCoeff(&(b->value)))
+			{
+				value = LazyTakeValue(a);
+				PolyScaleInPlace(&value, b->value.c);
+			}
+			else
+			{
+				value = MemoMul(&(a->value), &(b->value));
+			}
+			break;
+		default:
+			LazyEvaluate(a);
+			value = LazyTakeValue(a);
+			PolySetInverseCoeffs(&value);
+			break;
+	}
+	LazyRelease(e->args[0]);
+	LazyRelease(e->args[1]);
+	e->kind = LAZY_VALUE;
+	e->value = value;
+	e->args[0] = e->args[1] = NULL;
+	e->depth = 1;
+}
+
+/**
+ * Oblicza od razu wyrażenie, które jest zbyt głębokie
+ * @param[in] e : wyrażenie
+ * @return @p e
+ */
+static LazyExpr *LazyLimitDepth(LazyExpr *e)
+{
+	if(e->depth > LAZY_MAX_DEPTH)
+	{
+		LazyEvaluate(e);
+	}
+	return e;
+}
+
+LazyExpr *LazyFromPoly(Poly *p)
+{
+	LazyExpr *e = LazyNew(LAZY_VALUE, NULL, NULL);
+	e->value = *p;
+	return e;
+}
+
+LazyExpr *LazyAdd(LazyExpr *a, LazyExpr *b)
+{
+	if(a->kind == LAZY_VALUE && b->kind == LAZY_VALUE &&
+		PolyIsCoeff(&(a->value)) && PolyIsCoeff(&(b->value)))
+	{
+		Poly sum = PolyFromCoeff(a->value.c + b->value.c);
+		LazyRelease(a);
+		LazyRelease(b);
+		return LazyFromPoly(&sum);
+	}
+	return LazyLimitDepth(LazyNew(LAZY_ADD, a, b));
+}
+
+LazyExpr *LazyMul(LazyExpr *a, LazyExpr *b)
+{
+	if(a->kind == LAZY_VALUE && b->kind == LAZY_VALUE &&
+		PolyIsCoeff(&(a->value)) && PolyIsCoeff(&(b->value)))
+	{
+		Poly mul = PolyFromCoeff(a->value.c * b->value.c);
+		LazyRelease(a);
+		LazyRelease(b);
+		return LazyFromPoly(&mul);
+	}
+	return LazyLimitDepth(LazyNew(LAZY_MUL, a, b));
+}
+
+LazyExpr *LazyNeg(LazyExpr *a)
+{
+	if(a->kind == LAZY_NEG)
+	{
+		/* -(-x) = x */
+		LazyExpr *arg = LazyRetain(a->args[0]);
+		LazyRelease(a);
+		return arg;
+	}
+	if(a->kind == LAZY_VALUE && a->refCount == 1)
+	{
+		PolySetInverseCoeffs(&(a->value));
+		return a;
+	}
+	return LazyLimitDepth(LazyNew(LAZY_NEG, a, NULL));
+}
+
+void LazyRelease(LazyExpr *e)
+{
+	if(e != NULL && --(e->refCount) == 0)
+	{
+		LazyRelease(e->args[0]);
+		LazyRelease(e->args[1]);
+		PolyDestroy(&(e->value));
+		free(e);
+	}
+}
+
+Poly LazyForce(LazyExpr *e)
+{
+	LazyEvaluate(e);
+	Poly value = LazyTakeValue(e);
+	LazyRelease(e);
+	return value;
+}
@@ -0,0 +1,105 @@
+/** @file
+   Interfejs leniwie obliczanych wyrażeń na wielomianach
+
+   W trybie leniwym (zob. InitLazyOperations()) polecenia ADD, SUB, MUL, NEG
+   i CLONE nie liczą wyniku, tylko budują acykliczny graf wyrażenia, którego
+   wartość jest liczona dopiero wtedy, gdy potrzebuje jej inne polecenie.
+   Wyrażenie zdjęte ze stosu poleceniem POP przed obliczeniem nie jest
+   liczone wcale. Przy obliczaniu suma, której składnikiem jest iloczyn
+   (a * b + c), jest liczona w jednym przebiegu, bez tworzenia iloczynu,
+   a wspólne podwyrażenia (np. powstałe przez CLONE) są liczone raz.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-21
+*/
+#ifndef __LAZY_H__
+#define __LAZY_H__
+
+#include "poly.h"
+
+/**
+ * Maksymalna głębokość wyrażenia; głębsze wyrażenia są obliczane od razu,
+ * co ogranicza głębokość rekurencji przy obliczaniu
+ */
+#define LAZY_MAX_DEPTH 256
+
+/**
+ * Rodzaje węzłów wyrażenia
+ */
+typedef enum LazyKind
+{
+	LAZY_VALUE, ///< obliczona wartość
+	LAZY_ADD, ///< suma dwóch wyrażeń
+	LAZY_MUL, ///< iloczyn dwóch wyrażeń
+	LAZY_NEG ///< wyrażenie przeciwne
+} LazyKind;
+
+/**
+ * Węzeł wyrażenia (współdzielony, z licznikiem odwołań)
+ */
+typedef struct LazyExpr
+{
+	LazyKind kind; ///< rodzaj węzła
+	unsigned refCount; ///< licznik odwołań
+	unsigned depth; ///< głębokość wyrażenia (1 dla obliczonej wartości)
+	Poly value; ///< wartość (dla LAZY_VALUE)
+	struct LazyExpr *args[2]; ///< argumenty (dla LAZY_NEG tylko pierwszy)
+} LazyExpr;
+
+/**
+ * Tworzy obliczone wyrażenie, przejmując wielomian @p p na własność
+ * @param[in] p : wielomian
+ * @return wyrażenie (z jednym odwołaniem)
+ */
+LazyExpr *LazyFromPoly(Poly *p);
+
+/**
+ * Tworzy wyrażenie `a + b`, przejmując odwołania do argumentów
+ * @param[in] a : wyrażenie
+ * @param[in] b : wyrażenie
+ * @return wyrażenie (z jednym odwołaniem)
+ */
+LazyExpr *LazyAdd(LazyExpr *a, LazyExpr *b);
+
+/**
+ * Tworzy wyrażenie `a * b`, przejmując odwołania do argumentów
+ * @param[in] a : wyrażenie
+ * @param[in] b : wyrażenie
+ * @return wyrażenie (z jednym odwołaniem)
+ */
+LazyExpr *LazyMul(LazyExpr *a, LazyExpr *b);
+
+/**
+ * Tworzy wyrażenie `-a`, przejmując odwołanie do argumentu
+ * @param[in] a : wyrażenie
+ * @return wyrażenie (z jednym odwołaniem)
+ */
+LazyExpr *LazyNeg(LazyExpr *a);
+
+/**
+ * Zwiększa licznik odwołań do wyrażenia
+ * @param[in] e : wyrażenie
+ * @return @p e
+ */
+static inline LazyExpr *LazyRetain(LazyExpr *e)
+{
+	e->refCount++;
+	return e;
+}
+
+/**
+ * Zwalnia odwołanie do wyrażenia (bez obliczania go)
+ * @param[in] e : wyrażenie (może być NULL)
+ */
+void LazyRelease(LazyExpr *e);
+
+/**
+ * Oblicza wyrażenie, zwalnia odwołanie do niego i zwraca jego wartość
+ * na własność wywołującemu (bez kopiowania, jeśli było to ostatnie odwołanie)
+ * @param[in] e : wyrażenie
+ * @return wartość wyrażenia
+ */
+Poly LazyForce(LazyExpr *e);
+
+#endif /* __LAZY_H__ */
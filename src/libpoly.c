@@ -0,0 +1,124 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "libpoly.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "polystack.h"
+#include "operation.h"
+#include "checkpoint.h"
+#include "read.h"
+#include "output.h"
+#include "error.h"
+#include "serialize.h"
+
+#include "utils.h"
+
+/**
+ * Kontekst kalkulatora
+ */
+struct PolyCalc
+{
+	PolyStack stack; ///< stos wielomianów (razem z rejestrami)
+	Operation operation[OPER_WITHOUT_ARG_AMOUNT]; ///< bezargumentowe operacje
+	OperationWithArg opWithArg[OPER_WITH_ARG_AMOUNT]; ///< jednoargumentowe operacje
+	OperationWithStringArg opWithStrArg[OPER_WITH_STRING_ARG_AMOUNT]; ///< operacje z argumentem tekstowym
+	unsigned flags; ///< flagi POLY_CALC_... podane przy tworzeniu
+	int lineNumber; ///< numer ostatniego wykonanego wiersza
+	ByteBuffer output; ///< wyjście kalkulatora
+	ByteBuffer errors; ///< komunikaty o błędach
+};
+
+int PolyCalcVersion(void)
+{
+	return LIBPOLY_VERSION;
+}
+
+PolyCalc *PolyCalcCreate(unsigned flags)
+{
+	PolyCalc *calc = malloc(sizeof(PolyCalc));
+	assert(calc != NULL);
+	calc->stack = EmptyPolyStack();
+	InitStandardOperations(calc->operation, calc->opWithArg, calc->opWithStrArg);
+	CheckpointSetOperations(&(calc->stack), calc->operation, calc->opWithArg, calc->opWithStrArg);
+	if(flags & POLY_CALC_LAZY)
+	{
+		InitLazyOperations(calc->operation);
+	}
+	if(flags & POLY_CALC_NO_FILES)
+	{
+		DisableFileOperations(calc->opWithStrArg);
+	}
+	calc->flags = flags;
+	calc->lineNumber = 0;
+	calc->output = EmptyByteBuffer();
+	calc->errors = EmptyByteBuffer();
+	return calc;
+}
+
+void PolyCalcDestroy(PolyCalc *calc)
+{
+	if(calc == NULL)
+	{
+		return;
+	}
+	DestroyStack(&(calc->stack));
+	ByteBufferDestroy(&(calc->output));
+	ByteBufferDestroy(&(calc->errors));
+	free(calc);
+}
+
+bool PolyCalcExecute(PolyCalc *calc, const char *script, size_t size)
+{
+	if(size == 0)
+	{
+		return true;
+	}
+	/* ParseLine() czyta ze strumienia, więc skrypt udostępniamy jako strumień w pamięci */
+	FILE *input = fmemopen((void*)script, size, "r");
+	assert(input != NULL);
+	unsigned long errorsBefore = ErrorCount();
+	ByteBuffer *previousOutput = OutputSetSink(&(calc->output));
+	ByteBuffer *previousErrors = ErrorSetSink((calc->flags & POLY_CALC_MERGE_ERRORS) ?
+		&(calc->output) : &(calc->errors));
+	ReadSetInput(input);
+	while(1)
+	{
+		ParsedLine line;
+		if(!ParseLine(calc->lineNumber + 1, calc->operation, calc->opWithArg, calc->opWithStrArg, &line))
+		{
+			break;
+		}
+		calc->lineNumber++;
+		ExecuteParsedLine(&(calc->stack), &line);
+	}
+	ReadSetInput(NULL);
+	fclose(input);
+	OutputSetSink(previousOutput);
+	ErrorSetSink(previousErrors);
+	return ErrorCount() == errorsBefore;
+}
+
+const char *PolyCalcOutput(const PolyCalc *calc, size_t *size)
+{
+	*size = calc->output.size;
+	return (const char*)calc->output.data;
+}
+
+const char *PolyCalcErrors(const PolyCalc *calc, size_t *size)
+{
+	*size = calc->errors.size;
+	return (const char*)calc->errors.data;
+}
+
+void PolyCalcClearOutput(PolyCalc *calc)
+{
+	calc->output.size = 0;
+	calc->errors.size = 0;
+}
+
+size_t PolyCalcStackSize(const PolyCalc *calc)
+{
+	return PolyStackSize(&(calc->stack));
+}
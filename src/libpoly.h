@@ -0,0 +1,120 @@
+/** @file
+   Publiczny interfejs biblioteki libpoly: kalkulatora wielomianów
+   osadzanego w innym programie
+
+   Biblioteka udostępnia kalkulator bez osobnego procesu: program tworzy
+   kontekst (PolyCalcCreate()), przekazuje mu kolejne fragmenty skryptu
+   w pamięci (PolyCalcExecute()) i odczytuje wynik oraz komunikaty
+   o błędach z buforów kontekstu zamiast ze standardowego wyjścia.
+   Skrypt ma tę samą składnię i znaczenie co wejście programu calc_poly,
+   a numery wierszy w komunikatach o błędach są liczone od utworzenia kontekstu.
+
+   Kontekst jest nieprzezroczysty: stos wielomianów, rejestry, tablice
+   poleceń i punkt kontrolny (razem z dziennikiem) należą tylko do niego.
+   Jednego kontekstu może w danej chwili używać jeden wątek; różne konteksty
+   mogą działać równocześnie w różnych wątkach. Wspólne dla procesu
+   pozostają:
+   - pamięć podręczna wyników (domyślnie wyłączona, zob. memo.h),
+   - statystyki poleceń i sprzętowe liczniki wydajności (stats.h, perfcount.h),
+   - liczniki pamięci i ich okresowy raport (memstat.h),
+   - zapis śladu wykonania (trace.h).
+
+   Nagłówek nie zależy od pozostałych nagłówków projektu. Zmiana
+   znaczenia istniejących funkcji wymaga zwiększenia LIBPOLY_VERSION.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-27
+*/
+#ifndef __LIBPOLY_H__
+#define __LIBPOLY_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Wersja interfejsu biblioteki */
+#define LIBPOLY_VERSION 1
+
+/** Flaga PolyCalcCreate(): leniwe wykonywanie poleceń arytmetycznych (zob. lazy.h) */
+#define POLY_CALC_LAZY 1u
+/**
+ * Flaga PolyCalcCreate(): komunikaty o błędach trafiają do bufora wyjścia,
+ * w kolejności wykonania wierszy (tak jak przy wspólnym terminalu
+ * dla standardowego wyjścia i standardowego wyjścia błędów)
+ */
+#define POLY_CALC_MERGE_ERRORS 2u
+/**
+ * Flaga PolyCalcCreate(): bez poleceń czytających i zapisujących pliki
+ * (SAVE, LOAD, SAVE_MAPPED, LOAD_MAPPED, CHECKPOINT, RESTORE), które
+ * kontekst zgłasza wtedy jako nieznane (WRONG COMMAND)
+ */
+#define POLY_CALC_NO_FILES 4u
+
+/** Kontekst kalkulatora (nieprzezroczysty) */
+typedef struct PolyCalc PolyCalc;
+
+/**
+ * Zwraca wersję biblioteki, z którą program został skonsolidowany
+ * @return LIBPOLY_VERSION biblioteki
+ */
+int PolyCalcVersion(void);
+
+/**
+ * Tworzy kontekst kalkulatora z pustym stosem
+ * @param[in] flags : suma flag POLY_CALC_...
+ * @return kontekst
+ */
+PolyCalc *PolyCalcCreate(unsigned flags);
+
+/**
+ * Usuwa kontekst z pamięci (razem z jego stosem i buforami)
+ * @param[in] calc : kontekst lub NULL
+ */
+void PolyCalcDestroy(PolyCalc *calc);
+
+/**
+ * Wykonuje fragment skryptu kalkulatora. Fragment powinien składać się
+ * z całych wierszy; ostatni wiersz bez znaku końca wiersza jest wykonywany
+ * tak jak ostatni wiersz wejścia calc_poly.
+ * Wynik trafia do bufora wyjścia, a komunikaty o błędach do bufora błędów
+ * kontekstu lub, z flagą POLY_CALC_MERGE_ERRORS, także do bufora wyjścia
+ * (zob. PolyCalcOutput() i PolyCalcErrors()).
+ * @param[in] calc : kontekst
+ * @param[in] script : tekst skryptu (nie musi kończyć się znakiem '\0')
+ * @param[in] size : długość tekstu
+ * @return true, jeśli żaden wiersz nie zakończył się błędem
+ */
+bool PolyCalcExecute(PolyCalc *calc, const char *script, size_t size);
+
+/**
+ * Zwraca zawartość bufora wyjścia kontekstu (ważną do następnego wywołania
+ * PolyCalcExecute(), PolyCalcClearOutput() lub PolyCalcDestroy())
+ * @param[in] calc : kontekst
+ * @param[out] size : długość zawartości
+ * @return początek zawartości (bez kończącego znaku '\0')
+ */
+const char *PolyCalcOutput(const PolyCalc *calc, size_t *size);
+
+/**
+ * Zwraca zawartość bufora komunikatów o błędach kontekstu, na tych samych
+ * zasadach co PolyCalcOutput()
+ * @param[in] calc : kontekst
+ * @param[out] size : długość zawartości
+ * @return początek zawartości (bez kończącego znaku '\0')
+ */
+const char *PolyCalcErrors(const PolyCalc *calc, size_t *size);
+
+/**
+ * Opróżnia bufory wyjścia i komunikatów o błędach kontekstu
+ * @param[in] calc : kontekst
+ */
+void PolyCalcClearOutput(PolyCalc *calc);
+
+/**
+ * Zwraca liczbę wielomianów na stosie kontekstu
+ * @param[in] calc : kontekst
+ * @return rozmiar stosu
+ */
+size_t PolyCalcStackSize(const PolyCalc *calc);
+
+#endif /* __LIBPOLY_H__ */
@@ -0,0 +1,504 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "mapped.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "output.h"
+
+#include "utils.h"
+
+/** Rozszerzenie pliku tymczasowego, przez który zapisywana jest kopia odwzorowanego pliku */
+#define MAPPED_TMP_SUFFIX ".tmp"
+
+/**
+ * Zwraca liczbę jednomianów wielomianu (bez jednomianów współczynników)
+ * @param[in] p : wielomian
+ * @return liczba jednomianów
+ */
+static uint32_t PolyMonoCount(const Poly *p)
+{
+	uint32_t count = 0;
+	for(Mono *iter = p->ml.first; iter != NULL; iter = iter->next)
+	{
+		count++;
+	}
+	return count;
+}
+
+bool MappedPolySaveToFile(const Poly *p, const char *path)
+{
+	MappedHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAPPED_MAGIC, sizeof(header.magic));
+	header.version = MAPPED_VERSION;
+	header.byteOrder = MAPPED_BYTE_ORDER;
+	header.rootC = PolyIsCoeff(p) ? p->c : 0;
+	header.rootFirst = 0;
+	header.rootCount = PolyMonoCount(p);
+	header.monoCount = PolyMonoCountDeep(p);
+
+	size_t total = (size_t)header.monoCount;
+	MappedMono *records = calloc(total > 0 ? total : 1, sizeof(MappedMono));
+	const Poly **coeffs = malloc((total > 0 ? total : 1) * sizeof(const Poly *));
+	assert(records != NULL && coeffs != NULL);
+
+	/* jednomiany układamy wszerz – każdy wielomian dostaje ciągły fragment tablicy */
+	size_t next = 0;
+	for(Mono *iter = p->ml.first; iter != NULL; iter = iter->next)
+	{
+		records[next].exp = iter->exp;
+		coeffs[next] = &(iter->p);
+		next++;
+	}
+	for(size_t i = 0; i < total; i++)
+	{
+		const Poly *coeff = coeffs[i];
+		if(PolyIsCoeff(coeff))
+		{
+			records[i].c = coeff->c;
+			continue;
+		}
+		records[i].first = next;
+		records[i].count = PolyMonoCount(coeff);
+		for(Mono *iter = coeff->ml.first; iter != NULL; iter = iter->next)
+		{
+			records[next].exp = iter->exp;
+			coeffs[next] = &(iter->p);
+			next++;
+		}
+	}
+	free(coeffs);
+
+	bool ok = false;
+	FILE *file = fopen(path, "wb");
+	if(file != NULL)
+	{
+		ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+		ok = ok && (fwrite(records, sizeof(MappedMono), total, file) == total);
+		ok = (fclose(file) == 0) && ok;
+	}
+	free(records);
+	return ok;
+}
+
+/**
+ * Sprawdza, czy fragment tablicy rekordów jest poprawną listą jednomianów wielomianu:
+ * wykładniki są nieujemne i rosnące, współczynniki niezerowe, a wielomian
+ * stały nie jest zapisany jako jednomian
+ * @param[in] monos : tablica rekordów
+ * @param[in] first : indeks pierwszego jednomianu
+ * @param[in] count : liczba jednomianów
+ * @return Czy fragment jest poprawny
+ */
+static bool MappedMonosAreValid(const MappedMono *monos, uint64_t first, uint32_t count)
+{
+	for(uint64_t i = first; i < first + count; i++)
+	{
+		if(monos[i].exp < 0 || (i > first && monos[i].exp <= monos[i - 1].exp))
+		{
+			return false;
+		}
+		if(monos[i].count == 0 && monos[i].c == 0)
+		{
+			return false;
+		}
+	}
+	return !(count == 1 && monos[first].exp == 0 && monos[first].count == 0);
+}
+
+/**
+ * Sprawdza poprawność odwzorowanego pliku.
+ * Wymaga, by listy jednomianów były ułożone w kolejności, w jakiej zapisuje je
+ * MappedPolySaveToFile(), dzięki czemu sprawdzenie zajmuje czas liniowy
+ * i gwarantuje brak cykli.
+ * @param[in] base : początek odwzorowanej pamięci
+ * @param[in] size : rozmiar odwzorowanej pamięci
+ * @return Czy plik jest poprawny
+ */
+static bool MappedFileIsValid(const void *base, size_t size)
+{
+	if(size < sizeof(MappedHeader))
+	{
+		return false;
+	}
+	const MappedHeader *header = base;
+	const MappedMono *monos = (const MappedMono *)(header + 1);
+
+	if(memcmp(header->magic, MAPPED_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != MAPPED_VERSION || header->byteOrder != MAPPED_BYTE_ORDER)
+	{
+		return false;
+	}
+	if(header->monoCount != (size - sizeof(MappedHeader)) / sizeof(MappedMono) ||
+		(size - sizeof(MappedHeader)) % sizeof(MappedMono) != 0)
+	{
+		return false;
+	}
+	if(header->rootFirst != 0 || header->rootCount > header->monoCount ||
+		!MappedMonosAreValid(monos, 0, header->rootCount))
+	{
+		return false;
+	}
+
+	uint64_t next = header->rootCount;
+	for(uint64_t i = 0; i < header->monoCount; i++)
+	{
+		if(i >= next)
+		{
+			return false;
+		}
+		if(monos[i].count == 0)
+		{
+			continue;
+		}
+		if(monos[i].first != next || monos[i].count > header->monoCount - next ||
+			!MappedMonosAreValid(monos, next, monos[i].count))
+		{
+			return false;
+		}
+		next += monos[i].count;
+	}
+	return (next == header->monoCount);
+}
+
+MappedStore *MappedStoreOpen(const char *path)
+{
+	int fd = open(path, O_RDONLY);
+	if(fd < 0)
+	{
+		return NULL;
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MappedHeader))
+	{
+		close(fd);
+		return NULL;
+	}
+	size_t size = (size_t)st.st_size;
+	void *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(base == MAP_FAILED)
+	{
+		return NULL;
+	}
+	if(!MappedFileIsValid(base, size))
+	{
+		munmap(base, size);
+		return NULL;
+	}
+
+	const MappedHeader *header = base;
+	MappedStore *store = malloc(sizeof(MappedStore));
+	assert(store != NULL);
+	store->base = base;
+	store->size = size;
+	store->root.monos = (const MappedMono *)(header + 1);
+	store->root.c = header->rootC;
+	store->root.first = header->rootFirst;
+	store->root.count = header->rootCount;
+	store->refCount = 1;
+	return store;
+}
+
+MappedStore *MappedStoreRetain(MappedStore *store)
+{
+	store->refCount++;
+	return store;
+}
+
+void MappedStoreRelease(MappedStore *store)
+{
+	if(store != NULL && --(store->refCount) == 0)
+	{
+		munmap(store->base, store->size);
+		free(store);
+	}
+}
+
+bool MappedStoreSaveToFile(const MappedStore *store, const char *path)
+{
+	/* @p path może być odwzorowanym plikiem – nadpisanie go w miejscu zepsułoby odwzorowanie */
+	size_t pathLength = strlen(path);
+	char *tmpPath = malloc(pathLength + sizeof(MAPPED_TMP_SUFFIX));
+	assert(tmpPath != NULL);
+	memcpy(tmpPath, path, pathLength);
+	memcpy(tmpPath + pathLength, MAPPED_TMP_SUFFIX, sizeof(MAPPED_TMP_SUFFIX));
+
+	bool ok = false;
+	FILE *file = fopen(tmpPath, "wb");
+	if(file != NULL)
+	{
+		ok = (fwrite(store->base, 1, store->size, file) == store->size);
+		ok = (fclose(file) == 0) && ok;
+		ok = ok && (rename(tmpPath, path) == 0);
+		if(!ok)
+		{
+			unlink(tmpPath);
+		}
+	}
+	free(tmpPath);
+	return ok;
+}
+
+Poly MappedPolyToPoly(const MappedPoly *p)
+{
+	Poly res = PolyFromCoeff(p->c);
+	for(uint64_t i = p->first; i < p->first + p->count; i++)
+	{
+		MappedPoly coeff = MappedMonoCoeff(p, &(p->monos[i]));
+		Mono *m = MonoMallocEmpty();
+		m->exp = p->monos[i].exp;
+		m->p = MappedPolyToPoly(&coeff);
+		MonoListAppendMono(&(res.ml), m);
+	}
+	if(!MappedPolyIsCoeff(p))
+	{
+		res.c = 0;
+	}
+	return res;
+}
+
+void PrintMappedPoly(const MappedPoly *p)
+{
+	if(MappedPolyIsCoeff(p))
+	{
+		OutputLong(p->c);
+		return;
+	}
+	for(uint64_t i = p->first; i < p->first + p->count; i++)
+	{
+		MappedPoly coeff = MappedMonoCoeff(p, &(p->monos[i]));
+		if(i > p->first)
+		{
+			OutputChar('+');
+		}
+		OutputChar('(');
+		PrintMappedPoly(&coeff);
+		OutputChar(',');
+		OutputInt(p->monos[i].exp);
+		OutputChar(')');
+	}
+}
+
+poly_exp_t MappedPolyDeg(const MappedPoly *p)
+{
+	if(MappedPolyIsZero(p))
+	{
+		return (-1);
+	}
+	poly_exp_t maxExp = (MappedPolyIsCoeff(p) ? 0 : (-1));
+	for(uint64_t i = p->first; i < p->first + p->count; i++)
+	{
+		MappedPoly coeff = MappedMonoCoeff(p, &(p->monos[i]));
+		poly_exp_t currPolyDeg = MappedPolyDeg(&coeff) + p->monos[i].exp;
+		if(currPolyDeg > maxExp)
+		{
+			maxExp = currPolyDeg;
+		}
+	}
+	return maxExp;
+}
+
+poly_exp_t MappedPolyDegBy(const MappedPoly *p, unsigned var_idx)
+{
+	if(MappedPolyIsZero(p))
+	{
+		return (-1);
+	}
+	if(MappedPolyIsCoeff(p))
+	{
+		return 0;
+	}
+	if(var_idx == 0)
+	{
+		return p->monos[p->first + p->count - 1].exp;
+	}
+	poly_exp_t maxExp = (-1);
+	for(uint64_t i = p->first; i < p->first + p->count; i++)
+	{
+		MappedPoly coeff = MappedMonoCoeff(p, &(p->monos[i]));
+		poly_exp_t currPolyDeg = MappedPolyDegBy(&coeff, var_idx - 1);
+		if(currPolyDeg > maxExp)
+		{
+			maxExp = currPolyDeg;
+		}
+	}
+	return maxExp;
+}
+
+bool MappedPolyIsEq(const MappedPoly *p, const Poly *q)
+{
+	if(MappedPolyIsCoeff(p) && PolyIsCoeff(q))
+	{
+		return (p->c == q->c);
+	}
+	Mono *iterQ = q->ml.first;
+	for(uint64_t i = p->first; i < p->first + p->count; i++)
+	{
+		if(iterQ == NULL || iterQ->exp != p->monos[i].exp)
+		{
+			return false;
+		}
+		MappedPoly coeff = MappedMonoCoeff(p, &(p->monos[i]));
+		if(!MappedPolyIsEq(&coeff, &(iterQ->p)))
+		{
+			return false;
+		}
+		iterQ = iterQ->next;
+	}
+	return (iterQ == NULL);
+}
+
+bool MappedPolyIsEqMapped(const MappedPoly *p, const MappedPoly *q)
+{
+	if(MappedPolyIsCoeff(p) && MappedPolyIsCoeff(q))
+	{
+		return (p->c == q->c);
+	}
+	if(p->count != q->count)
+	{
+		return false;
+	}
+	for(uint32_t i = 0; i < p->count; i++)
+	{
+		const MappedMono *mp = &(p->monos[p->first + i]);
+		const MappedMono *mq = &(q->monos[q->first + i]);
+		MappedPoly coeffP = MappedMonoCoeff(p, mp);
+		MappedPoly coeffQ = MappedMonoCoeff(q, mq);
+		if(mp->exp != mq->exp || !MappedPolyIsEqMapped(&coeffP, &coeffQ))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Do listy jednomianów @p ml dodaje kopie jednomianów odwzorowanego wielomianu @p p
+ * (zob. MonoListAppendCopiedMonosFromPoly())
+ * @param[in] ml : lista jednomianów
+ * @param[in] p : odwzorowany wielomian
+ */
+static void MonoListAppendCopiedMonosFromMapped(MonoList *ml, const MappedPoly *p)
+{
+	if(MappedPolyIsCoeff(p))
+	{
+		if(!MappedPolyIsZero(p))
+		{
+			Mono *m = MonoMallocEmpty();
+			m->p = PolyFromCoeff(p->c);
+			MonoListAppendMono(ml, m);
+		}
+		return;
+	}
+	for(uint64_t i = p->first; i < p->first + p->count; i++)
+	{
+		MappedPoly coeff = MappedMonoCoeff(p, &(p->monos[i]));
+		Mono *m = MonoMallocEmpty();
+		m->exp = p->monos[i].exp;
+		m->p = MappedPolyToPoly(&coeff);
+		MonoListAppendMono(ml, m);
+	}
+}
+
+Poly PolyAddMapped(const Poly *p, const MappedPoly *q)
+{
+	if(PolyIsCoeff(p) && MappedPolyIsCoeff(q))
+	{
+		return PolyFromCoeff(p->c + q->c);
+	}
+	MonoList ml = EmptyMonoList();
+
+	MonoListAppendCopiedMonosFromPoly(&ml, p);
+	MonoListAppendCopiedMonosFromMapped(&ml, q);
+
+	return PolyAddMonosFromMonoList(&ml);
+}
+
+/**
+ * Dodaje do listy @p ml jednomian `p * x^exp`, jeśli @p p nie jest zerowy.
+ * Przejmuje na własność zawartość @p p.
+ * @param[in] ml : lista jednomianów
+ * @param[in] p : współczynnik
+ * @param[in] exp : wykładnik
+ */
+static void MonoListAppendNonZero(MonoList *ml, Poly *p, poly_exp_t exp)
+{
+	if(PolyIsZero(p))
+	{
+		PolyDestroy(p);
+		return;
+	}
+	Mono *m = MonoMallocEmpty();
+	m->p = *p;
+	m->exp = exp;
+	MonoListAppendMono(ml, m);
+}
+
+Poly PolyMulMapped(const Poly *p, const MappedPoly *q)
+{
+	if(PolyIsZero(p) || MappedPolyIsZero(q))
+	{
+		return PolyZero();
+	}
+	if(MappedPolyIsCoeff(q))
+	{
+		Poly qCoeff = PolyFromCoeff(q->c);
+		return PolyMul(p, &qCoeff);
+	}
+
+	MonoList res = EmptyMonoList();
+	if(PolyIsCoeff(p))
+	{
+		for(uint64_t i = q->first; i < q->first + q->count; i++)
+		{
+			MappedPoly coeff = MappedMonoCoeff(q, &(q->monos[i]));
+			Poly mul = PolyMulMapped(p, &coeff);
+			MonoListAppendNonZero(&res, &mul, q->monos[i].exp);
+		}
+	}
+	else
+	{
+		for(Mono *iterP = p->ml.first; iterP != NULL; iterP = iterP->next)
+		{
+			for(uint64_t i = q->first; i < q->first + q->count; i++)
+			{
+				MappedPoly coeff = MappedMonoCoeff(q, &(q->monos[i]));
+				Poly mul = PolyMulMapped(&(iterP->p), &coeff);
+				MonoListAppendNonZero(&res, &mul, iterP->exp + q->monos[i].exp);
+			}
+		}
+	}
+	return PolyAddMonosFromMonoList(&res);
+}
+
+Poly MappedPolyAt(const MappedPoly *p, poly_coeff_t x)
+{
+	if(MappedPolyIsCoeff(p))
+	{
+		return PolyFromCoeff(p->c);
+	}
+
+	MonoList ml = EmptyMonoList();
+	for(uint64_t i = p->first; i < p->first + p->count; i++)
+	{
+		MappedPoly coeff = MappedMonoCoeff(p, &(p->monos[i]));
+		Poly power = PolyFromCoeff(PowI(x, p->monos[i].exp));
+		Poly mul = PolyMulMapped(&power, &coeff);
+		if(PolyIsCoeff(&mul))
+		{
+			MonoListAppendNonZero(&ml, &mul, 0);
+		}
+		else
+		{
+			MonoListAppendCopiedMonosFromPoly(&ml, &mul);
+			PolyDestroy(&mul);
+		}
+	}
+	return PolyAddMonosFromMonoList(&ml);
+}
@@ -0,0 +1,218 @@
+/** @file
+   Interfejs wielomianów odwzorowanych w pamięci (tylko do odczytu)
+
+   Plik z wielomianem ma postać nagłówka (MappedHeader), po którym następuje
+   tablica rekordów MappedMono. Jednomiany każdego wielomianu zajmują ciągły
+   fragment tablicy (posortowany rosnąco po wykładnikach), a współczynnik
+   jednomianu wskazuje na swoje jednomiany indeksem w tablicy zamiast wskaźnikiem.
+   Dzięki temu plik można odwzorować w pamięci (`mmap`) i od razu
+   wykonywać na nim operacje, bez wczytywania go do struktur Poly.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-14
+*/
+#ifndef __MAPPED_H__
+#define __MAPPED_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "poly.h"
+
+/** Sygnatura pliku z odwzorowywanym wielomianem */
+#define MAPPED_MAGIC "IPPM"
+/** Wersja formatu pliku z odwzorowywanym wielomianem */
+#define MAPPED_VERSION 1
+/** Znacznik kolejności bajtów (plik jest czytelny tylko na maszynie o tej samej kolejności) */
+#define MAPPED_BYTE_ORDER 0x01020304u
+
+/**
+ * Rekord jednomianu w pliku z odwzorowywanym wielomianem
+ */
+typedef struct MappedMono
+{
+	/** Stała (w przypadku, gdy współczynnik jednomianu jest stałą) */
+	int64_t c;
+	/** Indeks pierwszego jednomianu współczynnika w tablicy rekordów */
+	uint64_t first;
+	/** Liczba jednomianów współczynnika (0, gdy współczynnik jest stałą) */
+	uint32_t count;
+	int32_t exp; ///< wykładnik
+} MappedMono;
+
+/**
+ * Nagłówek pliku z odwzorowywanym wielomianem
+ */
+typedef struct MappedHeader
+{
+	char magic[4]; ///< sygnatura MAPPED_MAGIC
+	uint32_t version; ///< wersja formatu
+	uint32_t byteOrder; ///< znacznik MAPPED_BYTE_ORDER
+	uint32_t rootCount; ///< liczba jednomianów wielomianu
+	uint64_t rootFirst; ///< indeks pierwszego jednomianu wielomianu
+	int64_t rootC; ///< stała (w przypadku, gdy wielomian jest stałą)
+	uint64_t monoCount; ///< liczba rekordów jednomianów w pliku
+} MappedHeader;
+
+/**
+ * Widok (tylko do odczytu) wielomianu zapisanego w odwzorowanym pliku
+ */
+typedef struct MappedPoly
+{
+	const MappedMono *monos; ///< tablica wszystkich rekordów pliku
+	poly_coeff_t c; ///< stała (w przypadku, gdy wielomian jest stałą)
+	uint64_t first; ///< indeks pierwszego jednomianu
+	uint32_t count; ///< liczba jednomianów (0, gdy wielomian jest stałą)
+} MappedPoly;
+
+/**
+ * Odwzorowany w pamięci plik z wielomianem.
+ * Może być współdzielony, jest zwalniany, gdy licznik odwołań spadnie do zera.
+ */
+typedef struct MappedStore
+{
+	void *base; ///< początek odwzorowanej pamięci
+	size_t size; ///< rozmiar odwzorowanej pamięci
+	MappedPoly root; ///< wielomian zapisany w pliku
+	unsigned refCount; ///< licznik odwołań
+} MappedStore;
+
+/**
+ * Zwraca widok współczynnika jednomianu @p m
+ * @param[in] p : wielomian, do którego należy jednomian
+ * @param[in] m : jednomian
+ * @return widok współczynnika
+ */
+static inline MappedPoly MappedMonoCoeff(const MappedPoly *p, const MappedMono *m)
+{
+	return (MappedPoly) {.monos = p->monos, .c = m->c, .first = m->first, .count = m->count};
+}
+
+/**
+ * Sprawdza, czy odwzorowany wielomian jest współczynnikiem.
+ * @param[in] p : wielomian
+ * @return Czy wielomian jest współczynnikiem?
+ */
+static inline bool MappedPolyIsCoeff(const MappedPoly *p)
+{
+	return (p->count == 0);
+}
+
+/**
+ * Sprawdza, czy odwzorowany wielomian jest tożsamościowo równy zeru.
+ * @param[in] p : wielomian
+ * @return Czy wielomian jest równy zero?
+ */
+static inline bool MappedPolyIsZero(const MappedPoly *p)
+{
+	return (MappedPolyIsCoeff(p) && p->c == 0);
+}
+
+/**
+ * Zapisuje wielomian do pliku w formacie nadającym się do odwzorowania w pamięci
+ * @param[in] p : wielomian
+ * @param[in] path : ścieżka do pliku
+ * @return Czy zapis się powiódł
+ */
+bool MappedPolySaveToFile(const Poly *p, const char *path);
+
+/**
+ * Odwzorowuje w pamięci plik z wielomianem i sprawdza poprawność jego struktury
+ * @param[in] path : ścieżka do pliku
+ * @return odwzorowany plik (z licznikiem odwołań równym 1) lub NULL w przypadku błędu
+ */
+MappedStore *MappedStoreOpen(const char *path);
+
+/**
+ * Zwiększa licznik odwołań do odwzorowanego pliku
+ * @param[in] store : odwzorowany plik
+ * @return @p store
+ */
+MappedStore *MappedStoreRetain(MappedStore *store);
+
+/**
+ * Zmniejsza licznik odwołań do odwzorowanego pliku i zwalnia go,
+ * gdy nie ma już do niego odwołań
+ * @param[in] store : odwzorowany plik
+ */
+void MappedStoreRelease(MappedStore *store);
+
+/**
+ * Zapisuje do pliku kopię odwzorowanego pliku (w formacie do odwzorowania
+ * w pamięci, zob. MappedPolySaveToFile())
+ * @param[in] store : odwzorowany plik
+ * @param[in] path : ścieżka do pliku
+ * @return Czy zapis się powiódł
+ */
+bool MappedStoreSaveToFile(const MappedStore *store, const char *path);
+
+/**
+ * Tworzy zwykły wielomian (głęboką kopię) z odwzorowanego wielomianu
+ * @param[in] p : odwzorowany wielomian
+ * @return wielomian
+ */
+Poly MappedPolyToPoly(const MappedPoly *p);
+
+/**
+ * Wypisuje odwzorowany wielomian na standardowe wyjście (tak jak PrintPoly())
+ * @param[in] p : odwzorowany wielomian
+ */
+void PrintMappedPoly(const MappedPoly *p);
+
+/**
+ * Zwraca stopień odwzorowanego wielomianu (-1 dla wielomianu tożsamościowo równego zeru).
+ * @param[in] p : wielomian
+ * @return stopień wielomianu @p p
+ */
+poly_exp_t MappedPolyDeg(const MappedPoly *p);
+
+/**
+ * Zwraca stopień odwzorowanego wielomianu ze względu na zadaną zmienną
+ * (zob. PolyDegBy())
+ * @param[in] p : wielomian
+ * @param[in] var_idx : indeks zmiennej
+ * @return stopień wielomianu @p p z względu na zmienną o indeksie @p var_idx
+ */
+poly_exp_t MappedPolyDegBy(const MappedPoly *p, unsigned var_idx);
+
+/**
+ * Sprawdza równość odwzorowanego wielomianu i zwykłego wielomianu.
+ * @param[in] p : odwzorowany wielomian
+ * @param[in] q : wielomian
+ * @return `p = q`
+ */
+bool MappedPolyIsEq(const MappedPoly *p, const Poly *q);
+
+/**
+ * Sprawdza równość dwóch odwzorowanych wielomianów.
+ * @param[in] p : odwzorowany wielomian
+ * @param[in] q : odwzorowany wielomian
+ * @return `p = q`
+ */
+bool MappedPolyIsEqMapped(const MappedPoly *p, const MappedPoly *q);
+
+/**
+ * Wylicza wartość odwzorowanego wielomianu w punkcie @p x (zob. PolyAt()).
+ * @param[in] p : odwzorowany wielomian
+ * @param[in] x : punkt
+ * @return @f$p(x, x_0, x_1, \ldots)@f$
+ */
+Poly MappedPolyAt(const MappedPoly *p, poly_coeff_t x);
+
+/**
+ * Dodaje wielomian i odwzorowany wielomian.
+ * @param[in] p : wielomian
+ * @param[in] q : odwzorowany wielomian
+ * @return `p + q`
+ */
+Poly PolyAddMapped(const Poly *p, const MappedPoly *q);
+
+/**
+ * Mnoży wielomian i odwzorowany wielomian.
+ * @param[in] p : wielomian
+ * @param[in] q : odwzorowany wielomian
+ * @return `p * q`
+ */
+Poly PolyMulMapped(const Poly *p, const MappedPoly *q);
+
+#endif /* __MAPPED_H__ */
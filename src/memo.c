@@ -0,0 +1,409 @@
+#include "memo.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "utils.h"
+
+/** Początkowa liczba kubełków tablicy z haszowaniem */
+#define MEMO_INITIAL_BUCKETS 64
+
+/**
+ * Rodzaje zapamiętywanych operacji
+ */
+typedef enum MemoKind
+{
+	MEMO_MUL, ///< PolyMul()
+	MEMO_COMPOSE ///< PolyCompose()
+} MemoKind;
+
+/**
+ * Zapamiętany wynik operacji
+ */
+typedef struct MemoEntry
+{
+	MemoKind kind; ///< rodzaj operacji
+	uint64_t hash; ///< skrót argumentów i rodzaju operacji
+	unsigned argCount; ///< liczba argumentów
+	Poly *args; ///< kopie argumentów (do potwierdzania trafień)
+	Poly result; ///< wynik operacji
+	size_t bytes; ///< szacowany rozmiar wpisu (w bajtach)
+	struct MemoEntry *newer; ///< wpis używany później (lub NULL)
+	struct MemoEntry *older; ///< wpis używany wcześniej (lub NULL)
+	struct MemoEntry *nextInBucket; ///< kolejny wpis w tym samym kubełku
+} MemoEntry;
+
+/** Budżet pamięci podręcznej (w bajtach); 0 oznacza, że jest wyłączona */
+static atomic_size_t memoBudget = 0;
+/** Kubełki tablicy z haszowaniem */
+static MemoEntry **memoBuckets = NULL;
+/** Liczba kubełków (potęga dwójki) */
+static size_t memoBucketCount = 0;
+/** Ostatnio używany wpis */
+static MemoEntry *memoNewest = NULL;
+/** Najdawniej używany wpis (pierwszy do usunięcia) */
+static MemoEntry *memoOldest = NULL;
+/** Liczniki pamięci podręcznej */
+static MemoStats memoStats;
+/**
+ * Blokada pamięci podręcznej (wspólnej dla wszystkich wątków, np. sesji
+ * serwera); obliczenia wyników odbywają się bez niej
+ */
+static pthread_mutex_t memoLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Miesza wartość @p v ze skrótem @p h (funkcja mieszająca SplitMix64)
+ * @param[in] h : skrót
+ * @param[in] v : wartość
+ * @return nowy skrót
+ */
+static uint64_t MemoMix(uint64_t h, uint64_t v)
+{
+	uint64_t z = h + v + 0x9e3779b97f4a7c15ULL;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * Liczy skrót struktury wielomianu (równe wielomiany mają równe skróty)
+ * @param[in] p : wielomian
+ * @return skrót
+ */
+static uint64_t MemoPolyHash(const Poly *p)
+{
+	if(PolyIsCoeff(p))
+	{
+		return MemoMix(0, (uint64_t)p->c);
+	}
+	uint64_t h = 1;
+	for(Mono *iter = p->ml.first; iter != NULL; iter = iter->next)
+	{
+		h = MemoMix(h, (uint64_t)iter->exp);
+		h = MemoMix(h, MemoPolyHash(&(iter->p)));
+	}
+	return h;
+}
+
+/**
+ * Odłącza wpis od listy kolejności użycia
+ * @param[in] entry : wpis
+ */
+static void MemoUnlinkLru(MemoEntry *entry)
+{
+	if(entry->newer != NULL)
+	{
+		entry->newer->older = entry->older;
+	}
+	else
+	{
+		memoNewest = entry->older;
+	}
+	if(entry->older != NULL)
+	{
+		entry->older->newer = entry->newer;
+	}
+	else
+	{
+		memoOldest = entry->newer;
+	}
+	entry->newer = entry->older = NULL;
+}
+
+/**
+ * Wstawia wpis na początek listy kolejności użycia (jako ostatnio używany)
+ * @param[in] entry : wpis
+ */
+static void MemoPushNewest(MemoEntry *entry)
+{
+	entry->newer = NULL;
+	entry->older = memoNewest;
+	if(memoNewest != NULL)
+	{
+		memoNewest->newer = entry;
+	}
+	else
+	{
+		memoOldest = entry;
+	}
+	memoNewest = entry;
+}
+
+/**
+ * Wstawia wpis do kubełka wyznaczonego przez jego skrót
+ * @param[in] entry : wpis
+ */
+static void MemoBucketInsert(MemoEntry *entry)
+{
+	size_t bucket = (size_t)entry->hash & (memoBucketCount - 1);
+	entry->nextInBucket = memoBuckets[bucket];
+	memoBuckets[bucket] = entry;
+}
+
+/**
+ * Podwaja liczbę kubełków, jeśli wpisów jest więcej niż kubełków
+ */
+static void MemoGrowBuckets()
+{
+	if(memoStats.entries < memoBucketCount)
+	{
+		return;
+	}
+	size_t newCount = memoBucketCount == 0 ? MEMO_INITIAL_BUCKETS : 2 * memoBucketCount;
+	free(memoBuckets);
+	memoBuckets = calloc(newCount, sizeof(MemoEntry*));
+	assert(memoBuckets != NULL);
+	memoBucketCount = newCount;
+	for(MemoEntry *entry = memoNewest; entry != NULL; entry = entry->older)
+	{
+		MemoBucketInsert(entry);
+	}
+}
+
+/**
+ * Usuwa wpis z pamięci podręcznej i zwalnia go
+ * @param[in] entry : wpis
+ */
+static void MemoRemove(MemoEntry *entry)
+{
+	MemoEntry **link = &(memoBuckets[(size_t)entry->hash & (memoBucketCount - 1)]);
+	while(*link != entry)
+	{
+		link = &((*link)->nextInBucket);
+	}
+	*link = entry->nextInBucket;
+	MemoUnlinkLru(entry);
+
+	for(unsigned i = 0; i < entry->argCount; i++)
+	{
+		PolyDestroy(&(entry->args[i]));
+	}
+	free(entry->args);
+	PolyDestroy(&(entry->result));
+	memoStats.entries--;
+	memoStats.bytes -= entry->bytes;
+	free(entry);
+}
+
+/**
+ * Usuwa najdawniej używane wpisy, dopóki rozmiar pamięci podręcznej przekracza budżet
+ */
+static void MemoEvict()
+{
+	while(memoStats.bytes > memoBudget && memoOldest != NULL)
+	{
+		MemoRemove(memoOldest);
+		memoStats.evictions++;
+	}
+}
+
+/**
+ * Sprawdza, czy wpis dotyczy operacji na podanych argumentach
+ * (mnożenie jest przemienne, więc jego argumenty porównywane są w obu kolejnościach)
+ * @param[in] entry : wpis
+ * @param[in] kind : rodzaj operacji
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return Czy wpis pasuje
+ */
+static bool MemoEntryMatches(const MemoEntry *entry, MemoKind kind, unsigned argCount, const Poly *args[])
+{
+	if(entry->kind != kind || entry->argCount != argCount)
+	{
+		return false;
+	}
+	bool equal = true;
+	for(unsigned i = 0; i < argCount && equal; i++)
+	{
+		equal = PolyIsEq(&(entry->args[i]), args[i]);
+	}
+	if(!equal && kind == MEMO_MUL)
+	{
+		equal = PolyIsEq(&(entry->args[0]), args[1]) && PolyIsEq(&(entry->args[1]), args[0]);
+	}
+	return equal;
+}
+
+/**
+ * Szuka w pamięci podręcznej wyniku operacji
+ * @param[in] kind : rodzaj operacji
+ * @param[in] hash : skrót argumentów i rodzaju operacji
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return wpis z wynikiem lub NULL, jeśli wyniku nie zapamiętano
+ */
+static MemoEntry *MemoFind(MemoKind kind, uint64_t hash, unsigned argCount, const Poly *args[])
+{
+	if(memoBucketCount == 0)
+	{
+		return NULL;
+	}
+	MemoEntry *entry = memoBuckets[(size_t)hash & (memoBucketCount - 1)];
+	for(; entry != NULL; entry = entry->nextInBucket)
+	{
+		if(entry->hash == hash)
+		{
+			if(MemoEntryMatches(entry, kind, argCount, args))
+			{
+				return entry;
+			}
+			memoStats.collisions++;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Zapamiętuje wynik operacji (o ile mieści się w budżecie)
+ * @param[in] kind : rodzaj operacji
+ * @param[in] hash : skrót argumentów i rodzaju operacji
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @param[in] result : wynik operacji
+ */
+static void MemoInsert(MemoKind kind, uint64_t hash, unsigned argCount, const Poly *args[],
+	const Poly *result)
+{
+	uint64_t monos = PolyMonoCountDeep(result);
+	for(unsigned i = 0; i < argCount; i++)
+	{
+		monos += PolyMonoCountDeep(args[i]);
+	}
+	uint64_t bytes = sizeof(MemoEntry) + argCount * sizeof(Poly) + monos * sizeof(Mono);
+	if(bytes > memoBudget)
+	{
+		return;
+	}
+
+	MemoEntry *entry = malloc(sizeof(MemoEntry));
+	assert(entry != NULL);
+	entry->kind = kind;
+	entry->hash = hash;
+	entry->argCount = argCount;
+	entry->args = malloc(argCount * sizeof(Poly));
+	assert(entry->args != NULL);
+	for(unsigned i = 0; i < argCount; i++)
+	{
+		entry->args[i] = PolyClone(args[i]);
+	}
+	entry->result = PolyClone(result);
+	entry->bytes = (size_t)bytes;
+
+	memoStats.entries++;
+	memoStats.bytes += entry->bytes;
+	MemoGrowBuckets();
+	MemoBucketInsert(entry);
+	MemoPushNewest(entry);
+	MemoEvict();
+}
+
+/**
+ * Zwraca kopię zapamiętanego wyniku i oznacza wpis jako ostatnio używany
+ * @param[in] entry : wpis
+ * @return wynik operacji
+ */
+static Poly MemoHit(MemoEntry *entry)
+{
+	memoStats.hits++;
+	MemoUnlinkLru(entry);
+	MemoPushNewest(entry);
+	return PolyClone(&(entry->result));
+}
+
+void MemoSetBudget(size_t bytes)
+{
+	pthread_mutex_lock(&memoLock);
+	memoBudget = bytes;
+	MemoEvict();
+	pthread_mutex_unlock(&memoLock);
+}
+
+Poly MemoMul(const Poly *p, const Poly *q)
+{
+	/* mnożenie przez stałą jest tańsze od szukania wyniku */
+	if(atomic_load_explicit(&memoBudget, memory_order_relaxed) == 0 || PolyIsCoeff(p) || PolyIsCoeff(q))
+	{
+		return PolyMul(p, q);
+	}
+	uint64_t hp = MemoPolyHash(p), hq = MemoPolyHash(q);
+	/* mnożenie jest przemienne – skrót nie zależy od kolejności argumentów */
+	uint64_t hash = hp < hq ? MemoMix(MemoMix(MEMO_MUL, hp), hq) : MemoMix(MemoMix(MEMO_MUL, hq), hp);
+	const Poly *args[2] = {p, q};
+
+	pthread_mutex_lock(&memoLock);
+	MemoEntry *entry = MemoFind(MEMO_MUL, hash, 2, args);
+	if(entry != NULL)
+	{
+		Poly mul = MemoHit(entry);
+		pthread_mutex_unlock(&memoLock);
+		return mul;
+	}
+	memoStats.misses++;
+	pthread_mutex_unlock(&memoLock);
+	Poly mul = PolyMul(p, q);
+	pthread_mutex_lock(&memoLock);
+	MemoInsert(MEMO_MUL, hash, 2, args, &mul);
+	pthread_mutex_unlock(&memoLock);
+	return mul;
+}
+
+Poly MemoCompose(const Poly *p, unsigned count, const Poly x[])
+{
+	if(atomic_load_explicit(&memoBudget, memory_order_relaxed) == 0 || PolyIsCoeff(p))
+	{
+		return PolyCompose(p, count, x);
+	}
+	const Poly **args = malloc((count + 1) * sizeof(Poly*));
+	assert(args != NULL);
+	args[0] = p;
+	uint64_t hash = MemoMix(MemoMix(MEMO_COMPOSE, count), MemoPolyHash(p));
+	for(unsigned i = 0; i < count; i++)
+	{
+		args[i + 1] = &(x[i]);
+		hash = MemoMix(hash, MemoPolyHash(&(x[i])));
+	}
+
+	Poly composed;
+	pthread_mutex_lock(&memoLock);
+	MemoEntry *entry = MemoFind(MEMO_COMPOSE, hash, count + 1, args);
+	if(entry != NULL)
+	{
+		composed = MemoHit(entry);
+		pthread_mutex_unlock(&memoLock);
+	}
+	else
+	{
+		memoStats.misses++;
+		pthread_mutex_unlock(&memoLock);
+		composed = PolyCompose(p, count, x);
+		pthread_mutex_lock(&memoLock);
+		MemoInsert(MEMO_COMPOSE, hash, count + 1, args, &composed);
+		pthread_mutex_unlock(&memoLock);
+	}
+	free(args);
+	return composed;
+}
+
+MemoStats MemoGetStats()
+{
+	pthread_mutex_lock(&memoLock);
+	MemoStats stats = memoStats;
+	stats.budget = memoBudget;
+	pthread_mutex_unlock(&memoLock);
+	return stats;
+}
+
+void MemoClear()
+{
+	pthread_mutex_lock(&memoLock);
+	while(memoOldest != NULL)
+	{
+		MemoRemove(memoOldest);
+	}
+	free(memoBuckets);
+	memoBuckets = NULL;
+	memoBucketCount = 0;
+	memoStats = (MemoStats) {.hits = 0, .misses = 0, .collisions = 0, .evictions = 0,
+		.entries = 0, .bytes = 0, .budget = 0};
+	pthread_mutex_unlock(&memoLock);
+}
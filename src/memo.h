@@ -0,0 +1,71 @@
+/** @file
+   Interfejs pamięci podręcznej wyników mnożenia i składania wielomianów
+
+   Wyniki PolyMul() i PolyCompose() są zapamiętywane pod skrótem struktury
+   argumentów i rodzaju operacji (dla składania – także liczby i listy
+   podstawianych wielomianów). Trafienie jest potwierdzane porównaniem
+   argumentów funkcją PolyIsEq(), więc kolizja skrótów nie może dać złego
+   wyniku. Łączny rozmiar zapamiętanych wielomianów jest ograniczony budżetem
+   pamięci; po jego przekroczeniu usuwane są najdawniej używane wyniki.
+   Domyślnie (przy zerowym budżecie) pamięć podręczna jest wyłączona.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-22
+*/
+#ifndef __MEMO_H__
+#define __MEMO_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "poly.h"
+
+/**
+ * Liczniki pamięci podręcznej
+ */
+typedef struct MemoStats
+{
+	uint64_t hits; ///< liczba trafień
+	uint64_t misses; ///< liczba chybień
+	uint64_t collisions; ///< liczba zgodnych skrótów przy różnych argumentach
+	uint64_t evictions; ///< liczba wyników usuniętych z powodu budżetu
+	size_t entries; ///< liczba zapamiętanych wyników
+	size_t bytes; ///< szacowany rozmiar zapamiętanych wyników (w bajtach)
+	size_t budget; ///< budżet pamięci (w bajtach)
+} MemoStats;
+
+/**
+ * Ustawia budżet pamięci podręcznej i usuwa wyniki, które się w nim nie mieszczą
+ * @param[in] bytes : budżet w bajtach (0 wyłącza pamięć podręczną)
+ */
+void MemoSetBudget(size_t bytes);
+
+/**
+ * Mnoży dwa wielomiany, korzystając z pamięci podręcznej (zob. PolyMul())
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @return `p * q`
+ */
+Poly MemoMul(const Poly *p, const Poly *q);
+
+/**
+ * Składa wielomiany, korzystając z pamięci podręcznej (zob. PolyCompose())
+ * @param[in] p : wielomian
+ * @param[in] count : liczba podstawianych wielomianów
+ * @param[in] x : podstawiane wielomiany
+ * @return wynik złożenia
+ */
+Poly MemoCompose(const Poly *p, unsigned count, const Poly x[]);
+
+/**
+ * Zwraca liczniki pamięci podręcznej
+ * @return liczniki
+ */
+MemoStats MemoGetStats();
+
+/**
+ * Usuwa z pamięci wszystkie zapamiętane wyniki i zeruje liczniki
+ */
+void MemoClear();
+
+#endif /* __MEMO_H__ */
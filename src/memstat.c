@@ -0,0 +1,199 @@
+#include "memstat.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "word.h"
+#include "mapped.h"
+
+#include "utils.h"
+
+/** Maksymalna długość jednego fragmentu raportu */
+#define MEMSTAT_LINE_SIZE 256
+
+/** Rozmiary węzłów kolejnych rodzajów (w bajtach) */
+static const int64_t memNodeSize[MEM_NODE_KIND_AMOUNT] =
+	{sizeof(Mono), sizeof(PolyStackElem), sizeof(WordElem)};
+/** Nazwy węzłów kolejnych rodzajów w raporcie */
+static const char *memNodeName[MEM_NODE_KIND_AMOUNT] = {"monos", "stack_elems", "word_elems"};
+
+/**
+ * Zmiany liczników pamięci w jednym wątku, jeszcze niedoliczone
+ * do wspólnych liczników
+ */
+typedef struct MemDelta
+{
+	long long live[MEM_NODE_KIND_AMOUNT]; ///< zmiany liczby żywych węzłów
+	long long bytes; ///< zmiana rozmiaru węzłów
+	unsigned updates; ///< liczba niedoliczonych zmian
+} MemDelta;
+
+/** Liczby żywych węzłów kolejnych rodzajów */
+static atomic_llong memLive[MEM_NODE_KIND_AMOUNT];
+/** Bieżący rozmiar węzłów (w bajtach) */
+static atomic_llong memBytes;
+/** Największy dotąd rozmiar węzłów (w bajtach) */
+static atomic_llong memPeakBytes;
+/** Niedoliczone zmiany liczników w bieżącym wątku */
+static _Thread_local MemDelta memDelta;
+/** Co ile wierszy raport jest wypisywany na standardowy strumień błędów (0 – wcale) */
+static atomic_size_t memStatInterval = 0;
+/** Liczba wierszy wykonanych (we wszystkich wątkach) od ustalenia odstępu między raportami */
+static atomic_size_t memStatLines = 0;
+
+void MemStatFlush()
+{
+	for(int i = 0; i < MEM_NODE_KIND_AMOUNT; i++)
+	{
+		atomic_fetch_add_explicit(&(memLive[i]), memDelta.live[i], memory_order_relaxed);
+		memDelta.live[i] = 0;
+	}
+	long long bytes = atomic_fetch_add_explicit(&memBytes, memDelta.bytes, memory_order_relaxed) +
+		memDelta.bytes;
+	memDelta.bytes = 0;
+	memDelta.updates = 0;
+	long long peak = atomic_load_explicit(&memPeakBytes, memory_order_relaxed);
+	while(bytes > peak && !atomic_compare_exchange_weak_explicit(&memPeakBytes, &peak, bytes,
+		memory_order_relaxed, memory_order_relaxed));
+}
+
+void MemStatAlloc(MemNodeKind kind, size_t count)
+{
+	memDelta.live[kind] += (long long)count;
+	memDelta.bytes += (long long)count * memNodeSize[kind];
+	if(++memDelta.updates == MEMSTAT_BATCH)
+	{
+		MemStatFlush();
+	}
+}
+
+void MemStatFree(MemNodeKind kind, size_t count)
+{
+	memDelta.live[kind] -= (long long)count;
+	memDelta.bytes -= (long long)count * memNodeSize[kind];
+	if(++memDelta.updates == MEMSTAT_BATCH)
+	{
+		MemStatFlush();
+	}
+}
+
+MemStats MemStatGet()
+{
+	MemStatFlush();
+	MemStats stats;
+	for(int i = 0; i < MEM_NODE_KIND_AMOUNT; i++)
+	{
+		stats.live[i] = atomic_load_explicit(&(memLive[i]), memory_order_relaxed);
+	}
+	stats.bytes = atomic_load_explicit(&memBytes, memory_order_relaxed);
+	stats.peakBytes = atomic_load_explicit(&memPeakBytes, memory_order_relaxed);
+	return stats;
+}
+
+/**
+ * Zwraca numer przedziału histogramu dla wielomianu o @p terms jednomianach
+ * @param[in] terms : liczba jednomianów
+ * @return numer przedziału
+ */
+static int MemStatBucket(uint64_t terms)
+{
+	int bucket = 0;
+	while(terms > 0 && bucket < MEMSTAT_HISTOGRAM_SIZE - 1)
+	{
+		terms >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+size_t MemStatHistogram(const PolyStack *pStack, size_t histogram[MEMSTAT_HISTOGRAM_SIZE])
+{
+	for(int i = 0; i < MEMSTAT_HISTOGRAM_SIZE; i++)
+	{
+		histogram[i] = 0;
+	}
+	size_t lazyCount = 0;
+	for(size_t i = 0; i < pStack->size; i++)
+	{
+		const PolyStackElem *elem = &(pStack->elems[i]);
+		if(elem->lazy != NULL)
+		{
+			lazyCount++;
+		}
+		else if(elem->mapped != NULL)
+		{
+			histogram[MemStatBucket(((const MappedHeader*)elem->mapped->base)->monoCount)]++;
+		}
+		else
+		{
+			histogram[MemStatBucket(PolyMonoCountDeep(&(elem->p)))]++;
+		}
+	}
+	return lazyCount;
+}
+
+void MemStatReport(const PolyStack *pStack, ByteBuffer *buf)
+{
+	MemStats stats = MemStatGet();
+	char line[MEMSTAT_LINE_SIZE];
+	int length;
+	for(int i = 0; i < MEM_NODE_KIND_AMOUNT; i++)
+	{
+		length = snprintf(line, MEMSTAT_LINE_SIZE, "%s=%lld ", memNodeName[i], (long long)stats.live[i]);
+		ByteBufferAppend(buf, line, (size_t)length);
+	}
+	length = snprintf(line, MEMSTAT_LINE_SIZE, "bytes=%lld peak_bytes=%lld\nsizes",
+		(long long)stats.bytes, (long long)stats.peakBytes);
+	ByteBufferAppend(buf, line, (size_t)length);
+
+	size_t histogram[MEMSTAT_HISTOGRAM_SIZE];
+	size_t lazyCount = MemStatHistogram(pStack, histogram);
+	for(int i = 0; i < MEMSTAT_HISTOGRAM_SIZE; i++)
+	{
+		if(histogram[i] == 0)
+		{
+			continue;
+		}
+		unsigned long long low = (i == 0) ? 0 : 1ULL << (i - 1);
+		unsigned long long high = (i == 0) ? 0 : (1ULL << i) - 1;
+		if(i == MEMSTAT_HISTOGRAM_SIZE - 1)
+		{
+			length = snprintf(line, MEMSTAT_LINE_SIZE, " %llu+:%zu", low, histogram[i]);
+		}
+		else if(low == high)
+		{
+			length = snprintf(line, MEMSTAT_LINE_SIZE, " %llu:%zu", low, histogram[i]);
+		}
+		else
+		{
+			length = snprintf(line, MEMSTAT_LINE_SIZE, " %llu-%llu:%zu", low, high, histogram[i]);
+		}
+		ByteBufferAppend(buf, line, (size_t)length);
+	}
+	if(lazyCount > 0)
+	{
+		length = snprintf(line, MEMSTAT_LINE_SIZE, " lazy:%zu", lazyCount);
+		ByteBufferAppend(buf, line, (size_t)length);
+	}
+	ByteBufferAppend(buf, "\n", 1);
+}
+
+void MemStatSetInterval(size_t lines)
+{
+	atomic_store_explicit(&memStatLines, 0, memory_order_relaxed);
+	atomic_store_explicit(&memStatInterval, lines, memory_order_relaxed);
+}
+
+void MemStatTick(const PolyStack *pStack)
+{
+	size_t interval = atomic_load_explicit(&memStatInterval, memory_order_relaxed);
+	if(interval == 0 ||
+		(atomic_fetch_add_explicit(&memStatLines, 1, memory_order_relaxed) + 1) % interval != 0)
+	{
+		return;
+	}
+	ByteBuffer report = EmptyByteBuffer();
+	MemStatReport(pStack, &report);
+	fprintf(stderr, "%.*s", (int)report.size, (const char*)report.data);
+	ByteBufferDestroy(&report);
+}
@@ -0,0 +1,114 @@
+/** @file
+   Interfejs rozliczania pamięci węzłów kalkulatora wielomianów
+
+   Każde zaalokowanie i zwolnienie jednomianu (Mono), miejsca na element
+   stosu (PolyStackElem) i elementu słowa (WordElem) jest doliczane do
+   liczników żywych węzłów danego rodzaju. Na ich podstawie liczony jest
+   bieżący i największy dotąd rozmiar pamięci zajętej przez węzły.
+   Liczniki są współdzielone przez wątki (np. wątek wczytujący w trybie
+   potokowym); każdy wątek zbiera swoje zmiany lokalnie i dolicza je
+   atomowo co MEMSTAT_BATCH zmian, więc największy rozmiar jest wyznaczany
+   z tą dokładnością.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-23
+*/
+#ifndef __MEMSTAT_H__
+#define __MEMSTAT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "polystack.h"
+#include "serialize.h"
+
+/**
+ * Liczba przedziałów histogramu rozmiarów wielomianów: przedział 0 to
+ * wielomiany bez jednomianów, a przedział k > 0 to wielomiany, które mają
+ * od 2^(k-1) do 2^k - 1 jednomianów (ostatni przedział nie ma górnej granicy)
+ */
+#define MEMSTAT_HISTOGRAM_SIZE 24
+
+/** Co ile zmian liczników wątek dolicza je do wspólnych liczników */
+#define MEMSTAT_BATCH 256
+
+/**
+ * Rodzaje rozliczanych węzłów
+ */
+typedef enum MemNodeKind
+{
+	MEM_MONO, ///< jednomian
+	MEM_STACK_ELEM, ///< miejsce na element stosu
+	MEM_WORD_ELEM, ///< element słowa
+	MEM_NODE_KIND_AMOUNT ///< liczba rodzajów węzłów
+} MemNodeKind;
+
+/**
+ * Stan liczników pamięci
+ */
+typedef struct MemStats
+{
+	int64_t live[MEM_NODE_KIND_AMOUNT]; ///< liczba żywych węzłów każdego rodzaju
+	int64_t bytes; ///< bieżący rozmiar węzłów (w bajtach)
+	int64_t peakBytes; ///< największy dotąd rozmiar węzłów (w bajtach)
+} MemStats;
+
+/**
+ * Dolicza zaalokowanie węzłów
+ * @param[in] kind : rodzaj węzłów
+ * @param[in] count : liczba węzłów
+ */
+void MemStatAlloc(MemNodeKind kind, size_t count);
+
+/**
+ * Dolicza zwolnienie węzłów
+ * @param[in] kind : rodzaj węzłów
+ * @param[in] count : liczba węzłów
+ */
+void MemStatFree(MemNodeKind kind, size_t count);
+
+/**
+ * Dolicza do wspólnych liczników zmiany zebrane przez bieżący wątek
+ * (wątek powinien to zrobić przed zakończeniem)
+ */
+void MemStatFlush();
+
+/**
+ * Zwraca stan liczników pamięci (po doliczeniu zmian bieżącego wątku)
+ * @return stan liczników
+ */
+MemStats MemStatGet();
+
+/**
+ * Liczy histogram rozmiarów (liczby jednomianów, łącznie z jednomianami
+ * współczynników) wielomianów na stosie. Nieobliczone wyrażenia trybu
+ * leniwego (zob. lazy.h) nie trafiają do histogramu.
+ * @param[in] pStack : stos wielomianów
+ * @param[out] histogram : liczby wielomianów w kolejnych przedziałach
+ * @return liczba nieobliczonych wyrażeń na stosie
+ */
+size_t MemStatHistogram(const PolyStack *pStack, size_t histogram[MEMSTAT_HISTOGRAM_SIZE]);
+
+/**
+ * Dopisuje do tablicy @p buf raport: liczniki pamięci oraz histogram
+ * rozmiarów wielomianów na stosie (tylko niepuste przedziały)
+ * @param[in] pStack : stos wielomianów
+ * @param[in] buf : tablica bajtów
+ */
+void MemStatReport(const PolyStack *pStack, ByteBuffer *buf);
+
+/**
+ * Ustala, co ile wykonanych wierszy raport ma być wypisywany
+ * na standardowy strumień błędów
+ * @param[in] lines : liczba wierszy (0 wyłącza wypisywanie)
+ */
+void MemStatSetInterval(size_t lines);
+
+/**
+ * Dolicza wykonany wiersz (w dowolnym wątku) i co ustaloną liczbę wierszy
+ * (zob. MemStatSetInterval()) wypisuje raport na standardowy strumień błędów
+ * @param[in] pStack : stos wielomianów
+ */
+void MemStatTick(const PolyStack *pStack);
+
+#endif /* __MEMSTAT_H__ */
@@ -6,18 +6,73 @@
    @date 2017-06-03
 */
 #include "operation.h"
+#include "output.h"
+#include "serialize.h"
+#include "mapped.h"
+#include "checkpoint.h"
+#include "chain.h"
+#include "lazy.h"
+#include "memo.h"
+#include "stats.h"
+#include "memstat.h"
+#include "oracle.h"
 
 #include "utils.h"
 
+/** Maksymalna długość wiersza raportu MEMO_STATS */
+#define MEMO_STATS_SIZE 256
+
 /// @private
-void Execute2ArgArithmeticOper(Poly (*op)(const Poly *, const Poly *), PolyStack *pStack)
+bool Execute2ArgMappedOper(Poly (*opMapped)(const Poly *, const MappedPoly *), PolyStack *pStack)
 {
+	if(PolyStackTopMapped(pStack) != NULL && PolyStackNextAfterTopMapped(pStack) != NULL)
+	{
+		PolyStackMaterialize(pStack, 1);
+	}
+	MappedStore *mapped = PolyStackTopMapped(pStack);
+	MappedStore *mapped2 = PolyStackNextAfterTopMapped(pStack);
+	Poly opRes;
+	/* operacje z odwzorowanym argumentem są przemienne */
+	if(mapped != NULL)
+	{
+		Poly top2 = PolyStackNextAfterTop(pStack);
+		opRes = opMapped(&top2, &(mapped->root));
+	}
+	else if(mapped2 != NULL)
+	{
+		Poly top = PolyStackTop(pStack);
+		opRes = opMapped(&top, &(mapped2->root));
+	}
+	else
+	{
+		return false;
+	}
+	PolyStackPop(pStack);
+	PolyStackReplaceTop(pStack, &opRes);
+	return true;
+}
+/// @private
+bool Execute2ArgSharedOper(Poly (*op)(const Poly *, const Poly *), PolyStack *pStack)
+{
+	if(PolyStackPeek(pStack, 0)->shared == NULL && PolyStackPeek(pStack, 1)->shared == NULL)
+	{
+		return false;
+	}
+	/* współdzielonego wielomianu nie można zmieniać w miejscu, a jego kopia
+	 * kosztowałaby tyle samo, co utworzenie wyniku od nowa */
 	Poly top = PolyStackTop(pStack);
 	Poly top2 = PolyStackNextAfterTop(pStack);
 	Poly opRes = op(&top, &top2);
 	PolyStackPop(pStack);
-	PolyStackPop(pStack);
-	PolyStackPush(pStack, &opRes);
+	PolyStackReplaceTop(pStack, &opRes);
+	return true;
+}
+/// @private
+void OutputIntResult(int value)
+{
+	OutputInt(value);
+	OutputChar('\n');
+	ChainRecordCoeff(value);
 }
 /**
  * Sprawdza, czy wielomian na wierzchołku stosu jest współczynnikiem – wypisuje 
@@ -27,7 +82,8 @@ void Execute2ArgArithmeticOper(Poly (*op)(const Poly *, const Poly *), PolyStack
 void IsCoeffExecute(PolyStack *pStack)
 {
 	Poly top = PolyStackTop(pStack);
-	printf("%d\n", PolyIsCoeff(&top));
+	MappedStore *mapped = PolyStackTopMapped(pStack);
+	OutputIntResult(mapped != NULL ? MappedPolyIsCoeff(&(mapped->root)) : PolyIsCoeff(&top));
 }
 /**
  * Sprawdza, czy wielomian na wierzchołku stosu jest tożsamościowo równy zeru – wypisuje 
@@ -37,7 +93,8 @@ void IsCoeffExecute(PolyStack *pStack)
 void IsZeroExecute(PolyStack *pStack)
 {
 	Poly top = PolyStackTop(pStack);
-	printf("%d\n", PolyIsZero(&top)); 
+	MappedStore *mapped = PolyStackTopMapped(pStack);
+	OutputIntResult(mapped != NULL ? MappedPolyIsZero(&(mapped->root)) : PolyIsZero(&top));
 }
 /**
  * Wstawia na stos kopię wielomianu z wierzchołka
@@ -45,6 +102,19 @@ void IsZeroExecute(PolyStack *pStack)
  */
 void CloneExecute(PolyStack *pStack)
 {
+	MappedStore *mapped = PolyStackTopMapped(pStack);
+	if(mapped != NULL)
+	{
+		/* odwzorowany plik jest tylko do odczytu, więc wystarczy kolejne odwołanie */
+		PolyStackPushMapped(pStack, MappedStoreRetain(mapped));
+		return;
+	}
+	SharedPoly *shared = PolyStackPeek(pStack, 0)->shared;
+	if(shared != NULL)
+	{
+		PolyStackPushShared(pStack, SharedPolyRetain(shared));
+		return;
+	}
 	Poly top = PolyStackTop(pStack);
 	Poly p2 = PolyClone(&top);
 	PolyStackPush(pStack, &p2);
@@ -55,7 +125,11 @@ void CloneExecute(PolyStack *pStack)
  */
 void AddExecute(PolyStack *pStack)
 {
-	Execute2ArgArithmeticOper(PolyAdd, pStack);
+	if(!Execute2ArgMappedOper(PolyAddMapped, pStack) && !Execute2ArgSharedOper(PolyAdd, pStack))
+	{
+		Poly top = PolyStackTake(pStack);
+		PolyAddInPlace(&(PolyStackPeek(pStack, 0)->p), &top);
+	}
 }
 /**
  * Mnoży dwa wielomiany z wierzchu stosu, usuwa je i wstawia na wierzchołek stosu ich iloczyn
@@ -63,7 +137,30 @@ void AddExecute(PolyStack *pStack)
  */
 void MulExecute(PolyStack *pStack)
 {
-	Execute2ArgArithmeticOper(PolyMul, pStack);
+	if(Execute2ArgMappedOper(PolyMulMapped, pStack) || Execute2ArgSharedOper(MemoMul, pStack))
+	{
+		return;
+	}
+	Poly top = PolyStackTake(pStack);
+	Poly *top2 = &(PolyStackPeek(pStack, 0)->p);
+	/* mnożenie przez stałą nie wymaga tworzenia nowego wielomianu */
+	if(PolyIsCoeff(&top))
+	{
+		PolyScaleInPlace(top2, top.c);
+	}
+	else if(PolyIsCoeff(top2))
+	{
+		poly_coeff_t c = top2->c;
+		*top2 = top;
+		top = PolyZero();
+		PolyScaleInPlace(top2, c);
+	}
+	else
+	{
+		Poly mul = MemoMul(&top, top2);
+		PolyStackReplaceTop(pStack, &mul);
+	}
+	PolyDestroy(&top);
 }
 /**
  * Neguje wielomian na wierzchołku stosu
@@ -71,10 +168,7 @@ void MulExecute(PolyStack *pStack)
  */
 void NegExecute(PolyStack *pStack)
 {
-	Poly top = PolyStackTop(pStack);
-	Poly neg = PolyNeg(&top);
-	PolyStackPop(pStack);
-	PolyStackPush(pStack, &neg);
+	PolySetInverseCoeffs(PolyStackPeekOwned(pStack, 0));
 }
 /**
  * Odejmuje od wielomianu z wierzchołka wielomian pod wierzchołkiem, usuwa je i wstawia 
@@ -83,7 +177,15 @@ void NegExecute(PolyStack *pStack)
  */
 void SubExecute(PolyStack *pStack)
 {
-	Execute2ArgArithmeticOper(PolySub, pStack);
+	if(Execute2ArgSharedOper(PolySub, pStack))
+	{
+		return;
+	}
+	Poly top = PolyStackTake(pStack);
+	Poly *top2 = &(PolyStackPeek(pStack, 0)->p);
+	/* top - top2 = (-top2) + top */
+	PolySetInverseCoeffs(top2);
+	PolyAddInPlace(top2, &top);
 }
 /**
  * Sprawdza, czy dwa wielomiany na wierzchu stosu są równe – wypisuje 
@@ -94,7 +196,26 @@ void IsEqExecute(PolyStack *pStack)
 {
 	Poly top = PolyStackTop(pStack);
 	Poly top2 = PolyStackNextAfterTop(pStack);
-	printf("%d\n", PolyIsEq(&top, &top2));
+	MappedStore *mapped = PolyStackTopMapped(pStack);
+	MappedStore *mapped2 = PolyStackNextAfterTopMapped(pStack);
+	bool isEq;
+	if(mapped != NULL && mapped2 != NULL)
+	{
+		isEq = MappedPolyIsEqMapped(&(mapped->root), &(mapped2->root));
+	}
+	else if(mapped != NULL)
+	{
+		isEq = MappedPolyIsEq(&(mapped->root), &top2);
+	}
+	else if(mapped2 != NULL)
+	{
+		isEq = MappedPolyIsEq(&(mapped2->root), &top);
+	}
+	else
+	{
+		isEq = PolyIsEq(&top, &top2);
+	}
+	OutputIntResult(isEq);
 }
 /**
  * Wypisuje na standardowe wyjście stopień wielomianu (−1 dla wielomianu 
@@ -104,7 +225,8 @@ void IsEqExecute(PolyStack *pStack)
 void DegExecute(PolyStack *pStack)
 {
 	Poly top = PolyStackTop(pStack);
-	printf("%d\n", PolyDeg(&top));
+	MappedStore *mapped = PolyStackTopMapped(pStack);
+	OutputIntResult(mapped != NULL ? MappedPolyDeg(&(mapped->root)) : PolyDeg(&top));
 }
 /**
  * Usuwa wielomian z wierzchołka stosu
@@ -114,6 +236,50 @@ void PopExecute(PolyStack *pStack)
 {
 	PolyStackPop(pStack);
 }
+/**
+ * Wypisuje na standardowe wyjście liczniki pamięci podręcznej wyników
+ * mnożenia i składania (zob. memo.h)
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ */
+void MemoStatsExecute(PolyStack *pStack)
+{
+	(void)pStack;
+	MemoStats stats = MemoGetStats();
+	char report[MEMO_STATS_SIZE];
+	int size = snprintf(report, MEMO_STATS_SIZE,
+		"hits=%ld misses=%ld collisions=%ld evictions=%ld entries=%ld bytes=%ld budget=%ld\n",
+		(long)stats.hits, (long)stats.misses, (long)stats.collisions, (long)stats.evictions,
+		(long)stats.entries, (long)stats.bytes, (long)stats.budget);
+	assert(size > 0 && size < MEMO_STATS_SIZE);
+	OutputBytes(report, (size_t)size);
+	ChainRecordText(report, (size_t)size);
+}
+/**
+ * Wypisuje na standardowe wyjście raport liczników wydajności poleceń (zob. stats.h)
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ */
+void StatsExecute(PolyStack *pStack)
+{
+	(void)pStack;
+	ByteBuffer report = EmptyByteBuffer();
+	StatsReport(&report);
+	OutputBytes((const char*)report.data, report.size);
+	ChainRecordText((const char*)report.data, report.size);
+	ByteBufferDestroy(&report);
+}
+/**
+ * Wypisuje na standardowe wyjście liczniki pamięci i histogram rozmiarów
+ * wielomianów na stosie (zob. memstat.h)
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ */
+void MemStatExecute(PolyStack *pStack)
+{
+	ByteBuffer report = EmptyByteBuffer();
+	MemStatReport(pStack, &report);
+	OutputBytes((const char*)report.data, report.size);
+	ChainRecordText((const char*)report.data, report.size);
+	ByteBufferDestroy(&report);
+}
 /**
  * Wstawia na wierzchołek stosu wielomian tożsamościowo równy zeru
  * @param[in] pStack : stos, na którym wykonywana jest operacja
@@ -130,8 +296,27 @@ void ZeroExecute(PolyStack *pStack)
 void PrintExecute(PolyStack *pStack)
 {
 	Poly top = PolyStackTop(pStack);
-	PrintPoly(&top);
-	printf("\n");
+	MappedStore *mapped = PolyStackTopMapped(pStack);
+	if(!OutputIsSuppressed())
+	{
+		if(mapped != NULL)
+		{
+			PrintMappedPoly(&(mapped->root));
+		}
+		else
+		{
+			PrintPoly(&top);
+		}
+		OutputChar('\n');
+	}
+	if(mapped != NULL)
+	{
+		ChainRecordMapped(mapped);
+	}
+	else
+	{
+		ChainRecordPoly(&top);
+	}
 }
 /**
  * Wypisuje na standardowe wyjście stopień wielomianu ze względu na zmienną o numerze @p arg 
@@ -139,10 +324,12 @@ void PrintExecute(PolyStack *pStack)
  * @param[in] pStack : stos, na którym wykonywana jest operacja
  * @param[in] arg : numer zmiennej
  */
-void DegByExecute(PolyStack *pStack, Number *arg)
+void DegByExecute(PolyStack *pStack, long arg)
 {
 	Poly top = PolyStackTop(pStack);
-	printf("%d\n", PolyDegBy(&top, (unsigned)NumberToLong(arg)));
+	MappedStore *mapped = PolyStackTopMapped(pStack);
+	unsigned varIdx = (unsigned)arg;
+	OutputIntResult(mapped != NULL ? MappedPolyDegBy(&(mapped->root), varIdx) : PolyDegBy(&top, varIdx));
 }
 /**
  * Wylicza wartość wielomianu w punkcie @p arg, usuwa wielomian z wierzchołka 
@@ -150,35 +337,30 @@ void DegByExecute(PolyStack *pStack, Number *arg)
  * @param[in] pStack : stos, na którym wykonywana jest operacja
  * @param[in] arg : punkt, w którym wyliczana jest wartość wielomianu
  */
-void AtExecute(PolyStack *pStack, Number *arg)
+void AtExecute(PolyStack *pStack, long arg)
 {
 	Poly top = PolyStackTop(pStack);
-	Poly at = PolyAt(&top, (poly_coeff_t)NumberToLong(arg));
-	PolyStackPop(pStack);
-	PolyStackPush(pStack, &at);
+	MappedStore *mapped = PolyStackTopMapped(pStack);
+	poly_coeff_t x = (poly_coeff_t)arg;
+	Poly at = (mapped != NULL) ? MappedPolyAt(&(mapped->root), x) : PolyAt(&top, x);
+	PolyStackReplaceTop(pStack, &at);
 }
 /**
  * Zdejmuje z wierzchołka stosu najpierw wielomian p, a potem kolejno wielomiany 
- * x[0], x[1], …, x[@p arg - 1] i umieszcza na stosie wynik funkcji PolyCompose.
+ * x[0], x[1], …, x[@p arg - 1] i umieszcza na stosie wynik funkcji PolyCompose
+ * (zob. MemoCompose()).
  * @param[in] pStack : stos, na którym wykonywana jest operacja
  * @param[in] arg : rozmiar tablicy x - ilość zdjętych wielomianów (nie licząc p)
  */
-void ComposeExecute(PolyStack *pStack, Number *arg)
+void ComposeExecute(PolyStack *pStack, long arg)
 {
-	Poly top_tmp = PolyStackTop(pStack);
-	Poly top = PolyClone(&top_tmp); /* PolyStackPop usuwa cały wielomian, 
-		więc potrzebujemy jego głębokiej kopii */
-	PolyStackPop(pStack);
-	unsigned count = (unsigned)NumberToLong(arg);
+	unsigned count = (unsigned)arg;
+	Poly top = PolyStackTake(pStack);
 	Poly *x = malloc(sizeof(Poly) * count);
-	assert(x != NULL);
-	for(unsigned i = 0; i < count; i++)
-	{
-		Poly tmp = PolyStackTop(pStack);
-		x[i] = PolyClone(&tmp);
-		PolyStackPop(pStack);
-	}
-	Poly composed = PolyCompose(&top, count, x);
+	assert(count == 0 || x != NULL);
+	PolyStackTakeMany(pStack, count, x);
+	
+	Poly composed = MemoCompose(&top, count, x);
 	for(unsigned i = 0; i < count; i++)
 	{
 		PolyDestroy(&(x[i]));
@@ -187,64 +369,312 @@ void ComposeExecute(PolyStack *pStack, Number *arg)
 	free(x);
 	PolyStackPush(pStack, &composed);
 }
+/**
+ * Zapisuje wielomian z wierzchołka stosu w postaci binarnej do pliku @p path
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ * @param[in] path : ścieżka do pliku
+ * @return Czy zapis się powiódł
+ */
+bool SaveExecute(PolyStack *pStack, const char *path)
+{
+	Poly top = PolyStackTop(pStack);
+	MappedStore *mapped = PolyStackTopMapped(pStack);
+	return (mapped != NULL) ? MappedPolySaveSerialized(&(mapped->root), path) : PolySaveToFile(&top, path);
+}
+/**
+ * Wczytuje wielomian zapisany w postaci binarnej w pliku @p path 
+ * i wstawia go na wierzchołek stosu
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ * @param[in] path : ścieżka do pliku
+ * @return Czy odczyt się powiódł
+ */
+bool LoadExecute(PolyStack *pStack, const char *path)
+{
+	Poly p;
+	if(!PolyLoadFromFile(path, &p))
+	{
+		return false;
+	}
+	PolyStackPush(pStack, &p);
+	return true;
+}
+/**
+ * Zapisuje wielomian z wierzchołka stosu do pliku @p path w formacie,
+ * który można później odwzorować w pamięci poleceniem LOAD_MAPPED
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ * @param[in] path : ścieżka do pliku
+ * @return Czy zapis się powiódł
+ */
+bool SaveMappedExecute(PolyStack *pStack, const char *path)
+{
+	Poly top = PolyStackTop(pStack);
+	MappedStore *mapped = PolyStackTopMapped(pStack);
+	return (mapped != NULL) ? MappedStoreSaveToFile(mapped, path) : MappedPolySaveToFile(&top, path);
+}
+/**
+ * Odwzorowuje w pamięci plik @p path z wielomianem i wstawia go na wierzchołek stosu
+ * (bez wczytywania go do pamięci)
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ * @param[in] path : ścieżka do pliku
+ * @return Czy odwzorowanie się powiodło
+ */
+bool LoadMappedExecute(PolyStack *pStack, const char *path)
+{
+	MappedStore *store = MappedStoreOpen(path);
+	if(store == NULL)
+	{
+		return false;
+	}
+	PolyStackPushMapped(pStack, store);
+	return true;
+}
+/**
+ * Zapisuje obraz całego stosu do pliku @p path i rozpoczyna nowy dziennik
+ * wykonywanych poleceń (zob. CheckpointSave())
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ * @param[in] path : ścieżka do pliku
+ * @return Czy zapis się powiódł
+ */
+bool CheckpointExecute(PolyStack *pStack, const char *path)
+{
+	return CheckpointSave(pStack, path);
+}
+/**
+ * Zastępuje stos obrazem zapisanym w pliku @p path i wykonuje polecenia
+ * z jego dziennika (zob. CheckpointRestore())
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ * @param[in] path : ścieżka do pliku
+ * @return Czy odtworzenie się powiodło
+ */
+bool RestoreExecute(PolyStack *pStack, const char *path)
+{
+	return CheckpointRestore(pStack, path);
+}
+/**
+ * Zapamiętuje wielomian z wierzchołka stosu w rejestrze @p name (bez kopiowania
+ * i bez zdejmowania go ze stosu)
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ * @param[in] name : nazwa rejestru
+ * @return true
+ */
+bool StoreExecute(PolyStack *pStack, const char *name)
+{
+	RegisterTableSet(&(pStack->registers), name, PolyStackShareTop(pStack));
+	return true;
+}
+/**
+ * Wstawia na wierzchołek stosu wielomian zapamiętany w rejestrze @p name
+ * (kopia powstaje dopiero przy pierwszej modyfikacji)
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ * @param[in] name : nazwa rejestru
+ * @return Czy rejestr był niepusty
+ */
+bool RecallExecute(PolyStack *pStack, const char *name)
+{
+	SharedPoly *shared = RegisterTableGet(&(pStack->registers), name);
+	if(shared == NULL)
+	{
+		return false;
+	}
+	PolyStackPushShared(pStack, SharedPolyRetain(shared));
+	return true;
+}
 /// @private
-long ConstantRequiredStackSize(Number *arg){
+bool LazyOperandsPlain(PolyStack *pStack, size_t count)
+{
+	for(size_t i = 0; i < count; i++)
+	{
+		PolyStackElem *elem = PolyStackPeek(pStack, i);
+		if(elem->mapped != NULL || elem->shared != NULL)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+/**
+ * Leniwa wersja polecenia ADD: wstawia na stos wyrażenie będące sumą
+ * dwóch wielomianów z wierzchu stosu (zob. lazy.h)
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ */
+void LazyAddExecute(PolyStack *pStack)
+{
+	if(!LazyOperandsPlain(pStack, 2))
+	{
+		PolyStackForce(pStack, 2);
+		AddExecute(pStack);
+		return;
+	}
+	LazyExpr *top = PolyStackTakeLazy(pStack);
+	LazyExpr *top2 = PolyStackTakeLazy(pStack);
+	PolyStackPushLazy(pStack, LazyAdd(top, top2));
+}
+/**
+ * Leniwa wersja polecenia MUL: wstawia na stos wyrażenie będące iloczynem
+ * dwóch wielomianów z wierzchu stosu (zob. lazy.h)
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ */
+void LazyMulExecute(PolyStack *pStack)
+{
+	if(!LazyOperandsPlain(pStack, 2))
+	{
+		PolyStackForce(pStack, 2);
+		MulExecute(pStack);
+		return;
+	}
+	LazyExpr *top = PolyStackTakeLazy(pStack);
+	LazyExpr *top2 = PolyStackTakeLazy(pStack);
+	PolyStackPushLazy(pStack, LazyMul(top, top2));
+}
+/**
+ * Leniwa wersja polecenia SUB: wstawia na stos wyrażenie będące różnicą
+ * wielomianu z wierzchołka i wielomianu pod wierzchołkiem (zob. lazy.h)
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ */
+void LazySubExecute(PolyStack *pStack)
+{
+	if(!LazyOperandsPlain(pStack, 2))
+	{
+		PolyStackForce(pStack, 2);
+		SubExecute(pStack);
+		return;
+	}
+	LazyExpr *top = PolyStackTakeLazy(pStack);
+	LazyExpr *top2 = PolyStackTakeLazy(pStack);
+	PolyStackPushLazy(pStack, LazyAdd(top, LazyNeg(top2)));
+}
+/**
+ * Leniwa wersja polecenia NEG: wstawia na stos wyrażenie przeciwne
+ * do wielomianu z wierzchołka (zob. lazy.h)
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ */
+void LazyNegExecute(PolyStack *pStack)
+{
+	if(!LazyOperandsPlain(pStack, 1))
+	{
+		NegExecute(pStack);
+		return;
+	}
+	PolyStackPushLazy(pStack, LazyNeg(PolyStackTakeLazy(pStack)));
+}
+/**
+ * Leniwa wersja polecenia CLONE: wstawia na stos kolejne odwołanie do
+ * wyrażenia z wierzchołka, które zostanie obliczone co najwyżej raz (zob. lazy.h)
+ * @param[in] pStack : stos, na którym wykonywana jest operacja
+ */
+void LazyCloneExecute(PolyStack *pStack)
+{
+	if(!LazyOperandsPlain(pStack, 1))
+	{
+		CloneExecute(pStack);
+		return;
+	}
+	LazyExpr *top = PolyStackTakeLazy(pStack);
+	PolyStackPushLazy(pStack, top);
+	PolyStackPushLazy(pStack, LazyRetain(top));
+}
+/// @private
+long ConstantRequiredStackSize(long arg){
+	(void)arg;
 	return 1;
 }
 /// @private
-long ArgDependentRequiredStackSize(Number *arg){
-	return (long)NumberToLong(arg) + 1;
+long ArgDependentRequiredStackSize(long arg){
+	return arg + 1;
 }
 
-void InitStandardOperations(Operation operation[], OperationWithArg opWithArg[])
+void InitStandardOperations(Operation operation[], OperationWithArg opWithArg[], 
+	OperationWithStringArg opWithStrArg[])
 {
 	operation[0].name = ZERO;
 	operation[0].requiredStackSize = 0;
 	operation[0].execute = ZeroExecute;
+	operation[0].acceptsMapped = true;
+	operation[0].acceptsLazy = false;
 	
 	operation[1].name = IS_COEFF;
 	operation[1].requiredStackSize = 1;
 	operation[1].execute = IsCoeffExecute;
+	operation[1].acceptsMapped = true;
+	operation[1].acceptsLazy = false;
 	
 	operation[2].name = IS_ZERO;
 	operation[2].requiredStackSize = 1;
 	operation[2].execute = IsZeroExecute;
+	operation[2].acceptsMapped = true;
+	operation[2].acceptsLazy = false;
 	
 	operation[3].name = CLONE;
 	operation[3].requiredStackSize = 1;
 	operation[3].execute = CloneExecute;
+	operation[3].acceptsMapped = true;
+	operation[3].acceptsLazy = false;
 	
 	operation[4].name = ADD;
 	operation[4].requiredStackSize = 2;
 	operation[4].execute = AddExecute;
+	operation[4].acceptsMapped = true;
+	operation[4].acceptsLazy = false;
 	
 	operation[5].name = MUL;
 	operation[5].requiredStackSize = 2;
 	operation[5].execute = MulExecute;
+	operation[5].acceptsMapped = true;
+	operation[5].acceptsLazy = false;
 	
 	operation[6].name = NEG;
 	operation[6].requiredStackSize = 1;
 	operation[6].execute = NegExecute;
+	operation[6].acceptsMapped = false;
+	operation[6].acceptsLazy = false;
 	
 	operation[7].name = SUB;
 	operation[7].requiredStackSize = 2;
 	operation[7].execute = SubExecute;
+	operation[7].acceptsMapped = false;
+	operation[7].acceptsLazy = false;
 	
 	operation[8].name = IS_EQ;
 	operation[8].requiredStackSize = 2;
 	operation[8].execute = IsEqExecute;
+	operation[8].acceptsMapped = true;
+	operation[8].acceptsLazy = false;
 	
 	operation[9].name = DEG;
 	operation[9].requiredStackSize = 1;
 	operation[9].execute = DegExecute;
+	operation[9].acceptsMapped = true;
+	operation[9].acceptsLazy = false;
 	
 	operation[10].name = PRINT;
 	operation[10].requiredStackSize = 1;
 	operation[10].execute = PrintExecute;
+	operation[10].acceptsMapped = true;
+	operation[10].acceptsLazy = false;
 	
 	operation[11].name = POP;
 	operation[11].requiredStackSize = 1;
 	operation[11].execute = PopExecute;
+	operation[11].acceptsMapped = true;
+	operation[11].acceptsLazy = false;
+	
+	operation[12].name = MEMO_STATS;
+	operation[12].requiredStackSize = 0;
+	operation[12].execute = MemoStatsExecute;
+	operation[12].acceptsMapped = true;
+	operation[12].acceptsLazy = true;
+	
+	operation[13].name = STATS;
+	operation[13].requiredStackSize = 0;
+	operation[13].execute = StatsExecute;
+	operation[13].acceptsMapped = true;
+	operation[13].acceptsLazy = true;
+	
+	operation[14].name = MEMSTAT;
+	operation[14].requiredStackSize = 0;
+	operation[14].execute = MemStatExecute;
+	operation[14].acceptsMapped = true;
+	operation[14].acceptsLazy = true;
 	
 	opWithArg[0].name = DEG_BY;
 	opWithArg[0].requiredStackSize = ConstantRequiredStackSize;
@@ -252,6 +682,7 @@ void InitStandardOperations(Operation operation[], OperationWithArg opWithArg[])
 	opWithArg[0].argErrorType = WRONG_VARIABLE;
 	opWithArg[0].argMinValue = 0;
 	opWithArg[0].argMaxValue = UINT_MAX;
+	opWithArg[0].acceptsMapped = true;
 	
 	opWithArg[1].name = AT;
 	opWithArg[1].requiredStackSize = ConstantRequiredStackSize;
@@ -259,6 +690,7 @@ void InitStandardOperations(Operation operation[], OperationWithArg opWithArg[])
 	opWithArg[1].argErrorType = WRONG_VALUE;
 	opWithArg[1].argMinValue = LONG_MIN;
 	opWithArg[1].argMaxValue = LONG_MAX;
+	opWithArg[1].acceptsMapped = true;
 	
 	opWithArg[2].name = COMPOSE;
 	opWithArg[2].requiredStackSize = ArgDependentRequiredStackSize;
@@ -266,4 +698,99 @@ void InitStandardOperations(Operation operation[], OperationWithArg opWithArg[])
 	opWithArg[2].argErrorType = WRONG_COUNT;
 	opWithArg[2].argMinValue = 0;
 	opWithArg[2].argMaxValue = UINT_MAX;
+	opWithArg[2].acceptsMapped = false;
+	
+	opWithStrArg[0].name = SAVE;
+	opWithStrArg[0].requiredStackSize = 1;
+	opWithStrArg[0].execute = SaveExecute;
+	opWithStrArg[0].argErrorType = WRONG_FILE;
+	opWithStrArg[0].acceptsMapped = true;
+	
+	opWithStrArg[1].name = LOAD;
+	opWithStrArg[1].requiredStackSize = 0;
+	opWithStrArg[1].execute = LoadExecute;
+	opWithStrArg[1].argErrorType = WRONG_FILE;
+	opWithStrArg[1].acceptsMapped = false;
+	
+	opWithStrArg[2].name = SAVE_MAPPED;
+	opWithStrArg[2].requiredStackSize = 1;
+	opWithStrArg[2].execute = SaveMappedExecute;
+	opWithStrArg[2].argErrorType = WRONG_FILE;
+	opWithStrArg[2].acceptsMapped = true;
+	
+	opWithStrArg[3].name = LOAD_MAPPED;
+	opWithStrArg[3].requiredStackSize = 0;
+	opWithStrArg[3].execute = LoadMappedExecute;
+	opWithStrArg[3].argErrorType = WRONG_FILE;
+	opWithStrArg[3].acceptsMapped = false;
+	
+	opWithStrArg[4].name = CHECKPOINT;
+	opWithStrArg[4].requiredStackSize = 0;
+	opWithStrArg[4].execute = CheckpointExecute;
+	opWithStrArg[4].argErrorType = WRONG_FILE;
+	opWithStrArg[4].acceptsMapped = true;
+	
+	opWithStrArg[5].name = RESTORE;
+	opWithStrArg[5].requiredStackSize = 0;
+	opWithStrArg[5].execute = RestoreExecute;
+	opWithStrArg[5].argErrorType = WRONG_FILE;
+	opWithStrArg[5].acceptsMapped = true;
+	
+	opWithStrArg[6].name = STORE;
+	opWithStrArg[6].requiredStackSize = 1;
+	opWithStrArg[6].execute = StoreExecute;
+	opWithStrArg[6].argErrorType = WRONG_REGISTER;
+	opWithStrArg[6].acceptsMapped = false;
+	
+	opWithStrArg[7].name = RECALL;
+	opWithStrArg[7].requiredStackSize = 0;
+	opWithStrArg[7].execute = RecallExecute;
+	opWithStrArg[7].argErrorType = WRONG_REGISTER;
+	opWithStrArg[7].acceptsMapped = true;
+}
+
+void InitLazyOperations(Operation operation[])
+{
+	for(int i = 0; i < OPER_WITHOUT_ARG_AMOUNT; i++)
+	{
+		void (*execute)(PolyStack *) = operation[i].execute;
+		if(execute == AddExecute)
+		{
+			operation[i].execute = LazyAddExecute;
+		}
+		else if(execute == MulExecute)
+		{
+			operation[i].execute = LazyMulExecute;
+		}
+		else if(execute == SubExecute)
+		{
+			operation[i].execute = LazySubExecute;
+		}
+		else if(execute == NegExecute)
+		{
+			operation[i].execute = LazyNegExecute;
+		}
+		else if(execute == CloneExecute)
+		{
+			operation[i].execute = LazyCloneExecute;
+		}
+		else if(execute != PopExecute)
+		{
+			continue;
+		}
+		operation[i].acceptsLazy = true;
+	}
+}
+
+void DisableFileOperations(OperationWithStringArg opWithStrArg[])
+{
+	for(int i = 0; i < OPER_WITH_STRING_ARG_AMOUNT; i++)
+	{
+		bool (*execute)(PolyStack *, const char *) = opWithStrArg[i].execute;
+		if(execute == SaveExecute || execute == LoadExecute || execute == SaveMappedExecute ||
+			execute == LoadMappedExecute || execute == CheckpointExecute || execute == RestoreExecute)
+		{
+			opWithStrArg[i].execute = NULL;
+		}
+	}
 }
@@ -32,9 +32,21 @@
 #define PRINT "PRINT"
 #define POP "POP"
 #define COMPOSE "COMPOSE"
+#define SAVE "SAVE"
+#define LOAD "LOAD"
+#define SAVE_MAPPED "SAVE_MAPPED"
+#define LOAD_MAPPED "LOAD_MAPPED"
+#define CHECKPOINT "CHECKPOINT"
+#define RESTORE "RESTORE"
+#define STORE "STORE"
+#define RECALL "RECALL"
+#define MEMO_STATS "MEMO_STATS"
+#define STATS "STATS"
+#define MEMSTAT "MEMSTAT"
 
-#define OPER_WITHOUT_ARG_AMOUNT 12
+#define OPER_WITHOUT_ARG_AMOUNT 15
 #define OPER_WITH_ARG_AMOUNT 3
+#define OPER_WITH_STRING_ARG_AMOUNT 8
 
 /**
  * Struktura przechowująca polecenie kalkulatora, które nie wymaga żadnego argumentu
@@ -44,6 +56,16 @@ typedef struct Operation
 	char* name; ///< nazwa polecenia
 	long requiredStackSize; ///< wymagany przez polecenie rozmiar stosu
 	void (*execute)(PolyStack *); ///< funkcja będąca wykonaniem danego polecenia
+	/**
+	 * czy polecenie obsługuje wielomiany odwzorowane w pamięci (zob. LOAD_MAPPED);
+	 * jeśli nie, są one przed wykonaniem polecenia zamieniane na zwykłe wielomiany
+	 */
+	bool acceptsMapped;
+	/**
+	 * czy polecenie obsługuje nieobliczone wyrażenia (zob. lazy.h);
+	 * jeśli nie, są one przed wykonaniem polecenia obliczane
+	 */
+	bool acceptsLazy;
 } Operation;
 /**
  * Struktura przechowująca polecenie kalkulatora, które wymaga dokładnie jednego argumentu
@@ -51,21 +73,76 @@ typedef struct Operation
 typedef struct OperationWithArg
 {
 	char* name; ///< nazwa polecenia
-	long (*requiredStackSize)(Number *); ///< funkcja zwracająca wymagany przez polecenie rozmiar stosu
-	void (*execute)(PolyStack *, Number *); ///< funkcja będąca wykonaniem danego polecenia
+	long (*requiredStackSize)(long); ///< funkcja zwracająca wymagany przez polecenie rozmiar stosu
+	/**
+	 * funkcja będąca wykonaniem danego polecenia 
+	 * (argument jest już sprawdzony – mieści się w zakresie od argMinValue do argMaxValue)
+	 */
+	void (*execute)(PolyStack *, long);
 	/**
 	 * typ błędu zwracany w przypadku, gdy argument operacji jest niewłaściwy
 	 */
 	char* argErrorType;
 	long argMinValue; ///< minimalna wartość argumentu
 	long argMaxValue; ///< maksymalna wartość argumentu
+	/**
+	 * czy polecenie obsługuje wielomiany odwzorowane w pamięci (zob. LOAD_MAPPED);
+	 * jeśli nie, są one przed wykonaniem polecenia zamieniane na zwykłe wielomiany
+	 */
+	bool acceptsMapped;
 } OperationWithArg;
 
+/**
+ * Struktura przechowująca polecenie kalkulatora, którego argumentem jest
+ * dowolny niepusty ciąg znaków (np. nazwa pliku) ciągnący się do końca wiersza
+ */
+typedef struct OperationWithStringArg
+{
+	char* name; ///< nazwa polecenia
+	long requiredStackSize; ///< wymagany przez polecenie rozmiar stosu
+	/**
+	 * funkcja będąca wykonaniem danego polecenia,
+	 * zwraca false, jeśli polecenia nie udało się wykonać z podanym argumentem;
+	 * NULL, jeśli polecenie jest wyłączone (zob. DisableFileOperations())
+	 */
+	bool (*execute)(PolyStack *, const char *);
+	/**
+	 * typ błędu zwracany w przypadku, gdy argument jest pusty 
+	 * lub polecenia nie udało się z nim wykonać
+	 */
+	char* argErrorType;
+	/**
+	 * czy polecenie obsługuje wielomiany odwzorowane w pamięci (zob. LOAD_MAPPED);
+	 * jeśli nie, są one przed wykonaniem polecenia zamieniane na zwykłe wielomiany
+	 */
+	bool acceptsMapped;
+} OperationWithStringArg;
+
 /**
  * Inicjalizuje tablice poleceń kalkulatora standardowymi operacjami
  * @param[in] operation : tablica operacji bezargumentowych
  * @param[in] opWithArg : tablica operacji jednoargumentowych
+ * @param[in] opWithStrArg : tablica operacji z argumentem tekstowym
+ */
+void InitStandardOperations(Operation operation[], OperationWithArg opWithArg[], 
+	OperationWithStringArg opWithStrArg[]);
+
+/**
+ * Zamienia w tablicy operacji bezargumentowych polecenia ADD, SUB, MUL, NEG
+ * i CLONE na ich leniwe wersje (zob. lazy.h), a POP oznacza jako obsługujące
+ * nieobliczone wyrażenia
+ * @param[in] operation : tablica operacji bezargumentowych (zainicjalizowana
+ * przez InitStandardOperations())
+ */
+void InitLazyOperations(Operation operation[]);
+
+/**
+ * Wyłącza polecenia SAVE, LOAD, SAVE_MAPPED, LOAD_MAPPED, CHECKPOINT
+ * i RESTORE, które czytają i zapisują dowolne pliki; wyłączone polecenie
+ * jest traktowane tak jak nieznane (WRONG COMMAND)
+ * @param[in] opWithStrArg : tablica operacji z argumentem tekstowym (zainicjalizowana
+ * przez InitStandardOperations())
  */
-void InitStandardOperations(Operation operation[], OperationWithArg opWithArg[]);
+void DisableFileOperations(OperationWithStringArg opWithStrArg[]);
 
 #endif /* __OPERATION_H__ */
@@ -0,0 +1,149 @@
+#include "options.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+
+#include "utils.h"
+
+CalcOptions DefaultCalcOptions()
+{
+	CalcOptions options;
+	options.pipeline = false;
+	options.lazy = false;
+	options.restorePath = NULL;
+	options.chainDir = NULL;
+	options.bytecodeCacheDir = NULL;
+	options.memoBudget = 0;
+	options.stats = STATS_DISABLED;
+	options.memStatInterval = 0;
+	options.tracePath = NULL;
+	options.traceMarkers = false;
+	options.perfCounters = false;
+	options.servePath = NULL;
+	options.workers = 0;
+	return options;
+}
+
+/**
+ * Odczytuje nieujemną liczbę zapisaną dziesiętnie
+ * @param[in] s : napis
+ * @param[out] value : odczytana liczba
+ * @return Czy napis jest poprawną liczbą
+ */
+static bool ParseSize(const char *s, size_t *value)
+{
+	if(*s < '0' || *s > '9')
+	{
+		return false;
+	}
+	char *end;
+	errno = 0;
+	unsigned long long parsed = strtoull(s, &end, 10);
+	if(errno != 0 || *end != '\0' || parsed > SIZE_MAX)
+	{
+		return false;
+	}
+	*value = (size_t)parsed;
+	return true;
+}
+
+/**
+ * Wypisuje na standardowy strumień błędów sposób użycia programu
+ * @param[in] programName : nazwa programu
+ */
+static void PrintUsage(const char *programName)
+{
+	fprintf(stderr, "Użycie: %s [%s] [%s] [%s PLIK] [%s KATALOG] [%s KATALOG] [%s BAJTY] "
+		"[%s | %s] [%s] [%s WIERSZE] [%s PLIK] [%s] [%s GNIAZDO [%s N]]\n", programName,
+		OPTION_PIPELINE, OPTION_LAZY, OPTION_RESTORE, OPTION_CHAIN, OPTION_BYTECODE_CACHE, OPTION_MEMO_BUDGET,
+		OPTION_STATS, OPTION_STATS_JSON, OPTION_PERF_COUNTERS, OPTION_MEMSTAT_INTERVAL, OPTION_TRACE,
+		OPTION_TRACE_MARKERS, OPTION_SERVE, OPTION_WORKERS);
+}
+
+bool ParseCalcOptions(int argc, char *argv[], CalcOptions *options)
+{
+	*options = DefaultCalcOptions();
+	
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], OPTION_PIPELINE) == 0)
+		{
+			options->pipeline = true;
+		}
+		else if(strcmp(argv[i], OPTION_LAZY) == 0)
+		{
+			options->lazy = true;
+		}
+		else if(strcmp(argv[i], OPTION_RESTORE) == 0 && i + 1 < argc)
+		{
+			options->restorePath = argv[++i];
+		}
+		else if(strcmp(argv[i], OPTION_CHAIN) == 0 && i + 1 < argc)
+		{
+			options->chainDir = argv[++i];
+		}
+		else if(strcmp(argv[i], OPTION_BYTECODE_CACHE) == 0 && i + 1 < argc)
+		{
+			options->bytecodeCacheDir = argv[++i];
+		}
+		else if(strcmp(argv[i], OPTION_STATS) == 0)
+		{
+			options->stats = STATS_TABLE;
+		}
+		else if(strcmp(argv[i], OPTION_STATS_JSON) == 0)
+		{
+			options->stats = STATS_JSON;
+		}
+		else if(strcmp(argv[i], OPTION_PERF_COUNTERS) == 0)
+		{
+			options->perfCounters = true;
+		}
+		else if(strcmp(argv[i], OPTION_TRACE) == 0 && i + 1 < argc)
+		{
+			options->tracePath = argv[++i];
+		}
+		else if(strcmp(argv[i], OPTION_TRACE_MARKERS) == 0)
+		{
+			options->traceMarkers = true;
+		}
+		else if(strcmp(argv[i], OPTION_SERVE) == 0 && i + 1 < argc)
+		{
+			options->servePath = argv[++i];
+		}
+		else if(strcmp(argv[i], OPTION_MEMO_BUDGET) == 0 && i + 1 < argc &&
+			ParseSize(argv[i + 1], &(options->memoBudget)))
+		{
+			i++;
+		}
+		else if(strcmp(argv[i], OPTION_WORKERS) == 0 && i + 1 < argc &&
+			ParseSize(argv[i + 1], &(options->workers)) && options->workers <= UINT_MAX)
+		{
+			i++;
+		}
+		else if(strcmp(argv[i], OPTION_MEMSTAT_INTERVAL) == 0 && i + 1 < argc &&
+			ParseSize(argv[i + 1], &(options->memStatInterval)))
+		{
+			i++;
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return false;
+		}
+	}
+	/* liczniki mierzą tylko wątek, który je otworzył, a sesje serwera wykonują wątki robocze */
+	if(options->perfCounters && options->servePath != NULL)
+	{
+		fprintf(stderr, "Opcji %s nie można łączyć z opcją %s\n", OPTION_PERF_COUNTERS, OPTION_SERVE);
+		return false;
+	}
+	if(options->perfCounters && options->stats == STATS_DISABLED)
+	{
+		options->stats = STATS_TABLE;
+	}
+	return true;
+}
@@ -0,0 +1,118 @@
+/** @file
+   Interfejs opcji wywołania kalkulatora wielomianów
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-16
+*/
+#ifndef __OPTIONS_H__
+#define __OPTIONS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "stats.h"
+
+#define OPTION_PIPELINE "--pipeline"
+#define OPTION_RESTORE "--restore"
+#define OPTION_CHAIN "--chain"
+#define OPTION_BYTECODE_CACHE "--bytecode-cache"
+#define OPTION_LAZY "--lazy"
+#define OPTION_MEMO_BUDGET "--memo-budget"
+#define OPTION_STATS "--stats"
+#define OPTION_STATS_JSON "--stats-json"
+#define OPTION_MEMSTAT_INTERVAL "--memstat-interval"
+#define OPTION_TRACE "--trace"
+#define OPTION_TRACE_MARKERS "--trace-markers"
+#define OPTION_PERF_COUNTERS "--perf-counters"
+#define OPTION_SERVE "--serve"
+#define OPTION_WORKERS "--workers"
+
+/**
+ * Struktura przechowująca opcje wywołania kalkulatora
+ */
+typedef struct CalcOptions
+{
+	/**
+	 * czy wczytywanie i parsowanie wierszy ma się odbywać w osobnym wątku,
+	 * równolegle z wykonywaniem poleceń
+	 */
+	bool pipeline;
+	/**
+	 * czy polecenia arytmetyczne mają być wykonywane leniwie
+	 * (zob. InitLazyOperations())
+	 */
+	bool lazy;
+	/**
+	 * ścieżka do punktu kontrolnego, z którego należy odtworzyć stan
+	 * kalkulatora przed wczytaniem wejścia (NULL, jeśli nie należy)
+	 */
+	const char *restorePath;
+	/**
+	 * katalog z łańcuchem plików do wykonania zamiast wczytywania
+	 * standardowego wejścia (NULL, jeśli nie należy; zob. RunChain())
+	 */
+	const char *chainDir;
+	/**
+	 * katalog pamięci podręcznej skompilowanych skryptów (NULL, jeśli wejście
+	 * ma być wykonywane bez kompilacji; zob. RunBytecodeCached())
+	 */
+	const char *bytecodeCacheDir;
+	/**
+	 * budżet pamięci podręcznej wyników mnożenia i składania w bajtach
+	 * (0, jeśli wyniki nie mają być zapamiętywane; zob. MemoSetBudget())
+	 */
+	size_t memoBudget;
+	/**
+	 * format raportu liczników wydajności poleceń wypisywanego przy wyjściu
+	 * (STATS_DISABLED, jeśli liczniki mają być wyłączone; zob. stats.h)
+	 */
+	StatsFormat stats;
+	/**
+	 * co ile wykonanych wierszy wypisywać na standardowy strumień błędów
+	 * liczniki pamięci (0, jeśli wcale; zob. MemStatSetInterval())
+	 */
+	size_t memStatInterval;
+	/**
+	 * plik, do którego należy zapisywać ślad wykonania w formacie Chrome trace
+	 * (NULL, jeśli nie należy; zob. trace.h)
+	 */
+	const char *tracePath;
+	/**
+	 * czy zapisywać ślad wykonania do pliku `trace_marker` jądra (dla `perf`)
+	 */
+	bool traceMarkers;
+	/**
+	 * czy doliczać do liczników poleceń sprzętowe liczniki wydajności
+	 * (zob. perfcount.h); włącza liczniki poleceń, jeśli nie były włączone;
+	 * nie można jej łączyć z trybem serwera
+	 */
+	bool perfCounters;
+	/**
+	 * gniazdo, na którym kalkulator ma działać jako serwer zamiast wczytywać
+	 * standardowe wejście (NULL, jeśli nie ma; zob. ServeUnixSocket())
+	 */
+	const char *servePath;
+	/**
+	 * liczba wątków roboczych serwera (0, jeśli tyle, ile jest procesorów)
+	 */
+	size_t workers;
+} CalcOptions;
+
+/**
+ * Zwraca domyślne opcje wywołania kalkulatora
+ * @return domyślne opcje
+ */
+CalcOptions DefaultCalcOptions();
+
+/**
+ * Odczytuje opcje wywołania kalkulatora z argumentów programu.
+ * W przypadku nieznanej lub niepełnej opcji wypisuje na standardowy
+ * strumień błędów sposób użycia programu.
+ * @param[in] argc : liczba argumentów programu
+ * @param[in] argv : argumenty programu
+ * @param[out] options : odczytane opcje
+ * @return Czy opcje są poprawne
+ */
+bool ParseCalcOptions(int argc, char *argv[], CalcOptions *options);
+
+#endif /* __OPTIONS_H__ */
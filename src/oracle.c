@@ -0,0 +1,438 @@
+#define ORACLE_NO_REDIRECT
+
+#include "oracle.h"
+
+#include <stdio.h>
+
+#include "memo.h"
+#include "operation.h"
+#include "serialize.h"
+
+#include "utils.h"
+
+/** Maksymalna liczba jednomianów argumentów, dla której przykład jest minimalizowany */
+#define ORACLE_SHRINK_MAX_MONOS 4096
+/** Maksymalna długość polecenia w przykładzie */
+#define ORACLE_SCRIPT_SIZE 32
+
+/**
+ * Operacja na argumentach w kolejności wstawiania na stos
+ * (ostatni argument jest na wierzchołku)
+ */
+typedef Poly (*OracleOp)(unsigned argCount, const Poly args[]);
+
+/**
+ * Sprawdzana szybka wersja operacji
+ */
+typedef struct OracleCase
+{
+	const char *name; ///< nazwa szybkiej wersji
+	/**
+	 * szybka wersja (NULL, jeśli nie da się jej wykonać na zwykłych
+	 * wielomianach – wtedy przykład nie jest minimalizowany)
+	 */
+	OracleOp fast;
+	OracleOp reference; ///< wersja wzorcowa (NULL, jeśli @p fast jest NULL)
+} OracleCase;
+
+/**
+ * Zwraca kopię wielomianu bez @p k-tego jednomianu (licząc w głąb, od zera);
+ * zmniejsza @p k o liczbę pominiętych po drodze jednomianów
+ * @param[in] p : wielomian
+ * @param[in] k : numer usuwanego jednomianu
+ * @return kopia wielomianu bez jednomianu
+ */
+static Poly OracleWithoutMono(const Poly *p, uint64_t *k)
+{
+	if(PolyIsCoeff(p))
+	{
+		return PolyClone(p);
+	}
+	unsigned count = 0;
+	for(const Mono *iter = p->ml.first; iter != NULL; iter = iter->next)
+	{
+		count++;
+	}
+	Mono *monos = malloc(count * sizeof(Mono));
+	assert(monos != NULL);
+	unsigned kept = 0;
+	for(const Mono *iter = p->ml.first; iter != NULL; iter = iter->next)
+	{
+		if(*k == 0)
+		{
+			/* pomijamy jednomian (wraz ze współczynnikiem) */
+			*k = UINT64_MAX;
+			continue;
+		}
+		if(*k != UINT64_MAX)
+		{
+			(*k)--;
+		}
+		Poly coeff = OracleWithoutMono(&(iter->p), k);
+		monos[kept++] = MonoFromPoly(&coeff, iter->exp);
+	}
+	Poly res = PolyAddMonos(kept, monos);
+	free(monos);
+	return res;
+}
+
+/**
+ * Sprawdza, czy szybka wersja daje inny wynik niż wzorcowa
+ * @param[in] c : sprawdzana operacja
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return Czy wyniki się różnią
+ */
+static bool OracleMismatch(const OracleCase *c, unsigned argCount, const Poly args[])
+{
+	Poly fast = c->fast(argCount, args);
+	Poly reference = c->reference(argCount, args);
+	bool mismatch = !PolyIsEq(&fast, &reference);
+	PolyDestroy(&fast);
+	PolyDestroy(&reference);
+	return mismatch;
+}
+
+/**
+ * Usuwa z argumentów kolejne jednomiany, dopóki wyniki nadal się różnią
+ * (po zakończeniu usunięcie dowolnego jednomianu usuwa różnicę)
+ * @param[in] c : sprawdzana operacja
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty (zastępowane mniejszymi)
+ */
+static void OracleShrink(const OracleCase *c, unsigned argCount, Poly args[])
+{
+	bool changed = true;
+	while(changed)
+	{
+		changed = false;
+		for(unsigned i = 0; i < argCount; i++)
+		{
+			for(uint64_t k = 0; k < PolyMonoCountDeep(&(args[i]));)
+			{
+				Poly original = args[i];
+				uint64_t skip = k;
+				args[i] = OracleWithoutMono(&original, &skip);
+				if(OracleMismatch(c, argCount, args))
+				{
+					PolyDestroy(&original);
+					changed = true;
+				}
+				else
+				{
+					PolyDestroy(&(args[i]));
+					args[i] = original;
+					k++;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Wypisuje na standardowy strumień błędów wielomian i znak końca wiersza
+ * @param[in] p : wielomian
+ */
+static void OraclePrintPoly(const Poly *p)
+{
+	ByteBuffer text = EmptyByteBuffer();
+	PolyToText(p, &text);
+	fprintf(stderr, "%.*s\n", (int)text.size, (const char*)text.data);
+	ByteBufferDestroy(&text);
+}
+
+/**
+ * Porównuje wynik szybkiej wersji z wynikiem wzorcowym. W przypadku różnicy
+ * wypisuje minimalny przykład (argumenty, polecenie @p script i PRINT)
+ * oraz oba wyniki i przerywa program.
+ * @param[in] c : sprawdzana operacja
+ * @param[in] script : polecenia kalkulatora wykonujące operację
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty w kolejności wstawiania na stos
+ * @param[in] fast : wynik szybkiej wersji
+ * @param[in] reference : wynik wzorcowy
+ */
+static void OracleCheck(const OracleCase *c, const char *script, unsigned argCount,
+	const Poly args[], const Poly *fast, const Poly *reference)
+{
+	if(PolyIsEq(fast, reference))
+	{
+		return;
+	}
+	Poly *minimal = malloc(argCount * sizeof(Poly));
+	assert(minimal != NULL);
+	uint64_t monos = 0;
+	for(unsigned i = 0; i < argCount; i++)
+	{
+		minimal[i] = PolyClone(&(args[i]));
+		monos += PolyMonoCountDeep(&(args[i]));
+	}
+	Poly minimalFast = PolyClone(fast), minimalReference = PolyClone(reference);
+	if(c->fast != NULL && monos <= ORACLE_SHRINK_MAX_MONOS && OracleMismatch(c, argCount, minimal))
+	{
+		OracleShrink(c, argCount, minimal);
+		PolyDestroy(&minimalFast);
+		PolyDestroy(&minimalReference);
+		minimalFast = c->fast(argCount, minimal);
+		minimalReference = c->reference(argCount, minimal);
+	}
+
+	fprintf(stderr, "Błąd wyroczni: wynik %s różni się od wyniku implementacji wzorcowej\n", c->name);
+	fprintf(stderr, "Minimalny przykład (skrypt kalkulatora):\n");
+	for(unsigned i = 0; i < argCount; i++)
+	{
+		OraclePrintPoly(&(minimal[i]));
+	}
+	fprintf(stderr, "%s\nPRINT\n", script);
+	fprintf(stderr, "Wynik wzorcowy: ");
+	OraclePrintPoly(&minimalReference);
+	fprintf(stderr, "Wynik %s: ", c->name);
+	OraclePrintPoly(&minimalFast);
+	abort();
+}
+
+/**
+ * Dodawanie w miejscu (argumenty: p, q)
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return `p + q`
+ */
+static Poly OracleRunAddInPlace(unsigned argCount, const Poly args[])
+{
+	(void)argCount;
+	Poly p = PolyClone(&(args[0])), q = PolyClone(&(args[1]));
+	PolyAddInPlace(&p, &q);
+	return p;
+}
+
+/**
+ * Dodawanie wzorcowe (argumenty: p, q)
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return `p + q`
+ */
+static Poly OracleRunAdd(unsigned argCount, const Poly args[])
+{
+	(void)argCount;
+	return PolyAdd(&(args[0]), &(args[1]));
+}
+
+/**
+ * Mnożenie wzorcowe (argumenty: p, q)
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return `p * q`
+ */
+static Poly OracleRunMul(unsigned argCount, const Poly args[])
+{
+	(void)argCount;
+	return PolyMul(&(args[0]), &(args[1]));
+}
+
+/**
+ * Mnożenie w miejscu przez stałą (argumenty: p, stała c)
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return `c * p`
+ */
+static Poly OracleRunScaleInPlace(unsigned argCount, const Poly args[])
+{
+	(void)argCount;
+	Poly p = PolyClone(&(args[0]));
+	PolyScaleInPlace(&p, args[1].c);
+	return p;
+}
+
+/**
+ * Złączone mnożenie z dodawaniem (argumenty: r, p, q)
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return `p * q + r`
+ */
+static Poly OracleRunMulAdd(unsigned argCount, const Poly args[])
+{
+	(void)argCount;
+	return PolyMulAdd(&(args[1]), &(args[2]), &(args[0]));
+}
+
+/**
+ * Wzorcowe mnożenie z dodawaniem (argumenty: r, p, q)
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return `p * q + r`
+ */
+static Poly OracleRunMulThenAdd(unsigned argCount, const Poly args[])
+{
+	(void)argCount;
+	Poly mul = PolyMul(&(args[1]), &(args[2]));
+	Poly res = PolyAdd(&mul, &(args[0]));
+	PolyDestroy(&mul);
+	return res;
+}
+
+/**
+ * Mnożenie z zapamiętywaniem wyników (argumenty: p, q)
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return `p * q`
+ */
+static Poly OracleRunMemoMul(unsigned argCount, const Poly args[])
+{
+	(void)argCount;
+	return MemoMul(&(args[0]), &(args[1]));
+}
+
+/**
+ * Złożenie (argumenty: x[count - 1], …, x[0], p – jak na stosie przed COMPOSE)
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @param[in] memo : czy korzystać z zapamiętanych wyników
+ * @return złożenie wielomianów
+ */
+static Poly OracleRunComposeWith(unsigned argCount, const Poly args[], bool memo)
+{
+	unsigned count = argCount - 1;
+	Poly *x = malloc((count + 1) * sizeof(Poly));
+	assert(x != NULL);
+	for(unsigned i = 0; i < count; i++)
+	{
+		x[i] = args[count - 1 - i];
+	}
+	Poly res = memo ? MemoCompose(&(args[count]), count, x) : PolyCompose(&(args[count]), count, x);
+	free(x);
+	return res;
+}
+
+/**
+ * Złożenie z zapamiętywaniem wyników (zob. OracleRunComposeWith())
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return złożenie wielomianów
+ */
+static Poly OracleRunMemoCompose(unsigned argCount, const Poly args[])
+{
+	return OracleRunComposeWith(argCount, args, true);
+}
+
+/**
+ * Złożenie wzorcowe (zob. OracleRunComposeWith())
+ * @param[in] argCount : liczba argumentów
+ * @param[in] args : argumenty
+ * @return złożenie wielomianów
+ */
+static Poly OracleRunCompose(unsigned argCount, const Poly args[])
+{
+	return OracleRunComposeWith(argCount, args, false);
+}
+
+/// @private
+static const OracleCase oracleAddInPlace = {"PolyAddInPlace", OracleRunAddInPlace, OracleRunAdd};
+/// @private
+static const OracleCase oracleScaleInPlace = {"PolyScaleInPlace", OracleRunScaleInPlace, OracleRunMul};
+/// @private
+static const OracleCase oracleMulAdd = {"PolyMulAdd", OracleRunMulAdd, OracleRunMulThenAdd};
+/// @private
+static const OracleCase oracleMemoMul = {"MemoMul", OracleRunMemoMul, OracleRunMul};
+/// @private
+static const OracleCase oracleMemoCompose = {"MemoCompose", OracleRunMemoCompose, OracleRunCompose};
+/// @private
+static const OracleCase oracleAddMapped = {"PolyAddMapped", NULL, NULL};
+/// @private
+static const OracleCase oracleMulMapped = {"PolyMulMapped", NULL, NULL};
+/// @private
+static const OracleCase oracleMappedAt = {"MappedPolyAt", NULL, NULL};
+
+void OracleAddInPlace(Poly *p, Poly *q)
+{
+	Poly args[2] = {PolyClone(p), PolyClone(q)};
+	Poly expected = PolyAdd(p, q);
+	PolyAddInPlace(p, q);
+	OracleCheck(&oracleAddInPlace, ADD, 2, args, p, &expected);
+	PolyDestroy(&expected);
+	PolyDestroy(&(args[0]));
+	PolyDestroy(&(args[1]));
+}
+
+void OracleScaleInPlace(Poly *p, poly_coeff_t c)
+{
+	Poly args[2] = {PolyClone(p), PolyFromCoeff(c)};
+	Poly expected = PolyMul(p, &(args[1]));
+	PolyScaleInPlace(p, c);
+	OracleCheck(&oracleScaleInPlace, MUL, 2, args, p, &expected);
+	PolyDestroy(&expected);
+	PolyDestroy(&(args[0]));
+}
+
+Poly OracleMulAdd(const Poly *p, const Poly *q, const Poly *r)
+{
+	Poly args[3] = {*r, *p, *q};
+	Poly res = OracleRunMulAdd(3, args);
+	Poly expected = OracleRunMulThenAdd(3, args);
+	OracleCheck(&oracleMulAdd, MUL "\n" ADD, 3, args, &res, &expected);
+	PolyDestroy(&expected);
+	return res;
+}
+
+Poly OracleMemoMul(const Poly *p, const Poly *q)
+{
+	Poly args[2] = {*p, *q};
+	Poly res = MemoMul(p, q);
+	Poly expected = PolyMul(p, q);
+	OracleCheck(&oracleMemoMul, MUL, 2, args, &res, &expected);
+	PolyDestroy(&expected);
+	return res;
+}
+
+Poly OracleMemoCompose(const Poly *p, unsigned count, const Poly x[])
+{
+	Poly *args = malloc((count + 1) * sizeof(Poly));
+	assert(args != NULL);
+	for(unsigned i = 0; i < count; i++)
+	{
+		args[count - 1 - i] = x[i];
+	}
+	args[count] = *p;
+	Poly res = MemoCompose(p, count, x);
+	Poly expected = PolyCompose(p, count, x);
+	char script[ORACLE_SCRIPT_SIZE];
+	snprintf(script, ORACLE_SCRIPT_SIZE, "%s %u", COMPOSE, count);
+	OracleCheck(&oracleMemoCompose, script, count + 1, args, &res, &expected);
+	PolyDestroy(&expected);
+	free(args);
+	return res;
+}
+
+Poly OracleAddMapped(const Poly *p, const MappedPoly *q)
+{
+	Poly args[2] = {*p, MappedPolyToPoly(q)};
+	Poly res = PolyAddMapped(p, q);
+	Poly expected = PolyAdd(p, &(args[1]));
+	OracleCheck(&oracleAddMapped, ADD, 2, args, &res, &expected);
+	PolyDestroy(&expected);
+	PolyDestroy(&(args[1]));
+	return res;
+}
+
+Poly OracleMulMapped(const Poly *p, const MappedPoly *q)
+{
+	Poly args[2] = {*p, MappedPolyToPoly(q)};
+	Poly res = PolyMulMapped(p, q);
+	Poly expected = PolyMul(p, &(args[1]));
+	OracleCheck(&oracleMulMapped, MUL, 2, args, &res, &expected);
+	PolyDestroy(&expected);
+	PolyDestroy(&(args[1]));
+	return res;
+}
+
+Poly OracleMappedAt(const MappedPoly *p, poly_coeff_t x)
+{
+	Poly arg = MappedPolyToPoly(p);
+	Poly res = MappedPolyAt(p, x);
+	Poly expected = PolyAt(&arg, x);
+	char script[ORACLE_SCRIPT_SIZE];
+	snprintf(script, ORACLE_SCRIPT_SIZE, "%s %ld", AT, x);
+	OracleCheck(&oracleMappedAt, script, 1, &arg, &res, &expected);
+	PolyDestroy(&expected);
+	PolyDestroy(&arg);
+	return res;
+}
@@ -0,0 +1,103 @@
+/** @file
+   Interfejs trybu wyroczni: porównywania szybkich wersji operacji arytmetycznych
+   z implementacją wzorcową
+
+   Kalkulator korzysta z szybszych odpowiedników podstawowych operacji
+   z poly.c: dodawania i mnożenia przez stałą w miejscu, złączonego mnożenia
+   z dodawaniem, zapamiętywanych wyników (zob. memo.h) i operacji na
+   wielomianach odwzorowanych w pamięci (zob. mapped.h). W kompilacji
+   z opcją POLY_ORACLE (zob. CMakeLists.txt) każde ich wywołanie
+   w operation.c i lazy.c jest zastępowane funkcją Oracle...(), która
+   oblicza wynik obiema drogami – szybką i wzorcową (PolyAdd(), PolyMul(),
+   PolyCompose(), PolyAt()) – i porównuje je funkcją PolyIsEq().
+   W przypadku różnicy wypisuje na standardowy strumień błędów minimalny
+   przykład (skrypt kalkulatora, z którego argumentów usunięto wszystkie
+   jednomiany zbędne do odtworzenia różnicy) i przerywa program.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-26
+*/
+#ifndef __ORACLE_H__
+#define __ORACLE_H__
+
+#include "poly.h"
+#include "mapped.h"
+
+/**
+ * PolyAddInPlace() sprawdzane z PolyAdd()
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian (przejmowany na własność)
+ */
+void OracleAddInPlace(Poly *p, Poly *q);
+
+/**
+ * PolyScaleInPlace() sprawdzane z PolyMul()
+ * @param[in] p : wielomian
+ * @param[in] c : stała
+ */
+void OracleScaleInPlace(Poly *p, poly_coeff_t c);
+
+/**
+ * PolyMulAdd() sprawdzane z PolyMul() i PolyAdd()
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @param[in] r : wielomian
+ * @return `p * q + r`
+ */
+Poly OracleMulAdd(const Poly *p, const Poly *q, const Poly *r);
+
+/**
+ * MemoMul() sprawdzane z PolyMul()
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @return `p * q`
+ */
+Poly OracleMemoMul(const Poly *p, const Poly *q);
+
+/**
+ * MemoCompose() sprawdzane z PolyCompose()
+ * @param[in] p : wielomian
+ * @param[in] count : liczba wielomianów @p x
+ * @param[in] x : podstawiane wielomiany
+ * @return złożenie wielomianów
+ */
+Poly OracleMemoCompose(const Poly *p, unsigned count, const Poly x[]);
+
+/**
+ * PolyAddMapped() sprawdzane z PolyAdd()
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian odwzorowany w pamięci
+ * @return `p + q`
+ */
+Poly OracleAddMapped(const Poly *p, const MappedPoly *q);
+
+/**
+ * PolyMulMapped() sprawdzane z PolyMul()
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian odwzorowany w pamięci
+ * @return `p * q`
+ */
+Poly OracleMulMapped(const Poly *p, const MappedPoly *q);
+
+/**
+ * MappedPolyAt() sprawdzane z PolyAt()
+ * @param[in] p : wielomian odwzorowany w pamięci
+ * @param[in] x : wartość pierwszej zmiennej
+ * @return wynik podstawienia
+ */
+Poly OracleMappedAt(const MappedPoly *p, poly_coeff_t x);
+
+/* oracle.c wywołuje szybkie wersje bezpośrednio */
+#if defined(POLY_ORACLE) && !defined(ORACLE_NO_REDIRECT)
+#define PolyAddInPlace OracleAddInPlace
+#define PolyScaleInPlace OracleScaleInPlace
+#define PolyMulAdd OracleMulAdd
+#define MemoMul OracleMemoMul
+#define MemoCompose OracleMemoCompose
+#define PolyAddMapped OracleAddMapped
+#define PolyMulMapped OracleMulMapped
+#define MappedPolyAt OracleMappedAt
+#endif /* POLY_ORACLE */
+
+#endif /* __ORACLE_H__ */
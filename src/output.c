@@ -0,0 +1,199 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "output.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+/** Maksymalna długość zapisu dziesiętnego liczby typu long (ze znakiem) */
+#define MAX_LONG_LENGTH 21
+
+/// @private
+static _Thread_local char outputBuffer[OUTPUT_BUFFER_SIZE];
+/// @private
+static _Thread_local size_t outputPosition = 0;
+/** Czy standardowe wyjście jest terminalem (-1, jeśli jeszcze nie sprawdzono) */
+static int outputIsTerminal = -1;
+/** Czy wyjście jest wyciszone (zob. OutputSetSuppressed()) */
+static _Thread_local bool outputSuppressed = false;
+/** Bufor w pamięci, do którego trafia wyjście (zob. OutputSetSink()) */
+static _Thread_local ByteBuffer *outputSink = NULL;
+
+/**
+ * Zapisy dziesiętne wszystkich liczb dwucyfrowych, zapisane jedna po drugiej.
+ * Zapis liczby `n` zaczyna się na pozycji `2 * n`.
+ */
+static const char digitPairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+void OutputFlush()
+{
+	if(outputSuppressed)
+	{
+		outputPosition = 0;
+		return;
+	}
+	if(outputSink != NULL)
+	{
+		ByteBufferAppend(outputSink, outputBuffer, outputPosition);
+		outputPosition = 0;
+		return;
+	}
+#ifdef UNIT_TESTING
+	printf("%.*s", (int)outputPosition, outputBuffer);
+#else
+	size_t written = 0;
+	while(written < outputPosition)
+	{
+		ssize_t res = write(STDOUT_FILENO, outputBuffer + written, outputPosition - written);
+		if(res < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+		written += (size_t)res;
+	}
+#endif /* UNIT_TESTING */
+	outputPosition = 0;
+}
+
+void OutputSetSuppressed(bool suppressed)
+{
+	if(suppressed && !outputSuppressed)
+	{
+		OutputFlush();
+	}
+	else if(!suppressed && outputSuppressed)
+	{
+		outputPosition = 0;
+	}
+	outputSuppressed = suppressed;
+}
+
+bool OutputIsSuppressed()
+{
+	return outputSuppressed;
+}
+
+ByteBuffer *OutputSetSink(ByteBuffer *sink)
+{
+	ByteBuffer *previous = outputSink;
+	OutputFlush();
+	outputSink = sink;
+	return previous;
+}
+
+void OutputBytes(const char *s, size_t size)
+{
+	while(size > 0)
+	{
+		if(outputPosition == OUTPUT_BUFFER_SIZE)
+		{
+			OutputFlush();
+		}
+		size_t chunk = OUTPUT_BUFFER_SIZE - outputPosition;
+		if(chunk > size)
+		{
+			chunk = size;
+		}
+		memcpy(outputBuffer + outputPosition, s, chunk);
+		outputPosition += chunk;
+		s += chunk;
+		size -= chunk;
+	}
+}
+
+/**
+ * Sprawdza, czy standardowe wyjście jest terminalem.
+ * W takim przypadku bufor jest opróżniany po każdej linii.
+ * @return Czy standardowe wyjście jest terminalem
+ */
+static bool OutputIsInteractive()
+{
+	if(outputIsTerminal < 0)
+	{
+#ifdef UNIT_TESTING
+		outputIsTerminal = 0;
+#else
+		outputIsTerminal = isatty(STDOUT_FILENO);
+#endif /* UNIT_TESTING */
+	}
+	return outputIsTerminal;
+}
+
+void OutputChar(char c)
+{
+	if(outputPosition == OUTPUT_BUFFER_SIZE)
+	{
+		OutputFlush();
+	}
+	outputBuffer[outputPosition++] = c;
+
+	if(c == '\n' && outputSink == NULL && OutputIsInteractive())
+	{
+		OutputFlush();
+	}
+}
+
+void OutputString(const char *s)
+{
+	OutputBytes(s, strlen(s));
+}
+
+void OutputLong(long l)
+{
+	char tab[MAX_LONG_LENGTH];
+	char *pos = tab + MAX_LONG_LENGTH;
+	/* liczymy na wartości bezwzględnej typu unsigned, żeby obsłużyć LONG_MIN */
+	unsigned long abs = (l < 0) ? (0ul - (unsigned long)l) : (unsigned long)l;
+
+	while(abs >= 100)
+	{
+		unsigned long pair = (abs % 100) * 2;
+		abs /= 100;
+		pos -= 2;
+		pos[0] = digitPairs[pair];
+		pos[1] = digitPairs[pair + 1];
+	}
+	if(abs >= 10)
+	{
+		pos -= 2;
+		pos[0] = digitPairs[abs * 2];
+		pos[1] = digitPairs[abs * 2 + 1];
+	}
+	else
+	{
+		*(--pos) = (char)('0' + abs);
+	}
+	if(l < 0)
+	{
+		*(--pos) = '-';
+	}
+
+	size_t size = (size_t)(tab + MAX_LONG_LENGTH - pos);
+	if(outputPosition + size <= OUTPUT_BUFFER_SIZE)
+	{
+		memcpy(outputBuffer + outputPosition, pos, size);
+		outputPosition += size;
+	}
+	else
+	{
+		OutputBytes(pos, size);
+	}
+}
@@ -0,0 +1,85 @@
+/** @file
+   Interfejs bufora standardowego wyjścia kalkulatora wielomianów
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-10
+*/
+#ifndef __OUTPUT_H__
+#define __OUTPUT_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "serialize.h"
+
+/** Rozmiar bufora wyjścia (w bajtach) */
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+
+/**
+ * Wypisuje całą zawartość bufora na standardowe wyjście
+ * (jednym wywołaniem `write`, o ile system na to pozwoli) i opróżnia bufor.
+ */
+void OutputFlush();
+
+/**
+ * Włącza lub wyłącza wyciszenie wyjścia kalkulatora. Przy włączaniu
+ * opróżnia bufor, a gdy wyjście jest wyciszone, zawartość bufora jest
+ * porzucana zamiast wypisywania (zob. też ErrorSetSuppressed()).
+ * @param[in] suppressed : czy wyjście ma być wyciszone
+ */
+void OutputSetSuppressed(bool suppressed);
+
+/**
+ * Sprawdza, czy wyjście kalkulatora jest wyciszone
+ * @return Czy wyjście jest wyciszone
+ */
+bool OutputIsSuppressed();
+
+/**
+ * Kieruje wyjście kalkulatora do bufora w pamięci zamiast na standardowe
+ * wyjście (np. dla kontekstów z libpoly.h). Przed zmianą opróżnia bufor
+ * wyjścia do dotychczasowego miejsca. Ustawienie, tak jak sam bufor
+ * wyjścia, dotyczy tylko bieżącego wątku.
+ * @param[in] sink : bufor lub NULL, jeśli wyjście ma trafiać na standardowe wyjście
+ * @return poprzedni bufor (lub NULL)
+ */
+ByteBuffer *OutputSetSink(ByteBuffer *sink);
+
+/**
+ * Dopisuje do bufora wyjścia @p size znaków z tablicy @p s.
+ * Gdy bufor się zapełni, jest on opróżniany.
+ * @param[in] s : tablica znaków
+ * @param[in] size : liczba znaków
+ */
+void OutputBytes(const char *s, size_t size);
+
+/**
+ * Dopisuje do bufora wyjścia znak @p c.
+ * Jeśli standardowe wyjście jest terminalem, znak końca linii opróżnia bufor.
+ * @param[in] c : znak
+ */
+void OutputChar(char c);
+
+/**
+ * Dopisuje do bufora wyjścia ciąg znaków zakończony zerem
+ * @param[in] s : ciąg znaków
+ */
+void OutputString(const char *s);
+
+/**
+ * Dopisuje do bufora wyjścia zapis dziesiętny liczby @p l
+ * @param[in] l : liczba
+ */
+void OutputLong(long l);
+
+/**
+ * Dopisuje do bufora wyjścia zapis dziesiętny liczby @p i
+ * @param[in] i : liczba
+ */
+static inline void OutputInt(int i)
+{
+	OutputLong(i);
+}
+
+#endif /* __OUTPUT_H__ */
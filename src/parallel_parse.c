@@ -0,0 +1,310 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parallel_parse.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "read.h"
+#include "memstat.h"
+
+#include "utils.h"
+
+/**
+ * Fragment wiersza parsowany przez jeden wątek wraz z wynikiem parsowania
+ */
+typedef struct ParseChunk
+{
+	const char *text; ///< znaki fragmentu
+	size_t size; ///< liczba znaków fragmentu
+	Mono *monos; ///< wczytane jednomiany (posortowane względem wykładników)
+	unsigned count; ///< liczba wczytanych jednomianów
+	bool ok; ///< czy fragment został poprawnie sparsowany
+} ParseChunk;
+
+/**
+ * Para fragmentów, których jednomiany są scalane (wynik trafia do pierwszego)
+ */
+typedef struct MergeTask
+{
+	ParseChunk *fst; ///< pierwszy fragment (otrzymuje wynik)
+	ParseChunk *snd; ///< drugi fragment (zostaje opróżniony)
+} MergeTask;
+
+/**
+ * Usuwa z pamięci jednomiany wczytane z fragmentu
+ * @param[in] chunk : fragment
+ */
+static void ParseChunkDestroy(ParseChunk *chunk)
+{
+	for(unsigned i = 0; i < chunk->count; i++)
+	{
+		MonoDestroy(&(chunk->monos[i]));
+	}
+	free(chunk->monos);
+	chunk->monos = NULL;
+	chunk->count = 0;
+}
+
+/**
+ * Funkcja wątku parsującego fragment wiersza
+ * @param[in] data : fragment (ParseChunk)
+ * @return NULL
+ */
+static void *ParseChunkThread(void *data)
+{
+	ParseChunk *chunk = data;
+	ParseError error = NoParseError();
+	int columnNumber = 1;
+
+	ReadSetSource(chunk->text, chunk->size);
+	ReadMonos(0, &columnNumber, &error, &(chunk->monos), &(chunk->count));
+	chunk->ok = (!error.hasError && ReadSourceAtEnd());
+	ReadSetSource(NULL, 0);
+
+	if(chunk->ok)
+	{
+		qsort(chunk->monos, chunk->count, sizeof(Mono), MonoCmp);
+	}
+	else
+	{
+		ParseChunkDestroy(chunk);
+	}
+	MemStatFlush();
+	MonoPoolRelease();
+	return NULL;
+}
+
+/**
+ * Funkcja wątku scalającego posortowane jednomiany dwóch fragmentów
+ * @param[in] data : para fragmentów (MergeTask)
+ * @return NULL
+ */
+static void *MergeChunksThread(void *data)
+{
+	MergeTask *task = data;
+	ParseChunk *fst = task->fst;
+	ParseChunk *snd = task->snd;
+	unsigned count = fst->count + snd->count;
+	Mono *merged = malloc(count * sizeof(Mono));
+	assert(merged != NULL);
+
+	unsigned i = 0, j = 0, k = 0;
+	while(i < fst->count && j < snd->count)
+	{
+		if(MonoCmp(&(snd->monos[j]), &(fst->monos[i])) < 0)
+		{
+			merged[k++] = snd->monos[j++];
+		}
+		else
+		{
+			merged[k++] = fst->monos[i++];
+		}
+	}
+	while(i < fst->count)
+	{
+		merged[k++] = fst->monos[i++];
+	}
+	while(j < snd->count)
+	{
+		merged[k++] = snd->monos[j++];
+	}
+
+	free(fst->monos);
+	free(snd->monos);
+	fst->monos = merged;
+	fst->count = count;
+	snd->monos = NULL;
+	snd->count = 0;
+	return NULL;
+}
+
+/**
+ * Wywołanie funkcji w osobnym wątku (zob. RunInParallel())
+ */
+typedef struct ParallelCall
+{
+	void *(*run)(void*); ///< wywoływana funkcja
+	void *arg; ///< argument funkcji
+} ParallelCall;
+
+#ifdef UNIT_TESTING
+/**
+ * Alokator używany w testach nie jest bezpieczny dla wątków, więc w testach
+ * wątki wykonują swoje wywołania po kolei (ale każde w swoim wątku)
+ */
+static pthread_mutex_t parallelTestLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+ * Funkcja wątku wykonującego jedno wywołanie
+ * @param[in] data : wywołanie (ParallelCall)
+ * @return NULL
+ */
+static void *ParallelCallThread(void *data)
+{
+	ParallelCall *call = data;
+#ifdef UNIT_TESTING
+	pthread_mutex_lock(&parallelTestLock);
+	call->run(call->arg);
+	pthread_mutex_unlock(&parallelTestLock);
+#else
+	call->run(call->arg);
+#endif
+	return NULL;
+}
+
+/**
+ * Wywołuje funkcję @p run dla każdego z @p count argumentów, każde wywołanie
+ * w osobnym wątku (pierwsze w bieżącym), i czeka na zakończenie wszystkich.
+ * Jeśli wątku nie da się utworzyć, odpowiednie wywołanie wykonuje się w bieżącym wątku.
+ * @param[in] run : wywoływana funkcja
+ * @param[in] args : tablica argumentów
+ * @param[in] argSize : rozmiar jednego argumentu
+ * @param[in] count : liczba argumentów (nie większa niż PARALLEL_PARSE_MAX_THREADS)
+ */
+static void RunInParallel(void *(*run)(void*), void *args, size_t argSize, unsigned count)
+{
+	char *arg = args;
+	ParallelCall calls[PARALLEL_PARSE_MAX_THREADS];
+	pthread_t threads[PARALLEL_PARSE_MAX_THREADS];
+	bool started[PARALLEL_PARSE_MAX_THREADS];
+
+	for(unsigned i = 0; i < count; i++)
+	{
+		calls[i] = (ParallelCall) {.run = run, .arg = arg + i * argSize};
+	}
+	for(unsigned i = 1; i < count; i++)
+	{
+		started[i] = (pthread_create(&(threads[i]), NULL, ParallelCallThread, &(calls[i])) == 0);
+		if(!started[i])
+		{
+			ParallelCallThread(&(calls[i]));
+		}
+	}
+	ParallelCallThread(&(calls[0]));
+	for(unsigned i = 1; i < count; i++)
+	{
+		if(started[i])
+		{
+			pthread_join(threads[i], NULL);
+		}
+	}
+}
+
+/**
+ * Dzieli wiersz na co najwyżej @p maxChunks fragmentów o zbliżonej długości
+ * w miejscach znaków '+' leżących poza nawiasami (znaki podziału nie należą
+ * do żadnego fragmentu)
+ * @param[in] text : znaki wiersza
+ * @param[in] size : liczba znaków wiersza
+ * @param[in] maxChunks : maksymalna liczba fragmentów
+ * @param[out] chunks : fragmenty
+ * @return liczba fragmentów
+ */
+static unsigned SplitIntoChunks(const char *text, size_t size, unsigned maxChunks, ParseChunk chunks[])
+{
+	size_t target = size / maxChunks;
+	size_t start = 0;
+	unsigned count = 0;
+	long depth = 0;
+
+	for(size_t i = 0; i < size && count + 1 < maxChunks; i++)
+	{
+		if(text[i] == '(')
+		{
+			depth++;
+		}
+		else if(text[i] == ')')
+		{
+			depth--;
+		}
+		else if(text[i] == '+' && depth == 0 && i - start >= target)
+		{
+			chunks[count++] = (ParseChunk) {.text = text + start, .size = i - start,
+				.monos = NULL, .count = 0, .ok = false};
+			start = i + 1;
+		}
+	}
+	chunks[count++] = (ParseChunk) {.text = text + start, .size = size - start,
+		.monos = NULL, .count = 0, .ok = false};
+	return count;
+}
+
+/**
+ * Zwraca liczbę wątków, które warto użyć do parsowania
+ * @return liczba wątków (od 1 do PARALLEL_PARSE_MAX_THREADS)
+ */
+static unsigned ParallelParseThreads()
+{
+#ifdef UNIT_TESTING
+	/* w testach wątki powstają niezależnie od liczby procesorów */
+	return PARALLEL_PARSE_MAX_THREADS;
+#else
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if(cpus < 1)
+	{
+		return 1;
+	}
+	if(cpus > PARALLEL_PARSE_MAX_THREADS)
+	{
+		return PARALLEL_PARSE_MAX_THREADS;
+	}
+	return (unsigned)cpus;
+#endif
+}
+
+bool ParsePolyParallel(const char *text, size_t size, Poly *p)
+{
+	if(size < PARALLEL_PARSE_MIN_LENGTH || text[0] != '(')
+	{
+		return false;
+	}
+	unsigned threads = ParallelParseThreads();
+	if(threads < 2)
+	{
+		return false;
+	}
+
+	ParseChunk chunks[PARALLEL_PARSE_MAX_THREADS];
+	unsigned count = SplitIntoChunks(text, size, threads, chunks);
+	if(count < 2)
+	{
+		return false;
+	}
+	RunInParallel(ParseChunkThread, chunks, sizeof(ParseChunk), count);
+
+	bool ok = true;
+	for(unsigned i = 0; i < count; i++)
+	{
+		ok = ok && chunks[i].ok;
+	}
+	if(!ok)
+	{
+		for(unsigned i = 0; i < count; i++)
+		{
+			ParseChunkDestroy(&(chunks[i]));
+		}
+		return false;
+	}
+
+	while(count > 1)
+	{
+		MergeTask tasks[PARALLEL_PARSE_MAX_THREADS / 2];
+		unsigned taskCount = count / 2;
+		for(unsigned i = 0; i < taskCount; i++)
+		{
+			tasks[i] = (MergeTask) {.fst = &(chunks[2 * i]), .snd = &(chunks[2 * i + 1])};
+		}
+		RunInParallel(MergeChunksThread, tasks, sizeof(MergeTask), taskCount);
+		for(unsigned i = 0; i < (count + 1) / 2; i++)
+		{
+			chunks[i] = chunks[2 * i];
+		}
+		count = (count + 1) / 2;
+	}
+
+	*p = PolyFromSortedMonos(chunks[0].count, chunks[0].monos);
+	free(chunks[0].monos);
+	return true;
+}
@@ -0,0 +1,40 @@
+/** @file
+   Interfejs równoległego parsowania bardzo długich wielomianów
+
+   Wiersz z wielomianem dzielony jest na fragmenty w miejscach znaków '+'
+   leżących poza nawiasami. Każdy fragment jest parsowany w osobnym wątku
+   do posortowanej tablicy jednomianów, a tablice są następnie scalane
+   parami (również równolegle).
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-16
+*/
+#ifndef __PARALLEL_PARSE_H__
+#define __PARALLEL_PARSE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "poly.h"
+
+#ifndef PARALLEL_PARSE_MIN_LENGTH
+/** Minimalna długość wiersza, od której wielomian jest parsowany równolegle */
+#define PARALLEL_PARSE_MIN_LENGTH (1 << 16)
+#endif
+
+/** Maksymalna liczba wątków parsujących jeden wiersz */
+#define PARALLEL_PARSE_MAX_THREADS 8
+
+/**
+ * Próbuje sparsować równolegle wiersz z wielomianem będącym sumą jednomianów.
+ * Nie zgłasza błędów: jeśli wiersz jest za krótki, nie jest sumą jednomianów
+ * lub zawiera błąd, zwraca false i należy go sparsować sekwencyjnie
+ * (co zapewnia zgłoszenie pierwszego błędu w tej samej kolumnie).
+ * @param[in] text : znaki wiersza (bez znaku końca wiersza)
+ * @param[in] size : liczba znaków wiersza
+ * @param[out] p : wczytany wielomian (tylko w przypadku powodzenia)
+ * @return Czy wielomian został wczytany
+ */
+bool ParsePolyParallel(const char *text, size_t size, Poly *p);
+
+#endif /* __PARALLEL_PARSE_H__ */
@@ -0,0 +1,110 @@
+#define _GNU_SOURCE
+
+#include "perfcount.h"
+
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+/** Typy i konfiguracje zdarzeń kolejnych liczników */
+static const struct
+{
+	uint32_t type; ///< typ zdarzenia
+	uint64_t config; ///< konfiguracja zdarzenia
+} perfEvents[PERF_COUNTER_AMOUNT] = {
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+};
+
+/** Deskryptory kolejnych liczników (-1, jeśli licznik nie jest otwarty) */
+static int perfFd[PERF_COUNTER_AMOUNT] = {-1, -1, -1, -1};
+/**
+ * Pozycje kolejnych liczników w odczycie grupy
+ * (-1, jeśli licznik nie jest otwarty)
+ */
+static int perfSlot[PERF_COUNTER_AMOUNT] = {-1, -1, -1, -1};
+/** Liczba otwartych liczników */
+static int perfOpened = 0;
+
+/**
+ * Otwiera licznik
+ * @param[in] counter : rodzaj licznika
+ * @param[in] groupFd : deskryptor lidera grupy (-1 dla lidera)
+ * @return deskryptor licznika lub -1
+ */
+static int PerfEventOpen(PerfCounter counter, int groupFd)
+{
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = perfEvents[counter].type;
+	attr.config = perfEvents[counter].config;
+	attr.read_format = PERF_FORMAT_GROUP;
+	attr.disabled = (groupFd == -1);
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+bool PerfCountersOpen()
+{
+	perfFd[PERF_CYCLES] = PerfEventOpen(PERF_CYCLES, -1);
+	if(perfFd[PERF_CYCLES] < 0)
+	{
+		return false;
+	}
+	perfSlot[PERF_CYCLES] = perfOpened++;
+	for(int i = PERF_CYCLES + 1; i < PERF_COUNTER_AMOUNT; i++)
+	{
+		perfFd[i] = PerfEventOpen((PerfCounter)i, perfFd[PERF_CYCLES]);
+		if(perfFd[i] >= 0)
+		{
+			perfSlot[i] = perfOpened++;
+		}
+	}
+	ioctl(perfFd[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(perfFd[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return true;
+}
+
+void PerfCountersRead(PerfCounts *counts)
+{
+	memset(counts, 0, sizeof(PerfCounts));
+	if(perfOpened == 0)
+	{
+		return;
+	}
+	/* odczyt grupy: liczba liczników, a po niej ich wartości */
+	uint64_t data[1 + PERF_COUNTER_AMOUNT];
+	ssize_t size = read(perfFd[PERF_CYCLES], data, sizeof(data));
+	if(size < (ssize_t)sizeof(uint64_t) || data[0] != (uint64_t)perfOpened)
+	{
+		return;
+	}
+	for(int i = 0; i < PERF_COUNTER_AMOUNT; i++)
+	{
+		if(perfSlot[i] >= 0)
+		{
+			counts->value[i] = data[1 + perfSlot[i]];
+		}
+	}
+}
+
+void PerfCountersClose()
+{
+	for(int i = PERF_COUNTER_AMOUNT - 1; i >= 0; i--)
+	{
+		if(perfFd[i] >= 0)
+		{
+			close(perfFd[i]);
+		}
+		perfFd[i] = perfSlot[i] = -1;
+	}
+	perfOpened = 0;
+}
@@ -0,0 +1,57 @@
+/** @file
+   Interfejs sprzętowych liczników wydajności
+
+   Liczniki (cykle, instrukcje, chybienia pamięci podręcznej i błędne
+   przewidywania skoków) są otwierane funkcją systemową `perf_event_open`
+   jako jedna grupa, liczą zdarzenia tylko w przestrzeni użytkownika
+   i tylko w wątku, który je otworzył, i są odczytywane jednym wywołaniem
+   systemowym. Liczniki, których procesor nie udostępnia, mają wartość 0.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-24
+*/
+#ifndef __PERFCOUNT_H__
+#define __PERFCOUNT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Rodzaje liczników
+ */
+typedef enum PerfCounter
+{
+	PERF_CYCLES, ///< cykle procesora
+	PERF_INSTRUCTIONS, ///< wykonane instrukcje
+	PERF_CACHE_MISSES, ///< chybienia pamięci podręcznej
+	PERF_BRANCH_MISSES, ///< błędnie przewidziane skoki
+	PERF_COUNTER_AMOUNT ///< liczba rodzajów liczników
+} PerfCounter;
+
+/**
+ * Stan liczników
+ */
+typedef struct PerfCounts
+{
+	uint64_t value[PERF_COUNTER_AMOUNT]; ///< wartości kolejnych liczników
+} PerfCounts;
+
+/**
+ * Otwiera i uruchamia liczniki dla bieżącego wątku
+ * @return Czy udało się otworzyć przynajmniej licznik cykli
+ */
+bool PerfCountersOpen();
+
+/**
+ * Odczytuje bieżące wartości liczników (zera, jeśli liczniki nie są otwarte)
+ * @param[out] counts : wartości liczników
+ */
+void PerfCountersRead(PerfCounts *counts);
+
+/**
+ * Zamyka liczniki
+ */
+void PerfCountersClose();
+
+#endif /* __PERFCOUNT_H__ */
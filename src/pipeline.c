@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pipeline.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "read.h"
+#include "memstat.h"
+
+#include "utils.h"
+
+/** Liczba prób aktywnego czekania, zanim wątek odda procesor */
+#define PIPELINE_SPIN_LIMIT 64
+/** Liczba prób oddania procesora, zanim wątek zacznie zasypiać */
+#define PIPELINE_YIELD_LIMIT 256
+/** Czas uśpienia wątku czekającego na kolejkę (w nanosekundach) */
+#define PIPELINE_SLEEP_NS 50000
+
+/**
+ * Ograniczona kolejka cykliczna wczytanych wierszy.
+ * Pozycje head i tail rosną nieograniczenie, indeks w tablicy to pozycja
+ * modulo PIPELINE_QUEUE_SIZE.
+ */
+typedef struct LineQueue
+{
+	ParsedLine lines[PIPELINE_QUEUE_SIZE]; ///< wczytane wiersze
+	atomic_size_t head; ///< pozycja następnego wiersza do wykonania (zmieniana przez konsumenta)
+	atomic_size_t tail; ///< pozycja następnego wiersza do wczytania (zmieniana przez producenta)
+	atomic_bool finished; ///< czy producent wczytał już całe wejście
+} LineQueue;
+
+/**
+ * Argumenty wątku wczytującego
+ */
+typedef struct ReaderArgs
+{
+	LineQueue *queue; ///< kolejka wczytanych wierszy
+	Operation *operation; ///< bezargumentowe operacje
+	OperationWithArg *opWithArg; ///< jednoargumentowe operacje
+	OperationWithStringArg *opWithStrArg; ///< operacje z argumentem tekstowym
+} ReaderArgs;
+
+/**
+ * Czeka chwilę na zmianę stanu kolejki – najpierw aktywnie,
+ * potem oddając procesor, a w końcu zasypiając
+ * @param[in] attempts : liczba dotychczasowych prób (zwiększana)
+ */
+static void PipelineWait(unsigned *attempts)
+{
+	(*attempts)++;
+	if(*attempts < PIPELINE_SPIN_LIMIT)
+	{
+		return;
+	}
+	if(*attempts < PIPELINE_YIELD_LIMIT)
+	{
+		sched_yield();
+		return;
+	}
+	struct timespec ts = {.tv_sec = 0, .tv_nsec = PIPELINE_SLEEP_NS};
+	nanosleep(&ts, NULL);
+}
+
+/**
+ * Funkcja wątku wczytującego: parsuje kolejne wiersze i wstawia je do kolejki
+ * @param[in] data : argumenty wątku (ReaderArgs)
+ * @return NULL
+ */
+static void *ReaderThread(void *data)
+{
+	ReaderArgs *args = data;
+	LineQueue *queue = args->queue;
+	int currLine = 1;
+	ParsedLine line;
+
+	while(ParseLine(currLine, args->operation, args->opWithArg, args->opWithStrArg, &line))
+	{
+		size_t tail = atomic_load_explicit(&(queue->tail), memory_order_relaxed);
+		unsigned attempts = 0;
+		while(tail - atomic_load_explicit(&(queue->head), memory_order_acquire) == PIPELINE_QUEUE_SIZE)
+		{
+			PipelineWait(&attempts);
+		}
+		queue->lines[tail % PIPELINE_QUEUE_SIZE] = line;
+		atomic_store_explicit(&(queue->tail), tail + 1, memory_order_release);
+		currLine++;
+	}
+	MemStatFlush();
+	MonoPoolRelease();
+	atomic_store_explicit(&(queue->finished), true, memory_order_release);
+	return NULL;
+}
+
+void RunPipelined(PolyStack *pStack, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[])
+{
+	LineQueue *queue = malloc(sizeof(LineQueue));
+	assert(queue != NULL);
+	atomic_init(&(queue->head), 0);
+	atomic_init(&(queue->tail), 0);
+	atomic_init(&(queue->finished), false);
+
+	ReaderArgs args = {.queue = queue, .operation = operation,
+		.opWithArg = opWithArg, .opWithStrArg = opWithStrArg};
+	pthread_t reader;
+	if(pthread_create(&reader, NULL, ReaderThread, &args) != 0)
+	{
+		/* bez drugiego wątku wykonujemy wszystko sekwencyjnie */
+		free(queue);
+		int currLine = 1;
+		while(ReadLine(pStack, currLine, operation, opWithArg, opWithStrArg))
+		{
+			currLine++;
+		}
+		return;
+	}
+
+	size_t head = 0;
+	while(1)
+	{
+		unsigned attempts = 0;
+		while(head == atomic_load_explicit(&(queue->tail), memory_order_acquire))
+		{
+			if(atomic_load_explicit(&(queue->finished), memory_order_acquire) &&
+				head == atomic_load_explicit(&(queue->tail), memory_order_acquire))
+			{
+				break;
+			}
+			PipelineWait(&attempts);
+		}
+		if(head == atomic_load_explicit(&(queue->tail), memory_order_acquire))
+		{
+			break;
+		}
+		ExecuteParsedLine(pStack, &(queue->lines[head % PIPELINE_QUEUE_SIZE]));
+		head++;
+		atomic_store_explicit(&(queue->head), head, memory_order_release);
+	}
+
+	pthread_join(reader, NULL);
+	free(queue);
+}
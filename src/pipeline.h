@@ -0,0 +1,33 @@
+/** @file
+   Interfejs potokowego wykonywania poleceń kalkulatora wielomianów
+
+   W trybie potokowym osobny wątek wczytuje i parsuje wiersze wejścia,
+   a wątek główny wykonuje je na stosie. Wątki komunikują się przez
+   ograniczoną kolejkę cykliczną bez blokad (jeden producent, jeden konsument).
+   Błędy i wyniki są wypisywane wyłącznie przez wątek wykonujący, 
+   więc ich kolejność jest taka sama, jak w trybie sekwencyjnym.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-16
+*/
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include "polystack.h"
+#include "operation.h"
+
+/** Pojemność kolejki wczytanych wierszy */
+#define PIPELINE_QUEUE_SIZE 256
+
+/**
+ * Wczytuje (w osobnym wątku) i wykonuje wszystkie wiersze standardowego wejścia
+ * @param[in] pStack : stos wielomianów (część kalkulatora)
+ * @param[in] operation : bezargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithArg : jednoargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym udostępnione przez kalkulator
+ */
+void RunPipelined(PolyStack *pStack, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[]);
+
+#endif /* __PIPELINE_H__ */
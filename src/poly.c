@@ -1,6 +1,57 @@
 #include "poly.h"
+#include "output.h"
+#include "memstat.h"
+#include "trace.h"
 #include "utils.h"
 
+/**
+ * Maksymalna liczba wolnych jednomianów przechowywanych przez wątek do
+ * ponownego użycia (w testach jednostkowych 0, żeby nie ukrywać wycieków)
+ */
+#ifdef UNIT_TESTING
+#define MONO_POOL_MAX 0
+#else
+#define MONO_POOL_MAX 4096
+#endif /* UNIT_TESTING */
+
+/** Limit puli jako zmienna – porównanie ze stałą 0 budziłoby ostrzeżenie kompilatora */
+static const size_t monoPoolMax = MONO_POOL_MAX;
+/** Wolne jednomiany bieżącego wątku (połączone polem next) */
+static _Thread_local Mono *monoPool = NULL;
+/** Liczba wolnych jednomianów bieżącego wątku */
+static _Thread_local size_t monoPoolSize = 0;
+
+/**
+ * Zwalnia pamięć jednomianu (bez jego współczynnika): odkłada go do puli
+ * bieżącego wątku lub, gdy pula jest pełna, zwalnia funkcją free()
+ * @param[in] m : jednomian
+ */
+static void MonoFreeNode(Mono *m)
+{
+	MemStatFree(MEM_MONO, 1);
+	if(monoPoolSize < monoPoolMax)
+	{
+		m->next = monoPool;
+		monoPool = m;
+		monoPoolSize++;
+	}
+	else
+	{
+		free(m);
+	}
+}
+
+void MonoPoolRelease()
+{
+	while(monoPool != NULL)
+	{
+		Mono *next = monoPool->next;
+		free(monoPool);
+		monoPool = next;
+	}
+	monoPoolSize = 0;
+}
+
 void MonoDestroy(Mono *m)
 {
 	if(m != NULL)
@@ -9,17 +60,12 @@ void MonoDestroy(Mono *m)
 	}
 }
 
-/**
- * Usuwa jednomian @p m z pamięci i zwalnia pamięć, 
- * która została zaalokowana na sam wskaźnik.
- * @param[in] m : jednomian
- */
 void MonoDestroyMalloced(Mono *m)
 {
 	if(m != NULL)
 	{
 		MonoDestroy(m);
-		free(m);
+		MonoFreeNode(m);
 	}
 }
 
@@ -41,13 +87,95 @@ int MonoListLength(const MonoList *ml)
 }
 
 /**
- * Tworzy wskaźnik na zaalokowany dynamicznie jednomian zerowy.
- * @return wskaźnik na wielomian zerowy
+ * Zwraca liczbę jednomianów najwyższego poziomu wielomianu (do zdarzeń śladu)
+ * @param[in] p : wielomian
+ * @return liczba jednomianów
+ */
+static long PolyTraceTerms(const Poly *p)
+{
+	return PolyIsCoeff(p) ? 0 : MonoListLength(&(p->ml));
+}
+
+/**
+ * Rozpoczyna zdarzenie śladu dla operacji na wielomianach @p p i @p q
+ * (zob. trace.h); argumentem zdarzenia jest łączna liczba ich jednomianów
+ * @param[in] name : nazwa operacji
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian (lub NULL)
+ * @return Czy zdarzenie jest zapisywane
+ */
+static bool PolyTraceBegin(const char *name, const Poly *p, const Poly *q)
+{
+	if(!TraceActive())
+	{
+		return false;
+	}
+	TraceBegin(name, "terms", PolyTraceTerms(p) + (q != NULL ? PolyTraceTerms(q) : 0));
+	return true;
+}
+
+/**
+ * Kończy zdarzenie śladu operacji rozpoczęte przez PolyTraceBegin();
+ * argumentem zdarzenia jest liczba jednomianów wyniku
+ * @param[in] traced : czy zdarzenie jest zapisywane
+ * @param[in] name : nazwa operacji
+ * @param[in] res : wynik operacji
+ */
+static void PolyTraceEnd(bool traced, const char *name, const Poly *res)
+{
+	if(traced)
+	{
+		TraceEnd(name, "terms_out", PolyTraceTerms(res));
+	}
+}
+
+/**
+ * Rozpoczyna zdarzenie śladu dla etapu operacji (np. sortowania)
+ * @param[in] name : nazwa etapu
+ * @param[in] terms : liczba przetwarzanych jednomianów
+ * @return Czy zdarzenie jest zapisywane
+ */
+static bool PolyTracePhaseBegin(const char *name, long terms)
+{
+	if(!TraceActive())
+	{
+		return false;
+	}
+	TraceBegin(name, "terms", terms);
+	return true;
+}
+
+/**
+ * Kończy zdarzenie śladu etapu rozpoczęte przez PolyTracePhaseBegin()
+ * @param[in] traced : czy zdarzenie jest zapisywane
+ * @param[in] name : nazwa etapu
  */
+static void PolyTracePhaseEnd(bool traced, const char *name)
+{
+	if(traced)
+	{
+		TraceEnd(name, NULL, TRACE_NO_ARG);
+	}
+}
+
+/** Liczba jednomianów zaalokowanych przez bieżący wątek (zob. MonoAllocCount()) */
+static _Thread_local uint64_t monoAllocCount = 0;
+
 Mono *MonoMallocEmpty()
 {
-	Mono *newMono = (Mono*)malloc(sizeof(Mono));
-	assert(newMono != NULL);
+	Mono *newMono = monoPool;
+	if(newMono != NULL)
+	{
+		monoPool = newMono->next;
+		monoPoolSize--;
+	}
+	else
+	{
+		newMono = (Mono*)malloc(sizeof(Mono));
+		assert(newMono != NULL);
+	}
+	monoAllocCount++;
+	MemStatAlloc(MEM_MONO, 1);
 	newMono->next = NULL;
 	newMono->prev = NULL;
 	newMono->exp = 0;
@@ -55,6 +183,11 @@ Mono *MonoMallocEmpty()
 	return newMono;
 }
 
+uint64_t MonoAllocCount()
+{
+	return monoAllocCount;
+}
+
 void MonoListAppendMono(MonoList *ml, Mono *m)
 {
 	if(ml->first == NULL)
@@ -120,12 +253,6 @@ Poly PolyClone(const Poly *p)
 	return pClone;
 }
 
-/**
- * Porównuje jednomiany względem ich wykładników.
- * @param[in] fst : jednomian
- * @param[in] snd : jednomian
- * @return liczba < 0, jeśli @p fst < @p snd, 0, jeśli @p fst == @p snd, a > 0, jeśli @p fst > @p snd.
- */
 int MonoCmp(const void *fst, const void *snd)
 {
 	int expFst = ((Mono*)fst)->exp;
@@ -246,19 +373,21 @@ Poly PolyAddMonosFromMonoList(MonoList *ml)
 		iter = iter->next;
 	}
 	
-	Poly res = PolyAddMonos(MonoListLength(ml), monos);
+	Poly res = PolyAddMonos(index, monos);
 	free(monos);
 	
+	bool traced = PolyTracePhaseBegin("destroy", index);
 	iter = ml->first;
 	Mono *iter2;
 	while(iter != NULL)
 	{
 		iter2 = iter->next;
-		free(iter); //wszystko "głębiej" zostanie usunięte 
+		MonoFreeNode(iter); //wszystko "głębiej" zostanie usunięte 
 					//przez wywołany wcześniej PolyAddMonos
 		iter = iter2;
 	}
 	*ml = EmptyMonoList();
+	PolyTracePhaseEnd(traced, "destroy");
 	
 	return res;
 }
@@ -275,8 +404,11 @@ Poly PolyAddMonos(unsigned count, const Mono monos[])
 		monosSorted[i] = monos[i];
 	}
 	
+	bool traced = PolyTracePhaseBegin("sort", count);
 	qsort(monosSorted, count, sizeof(Mono), MonoCmp);
+	PolyTracePhaseEnd(traced, "sort");
 	
+	traced = PolyTracePhaseBegin("merge", count);
 	for(i = 0; i < count; i++)
 	{
 		Mono *newMono = MonoMallocEmpty();
@@ -284,11 +416,28 @@ Poly PolyAddMonos(unsigned count, const Mono monos[])
 		
 		PolyAppendMono(&res, newMono);
 	}
+	PolyTracePhaseEnd(traced, "merge");
+	traced = PolyTracePhaseBegin("destroy", count);
 	for(i = 0; i < count; i++)
 	{
 		MonoDestroy(&monosSorted[i]);
 	}
 	free(monosSorted);
+	PolyTracePhaseEnd(traced, "destroy");
+	return res;
+}
+
+Poly PolyFromSortedMonos(unsigned count, Mono monos[])
+{
+	Poly res = PolyZero();
+	
+	for(unsigned i = 0; i < count; i++)
+	{
+		Mono *newMono = MonoMallocEmpty();
+		*newMono = monos[i];
+		
+		PolyAppendMono(&res, newMono);
+	}
 	return res;
 }
 
@@ -385,13 +534,6 @@ bool PolyIsEq(const Poly *p, const Poly *q)
 	return true;
 }
 
-/**
- * Do listy jednomianów @p ml dodaje głębokie kopie jednomianów zawartych w wielomianie @p p. 
- * Jeśli @p p jest wielomianem zerowym, nie dodaje nic. Jeśli jest wielomianem 
- * stałym różnym od zerowego, dodaje odpowiadający mu jednomian.
- * @param[in] ml : lista jednomianów
- * @param[in] p : wielomian
- */
 void MonoListAppendCopiedMonosFromPoly(MonoList *ml, const Poly *p)
 {
 	if(PolyIsCoeff(p))
@@ -423,12 +565,17 @@ Poly PolyAdd(const Poly *p, const Poly *q)
 	{
 		return PolyFromCoeff(p->c + q->c);
 	}
+	bool traced = PolyTraceBegin("PolyAdd", p, q);
 	MonoList ml = EmptyMonoList();
 	
+	bool tracedClone = PolyTracePhaseBegin("clone", PolyTraceTerms(p) + PolyTraceTerms(q));
 	MonoListAppendCopiedMonosFromPoly(&ml, p);
 	MonoListAppendCopiedMonosFromPoly(&ml, q);
+	PolyTracePhaseEnd(tracedClone, "clone");
 	
-	return PolyAddMonosFromMonoList(&ml);
+	Poly res = PolyAddMonosFromMonoList(&ml);
+	PolyTraceEnd(traced, "PolyAdd", &res);
+	return res;
 }
 /**
  * Mnoży dwa jednomiany.
@@ -467,8 +614,10 @@ Poly PolyMul(const Poly *p, const Poly *q)
 		return res;
 	}
 	
+	bool traced = PolyTraceBegin("PolyMul", p, q);
 	MonoList res = EmptyMonoList();
 	
+	bool tracedMultiply = PolyTracePhaseBegin("multiply", PolyTraceTerms(p) * PolyTraceTerms(q));
 	Mono *iterP = p->ml.first, *iterQ = q->ml.first;
 	while(iterP != NULL)
 	{
@@ -486,13 +635,50 @@ Poly PolyMul(const Poly *p, const Poly *q)
 		iterQ = q->ml.first;
 		iterP = iterP->next;
 	}
+	PolyTracePhaseEnd(tracedMultiply, "multiply");
+	Poly mul = PolyAddMonosFromMonoList(&res);
+	PolyTraceEnd(traced, "PolyMul", &mul);
+	return mul;
+}
+
+uint64_t PolyMonoCountDeep(const Poly *p)
+{
+	uint64_t count = 0;
+	for(Mono *iter = p->ml.first; iter != NULL; iter = iter->next)
+	{
+		count += 1 + PolyMonoCountDeep(&(iter->p));
+	}
+	return count;
+}
+
+Poly PolyMulAdd(const Poly *p, const Poly *q, const Poly *r)
+{
+	if(PolyIsCoeff(p) || PolyIsCoeff(q))
+	{
+		Poly mul = PolyMul(p, q);
+		Poly res = PolyAdd(&mul, r);
+		PolyDestroy(&mul);
+		return res;
+	}
+	
+	MonoList res = EmptyMonoList();
+	
+	for(Mono *iterP = p->ml.first; iterP != NULL; iterP = iterP->next)
+	{
+		for(Mono *iterQ = q->ml.first; iterQ != NULL; iterQ = iterQ->next)
+		{
+			Mono mulMono = MonoMul(iterP, iterQ);
+			if(!PolyIsZero(&(mulMono.p)))
+			{
+				MonoListCopyAndAppend(&res, &mulMono);
+			}
+			MonoDestroy(&mulMono);
+		}
+	}
+	MonoListAppendCopiedMonosFromPoly(&res, r);
 	return PolyAddMonosFromMonoList(&res);
 }
 
-/**
- * Wielomianowi @p p rekurencyjnie ustawia wartości "wewnętrznych" stałych na przeciwne.
- * @param[in] p : wielomian
- */
 void PolySetInverseCoeffs(Poly *p)
 {
 	if(PolyIsCoeff(p))
@@ -519,11 +705,169 @@ Poly PolyNeg(const Poly *p)
 }
 
 /**
- * Zwraca @p x podniesiony do potęgi @p exp.
- * @param[in] x : liczba całkowita
- * @param[in] exp : liczba całkowita
- * @return @p x ^ @p exp.
+ * Doprowadza do postaci kanonicznej wielomian, którego jednomiany mają niezerowe
+ * współczynniki w postaci kanonicznej: pusta lista jednomianów staje się wielomianem
+ * zerowym, a pojedynczy jednomian stopnia 0 ze stałym współczynnikiem – stałą.
+ * @param[in] p : wielomian
+ */
+static void PolyNormalize(Poly *p)
+{
+	if(MonoListIsEmpty(&(p->ml)))
+	{
+		*p = PolyZero();
+	}
+	else if(PolyHasOnlyOneMono(p) && p->ml.first->exp == 0 && PolyIsCoeff(&(p->ml.first->p)))
+	{
+		PolyTurnToCoeff(p);
+	}
+}
+
+/**
+ * Dodaje w miejscu stałą @p c do wielomianu @p p (`p := p + c`).
+ * @param[in] p : wielomian
+ * @param[in] c : stała
  */
+static void PolyAddCoeffInPlace(Poly *p, poly_coeff_t c)
+{
+	if(c == 0)
+	{
+		return;
+	}
+	if(PolyIsCoeff(p))
+	{
+		p->c = p->c + c;
+		return;
+	}
+	
+	Mono *first = p->ml.first;
+	if(first->exp == 0)
+	{
+		PolyAddCoeffInPlace(&(first->p), c);
+		if(PolyIsZero(&(first->p)))
+		{
+			p->ml.first = first->next;
+			if(p->ml.first != NULL)
+			{
+				p->ml.first->prev = NULL;
+			}
+			else
+			{
+				p->ml.last = NULL;
+			}
+			MonoDestroyMalloced(first);
+		}
+		PolyNormalize(p);
+	}
+	else
+	{
+		Mono *m = MonoMallocEmpty();
+		m->p = PolyFromCoeff(c);
+		m->next = first;
+		first->prev = m;
+		p->ml.first = m;
+	}
+}
+
+void PolyAddInPlace(Poly *p, Poly *q)
+{
+	if(PolyIsCoeff(q))
+	{
+		PolyAddCoeffInPlace(p, q->c);
+		*q = PolyZero();
+		return;
+	}
+	if(PolyIsCoeff(p))
+	{
+		poly_coeff_t c = p->c;
+		*p = *q;
+		*q = PolyZero();
+		PolyAddCoeffInPlace(p, c);
+		return;
+	}
+	
+	MonoList res = EmptyMonoList();
+	Mono *iterP = p->ml.first, *iterQ = q->ml.first;
+	
+	while(iterP != NULL || iterQ != NULL)
+	{
+		if(iterQ == NULL || (iterP != NULL && iterP->exp < iterQ->exp))
+		{
+			Mono *next = iterP->next;
+			MonoListAppendMono(&res, iterP);
+			iterP = next;
+		}
+		else if(iterP == NULL || iterQ->exp < iterP->exp)
+		{
+			Mono *next = iterQ->next;
+			MonoListAppendMono(&res, iterQ);
+			iterQ = next;
+		}
+		else
+		{
+			Mono *nextP = iterP->next, *nextQ = iterQ->next;
+			PolyAddInPlace(&(iterP->p), &(iterQ->p));
+			MonoDestroyMalloced(iterQ);
+			if(PolyIsZero(&(iterP->p)))
+			{
+				MonoDestroyMalloced(iterP);
+			}
+			else
+			{
+				MonoListAppendMono(&res, iterP);
+			}
+			iterP = nextP;
+			iterQ = nextQ;
+		}
+	}
+	if(res.last != NULL)
+	{
+		res.last->next = NULL;
+	}
+	p->ml = res;
+	*q = PolyZero();
+	PolyNormalize(p);
+}
+
+void PolyScaleInPlace(Poly *p, poly_coeff_t c)
+{
+	if(c == 0)
+	{
+		PolyDestroy(p);
+		*p = PolyZero();
+		return;
+	}
+	if(PolyIsCoeff(p))
+	{
+		p->c = (p->c) * c;
+		return;
+	}
+	
+	MonoList res = EmptyMonoList();
+	Mono *iter = p->ml.first;
+	
+	while(iter != NULL)
+	{
+		Mono *next = iter->next;
+		/* przy przepełnieniu iloczyn niezerowych liczb może być zerem */
+		PolyScaleInPlace(&(iter->p), c);
+		if(PolyIsZero(&(iter->p)))
+		{
+			MonoDestroyMalloced(iter);
+		}
+		else
+		{
+			MonoListAppendMono(&res, iter);
+		}
+		iter = next;
+	}
+	if(res.last != NULL)
+	{
+		res.last->next = NULL;
+	}
+	p->ml = res;
+	PolyNormalize(p);
+}
+
 poly_coeff_t PowI(poly_coeff_t x, poly_exp_t exp)
 {
 	if(exp == 0)return 1;
@@ -544,6 +888,8 @@ Poly PolyAt(const Poly *p, poly_coeff_t x)
 		return res;
 	}
 	
+	bool traced = PolyTraceBegin("PolyAt", p, NULL);
+	bool tracedEvaluate = PolyTracePhaseBegin("evaluate", PolyTraceTerms(p));
 	Mono *iter = p->ml.first;
 	MonoList ml = EmptyMonoList();
 	
@@ -572,7 +918,10 @@ Poly PolyAt(const Poly *p, poly_coeff_t x)
 		PolyDestroy(&coeff);
 		iter = iter->next;
 	}
-	return PolyAddMonosFromMonoList(&ml);
+	PolyTracePhaseEnd(tracedEvaluate, "evaluate");
+	Poly res = PolyAddMonosFromMonoList(&ml);
+	PolyTraceEnd(traced, "PolyAt", &res);
+	return res;
 }
 
 Mono MonoClone(const Mono *m)
@@ -588,7 +937,7 @@ void PrintPoly(const Poly *p)
 {
 	if(PolyIsCoeff(p))
 	{
-		printf("%ld", p->c);
+		OutputLong(p->c);
 	}
 	else
 	{
@@ -599,7 +948,7 @@ void PrintPoly(const Poly *p)
 			PrintMono(iter);
 			if(iter->next != NULL)
 			{
-				printf("+");
+				OutputChar('+');
 			}
 			iter = iter->next;
 		}
@@ -608,9 +957,11 @@ void PrintPoly(const Poly *p)
 
 void PrintMono(const Mono *m)
 {
-	printf("(");
+	OutputChar('(');
 	PrintPoly(&(m->p));
-	printf(",%d)",m->exp);
+	OutputChar(',');
+	OutputInt(m->exp);
+	OutputChar(')');
 }
 /*
 Mono MonoZero()
@@ -689,5 +1040,8 @@ Poly PolyCompose(const Poly *p, unsigned count, const Poly x[])
 		return PolyZero();
 	}
 	
-	return PolyComposeExecute(p, count, x, 0);
+	bool traced = PolyTraceBegin("PolyCompose", p, NULL);
+	Poly res = PolyComposeExecute(p, count, x, 0);
+	PolyTraceEnd(traced, "PolyCompose", &res);
+	return res;
 }
@@ -11,6 +11,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -98,6 +99,24 @@ static inline bool MonoListIsEmpty(const MonoList *ml)
  */
 Poly PolyAddMonosFromMonoList(MonoList *ml);
 
+/**
+ * Porównuje jednomiany względem ich wykładników (funkcja porównująca dla qsort).
+ * @param[in] fst : jednomian
+ * @param[in] snd : jednomian
+ * @return liczba < 0, jeśli @p fst < @p snd, 0, jeśli @p fst == @p snd, a > 0, jeśli @p fst > @p snd.
+ */
+int MonoCmp(const void *fst, const void *snd);
+
+/**
+ * Tworzy wielomian będący sumą jednomianów z tablicy @p monos,
+ * posortowanej rosnąco względem wykładników (np. przez qsort z MonoCmp()).
+ * Przejmuje na własność zawartość jednomianów (ale nie samą tablicę).
+ * @param[in] count : liczba jednomianów
+ * @param[in] monos : tablica jednomianów
+ * @return wielomian będący sumą jednomianów
+ */
+Poly PolyFromSortedMonos(unsigned count, Mono monos[]);
+
 /**
  * Dodaje do listy jednomianów @p ml dynamicznie zaalokowaną głęboką kopię jednomianu @p m.
  * @param[in] ml : lista
@@ -113,6 +132,15 @@ void MonoListCopyAndAppend(MonoList *ml, Mono *m);
  */
 void MonoListAppendMono(MonoList *ml, Mono *m);
 
+/**
+ * Do listy jednomianów @p ml dodaje głębokie kopie jednomianów zawartych w wielomianie @p p. 
+ * Jeśli @p p jest wielomianem zerowym, nie dodaje nic. Jeśli jest wielomianem 
+ * stałym różnym od zerowego, dodaje odpowiadający mu jednomian.
+ * @param[in] ml : lista jednomianów
+ * @param[in] p : wielomian
+ */
+void MonoListAppendCopiedMonosFromPoly(MonoList *ml, const Poly *p);
+
 /**
  * Tworzy wielomian, który jest współczynnikiem
  * @param[in] c : wartość współczynnika
@@ -176,6 +204,33 @@ void PolyDestroy(Poly *p);
  */
 void MonoDestroy(Mono *m);
 
+/**
+ * Tworzy wskaźnik na zaalokowany dynamicznie jednomian zerowy.
+ * @return wskaźnik na jednomian zerowy
+ */
+Mono *MonoMallocEmpty();
+
+/**
+ * Zwraca liczbę jednomianów zaalokowanych funkcją MonoMallocEmpty() przez
+ * bieżący wątek od początku działania programu
+ * @return liczba zaalokowanych jednomianów
+ */
+uint64_t MonoAllocCount();
+
+/**
+ * Zwalnia wolne jednomiany przechowywane przez bieżący wątek do ponownego
+ * użycia przez MonoMallocEmpty(). Wątek powinien ją wywołać przed
+ * zakończeniem, jeśli tworzył lub usuwał wielomiany.
+ */
+void MonoPoolRelease();
+
+/**
+ * Usuwa jednomian @p m z pamięci i zwalnia pamięć, 
+ * która została zaalokowana na sam wskaźnik.
+ * @param[in] m : jednomian
+ */
+void MonoDestroyMalloced(Mono *m);
+
 /**
  * Robi pełną, głęboką kopię wielomianu.
  * @param[in] p : wielomian
@@ -215,6 +270,23 @@ Poly PolyAddMonos(unsigned count, const Mono monos[]);
  */
 Poly PolyMul(const Poly *p, const Poly *q);
 
+/**
+ * Zwraca liczbę wszystkich jednomianów wielomianu (łącznie z jednomianami współczynników)
+ * @param[in] p : wielomian
+ * @return liczba jednomianów
+ */
+uint64_t PolyMonoCountDeep(const Poly *p);
+
+/**
+ * Mnoży dwa wielomiany i dodaje do iloczynu trzeci – w jednym przebiegu,
+ * bez tworzenia iloczynu jako osobnego wielomianu.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @param[in] r : wielomian
+ * @return `p * q + r`
+ */
+Poly PolyMulAdd(const Poly *p, const Poly *q, const Poly *r);
+
 /**
  * Zwraca przeciwny wielomian.
  * @param[in] p : wielomian
@@ -222,6 +294,29 @@ Poly PolyMul(const Poly *p, const Poly *q);
  */
 Poly PolyNeg(const Poly *p);
 
+/**
+ * Neguje wielomian w miejscu (rekurencyjnie zmienia znak wszystkich stałych),
+ * bez alokowania pamięci.
+ * @param[in] p : wielomian
+ */
+void PolySetInverseCoeffs(Poly *p);
+
+/**
+ * Dodaje w miejscu wielomian @p q do wielomianu @p p (`p := p + q`).
+ * Wykorzystuje jednomiany obu wielomianów zamiast je kopiować – przejmuje
+ * @p q na własność (po wywołaniu @p q jest wielomianem zerowym).
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ */
+void PolyAddInPlace(Poly *p, Poly *q);
+
+/**
+ * Mnoży w miejscu wielomian @p p przez stałą @p c (`p := c * p`).
+ * @param[in] p : wielomian
+ * @param[in] c : stała
+ */
+void PolyScaleInPlace(Poly *p, poly_coeff_t c);
+
 /**
  * Odejmuje wielomian od wielomianu.
  * @param[in] p : wielomian
@@ -273,6 +368,14 @@ poly_exp_t PolyDeg(const Poly *p);
  */
 bool PolyIsEq(const Poly *p, const Poly *q);
 
+/**
+ * Zwraca @p x podniesiony do potęgi @p exp.
+ * @param[in] x : liczba całkowita
+ * @param[in] exp : liczba całkowita
+ * @return @p x ^ @p exp.
+ */
+poly_coeff_t PowI(poly_coeff_t x, poly_exp_t exp);
+
 /**
  * Wylicza wartość wielomianu w punkcie @p x.
  * Wstawia pod pierwszą zmienną wielomianu wartość @p x.
@@ -288,6 +391,7 @@ Poly PolyAt(const Poly *p, poly_coeff_t x);
 
 /**
  * Wypisuje na standardowe wyjście wielomian
+ * (za pośrednictwem bufora wyjścia, zob. OutputFlush())
  * @param[in] p : wielomian
  */
 void PrintPoly(const Poly *p);
@@ -1,53 +1,224 @@
 #include "polystack.h"
+#include "checkpoint.h"
+#include "memstat.h"
 
 #include "utils.h"
 
+/** Minimalny rozmiar zaalokowanej tablicy elementów stosu */
+#define POLY_STACK_MIN_CAPACITY 16
+
 PolyStack EmptyPolyStack()
 {
 	PolyStack pStack;
-	pStack.topElem = NULL;
+	pStack.elems = NULL;
+	pStack.size = 0;
+	pStack.capacity = 0;
+	pStack.registers = EmptyRegisterTable();
+	pStack.checkpoint.operation = NULL;
+	pStack.checkpoint.opWithArg = NULL;
+	pStack.checkpoint.opWithStrArg = NULL;
+	pStack.checkpoint.walFd = -1;
 	return pStack;
 }
-bool PolyStackHasEnoughElements(PolyStack *pStack, long numOfElems)
+/**
+ * Zapewnia, że na stosie zmieści się jeszcze @p extra elementów
+ * @param[in] pStack : stos wielomianów
+ * @param[in] extra : liczba elementów
+ */
+static void PolyStackReserve(PolyStack *pStack, size_t extra)
 {
-	if(numOfElems <= 0)
+	if(pStack->size + extra <= pStack->capacity)
 	{
-		return true;
+		return;
 	}
-	
-	PolyStackElem *iter = pStack->topElem;
-	int elems = 0;
-	
-	while(iter != NULL)
+	size_t newCapacity = (pStack->capacity < POLY_STACK_MIN_CAPACITY) ? POLY_STACK_MIN_CAPACITY : pStack->capacity;
+	while(newCapacity < pStack->size + extra)
 	{
-		elems++;
-		if(elems >= numOfElems)
-		{
-			return true;
-		}
-		iter = iter->prev;
+		newCapacity *= 2;
 	}
-	return false;
+	pStack->elems = realloc(pStack->elems, newCapacity * sizeof(PolyStackElem));
+	assert(pStack->elems != NULL);
+	MemStatAlloc(MEM_STACK_ELEM, newCapacity - pStack->capacity);
+	pStack->capacity = newCapacity;
 }
 void PolyStackPush(PolyStack *pStack, Poly *p)
 {
-	PolyStackElem *newElem = (PolyStackElem*)malloc(sizeof(PolyStackElem));
-	assert(newElem != NULL);
+	PolyStackReserve(pStack, 1);
+	PolyStackElem *newElem = &(pStack->elems[pStack->size++]);
 	newElem->p = *p;
-	newElem->prev = pStack->topElem;
-	pStack->topElem = newElem;
+	newElem->mapped = NULL;
+	newElem->shared = NULL;
+	newElem->lazy = NULL;
+}
+void PolyStackPushMany(PolyStack *pStack, size_t count, Poly p[])
+{
+	PolyStackReserve(pStack, count);
+	for(size_t i = 0; i < count; i++)
+	{
+		PolyStackElem *newElem = &(pStack->elems[pStack->size++]);
+		newElem->p = p[i];
+		newElem->mapped = NULL;
+		newElem->shared = NULL;
+		newElem->lazy = NULL;
+	}
+}
+void PolyStackPushMapped(PolyStack *pStack, MappedStore *store)
+{
+	Poly p = PolyZero();
+	PolyStackPush(pStack, &p);
+	PolyStackPeek(pStack, 0)->mapped = store;
+}
+void PolyStackPushShared(PolyStack *pStack, SharedPoly *shared)
+{
+	PolyStackPush(pStack, &(shared->p));
+	PolyStackPeek(pStack, 0)->shared = shared;
+}
+SharedPoly *PolyStackShareTop(PolyStack *pStack)
+{
+	PolyStackElem *top = PolyStackPeek(pStack, 0);
+	assert(top->mapped == NULL);
+	if(top->shared == NULL)
+	{
+		top->shared = SharedPolyCreate(&(top->p));
+	}
+	return SharedPolyRetain(top->shared);
+}
+/**
+ * Zamienia element stosu, który jest odwzorowanym plikiem, jest współdzielony
+ * lub jest nieobliczonym wyrażeniem, na zwykły wielomian, którego element jest właścicielem
+ * @param[in] elem : element stosu
+ */
+static void PolyStackElemMakeOwned(PolyStackElem *elem)
+{
+	if(elem->mapped != NULL)
+	{
+		elem->p = MappedPolyToPoly(&(elem->mapped->root));
+		MappedStoreRelease(elem->mapped);
+		elem->mapped = NULL;
+	}
+	if(elem->shared != NULL)
+	{
+		elem->p = SharedPolyTake(elem->shared);
+		elem->shared = NULL;
+	}
+	if(elem->lazy != NULL)
+	{
+		elem->p = LazyForce(elem->lazy);
+		elem->lazy = NULL;
+	}
+}
+/**
+ * Usuwa z pamięci zawartość elementu stosu
+ * @param[in] elem : element stosu
+ */
+static void PolyStackElemDestroy(PolyStackElem *elem)
+{
+	if(elem->shared != NULL)
+	{
+		SharedPolyRelease(elem->shared);
+	}
+	else if(elem->lazy != NULL)
+	{
+		LazyRelease(elem->lazy);
+	}
+	else
+	{
+		PolyDestroy(&(elem->p));
+	}
+	MappedStoreRelease(elem->mapped);
+}
+void PolyStackPushLazy(PolyStack *pStack, LazyExpr *e)
+{
+	Poly p = PolyZero();
+	PolyStackPush(pStack, &p);
+	PolyStackPeek(pStack, 0)->lazy = e;
+}
+LazyExpr *PolyStackTakeLazy(PolyStack *pStack)
+{
+	PolyStackElem *top = PolyStackPeek(pStack, 0);
+	if(top->lazy != NULL)
+	{
+		LazyExpr *e = top->lazy;
+		pStack->size--;
+		return e;
+	}
+	Poly p = PolyStackTake(pStack);
+	return LazyFromPoly(&p);
+}
+void PolyStackForce(PolyStack *pStack, long numOfElems)
+{
+	for(long i = 0; i < numOfElems && (size_t)i < pStack->size; i++)
+	{
+		PolyStackElem *elem = PolyStackPeek(pStack, (size_t)i);
+		if(elem->lazy != NULL)
+		{
+			elem->p = LazyForce(elem->lazy);
+			elem->lazy = NULL;
+		}
+	}
+}
+Poly *PolyStackPeekOwned(PolyStack *pStack, size_t k)
+{
+	PolyStackElem *elem = PolyStackPeek(pStack, k);
+	PolyStackElemMakeOwned(elem);
+	return &(elem->p);
+}
+void PolyStackMaterialize(PolyStack *pStack, long numOfElems)
+{
+	for(long i = 0; i < numOfElems && (size_t)i < pStack->size; i++)
+	{
+		PolyStackElem *elem = PolyStackPeek(pStack, (size_t)i);
+		if(elem->mapped != NULL)
+		{
+			elem->p = MappedPolyToPoly(&(elem->mapped->root));
+			MappedStoreRelease(elem->mapped);
+			elem->mapped = NULL;
+		}
+	}
 }
 void PolyStackPop(PolyStack *pStack)
 {
-	PolyDestroy(&(pStack->topElem->p));
-	PolyStackElem *elemToRemove = pStack->topElem;
-	pStack->topElem = pStack->topElem->prev;
-	free(elemToRemove);
+	PolyStackPopMany(pStack, 1);
 }
-void DestroyStack(PolyStack *pStack)
+void PolyStackPopMany(PolyStack *pStack, size_t numOfElems)
 {
-	while(!PolyStackIsEmpty(pStack))
+	assert(numOfElems <= pStack->size);
+	for(size_t i = 0; i < numOfElems; i++)
 	{
-		PolyStackPop(pStack);
+		PolyStackElemDestroy(&(pStack->elems[--(pStack->size)]));
 	}
 }
+Poly PolyStackTake(PolyStack *pStack)
+{
+	Poly res;
+	PolyStackTakeMany(pStack, 1, &res);
+	return res;
+}
+void PolyStackTakeMany(PolyStack *pStack, size_t count, Poly p[])
+{
+	assert(count <= pStack->size);
+	for(size_t i = 0; i < count; i++)
+	{
+		PolyStackElem *elem = &(pStack->elems[--(pStack->size)]);
+		PolyStackElemMakeOwned(elem);
+		p[i] = elem->p;
+	}
+}
+void PolyStackReplaceTop(PolyStack *pStack, Poly *p)
+{
+	PolyStackElem *top = PolyStackPeek(pStack, 0);
+	PolyStackElemDestroy(top);
+	top->p = *p;
+	top->mapped = NULL;
+	top->shared = NULL;
+	top->lazy = NULL;
+}
+void DestroyStack(PolyStack *pStack)
+{
+	PolyStackPopMany(pStack, pStack->size);
+	free(pStack->elems);
+	MemStatFree(MEM_STACK_ELEM, pStack->capacity);
+	RegisterTableDestroy(&(pStack->registers));
+	CheckpointClose(pStack);
+	*pStack = EmptyPolyStack();
+}
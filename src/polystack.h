@@ -9,30 +9,68 @@
 #define __POLYSTACK_H__
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <assert.h>
 #include "poly.h"
-
-typedef struct PolyStackElem PolyStackElem;
+#include "mapped.h"
+#include "registers.h"
+#include "lazy.h"
 
 /**
  * Struktura reprezentująca element stosu wielomianów (typu PolyStack)
  */
 typedef struct PolyStackElem
 {
-	Poly p; ///< przechowywany wielomian
 	/**
-	 * wskaźnik na element będący bezpośrednio pod danym elementem
-	 * NULL w przypadku, gdy nie ma już elementów poniżej danego
+	 * przechowywany wielomian (wielomian zerowy, jeśli element jest odwzorowanym plikiem,
+	 * płytka kopia współdzielonego wielomianu, jeśli element jest współdzielony)
+	 */
+	Poly p;
+	/**
+	 * odwzorowany w pamięci plik z wielomianem, jeśli element go przechowuje
+	 * (wtedy pole p nie ma znaczenia), NULL w przeciwnym przypadku
 	 */
-	PolyStackElem *prev;
+	MappedStore *mapped;
+	/**
+	 * współdzielony wielomian (np. z rejestru), którego płytką kopią jest pole p;
+	 * takiego wielomianu nie wolno modyfikować ani usuwać. NULL, jeśli element
+	 * jest właścicielem pola p.
+	 */
+	SharedPoly *shared;
+	/**
+	 * nieobliczone wyrażenie, jeśli element je przechowuje (wtedy pole p
+	 * nie ma znaczenia; zob. lazy.h), NULL w przeciwnym przypadku
+	 */
+	LazyExpr *lazy;
 } PolyStackElem;
 
+struct Operation;
+struct OperationWithArg;
+struct OperationWithStringArg;
+
+/**
+ * Stan punktu kontrolnego stosu (zob. checkpoint.h)
+ */
+typedef struct CheckpointLog
+{
+	struct Operation *operation; ///< bezargumentowe operacje, względem których numerowane są polecenia w dzienniku
+	struct OperationWithArg *opWithArg; ///< jednoargumentowe operacje
+	struct OperationWithStringArg *opWithStrArg; ///< operacje z argumentem tekstowym
+	int walFd; ///< deskryptor dziennika bieżącego punktu kontrolnego (-1, jeśli go nie ma)
+} CheckpointLog;
+
 /**
- * Struktura reprezentująca stos wielomianów
+ * Struktura reprezentująca stos wielomianów.
+ * Elementy są przechowywane w ciągłej, dynamicznie powiększanej tablicy
+ * (od dna do szczytu stosu).
  */
 typedef struct PolyStack
 {
-	PolyStackElem *topElem; ///< element stosu będący na jego szczycie
+	PolyStackElem *elems; ///< tablica elementów stosu
+	size_t size; ///< liczba elementów stosu
+	size_t capacity; ///< rozmiar zaalokowanej tablicy
+	RegisterTable registers; ///< nazwane rejestry kalkulatora (zob. STORE i RECALL)
+	CheckpointLog checkpoint; ///< punkt kontrolny, którego dziennik prowadzi stos
 } PolyStack;
 
 
@@ -41,13 +79,48 @@ typedef struct PolyStack
  * @return Pusty stos wielomianów
  */
 PolyStack EmptyPolyStack();
+
+/**
+ * Zwraca liczbę elementów stosu wielomianów
+ * @param[in] pStack : stos wielomianów
+ * @return liczba elementów stosu
+ */
+static inline size_t PolyStackSize(const PolyStack *pStack)
+{
+	return pStack->size;
+}
 /**
  * Sprawdza, czy stos wielomianów @p pStack ma przynajmniej @p numOfElems elementów
  * @param[in] pStack : stos wielomianów
  * @param[in] numOfElems : wymagana ilość
  * @return Czy @p pStack ma przynajmniej @p numOfElems elementów
  */
-bool PolyStackHasEnoughElements(PolyStack *pStack, long numOfElems);
+static inline bool PolyStackHasEnoughElements(const PolyStack *pStack, long numOfElems)
+{
+	return (numOfElems <= 0 || (unsigned long)numOfElems <= pStack->size);
+}
+/**
+ * Zwraca element stosu leżący @p k pozycji pod szczytem (0 oznacza szczyt).
+ * Funkcja zakłada, że stos ma więcej niż @p k elementów.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] k : odległość od szczytu stosu
+ * @return element stosu
+ */
+static inline PolyStackElem *PolyStackPeek(const PolyStack *pStack, size_t k)
+{
+	return &(pStack->elems[pStack->size - 1 - k]);
+}
+/**
+ * Zwraca wskaźnik na wielomian leżący @p k pozycji pod szczytem stosu, który
+ * można modyfikować w miejscu. Jeśli element jest odwzorowanym plikiem, jest
+ * współdzielony lub jest nieobliczonym wyrażeniem, najpierw zamienia go na zwykły
+ * wielomian (w razie potrzeby kopiując go lub obliczając).
+ * Funkcja zakłada, że stos ma więcej niż @p k elementów.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] k : odległość od szczytu stosu
+ * @return wskaźnik na wielomian
+ */
+Poly *PolyStackPeekOwned(PolyStack *pStack, size_t k);
 
 /**
  * Zwraca wielomian będący na szczycie stosu wielomianów
@@ -56,7 +129,7 @@ bool PolyStackHasEnoughElements(PolyStack *pStack, long numOfElems);
  */
 static inline Poly PolyStackTop(const PolyStack *pStack)
 {
-	return pStack->topElem->p;
+	return PolyStackPeek(pStack, 0)->p;
 }
 /**
  * Zwraca wielomian będący bezpośrednio pod wielomianem będącym na szczycie stosu wielomianów
@@ -65,7 +138,25 @@ static inline Poly PolyStackTop(const PolyStack *pStack)
  */
 static inline Poly PolyStackNextAfterTop(const PolyStack *pStack)
 {
-	return pStack->topElem->prev->p;
+	return PolyStackPeek(pStack, 1)->p;
+}
+/**
+ * Zwraca odwzorowany plik z wielomianem będący na szczycie stosu wielomianów
+ * @param[in] pStack : stos wielomianów
+ * @return Odwzorowany plik lub NULL, jeśli na szczycie jest zwykły wielomian
+ */
+static inline MappedStore *PolyStackTopMapped(const PolyStack *pStack)
+{
+	return PolyStackPeek(pStack, 0)->mapped;
+}
+/**
+ * Zwraca odwzorowany plik z wielomianem będący bezpośrednio pod szczytem stosu wielomianów
+ * @param[in] pStack : stos wielomianów
+ * @return Odwzorowany plik lub NULL, jeśli pod szczytem jest zwykły wielomian
+ */
+static inline MappedStore *PolyStackNextAfterTopMapped(const PolyStack *pStack)
+{
+	return PolyStackPeek(pStack, 1)->mapped;
 }
 /**
  * Sprawdza, czy stos wielomianów jest pusty
@@ -74,15 +165,53 @@ static inline Poly PolyStackNextAfterTop(const PolyStack *pStack)
  */
 static inline bool PolyStackIsEmpty(const PolyStack *pStack)
 {
-	return (pStack->topElem == NULL);
+	return (pStack->size == 0);
 }
 /**
  * Usuwa wielomian ze szczytu stosu wielomianów.
- * W szczególności, usuwa ten wielomian z pamięci
+ * W szczególności, usuwa ten wielomian z pamięci (współdzielony wielomian –
+ * tylko wtedy, gdy było to ostatnie odwołanie do niego)
  * @param[in] pStack : stos wielomianów
  */
 void PolyStackPop(PolyStack *pStack);
 
+/**
+ * Usuwa @p numOfElems wielomianów ze szczytu stosu wielomianów (wraz z ich zawartością).
+ * Funkcja zakłada, że stos ma wystarczająco dużo elementów.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] numOfElems : liczba usuwanych wielomianów
+ */
+void PolyStackPopMany(PolyStack *pStack, size_t numOfElems);
+
+/**
+ * Zdejmuje wielomian ze szczytu stosu i przekazuje go na własność wywołującemu
+ * (bez kopiowania i bez usuwania z pamięci). Jeśli na szczycie jest odwzorowany
+ * plik lub wielomian współdzielony z innymi odwołaniami, zwraca jego głęboką kopię.
+ * Funkcja zakłada, że stos nie jest pusty.
+ * @param[in] pStack : stos wielomianów
+ * @return wielomian zdjęty ze szczytu stosu
+ */
+Poly PolyStackTake(PolyStack *pStack);
+
+/**
+ * Zdejmuje @p count wielomianów ze szczytu stosu i przekazuje je na własność
+ * wywołującemu: @p p[0] to wielomian ze szczytu, @p p[1] – wielomian pod nim itd.
+ * Funkcja zakłada, że stos ma wystarczająco dużo elementów.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] count : liczba zdejmowanych wielomianów
+ * @param[out] p : zdjęte wielomiany
+ */
+void PolyStackTakeMany(PolyStack *pStack, size_t count, Poly p[]);
+
+/**
+ * Zastępuje wielomian na szczycie stosu wielomianem @p p (przejmując go na własność),
+ * usuwając z pamięci poprzedni wielomian.
+ * Funkcja zakłada, że stos nie jest pusty.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] p : nowy wielomian na szczycie stosu
+ */
+void PolyStackReplaceTop(PolyStack *pStack, Poly *p);
+
 /**
  * Dodaje wielomian na szczyt stosu wielomianów
  * @param[in] pStack : stos wielomianów
@@ -91,7 +220,75 @@ void PolyStackPop(PolyStack *pStack);
 void PolyStackPush(PolyStack *pStack, Poly *p);
 
 /**
- * Usuwa stos wielomianów z pamięci
+ * Dodaje na szczyt stosu kolejno wielomiany @p p[0], @p p[1], …, @p p[@p count - 1]
+ * (ostatni trafia na szczyt). Przejmuje wielomiany na własność.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] count : liczba dodawanych wielomianów
+ * @param[in] p : dodawane wielomiany
+ */
+void PolyStackPushMany(PolyStack *pStack, size_t count, Poly p[]);
+
+/**
+ * Dodaje odwzorowany plik z wielomianem na szczyt stosu wielomianów.
+ * Przejmuje na własność jedno odwołanie do @p store.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] store : odwzorowany plik
+ */
+void PolyStackPushMapped(PolyStack *pStack, MappedStore *store);
+
+/**
+ * Dodaje nieobliczone wyrażenie na szczyt stosu wielomianów.
+ * Przejmuje na własność jedno odwołanie do @p e.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] e : wyrażenie
+ */
+void PolyStackPushLazy(PolyStack *pStack, LazyExpr *e);
+
+/**
+ * Zdejmuje element ze szczytu stosu i zwraca go jako wyrażenie (bez obliczania,
+ * jeśli element jest nieobliczonym wyrażeniem).
+ * Funkcja zakłada, że stos jest niepusty.
+ * @param[in] pStack : stos wielomianów
+ * @return wyrażenie (z jednym odwołaniem należącym do wywołującego)
+ */
+LazyExpr *PolyStackTakeLazy(PolyStack *pStack);
+
+/**
+ * Oblicza nieobliczone wyrażenia wśród @p numOfElems elementów ze szczytu stosu
+ * @param[in] pStack : stos wielomianów
+ * @param[in] numOfElems : liczba elementów (może przekraczać rozmiar stosu)
+ */
+void PolyStackForce(PolyStack *pStack, long numOfElems);
+
+/**
+ * Dodaje współdzielony wielomian na szczyt stosu wielomianów (bez kopiowania).
+ * Przejmuje na własność jedno odwołanie do @p shared.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] shared : współdzielony wielomian
+ */
+void PolyStackPushShared(PolyStack *pStack, SharedPoly *shared);
+
+/**
+ * Zamienia wielomian na szczycie stosu na współdzielony (bez kopiowania)
+ * i zwraca nowe odwołanie do niego.
+ * Funkcja zakłada, że na szczycie stosu nie ma odwzorowanego pliku.
+ * @param[in] pStack : stos wielomianów
+ * @return nowe odwołanie do współdzielonego wielomianu ze szczytu stosu
+ */
+SharedPoly *PolyStackShareTop(PolyStack *pStack);
+
+/**
+ * Zamienia @p numOfElems elementów ze szczytu stosu, które są odwzorowanymi plikami,
+ * na zwykłe wielomiany (ich głębokie kopie).
+ * Funkcja zakłada, że stos ma wystarczająco dużo elementów.
+ * @param[in] pStack : stos wielomianów
+ * @param[in] numOfElems : liczba elementów
+ */
+void PolyStackMaterialize(PolyStack *pStack, long numOfElems);
+
+/**
+ * Usuwa stos wielomianów (wraz z rejestrami) z pamięci i zamyka dziennik
+ * jego punktu kontrolnego
  * @param[in] pStack : stos wielomianów
  */
 void DestroyStack(PolyStack *pStack);
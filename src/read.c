@@ -1,4 +1,11 @@
 #include "read.h"
+#include "parallel_parse.h"
+#include "serialize.h"
+#include "checkpoint.h"
+#include "stats.h"
+#include "memstat.h"
+#include "trace.h"
+
 #include "utils.h"
 
 /**
@@ -12,123 +19,231 @@ Poly PolyFromCoeffNumber(Number *number)
 	return PolyFromCoeff(convertedNumber);
 }
 
-Poly ReadPoly(int lineNumber, int *columnNumber, bool *hasError)
+/** Początkowy rozmiar tablicy wczytywanych jednomianów */
+#define READ_MONOS_MIN_CAPACITY 4
+
+/**
+ * Źródło znaków parsera wielomianów w bieżącym wątku: fragment pamięci
+ * lub (gdy parseSourceData == NULL) strumień wejściowy (zob. ReadSetInput())
+ */
+static _Thread_local const char *parseSourceData = NULL;
+/** Długość fragmentu pamięci będącego źródłem znaków parsera */
+static _Thread_local size_t parseSourceSize = 0;
+/** Pozycja odczytu we fragmencie pamięci będącym źródłem znaków parsera */
+static _Thread_local size_t parseSourcePos = 0;
+
+/** Strumień, z którego ParseLine() wczytuje kolejne wiersze (NULL – standardowe wejście) */
+static _Thread_local FILE *readInputStream = NULL;
+
+void ReadSetInput(FILE *stream)
 {
-	char firstChar = getc(stdin);
-	ungetc(firstChar, stdin);
-	
-	if(firstChar == '-' || IsDigit(firstChar))
+	readInputStream = stream;
+}
+
+/**
+ * Zwraca strumień, z którego wczytywane są kolejne wiersze
+ * @return strumień wejściowy
+ */
+static inline FILE *ReadInput()
+{
+	return (readInputStream != NULL) ? readInputStream : stdin;
+}
+
+void ReadSetSource(const char *data, size_t size)
+{
+	parseSourceData = data;
+	parseSourceSize = size;
+	parseSourcePos = 0;
+}
+
+bool ReadSourceAtEnd()
+{
+	return (parseSourceData != NULL && parseSourcePos == parseSourceSize);
+}
+
+/**
+ * Wczytuje znak ze źródła parsera (odpowiednik getc)
+ * @return wczytany znak lub EOF
+ */
+static inline int ReadChar()
+{
+	if(parseSourceData == NULL)
 	{
-		Number coeff = ReadNumberForParse(lineNumber, columnNumber, hasError, MIN_COEFF, MAX_COEFF);
-		Poly res = PolyZero();
-		if(!NumberIsEmpty(&coeff))
-		{
-			res = PolyFromCoeffNumber(&coeff);
-		}
-		else
-		{
-			ErrorParse(lineNumber, *columnNumber, hasError);
-		}
-		NumberDestroy(&coeff);
-		return res;
+		return getc(ReadInput());
 	}
-	else
+	if(parseSourcePos == parseSourceSize)
+	{
+		return EOF;
+	}
+	return (unsigned char)parseSourceData[parseSourcePos++];
+}
+
+/**
+ * Zwraca znak do źródła parsera (odpowiednik ungetc)
+ * @param[in] c : ostatnio wczytany znak
+ */
+static inline void UnreadChar(int c)
+{
+	if(parseSourceData == NULL)
+	{
+		ungetc(c, ReadInput());
+	}
+	else if(c != EOF)
 	{
-		MonoList ml = EmptyMonoList();
-		bool forcePlus = false;
+		parseSourcePos--;
+	}
+}
+
+void ReadMonos(int lineNumber, int *columnNumber, ParseError *error, Mono **monos, unsigned *count)
+{
+	unsigned capacity = 0;
+	bool forcePlus = false;
+	
+	*monos = NULL;
+	*count = 0;
 
-		while(1)
+	while(1)
+	{
+		char currChar = ReadChar();
+		if(currChar == '+')
 		{
-			char currChar = getc(stdin);
-			if(currChar == '+')
+			if(forcePlus == true)
 			{
-				if(forcePlus == true)
-				{
-					forcePlus = false;
-				}
-				else
-				{
-					ErrorParse(lineNumber, *columnNumber, hasError);
-				}
+				forcePlus = false;
 			}
-			else if(currChar == '(')
+			else
 			{
-				if(forcePlus == false)
+				ErrorParse(lineNumber, *columnNumber, error);
+			}
+		}
+		else if(currChar == '(')
+		{
+			if(forcePlus == false)
+			{
+				UnreadChar(currChar);
+				Mono m = ReadMono(lineNumber, columnNumber, error);
+				if(!(error->hasError))
 				{
-					ungetc(currChar, stdin);
-					Mono m = ReadMono(lineNumber, columnNumber, hasError);
-					if(!(*hasError))
+					if(*count == capacity)
 					{
-						MonoListCopyAndAppend(&ml, &m);
+						capacity = (capacity == 0) ? READ_MONOS_MIN_CAPACITY : 2 * capacity;
+						*monos = realloc(*monos, capacity * sizeof(Mono));
+						assert(*monos != NULL);
 					}
-					MonoDestroy(&m);
-					forcePlus = true;
+					(*monos)[(*count)++] = m;
 				}
 				else
 				{
-					ErrorParse(lineNumber, *columnNumber, hasError);
+					MonoDestroy(&m);
 				}
+				forcePlus = true;
 			}
 			else
 			{
-				if(forcePlus == false)
-				{
-					ErrorParse(lineNumber, *columnNumber, hasError);
-				}
-				ungetc(currChar, stdin);
-				break;
+				ErrorParse(lineNumber, *columnNumber, error);
 			}
-			(*columnNumber)++;
 		}
+		else
+		{
+			if(forcePlus == false)
+			{
+				ErrorParse(lineNumber, *columnNumber, error);
+			}
+			UnreadChar(currChar);
+			break;
+		}
+		(*columnNumber)++;
+	}
+	
+	if(error->hasError)
+	{
+		for(unsigned i = 0; i < *count; i++)
+		{
+			MonoDestroy(&((*monos)[i]));
+		}
+		free(*monos);
+		*monos = NULL;
+		*count = 0;
+	}
+}
+
+Poly ReadPoly(int lineNumber, int *columnNumber, ParseError *error)
+{
+	char firstChar = ReadChar();
+	UnreadChar(firstChar);
+	
+	if(firstChar == '-' || IsDigit(firstChar))
+	{
+		Number coeff = ReadNumberForParse(lineNumber, columnNumber, error, MIN_COEFF, MAX_COEFF);
+		Poly res = PolyZero();
+		if(!NumberIsEmpty(&coeff))
+		{
+			res = PolyFromCoeffNumber(&coeff);
+		}
+		else
+		{
+			ErrorParse(lineNumber, *columnNumber, error);
+		}
+		NumberDestroy(&coeff);
+		return res;
+	}
+	else
+	{
+		Mono *monos;
+		unsigned count;
 		
-		if(MonoListIsEmpty(&ml))
+		ReadMonos(lineNumber, columnNumber, error, &monos, &count);
+		
+		if(count == 0)
 		{
-			ErrorParse(lineNumber, *columnNumber, hasError);
+			ErrorParse(lineNumber, *columnNumber, error);
 			return PolyZero();
 		}
 		else
 		{
-			Poly res = PolyAddMonosFromMonoList(&ml);
+			qsort(monos, count, sizeof(Mono), MonoCmp);
+			Poly res = PolyFromSortedMonos(count, monos);
+			free(monos);
 			return res;
 		}
 	}
 }
 
-Mono ReadMono(int lineNumber, int *columnNumber, bool *hasError)
+Mono ReadMono(int lineNumber, int *columnNumber, ParseError *error)
 {
 	Mono res;
 	
 	Poly p0 = PolyZero();
 	res = MonoFromPoly(&p0, 0);
 	
-	char currChar = getc(stdin);
+	char currChar = ReadChar();
 	
 	if(currChar != '(')
 	{
-		ErrorParse(lineNumber, (*columnNumber) + 1, hasError);
-		ungetc(currChar, stdin);
+		ErrorParse(lineNumber, (*columnNumber) + 1, error);
+		UnreadChar(currChar);
 		return res;
 	}
 	(*columnNumber)++;
 	
-	Poly p = ReadPoly(lineNumber, columnNumber, hasError);
+	Poly p = ReadPoly(lineNumber, columnNumber, error);
 	res = MonoFromPoly(&p, 0);
 	
-	currChar = getc(stdin);
+	currChar = ReadChar();
 	
 	if(currChar != ',')
 	{
-		ErrorParse(lineNumber, *columnNumber, hasError);
-		ungetc(currChar, stdin);
+		ErrorParse(lineNumber, *columnNumber, error);
+		UnreadChar(currChar);
 		return res;
 	}
 	(*columnNumber)++;
 	
-	Number exp = ReadNumberForParse(lineNumber, columnNumber, hasError, MIN_EXP, MAX_EXP);
+	Number exp = ReadNumberForParse(lineNumber, columnNumber, error, MIN_EXP, MAX_EXP);
 	
 	if(NumberIsEmpty(&exp))
 	{
-		ErrorParse(lineNumber, *columnNumber, hasError);
+		ErrorParse(lineNumber, *columnNumber, error);
 		return res;
 	}
 	
@@ -136,12 +251,12 @@ Mono ReadMono(int lineNumber, int *columnNumber, bool *hasError)
 	
 	NumberDestroy(&exp);
 	
-	currChar = getc(stdin);
+	currChar = ReadChar();
 	
 	if(currChar != ')')
 	{
-		ErrorParse(lineNumber, *columnNumber, hasError);
-		ungetc(currChar, stdin);
+		ErrorParse(lineNumber, *columnNumber, error);
+		UnreadChar(currChar);
 	}
 	return res;
 }
@@ -152,7 +267,7 @@ Number ReadNumber()
 	
 	while(1)
 	{
-		char currChar = getc(stdin);
+		char currChar = getc(ReadInput());
 		
 		if(currChar == '-')
 		{
@@ -162,7 +277,7 @@ Number ReadNumber()
 			}
 			else
 			{
-				ungetc(currChar, stdin);
+				ungetc(currChar, ReadInput());
 				break;
 			}
 		}
@@ -172,20 +287,20 @@ Number ReadNumber()
 		}
 		else
 		{
-			ungetc(currChar, stdin);
+			ungetc(currChar, ReadInput());
 			break;
 		}
 	}
 	return number;
 }
 
-Number ReadNumberForParse(int lineNumber, int *columnNumber, bool *hasError, long minValue, long maxValue)
+Number ReadNumberForParse(int lineNumber, int *columnNumber, ParseError *error, long minValue, long maxValue)
 {
 	Number number = EmptyNumber();
 	
 	while(1)
 	{
-		char currChar = getc(stdin);
+		char currChar = ReadChar();
 		
 		if(currChar == '-')
 		{
@@ -195,14 +310,14 @@ Number ReadNumberForParse(int lineNumber, int *columnNumber, bool *hasError, lon
 				
 				if(minValue > 0L)
 				{
-					ErrorParse(lineNumber, *columnNumber, hasError);
+					ErrorParse(lineNumber, *columnNumber, error);
 					break;
 				}
 			}
 			else
 			{
-				ErrorParse(lineNumber, *columnNumber, hasError);
-				ungetc(currChar, stdin);
+				ErrorParse(lineNumber, *columnNumber, error);
+				UnreadChar(currChar);
 				break;
 			}
 		}
@@ -212,14 +327,14 @@ Number ReadNumberForParse(int lineNumber, int *columnNumber, bool *hasError, lon
 			
 			if((CmpNumberLong(&number, minValue) < 0) || (CmpNumberLong(&number, maxValue) > 0))
 			{
-				ErrorParse(lineNumber, *columnNumber, hasError);
-				ungetc(currChar, stdin);
+				ErrorParse(lineNumber, *columnNumber, error);
+				UnreadChar(currChar);
 				break;
 			}
 		}
 		else
 		{
-			ungetc(currChar, stdin);
+			UnreadChar(currChar);
 			break;
 		}
 		(*columnNumber)++;
@@ -233,61 +348,255 @@ Word ReadCommandName()
 	
 	while(1)
 	{
-		char currChar = getc(stdin);
+		char currChar = getc(ReadInput());
 		if(IsCorrectCommandChar(currChar))
 		{
 			WordAppend(&commandName, currChar);
 		}
 		else
 		{
-			ungetc(currChar, stdin);
+			ungetc(currChar, ReadInput());
 			break;
 		}
 	}
 	return commandName;
 }
 
-bool ReadLine(PolyStack *pStack, int lineNumber, Operation operation[], OperationWithArg opWithArg[])
+Word ReadRestOfLine()
+{
+	Word rest = EmptyWord();
+	
+	while(1)
+	{
+		char currChar = getc(ReadInput());
+		if(currChar == '\n' || currChar == EOF)
+		{
+			ungetc(currChar, ReadInput());
+			break;
+		}
+		WordAppend(&rest, currChar);
+	}
+	return rest;
+}
+
+/**
+ * Wczytuje argument liczbowy polecenia @p op i zapisuje w @p line 
+ * polecenie gotowe do wykonania lub błąd
+ * @param[in] op : polecenie
+ * @param[in] line : wczytany wiersz
+ */
+static void ReadCommandNumberArg(OperationWithArg *op, ParsedLine *line)
+{
+	char currChar = getc(ReadInput());
+	if(currChar != ' ')
+	{
+		if(currChar == '\n' || currChar == EOF)
+		{
+			line->errorType = op->argErrorType;
+		}
+		else{
+			line->errorType = WRONG_COMMAND;
+		}
+		ungetc(currChar, ReadInput());
+		return;
+	}
+	
+	Number arg = ReadNumber();
+	
+	currChar = getc(ReadInput());
+	ungetc(currChar, ReadInput());
+	
+	if((currChar != '\n' && currChar != EOF) || NumberIsEmpty(&arg))
+	{
+		line->errorType = op->argErrorType;
+	}
+	else if((CmpNumberLong(&arg, op->argMinValue) >= 0) && 
+		(CmpNumberLong(&arg, op->argMaxValue) <= 0))
+	{
+		line->opWithArg = op;
+		line->arg = NumberToLong(&arg);
+	}
+	else
+	{
+		line->errorType = op->argErrorType;
+	}
+	NumberDestroy(&arg);
+}
+
+/**
+ * Wczytuje argument tekstowy polecenia @p op i zapisuje w @p line 
+ * polecenie gotowe do wykonania lub błąd
+ * @param[in] op : polecenie
+ * @param[in] line : wczytany wiersz
+ */
+static void ReadCommandStringArg(OperationWithStringArg *op, ParsedLine *line)
+{
+	char currChar = getc(ReadInput());
+	if(currChar != ' ')
+	{
+		if(currChar == '\n' || currChar == EOF)
+		{
+			line->errorType = op->argErrorType;
+		}
+		else{
+			line->errorType = WRONG_COMMAND;
+		}
+		ungetc(currChar, ReadInput());
+		return;
+	}
+	
+	Word argWord = ReadRestOfLine();
+	
+	if(WordIsEmpty(&argWord))
+	{
+		line->errorType = op->argErrorType;
+	}
+	else
+	{
+		line->opWithStrArg = op;
+		line->strArg = WordToString(&argWord);
+	}
+	WordDestroy(&argWord);
+}
+
+void ReadCommand(int lineNumber, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[], ParsedLine *line)
+{
+	Word commandName = ReadCommandName();
+	
+	line->type = PARSED_COMMAND;
+	line->lineNumber = lineNumber;
+	
+	bool nameFound = false;
+	
+	for(int i = 0; i < OPER_WITH_ARG_AMOUNT && !nameFound; i++)
+	{
+		if(WordEquals(&commandName, opWithArg[i].name))
+		{
+			nameFound = true;
+			ReadCommandNumberArg(&(opWithArg[i]), line);
+		}
+	}
+	for(int i = 0; i < OPER_WITH_STRING_ARG_AMOUNT && !nameFound; i++)
+	{
+		if(opWithStrArg[i].execute != NULL && WordEquals(&commandName, opWithStrArg[i].name))
+		{
+			nameFound = true;
+			ReadCommandStringArg(&(opWithStrArg[i]), line);
+		}
+	}
+	if(nameFound == false)
+	{
+		char currChar = getc(ReadInput());
+		ungetc(currChar, ReadInput());
+		if(currChar == '\n' || currChar == EOF)
+		{
+			for(int i = 0; i < OPER_WITHOUT_ARG_AMOUNT && !nameFound; i++)
+			{
+				if(WordEquals(&commandName, operation[i].name))
+				{
+					nameFound = true;
+					line->operation = &(operation[i]);
+				}
+			}
+		}
+		if(!nameFound)
+		{
+			line->errorType = WRONG_COMMAND;
+		}
+	}
+	WordDestroy(&commandName);
+}
+
+/**
+ * Wczytuje ze standardowego wejścia wszystkie znaki do końca wiersza
+ * (nie wczytuje znaku końca wiersza)
+ * @return Wczytane znaki
+ */
+static ByteBuffer ReadLineText()
+{
+	ByteBuffer text = EmptyByteBuffer();
+	
+	while(1)
+	{
+		char currChar = getc(ReadInput());
+		if(currChar == '\n' || currChar == EOF)
+		{
+			ungetc(currChar, ReadInput());
+			break;
+		}
+		ByteBufferAppend(&text, &currChar, 1);
+	}
+	return text;
+}
+
+/**
+ * Parsuje wiersz z wielomianem. Długie wiersze próbuje parsować równolegle,
+ * a jeśli to się nie uda (np. wiersz zawiera błąd), parsuje je sekwencyjnie,
+ * tak by numer kolumny pierwszego błędu był zawsze taki sam.
+ * @param[in] lineNumber : aktualny numer wiersza
+ * @param[in] text : znaki wiersza (bez znaku końca wiersza)
+ * @param[in] size : liczba znaków wiersza
+ * @param[in] error : pierwszy błąd parsowania w danym wierszu
+ * @return wczytany wielomian (w przypadku błędu – wielomian zerowy)
+ */
+static Poly ParsePolyLine(int lineNumber, const char *text, size_t size, ParseError *error)
+{
+	Poly res;
+	
+	if(ParsePolyParallel(text, size, &res))
+	{
+		return res;
+	}
+	
+	int columnNumber = 1;
+	
+	ReadSetSource((text != NULL) ? text : "", size);
+	res = ReadPoly(lineNumber, &columnNumber, error);
+	
+	if(!ReadSourceAtEnd())
+	{
+		ErrorParse(lineNumber, columnNumber, error);
+	}
+	ReadSetSource(NULL, 0);
+	
+	if(error->hasError)
+	{
+		PolyDestroy(&res);
+	}
+	return res;
+}
+
+bool ParseLine(int lineNumber, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[], ParsedLine *line)
 {
-    char firstChar = getc(stdin);
+    *line = EmptyParsedLine();
+    
+    char firstChar = getc(ReadInput());
     
     if(firstChar == EOF)return false;
     
-    ungetc(firstChar, stdin);
+    ungetc(firstChar, ReadInput());
     
     if(IsLetter(firstChar))
     {
-        ReadAndExecuteCommand(pStack, lineNumber, operation, opWithArg);
+        ReadCommand(lineNumber, operation, opWithArg, opWithStrArg, line);
     }
     else
     {
-    	bool hasError = false;
-    	int columnNumber = 1;
+    	ByteBuffer text = ReadLineText();
     	
-        Poly p = ReadPoly(lineNumber, &columnNumber, &hasError);
+    	line->type = PARSED_POLY;
+    	line->lineNumber = lineNumber;
+        line->p = ParsePolyLine(lineNumber, (const char*)text.data, text.size, &(line->parseError));
         
-        char currChar = getc(stdin);
-        ungetc(currChar, stdin);
-        
-        if(currChar != '\n' && currChar != EOF)
-        {
-			ErrorParse(lineNumber, columnNumber, &hasError);
-			PolyDestroy(&p);
-        }
-        else if(hasError == false)
-        {
-        	PolyStackPush(pStack, &p);
-        }
-        else
-        {
-        	PolyDestroy(&p);
-        }
+        ByteBufferDestroy(&text);
     }
     
     char currChar;
     while(1)
     {
-    	currChar = getc(stdin);
+    	currChar = getc(ReadInput());
     	if(currChar == EOF || currChar == '\n')
     	{
     		break;
@@ -296,97 +605,193 @@ bool ReadLine(PolyStack *pStack, int lineNumber, Operation operation[], Operatio
     return true;
 }
 
-void ReadAndExecuteCommand(PolyStack *pStack, int lineNumber, Operation operation[], OperationWithArg opWithArg[])
+/**
+ * Wykonuje wczytany wiersz (zob. ExecuteParsedLine()) bez pomiaru
+ * @param[in] pStack : stos wielomianów (część kalkulatora)
+ * @param[in] line : wczytany wiersz
+ */
+static void ExecuteParsedLineUnmeasured(PolyStack *pStack, ParsedLine *line)
 {
-	Word commandName = ReadCommandName();
+	CheckpointLogLine(pStack, line);
 	
-	bool nameFound = false;
-	
-	for(int i = 0; i < OPER_WITH_ARG_AMOUNT; i++)
+	if(line->type == PARSED_POLY)
 	{
-		if(WordEquals(&commandName, opWithArg[i].name))
+		if(line->parseError.hasError)
 		{
-			nameFound = true;
-			
-			char currChar = getc(stdin);
-			if(currChar != ' ')
+			ErrorParseReport(&(line->parseError));
+		}
+		else
+		{
+			PolyStackPush(pStack, &(line->p));
+			line->p = PolyZero();
+		}
+	}
+	else if(line->errorType != NULL)
+	{
+		ErrorCommand(line->lineNumber, line->errorType);
+	}
+	else if(line->operation != NULL)
+	{
+		Operation *op = line->operation;
+		if(PolyStackHasEnoughElements(pStack, op->requiredStackSize))
+		{
+			if(!op->acceptsMapped)
 			{
-				if(currChar == '\n' || currChar == EOF)
-				{
-					ErrorCommand(lineNumber, opWithArg[i].argErrorType);
-				}
-				else{
-					ErrorCommand(lineNumber, WRONG_COMMAND);
-				}
-				ungetc(currChar, stdin);
+				PolyStackMaterialize(pStack, op->requiredStackSize);
 			}
-			else
+			if(!op->acceptsLazy)
 			{
-				Number arg = ReadNumber();
-				
-				currChar = getc(stdin);
-				ungetc(currChar, stdin);
-				
-				if((currChar != '\n' && currChar != EOF) || NumberIsEmpty(&arg))
-				{
-					ErrorCommand(lineNumber, opWithArg[i].argErrorType);
-				}
-				else
-				{
-					if((CmpNumberLong(&arg, opWithArg[i].argMinValue) >= 0) && 
-						(CmpNumberLong(&arg, opWithArg[i].argMaxValue) <= 0))
-					{
-						if(PolyStackHasEnoughElements(pStack, opWithArg[i].requiredStackSize(&arg)))
-						{
-							opWithArg[i].execute(pStack, &arg);
-						}
-						else
-						{
-							ErrorCommand(lineNumber, STACK_UNDERFLOW);
-						}
-					}
-					else
-					{
-						ErrorCommand(lineNumber, opWithArg[i].argErrorType);
-					}
-				
-				}
-				NumberDestroy(&arg);
+				PolyStackForce(pStack, op->requiredStackSize);
 			}
+			op->execute(pStack);
+		}
+		else
+		{
+			ErrorCommand(line->lineNumber, STACK_UNDERFLOW);
 		}
 	}
-	if(nameFound == false)
+	else if(line->opWithArg != NULL)
 	{
-		char currChar = getc(stdin);
-		ungetc(currChar, stdin);
-		if(currChar != '\n' && currChar != EOF)
+		OperationWithArg *op = line->opWithArg;
+		long requiredStackSize = op->requiredStackSize(line->arg);
+		if(PolyStackHasEnoughElements(pStack, requiredStackSize))
 		{
-			ErrorCommand(lineNumber, WRONG_COMMAND);
+			if(!op->acceptsMapped)
+			{
+				PolyStackMaterialize(pStack, requiredStackSize);
+			}
+			PolyStackForce(pStack, requiredStackSize);
+			op->execute(pStack, line->arg);
 		}
 		else
 		{
-			for(int i = 0; i < OPER_WITHOUT_ARG_AMOUNT; i++)
+			ErrorCommand(line->lineNumber, STACK_UNDERFLOW);
+		}
+	}
+	else if(line->opWithStrArg != NULL)
+	{
+		OperationWithStringArg *op = line->opWithStrArg;
+		if(!PolyStackHasEnoughElements(pStack, op->requiredStackSize))
+		{
+			ErrorCommand(line->lineNumber, STACK_UNDERFLOW);
+		}
+		else
+		{
+			if(!op->acceptsMapped)
 			{
-				if(WordEquals(&commandName, operation[i].name))
-				{
-					nameFound = true;
-					if(PolyStackHasEnoughElements(pStack, operation[i].requiredStackSize))
-					{
-						operation[i].execute(pStack);
-					}
-					else
-					{
-						ErrorCommand(lineNumber, STACK_UNDERFLOW);
-					}
-					break;
-				}
+				PolyStackMaterialize(pStack, op->requiredStackSize);
 			}
-			if(!nameFound)
+			PolyStackForce(pStack, op->requiredStackSize);
+			if(!op->execute(pStack, line->strArg))
+			{
+				ErrorCommand(line->lineNumber, op->argErrorType);
+			}
+			else
 			{
-				ErrorCommand(lineNumber, WRONG_COMMAND);
+				CheckpointLogLoad(pStack, line);
 			}
 		}
 	}
-	WordDestroy(&commandName);
+	ParsedLineDestroy(line);
+}
+
+/**
+ * Zwraca nazwę polecenia z wczytanego wiersza i liczbę jego argumentów na stosie
+ * @param[in] line : wczytany wiersz
+ * @param[out] requiredStackSize : wymagany przez polecenie rozmiar stosu
+ * @return nazwa polecenia lub NULL, jeśli wiersz nie jest poprawnym poleceniem
+ */
+static const char *ParsedLineCommandName(const ParsedLine *line, long *requiredStackSize)
+{
+	*requiredStackSize = 0;
+	if(line->type != PARSED_COMMAND || line->errorType != NULL)
+	{
+		return NULL;
+	}
+	if(line->operation != NULL)
+	{
+		*requiredStackSize = line->operation->requiredStackSize;
+		return line->operation->name;
+	}
+	if(line->opWithArg != NULL)
+	{
+		*requiredStackSize = line->opWithArg->requiredStackSize(line->arg);
+		return line->opWithArg->name;
+	}
+	if(line->opWithStrArg != NULL)
+	{
+		*requiredStackSize = line->opWithStrArg->requiredStackSize;
+		return line->opWithStrArg->name;
+	}
+	return NULL;
 }
 
+/**
+ * Wykonuje wczytany wiersz (zob. ExecuteParsedLine()), doliczając
+ * wykonanie polecenia do jego liczników wydajności (zob. stats.h)
+ * @param[in] pStack : stos wielomianów (część kalkulatora)
+ * @param[in] line : wczytany wiersz
+ */
+static void ExecuteParsedLineMeasured(PolyStack *pStack, ParsedLine *line)
+{
+	long requiredStackSize;
+	const char *name = ParsedLineCommandName(line, &requiredStackSize);
+	if(name == NULL)
+	{
+		ExecuteParsedLineUnmeasured(pStack, line);
+		return;
+	}
+	StatsSample sample;
+	StatsBegin(&sample, pStack, requiredStackSize);
+	ExecuteParsedLineUnmeasured(pStack, line);
+	StatsEnd(&sample, name, pStack);
+}
+
+void ExecuteParsedLine(PolyStack *pStack, ParsedLine *line)
+{
+	bool traced = TraceActive();
+	const char *traceName = NULL;
+	if(traced)
+	{
+		long requiredStackSize;
+		traceName = ParsedLineCommandName(line, &requiredStackSize);
+		if(traceName == NULL)
+		{
+			traceName = (line->type == PARSED_POLY) ? "POLY" : "ERROR";
+		}
+		TraceBegin(traceName, "line", line->lineNumber);
+	}
+	if(StatsIsEnabled())
+	{
+		ExecuteParsedLineMeasured(pStack, line);
+	}
+	else
+	{
+		ExecuteParsedLineUnmeasured(pStack, line);
+	}
+	MemStatTick(pStack);
+	if(traced)
+	{
+		TraceEnd(traceName, "stack", (long)PolyStackSize(pStack));
+	}
+}
+
+void ParsedLineDestroy(ParsedLine *line)
+{
+	PolyDestroy(&(line->p));
+	free(line->strArg);
+	*line = EmptyParsedLine();
+}
+
+bool ReadLine(PolyStack *pStack, int lineNumber, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[])
+{
+	ParsedLine line;
+	
+	if(!ParseLine(lineNumber, operation, opWithArg, opWithStrArg, &line))
+	{
+		return false;
+	}
+	ExecuteParsedLine(pStack, &line);
+	return true;
+}
@@ -11,6 +11,7 @@
 
 #include <stdbool.h>
 #include <limits.h>
+#include <stddef.h>
 #include "poly.h"
 #include "number.h"
 #include "error.h"
@@ -24,26 +25,59 @@
 #define MAX_EXP INT_MAX
 
 /**
- * Wczytuje ze standardowego wejścia wielomian, "przesuwa" numer kolumny
+ * Ustawia strumień, z którego ParseLine() i ReadLine() wczytują kolejne wiersze
+ * @param[in] stream : strumień lub NULL, jeśli źródłem ma być standardowe wejście
+ */
+void ReadSetInput(FILE *stream);
+
+/**
+ * Ustawia źródło znaków, z którego w bieżącym wątku czytają ReadPoly(),
+ * ReadMonos(), ReadMono() i ReadNumberForParse()
+ * @param[in] data : fragment pamięci lub NULL, jeśli źródłem ma być standardowe wejście
+ * @param[in] size : długość fragmentu pamięci
+ */
+void ReadSetSource(const char *data, size_t size);
+
+/**
+ * Sprawdza, czy wczytano już wszystkie znaki z fragmentu pamięci
+ * ustawionego przez ReadSetSource()
+ * @return Czy wczytano wszystkie znaki (false, gdy źródłem jest standardowe wejście)
+ */
+bool ReadSourceAtEnd();
+
+/**
+ * Wczytuje (z bieżącego źródła znaków) wielomian, "przesuwa" numer kolumny
  * i zgłasza błąd, gdy takowy napotka
  * Kończy wczytywanie, gdy następny znak nie może być "przedłużeniem" wielomianu
  * @param[in] lineNumber : aktualny numer linii
  * @param[in] columnNumber : aktualny numer kolumny (numer kolumny, w której wczytywany wielomian się zaczyna)
- * @param[in] hasError : czy w danym wierszu wystąpił już błąd
+ * @param[in] error : pierwszy błąd parsowania w danym wierszu
  * @return Wczytany wielomian
  */
-Poly ReadPoly(int lineNumber, int *columnNumber, bool *hasError);
+Poly ReadPoly(int lineNumber, int *columnNumber, ParseError *error);
 
 /**
- * Wczytuje ze standardowego wejścia jednomian, "przesuwa" numer kolumny
+ * Wczytuje ciąg jednomianów oddzielonych znakami '+', "przesuwa" numer kolumny
+ * i zgłasza błąd, gdy takowy napotka
+ * Kończy wczytywanie, gdy następny znak nie może być "przedłużeniem" ciągu
+ * @param[in] lineNumber : aktualny numer linii
+ * @param[in] columnNumber : aktualny numer kolumny (numer kolumny, w której ciąg się zaczyna)
+ * @param[in] error : pierwszy błąd parsowania w danym wierszu
+ * @param[out] monos : nowo zaalokowana tablica wczytanych jednomianów (w kolejności wystąpienia, NULL w przypadku błędu)
+ * @param[out] count : liczba wczytanych jednomianów (0 w przypadku błędu)
+ */
+void ReadMonos(int lineNumber, int *columnNumber, ParseError *error, Mono **monos, unsigned *count);
+
+/**
+ * Wczytuje (z bieżącego źródła znaków) jednomian, "przesuwa" numer kolumny
  * i zgłasza błąd, gdy takowy napotka
  * Kończy wczytywanie, gdy następny znak nie może być "przedłużeniem" jednomianu
  * @param[in] lineNumber : aktualny numer linii
  * @param[in] columnNumber : aktualny numer kolumny (numer kolumny, w której wczytywany monomian się zaczyna)
- * @param[in] hasError : czy w danym wierszu wystąpił już błąd
+ * @param[in] error : pierwszy błąd parsowania w danym wierszu
  * @return Wczytana liczba
  */
-Mono ReadMono(int lineNumber, int *columnNumber, bool *hasError);
+Mono ReadMono(int lineNumber, int *columnNumber, ParseError *error);
 
 /**
  * Wczytuje ze standardowego wejścia nazwę polecenia
@@ -54,17 +88,17 @@ Mono ReadMono(int lineNumber, int *columnNumber, bool *hasError);
 Word ReadCommandName();
 
 /**
- * Wczytuje ze standardowego wejścia liczbę (typu Number)
+ * Wczytuje (z bieżącego źródła znaków) liczbę (typu Number)
  * Kończy wczytywanie, gdy następny znak nie może być "przedłużeniem" liczby
  * Zgłasza błąd, gdy jego wartość przekracza podane limity
  * @param[in] lineNumber : aktualny numer linii
  * @param[in] columnNumber : aktualny numer kolumny (numer kolumny, w której wczytywana liczba się zaczyna)
- * @param[in] hasError : czy w danym wierszu wystąpił już błąd
+ * @param[in] error : pierwszy błąd parsowania w danym wierszu
  * @param[in] minValue : minimalna wartość liczby
  * @param[in] maxValue : maksymalna wartość liczby
  * @return Wczytana liczba, a w przypadku przekroczenia limitu jej najdłuższy prawidłowy prefiks
  */
-Number ReadNumberForParse(int lineNumber, int *columnNumber, bool *hasError, long minValue, long maxValue);
+Number ReadNumberForParse(int lineNumber, int *columnNumber, ParseError *error, long minValue, long maxValue);
 
 /**
  * Wczytuje ze standardowego wejścia liczbę (typu Number)
@@ -73,6 +107,82 @@ Number ReadNumberForParse(int lineNumber, int *columnNumber, bool *hasError, lon
  */
 Number ReadNumber();
 
+/**
+ * Wczytuje ze standardowego wejścia wszystkie znaki do końca wiersza
+ * (nie wczytuje znaku końca wiersza)
+ * @return Wczytane znaki
+ */
+Word ReadRestOfLine();
+
+/**
+ * Rodzaj wczytanego wiersza
+ */
+typedef enum ParsedLineType
+{
+	PARSED_POLY, ///< wiersz z wielomianem
+	PARSED_COMMAND ///< wiersz z poleceniem kalkulatora
+} ParsedLineType;
+
+/**
+ * Wczytany i sparsowany wiersz wejścia, gotowy do wykonania.
+ * Wiersz nie zależy od stanu stosu, więc może zostać wczytany
+ * niezależnie od (np. równolegle z) wykonywania wcześniejszych wierszy.
+ */
+typedef struct ParsedLine
+{
+	int lineNumber; ///< numer wiersza
+	ParsedLineType type; ///< rodzaj wiersza
+	Poly p; ///< wczytany wielomian (dla wiersza z wielomianem)
+	ParseError parseError; ///< błąd parsowania wielomianu (dla wiersza z wielomianem)
+	/**
+	 * błąd polecenia wykryty podczas wczytywania (np. WRONG_COMMAND)
+	 * lub NULL, jeśli polecenie jest poprawne
+	 */
+	char *errorType;
+	Operation *operation; ///< wczytane polecenie bezargumentowe (lub NULL)
+	OperationWithArg *opWithArg; ///< wczytane polecenie jednoargumentowe (lub NULL)
+	OperationWithStringArg *opWithStrArg; ///< wczytane polecenie z argumentem tekstowym (lub NULL)
+	long arg; ///< argument polecenia jednoargumentowego
+	char *strArg; ///< argument polecenia z argumentem tekstowym (lub NULL)
+} ParsedLine;
+
+/**
+ * Zwraca pusty wczytany wiersz
+ * @return pusty wiersz
+ */
+static inline ParsedLine EmptyParsedLine()
+{
+	return (ParsedLine) {.lineNumber = 0, .type = PARSED_POLY, .p = PolyZero(), 
+		.parseError = NoParseError(), .errorType = NULL, .operation = NULL, 
+		.opWithArg = NULL, .opWithStrArg = NULL, .arg = 0, .strArg = NULL};
+}
+
+/**
+ * Usuwa z pamięci zawartość wczytanego wiersza
+ * @param[in] line : wczytany wiersz
+ */
+void ParsedLineDestroy(ParsedLine *line);
+
+/**
+ * Wczytuje ze standardowego wejścia wiersz i parsuje go (nie wykonując polecenia)
+ * @param[in] lineNumber : aktualny numer wiersza
+ * @param[in] operation : bezargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithArg : jednoargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym udostępnione przez kalkulator
+ * @param[out] line : wczytany wiersz
+ * @return false, jeśli pierwszy znak wiersza to EOF, true w przeciwnym wypadku
+ */
+bool ParseLine(int lineNumber, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[], ParsedLine *line);
+
+/**
+ * Wykonuje wczytany wiersz: wstawia wielomian na stos lub wykonuje polecenie
+ * i wypisuje ewentualne błędy. Usuwa z pamięci zawartość wiersza.
+ * @param[in] pStack : stos wielomianów (część kalkulatora)
+ * @param[in] line : wczytany wiersz
+ */
+void ExecuteParsedLine(PolyStack *pStack, ParsedLine *line);
+
 /**
  * Wczytuje wiersz
  * w zależności od pierwszego znaku, wykonuje operację kalkulatora lub parsowanie wielomianu
@@ -81,9 +191,11 @@ Number ReadNumber();
  * @param[in] lineNumber : aktualny numer wiersza
  * @param[in] operation : bezargumentowe operacje udostępnione przez kalkulator
  * @param[in] opWithArg : jednoargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym udostępnione przez kalkulator
  * @return false, jeśli pierwszy znak wiersza to EOF, true w przeciwnym wypadku
  */
-bool ReadLine(PolyStack *pStack, int lineNumber, Operation operation[], OperationWithArg opWithArg[]);
+bool ReadLine(PolyStack *pStack, int lineNumber, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[]);
 
 /**
  * Sprawdza, czy znak jest cyfrą
@@ -114,13 +226,16 @@ static inline bool IsCorrectCommandChar(char c)
 	return (IsLetter(c) || c == '_');
 }
 /**
- * Wczytuje i wykonuje polecenie kalkulatora
- * w przypadku, gdy wykonanie nie jest możliwe, zwraca odpowiedni błąd
- * @param[in] pStack : stos wielomianów (część kalkulatora)
+ * Wczytuje polecenie kalkulatora (wraz z argumentem) i zapisuje je w @p line.
+ * W przypadku, gdy polecenie lub jego argument są niepoprawne, zapisuje 
+ * w @p line odpowiedni błąd.
  * @param[in] lineNumber : aktualny numer wiersza
  * @param[in] operation : bezargumentowe operacje udostępnione przez kalkulator
  * @param[in] opWithArg : jednoargumentowe operacje udostępnione przez kalkulator
+ * @param[in] opWithStrArg : operacje z argumentem tekstowym udostępnione przez kalkulator
+ * @param[out] line : wczytany wiersz
  */
-void ReadAndExecuteCommand(PolyStack *pStack, int lineNumber, Operation operation[], OperationWithArg opWithArg[]);
+void ReadCommand(int lineNumber, Operation operation[], OperationWithArg opWithArg[],
+	OperationWithStringArg opWithStrArg[], ParsedLine *line);
 
 #endif /* __READ_H__ */
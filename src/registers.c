@@ -0,0 +1,119 @@
+#include "registers.h"
+
+#include <string.h>
+
+#include "serialize.h"
+
+#include "utils.h"
+
+SharedPoly *SharedPolyCreate(Poly *p)
+{
+	SharedPoly *shared = malloc(sizeof(SharedPoly));
+	assert(shared != NULL);
+	shared->p = *p;
+	shared->refCount = 1;
+	return shared;
+}
+
+void SharedPolyRelease(SharedPoly *shared)
+{
+	if(shared != NULL && --(shared->refCount) == 0)
+	{
+		PolyDestroy(&(shared->p));
+		free(shared);
+	}
+}
+
+Poly SharedPolyTake(SharedPoly *shared)
+{
+	if(shared->refCount == 1)
+	{
+		Poly res = shared->p;
+		free(shared);
+		return res;
+	}
+	shared->refCount--;
+	return PolyClone(&(shared->p));
+}
+
+/**
+ * Zwraca wpis, w którym jest (lub powinien się znaleźć) rejestr o nazwie @p name.
+ * Funkcja zakłada, że tablica ma co najmniej jeden wolny wpis.
+ * @param[in] entries : wpisy tablicy
+ * @param[in] capacity : liczba wpisów (potęga dwójki)
+ * @param[in] name : nazwa rejestru
+ * @return wpis z rejestrem o nazwie @p name lub wolny wpis
+ */
+static RegisterEntry *RegisterTableFind(RegisterEntry *entries, size_t capacity, const char *name)
+{
+	size_t i = Fnv1a32((const unsigned char*)name, strlen(name)) & (capacity - 1);
+	while(entries[i].name != NULL && strcmp(entries[i].name, name) != 0)
+	{
+		i = (i + 1) & (capacity - 1);
+	}
+	return &(entries[i]);
+}
+
+/**
+ * Powiększa dwukrotnie tablicę rejestrów, rozmieszczając wpisy na nowo
+ * @param[in] table : tablica rejestrów
+ */
+static void RegisterTableGrow(RegisterTable *table)
+{
+	size_t newCapacity = (table->capacity == 0) ? REGISTER_TABLE_MIN_CAPACITY : 2 * table->capacity;
+	RegisterEntry *newEntries = calloc(newCapacity, sizeof(RegisterEntry));
+	assert(newEntries != NULL);
+
+	for(size_t i = 0; i < table->capacity; i++)
+	{
+		if(table->entries[i].name != NULL)
+		{
+			*RegisterTableFind(newEntries, newCapacity, table->entries[i].name) = table->entries[i];
+		}
+	}
+	free(table->entries);
+	table->entries = newEntries;
+	table->capacity = newCapacity;
+}
+
+SharedPoly *RegisterTableGet(const RegisterTable *table, const char *name)
+{
+	if(table->size == 0)
+	{
+		return NULL;
+	}
+	return RegisterTableFind(table->entries, table->capacity, name)->value;
+}
+
+void RegisterTableSet(RegisterTable *table, const char *name, SharedPoly *value)
+{
+	/* współczynnik wypełnienia nie przekracza 1/2 */
+	if(2 * (table->size + 1) > table->capacity)
+	{
+		RegisterTableGrow(table);
+	}
+	RegisterEntry *entry = RegisterTableFind(table->entries, table->capacity, name);
+	if(entry->name == NULL)
+	{
+		entry->name = malloc(strlen(name) + 1);
+		assert(entry->name != NULL);
+		strcpy(entry->name, name);
+		table->size++;
+	}
+	SharedPolyRelease(entry->value);
+	entry->value = value;
+}
+
+void RegisterTableDestroy(RegisterTable *table)
+{
+	for(size_t i = 0; i < table->capacity; i++)
+	{
+		if(table->entries[i].name != NULL)
+		{
+			free(table->entries[i].name);
+			SharedPolyRelease(table->entries[i].value);
+		}
+	}
+	free(table->entries);
+	*table = EmptyRegisterTable();
+}
@@ -0,0 +1,120 @@
+/** @file
+   Interfejs nazwanych rejestrów kalkulatora wielomianów
+
+   Rejestr przechowuje współdzielony wielomian (SharedPoly). Polecenie RECALL
+   wstawia na stos kolejne odwołanie do tego samego wielomianu zamiast jego
+   głębokiej kopii; kopia powstaje dopiero wtedy, gdy któreś polecenie
+   chce zmodyfikować wielomian ze stosu.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-18
+*/
+#ifndef __REGISTERS_H__
+#define __REGISTERS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "poly.h"
+
+/** Minimalny rozmiar tablicy haszującej rejestrów */
+#define REGISTER_TABLE_MIN_CAPACITY 16
+
+/**
+ * Wielomian współdzielony przez rejestry i elementy stosu.
+ * Współdzielony wielomian nie jest modyfikowany; jest usuwany z pamięci,
+ * gdy licznik odwołań spadnie do zera.
+ */
+typedef struct SharedPoly
+{
+	Poly p; ///< wielomian
+	unsigned refCount; ///< licznik odwołań
+} SharedPoly;
+
+/**
+ * Wpis tablicy rejestrów
+ */
+typedef struct RegisterEntry
+{
+	char *name; ///< nazwa rejestru (NULL, jeśli wpis jest wolny)
+	SharedPoly *value; ///< zawartość rejestru
+} RegisterEntry;
+
+/**
+ * Tablica haszująca (z adresowaniem otwartym) nazwanych rejestrów
+ */
+typedef struct RegisterTable
+{
+	RegisterEntry *entries; ///< wpisy tablicy
+	size_t size; ///< liczba zajętych wpisów
+	size_t capacity; ///< liczba wszystkich wpisów (potęga dwójki lub 0)
+} RegisterTable;
+
+/**
+ * Tworzy współdzielony wielomian (z licznikiem odwołań równym 1),
+ * przejmując @p p na własność
+ * @param[in] p : wielomian
+ * @return współdzielony wielomian
+ */
+SharedPoly *SharedPolyCreate(Poly *p);
+
+/**
+ * Zwiększa licznik odwołań do współdzielonego wielomianu
+ * @param[in] shared : współdzielony wielomian
+ * @return @p shared
+ */
+static inline SharedPoly *SharedPolyRetain(SharedPoly *shared)
+{
+	shared->refCount++;
+	return shared;
+}
+
+/**
+ * Zmniejsza licznik odwołań do współdzielonego wielomianu i usuwa go
+ * z pamięci, gdy nie ma już do niego odwołań
+ * @param[in] shared : współdzielony wielomian (może być NULL)
+ */
+void SharedPolyRelease(SharedPoly *shared);
+
+/**
+ * Zwalnia odwołanie do współdzielonego wielomianu i zwraca wielomian
+ * na własność wywołującemu: jeśli było to ostatnie odwołanie, bez kopiowania,
+ * w przeciwnym razie – głęboką kopię.
+ * @param[in] shared : współdzielony wielomian
+ * @return wielomian
+ */
+Poly SharedPolyTake(SharedPoly *shared);
+
+/**
+ * Zwraca pustą tablicę rejestrów
+ * @return pusta tablica rejestrów
+ */
+static inline RegisterTable EmptyRegisterTable()
+{
+	return (RegisterTable) {.entries = NULL, .size = 0, .capacity = 0};
+}
+
+/**
+ * Zwraca zawartość rejestru o nazwie @p name
+ * @param[in] table : tablica rejestrów
+ * @param[in] name : nazwa rejestru
+ * @return współdzielony wielomian lub NULL, jeśli rejestr jest pusty
+ */
+SharedPoly *RegisterTableGet(const RegisterTable *table, const char *name);
+
+/**
+ * Ustawia zawartość rejestru o nazwie @p name (zwalniając poprzednią).
+ * Przejmuje na własność jedno odwołanie do @p value.
+ * @param[in] table : tablica rejestrów
+ * @param[in] name : nazwa rejestru
+ * @param[in] value : współdzielony wielomian
+ */
+void RegisterTableSet(RegisterTable *table, const char *name, SharedPoly *value);
+
+/**
+ * Usuwa tablicę rejestrów z pamięci (zwalniając ich zawartość)
+ * @param[in] table : tablica rejestrów
+ */
+void RegisterTableDestroy(RegisterTable *table);
+
+#endif /* __REGISTERS_H__ */
@@ -0,0 +1,434 @@
+#include "serialize.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "utils.h"
+
+/** Minimalny rozmiar zaalokowanej pamięci tablicy bajtów */
+#define BYTE_BUFFER_MIN_CAPACITY 64
+/** Początkowa wartość sumy kontrolnej FNV-1a */
+#define FNV1A_32_OFFSET 2166136261u
+/** Mnożnik sumy kontrolnej FNV-1a */
+#define FNV1A_32_PRIME 16777619u
+/** Początkowa wartość 64-bitowego skrótu FNV-1a */
+#define FNV1A_64_OFFSET 14695981039346656037ull
+/** Mnożnik 64-bitowego skrótu FNV-1a */
+#define FNV1A_64_PRIME 1099511628211ull
+/** Rozmiar sumy kontrolnej w zapisie */
+#define CHECKSUM_SIZE 4
+/** Maksymalna długość zapisu dziesiętnego liczby typu long (ze znakiem) */
+#define TEXT_LONG_LENGTH 24
+
+void ByteBufferDestroy(ByteBuffer *buf)
+{
+	free(buf->data);
+	*buf = EmptyByteBuffer();
+}
+
+/**
+ * Zapewnia, że w tablicy @p buf zmieści się jeszcze @p extra bajtów
+ * @param[in] buf : tablica bajtów
+ * @param[in] extra : liczba bajtów
+ */
+static void ByteBufferReserve(ByteBuffer *buf, size_t extra)
+{
+	if(buf->size + extra <= buf->capacity)
+	{
+		return;
+	}
+	size_t newCapacity = (buf->capacity < BYTE_BUFFER_MIN_CAPACITY) ? BYTE_BUFFER_MIN_CAPACITY : buf->capacity;
+	while(newCapacity < buf->size + extra)
+	{
+		newCapacity *= 2;
+	}
+	buf->data = realloc(buf->data, newCapacity);
+	assert(buf->data != NULL);
+	buf->capacity = newCapacity;
+}
+
+void ByteBufferAppend(ByteBuffer *buf, const void *data, size_t size)
+{
+	if(size == 0)
+	{
+		return;
+	}
+	ByteBufferReserve(buf, size);
+	memcpy(buf->data + buf->size, data, size);
+	buf->size += size;
+}
+
+void ByteBufferAppendVarint(ByteBuffer *buf, uint64_t v)
+{
+	ByteBufferReserve(buf, 10);
+	while(v >= 0x80)
+	{
+		buf->data[buf->size++] = (unsigned char)(v | 0x80);
+		v >>= 7;
+	}
+	buf->data[buf->size++] = (unsigned char)v;
+}
+
+bool ReadVarint(const unsigned char *data, size_t size, size_t *pos, uint64_t *v)
+{
+	uint64_t res = 0;
+	unsigned shift = 0;
+
+	while(*pos < size && shift < 64)
+	{
+		unsigned char byte = data[(*pos)++];
+		res |= (uint64_t)(byte & 0x7f) << shift;
+		if(!(byte & 0x80))
+		{
+			*v = res;
+			return true;
+		}
+		shift += 7;
+	}
+	return false;
+}
+
+uint32_t Fnv1a32(const unsigned char *data, size_t size)
+{
+	uint32_t hash = FNV1A_32_OFFSET;
+	for(size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= FNV1A_32_PRIME;
+	}
+	return hash;
+}
+
+uint64_t Fnv1a64(const unsigned char *data, size_t size)
+{
+	uint64_t hash = FNV1A_64_OFFSET;
+	for(size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= FNV1A_64_PRIME;
+	}
+	return hash;
+}
+
+/**
+ * Koduje współczynnik w kodowaniu zigzag (małe co do modułu liczby ujemne
+ * stają się małymi liczbami nieujemnymi)
+ * @param[in] c : współczynnik
+ * @return zakodowany współczynnik
+ */
+static inline uint64_t ZigzagEncode(poly_coeff_t c)
+{
+	return ((uint64_t)c << 1) ^ (c < 0 ? UINT64_MAX : 0);
+}
+
+/**
+ * Odwraca kodowanie ZigzagEncode()
+ * @param[in] v : zakodowany współczynnik
+ * @return współczynnik
+ */
+static inline poly_coeff_t ZigzagDecode(uint64_t v)
+{
+	return (poly_coeff_t)((v >> 1) ^ (~(v & 1) + 1));
+}
+
+/**
+ * Dopisuje do tablicy @p buf zakodowany wielomian (bez nagłówka)
+ * @param[in] p : wielomian
+ * @param[in] buf : tablica bajtów
+ */
+static void PolyEncode(const Poly *p, ByteBuffer *buf)
+{
+	if(PolyIsCoeff(p))
+	{
+		ByteBufferAppendVarint(buf, 0);
+		ByteBufferAppendVarint(buf, ZigzagEncode(p->c));
+		return;
+	}
+
+	uint64_t count = 0;
+	for(Mono *iter = p->ml.first; iter != NULL; iter = iter->next)
+	{
+		count++;
+	}
+	ByteBufferAppendVarint(buf, count);
+
+	poly_exp_t prevExp = 0;
+	for(Mono *iter = p->ml.first; iter != NULL; iter = iter->next)
+	{
+		ByteBufferAppendVarint(buf, (uint64_t)(iter->exp - prevExp));
+		prevExp = iter->exp;
+		PolyEncode(&(iter->p), buf);
+	}
+}
+
+/**
+ * Dopisuje do tablicy @p buf zakodowany odwzorowany wielomian (bez nagłówka,
+ * w tym samym formacie co PolyEncode())
+ * @param[in] p : odwzorowany wielomian
+ * @param[in] buf : tablica bajtów
+ */
+static void MappedPolyEncode(const MappedPoly *p, ByteBuffer *buf)
+{
+	if(MappedPolyIsCoeff(p))
+	{
+		ByteBufferAppendVarint(buf, 0);
+		ByteBufferAppendVarint(buf, ZigzagEncode(p->c));
+		return;
+	}
+
+	ByteBufferAppendVarint(buf, p->count);
+	poly_exp_t prevExp = 0;
+	for(uint64_t i = p->first; i < p->first + p->count; i++)
+	{
+		MappedPoly coeff = MappedMonoCoeff(p, &(p->monos[i]));
+		ByteBufferAppendVarint(buf, (uint64_t)(p->monos[i].exp - prevExp));
+		prevExp = p->monos[i].exp;
+		MappedPolyEncode(&coeff, buf);
+	}
+}
+
+/**
+ * Dopisuje do tablicy @p buf nagłówek, zakodowany wielomian i sumę kontrolną
+ * @param[in] payload : zakodowany wielomian
+ * @param[in] buf : tablica bajtów
+ */
+static void SerializePayload(const ByteBuffer *payload, ByteBuffer *buf)
+{
+	unsigned char version = POLY_SERIAL_VERSION;
+	ByteBufferAppend(buf, POLY_SERIAL_MAGIC, POLY_SERIAL_MAGIC_SIZE);
+	ByteBufferAppend(buf, &version, 1);
+	ByteBufferAppendVarint(buf, payload->size);
+	ByteBufferAppend(buf, payload->data, payload->size);
+
+	uint32_t checksum = Fnv1a32(payload->data, payload->size);
+	unsigned char checksumBytes[CHECKSUM_SIZE];
+	for(int i = 0; i < CHECKSUM_SIZE; i++)
+	{
+		checksumBytes[i] = (unsigned char)(checksum >> (8 * i));
+	}
+	ByteBufferAppend(buf, checksumBytes, CHECKSUM_SIZE);
+}
+
+void PolySerialize(const Poly *p, ByteBuffer *buf)
+{
+	ByteBuffer payload = EmptyByteBuffer();
+	PolyEncode(p, &payload);
+	SerializePayload(&payload, buf);
+	ByteBufferDestroy(&payload);
+}
+
+void MappedPolySerialize(const MappedPoly *p, ByteBuffer *buf)
+{
+	ByteBuffer payload = EmptyByteBuffer();
+	MappedPolyEncode(p, &payload);
+	SerializePayload(&payload, buf);
+	ByteBufferDestroy(&payload);
+}
+
+/**
+ * Odczytuje zakodowany wielomian (bez nagłówka), sprawdzając jego poprawność
+ * @param[in] data : dane
+ * @param[in] size : liczba dostępnych bajtów
+ * @param[in] pos : pozycja odczytu, przesuwana za odczytany wielomian
+ * @param[out] p : odczytany wielomian (w przypadku błędu – wielomian zerowy)
+ * @return Czy odczyt się powiódł
+ */
+static bool PolyDecode(const unsigned char *data, size_t size, size_t *pos, Poly *p)
+{
+	uint64_t count, v;
+	*p = PolyZero();
+
+	if(!ReadVarint(data, size, pos, &count))
+	{
+		return false;
+	}
+	if(count == 0)
+	{
+		if(!ReadVarint(data, size, pos, &v))
+		{
+			return false;
+		}
+		p->c = ZigzagDecode(v);
+		return true;
+	}
+	/* każdy jednomian zajmuje co najmniej 3 bajty */
+	if(count > (size - *pos) / 3)
+	{
+		return false;
+	}
+
+	uint64_t exp = 0;
+	for(uint64_t i = 0; i < count; i++)
+	{
+		if(!ReadVarint(data, size, pos, &v) || (i > 0 && v == 0) || v > (uint64_t)INT_MAX - exp)
+		{
+			PolyDestroy(p);
+			return false;
+		}
+		exp += v;
+
+		Mono *m = MonoMallocEmpty();
+		m->exp = (poly_exp_t)exp;
+		bool ok = PolyDecode(data, size, pos, &(m->p));
+		if(!ok || PolyIsZero(&(m->p)))
+		{
+			MonoDestroyMalloced(m);
+			PolyDestroy(p);
+			return false;
+		}
+		MonoListAppendMono(&(p->ml), m);
+	}
+	/* wielomian stały musi być zapisany jako współczynnik */
+	if(count == 1 && exp == 0 && PolyIsCoeff(&(p->ml.first->p)))
+	{
+		PolyDestroy(p);
+		return false;
+	}
+	return true;
+}
+
+bool PolyDeserialize(const unsigned char *data, size_t size, Poly *p, size_t *consumed)
+{
+	size_t pos = POLY_SERIAL_MAGIC_SIZE + 1;
+	uint64_t payloadSize;
+
+	if(size < pos || memcmp(data, POLY_SERIAL_MAGIC, POLY_SERIAL_MAGIC_SIZE) != 0 ||
+		data[POLY_SERIAL_MAGIC_SIZE] != POLY_SERIAL_VERSION)
+	{
+		return false;
+	}
+	if(!ReadVarint(data, size, &pos, &payloadSize) || payloadSize > size - pos ||
+		CHECKSUM_SIZE > size - pos - payloadSize)
+	{
+		return false;
+	}
+
+	const unsigned char *payload = data + pos;
+	const unsigned char *checksumBytes = payload + payloadSize;
+	uint32_t checksum = 0;
+	for(int i = 0; i < CHECKSUM_SIZE; i++)
+	{
+		checksum |= (uint32_t)checksumBytes[i] << (8 * i);
+	}
+	if(checksum != Fnv1a32(payload, payloadSize))
+	{
+		return false;
+	}
+
+	size_t payloadPos = 0;
+	Poly res;
+	if(!PolyDecode(payload, payloadSize, &payloadPos, &res))
+	{
+		return false;
+	}
+	if(payloadPos != payloadSize)
+	{
+		PolyDestroy(&res);
+		return false;
+	}
+	*p = res;
+	if(consumed != NULL)
+	{
+		*consumed = pos + payloadSize + CHECKSUM_SIZE;
+	}
+	return true;
+}
+
+void PolyToText(const Poly *p, ByteBuffer *buf)
+{
+	char number[TEXT_LONG_LENGTH];
+	int length;
+	if(PolyIsCoeff(p))
+	{
+		length = snprintf(number, TEXT_LONG_LENGTH, "%ld", p->c);
+		ByteBufferAppend(buf, number, (size_t)length);
+		return;
+	}
+	for(const Mono *iter = p->ml.first; iter != NULL; iter = iter->next)
+	{
+		ByteBufferAppend(buf, "(", 1);
+		PolyToText(&(iter->p), buf);
+		length = snprintf(number, TEXT_LONG_LENGTH, ",%d)", iter->exp);
+		ByteBufferAppend(buf, number, (size_t)length);
+		if(iter->next != NULL)
+		{
+			ByteBufferAppend(buf, "+", 1);
+		}
+	}
+}
+
+/**
+ * Zapisuje zawartość tablicy bajtów do pliku
+ * @param[in] buf : tablica bajtów
+ * @param[in] path : ścieżka do pliku
+ * @return Czy zapis się powiódł
+ */
+static bool SaveBufferToFile(const ByteBuffer *buf, const char *path)
+{
+	FILE *file = fopen(path, "wb");
+	if(file == NULL)
+	{
+		return false;
+	}
+	bool ok = (fwrite(buf->data, 1, buf->size, file) == buf->size);
+	ok = (fclose(file) == 0) && ok;
+	return ok;
+}
+
+bool PolySaveToFile(const Poly *p, const char *path)
+{
+	ByteBuffer buf = EmptyByteBuffer();
+	PolySerialize(p, &buf);
+	bool ok = SaveBufferToFile(&buf, path);
+	ByteBufferDestroy(&buf);
+	return ok;
+}
+
+bool MappedPolySaveSerialized(const MappedPoly *p, const char *path)
+{
+	ByteBuffer buf = EmptyByteBuffer();
+	MappedPolySerialize(p, &buf);
+	bool ok = SaveBufferToFile(&buf, path);
+	ByteBufferDestroy(&buf);
+	return ok;
+}
+
+bool PolyLoadFromFile(const char *path, Poly *p)
+{
+	FILE *file = fopen(path, "rb");
+	if(file == NULL)
+	{
+		return false;
+	}
+	long fileSize = -1;
+	if(fseek(file, 0, SEEK_END) == 0)
+	{
+		fileSize = ftell(file);
+	}
+	if(fileSize < 0 || fseek(file, 0, SEEK_SET) != 0)
+	{
+		fclose(file);
+		return false;
+	}
+
+	unsigned char *data = malloc(fileSize > 0 ? (size_t)fileSize : 1);
+	assert(data != NULL);
+	bool ok = (fread(data, 1, (size_t)fileSize, file) == (size_t)fileSize);
+	fclose(file);
+
+	size_t consumed;
+	Poly res;
+	ok = ok && PolyDeserialize(data, (size_t)fileSize, &res, &consumed);
+	free(data);
+	if(ok && consumed != (size_t)fileSize)
+	{
+		PolyDestroy(&res);
+		ok = false;
+	}
+	if(ok)
+	{
+		*p = res;
+	}
+	return ok;
+}
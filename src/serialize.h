@@ -0,0 +1,165 @@
+/** @file
+   Interfejs binarnej serializacji wielomianów
+
+   Format zapisu (wersja 1):
+   - 4 bajty: sygnatura `IPPB`,
+   - 1 bajt: numer wersji formatu,
+   - varint: długość (w bajtach) zakodowanego wielomianu,
+   - zakodowany wielomian,
+   - 4 bajty: suma kontrolna FNV-1a zakodowanego wielomianu (little endian).
+
+   Wielomian kodowany jest rekurencyjnie: najpierw varint z liczbą jednomianów,
+   a następnie, jeśli wielomian jest stały, jego współczynnik (varint w kodowaniu
+   zigzag), a w przeciwnym razie kolejne jednomiany. Jednomian to varint z różnicą
+   wykładnika względem poprzedniego jednomianu (dla pierwszego – sam wykładnik),
+   po którym następuje zakodowany współczynnik.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-12
+*/
+#ifndef __SERIALIZE_H__
+#define __SERIALIZE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "poly.h"
+#include "mapped.h"
+
+/** Sygnatura zapisu binarnego wielomianu */
+#define POLY_SERIAL_MAGIC "IPPB"
+/** Długość sygnatury zapisu binarnego wielomianu */
+#define POLY_SERIAL_MAGIC_SIZE 4
+/** Wersja formatu zapisu binarnego wielomianu */
+#define POLY_SERIAL_VERSION 1
+
+/**
+ * Dynamicznie powiększana tablica bajtów
+ */
+typedef struct ByteBuffer
+{
+	unsigned char *data; ///< zawartość
+	size_t size; ///< liczba zapisanych bajtów
+	size_t capacity; ///< rozmiar zaalokowanej pamięci
+} ByteBuffer;
+
+/**
+ * Zwraca pustą tablicę bajtów
+ * @return pusta tablica bajtów
+ */
+static inline ByteBuffer EmptyByteBuffer()
+{
+	return (ByteBuffer) {.data = NULL, .size = 0, .capacity = 0};
+}
+
+/**
+ * Usuwa tablicę bajtów z pamięci
+ * @param[in] buf : tablica bajtów
+ */
+void ByteBufferDestroy(ByteBuffer *buf);
+
+/**
+ * Dopisuje na koniec tablicy @p buf @p size bajtów z @p data
+ * @param[in] buf : tablica bajtów
+ * @param[in] data : dopisywane bajty
+ * @param[in] size : liczba bajtów
+ */
+void ByteBufferAppend(ByteBuffer *buf, const void *data, size_t size);
+
+/**
+ * Dopisuje na koniec tablicy @p buf liczbę @p v w kodowaniu varint
+ * (po 7 bitów na bajt, najstarszy bit oznacza kontynuację)
+ * @param[in] buf : tablica bajtów
+ * @param[in] v : liczba
+ */
+void ByteBufferAppendVarint(ByteBuffer *buf, uint64_t v);
+
+/**
+ * Odczytuje liczbę zapisaną w kodowaniu varint
+ * @param[in] data : początek danych
+ * @param[in] size : liczba dostępnych bajtów
+ * @param[out] pos : pozycja odczytu, przesuwana za odczytaną liczbę
+ * @param[out] v : odczytana liczba
+ * @return Czy odczyt się powiódł
+ */
+bool ReadVarint(const unsigned char *data, size_t size, size_t *pos, uint64_t *v);
+
+/**
+ * Liczy sumę kontrolną FNV-1a ciągu bajtów
+ * @param[in] data : bajty
+ * @param[in] size : liczba bajtów
+ * @return suma kontrolna
+ */
+uint32_t Fnv1a32(const unsigned char *data, size_t size);
+
+/**
+ * Liczy 64-bitowy skrót FNV-1a ciągu bajtów
+ * @param[in] data : bajty
+ * @param[in] size : liczba bajtów
+ * @return skrót
+ */
+uint64_t Fnv1a64(const unsigned char *data, size_t size);
+
+/**
+ * Dopisuje na koniec tablicy @p buf pełny zapis binarny wielomianu @p p
+ * (z nagłówkiem i sumą kontrolną)
+ * @param[in] p : wielomian
+ * @param[in] buf : tablica bajtów
+ */
+void PolySerialize(const Poly *p, ByteBuffer *buf);
+
+/**
+ * Dopisuje na koniec tablicy @p buf pełny zapis binarny odwzorowanego
+ * wielomianu @p p (taki sam jak PolySerialize() dla równego mu wielomianu)
+ * @param[in] p : odwzorowany wielomian
+ * @param[in] buf : tablica bajtów
+ */
+void MappedPolySerialize(const MappedPoly *p, ByteBuffer *buf);
+
+/**
+ * Odtwarza wielomian z zapisu binarnego stworzonego przez PolySerialize().
+ * Sprawdza sygnaturę, wersję, sumę kontrolną i poprawność struktury
+ * (rosnące wykładniki, brak zerowych współczynników).
+ * @param[in] data : zapis binarny
+ * @param[in] size : liczba dostępnych bajtów
+ * @param[out] p : odczytany wielomian (tylko w przypadku powodzenia)
+ * @param[out] consumed : liczba bajtów zajmowanych przez zapis (może być NULL)
+ * @return Czy odczyt się powiódł
+ */
+bool PolyDeserialize(const unsigned char *data, size_t size, Poly *p, size_t *consumed);
+
+/**
+ * Dopisuje na koniec tablicy @p buf zapis tekstowy wielomianu @p p
+ * (taki sam, jak wypisywany przez PrintPoly())
+ * @param[in] p : wielomian
+ * @param[in] buf : tablica bajtów
+ */
+void PolyToText(const Poly *p, ByteBuffer *buf);
+
+/**
+ * Zapisuje wielomian w postaci binarnej do pliku
+ * @param[in] p : wielomian
+ * @param[in] path : ścieżka do pliku
+ * @return Czy zapis się powiódł
+ */
+bool PolySaveToFile(const Poly *p, const char *path);
+
+/**
+ * Zapisuje odwzorowany wielomian w postaci binarnej (zob. PolySaveToFile())
+ * do pliku, bez tworzenia jego kopii w pamięci
+ * @param[in] p : odwzorowany wielomian
+ * @param[in] path : ścieżka do pliku
+ * @return Czy zapis się powiódł
+ */
+bool MappedPolySaveSerialized(const MappedPoly *p, const char *path);
+
+/**
+ * Wczytuje wielomian zapisany w postaci binarnej z pliku
+ * @param[in] path : ścieżka do pliku
+ * @param[out] p : wczytany wielomian (tylko w przypadku powodzenia)
+ * @return Czy odczyt się powiódł
+ */
+bool PolyLoadFromFile(const char *path, Poly *p);
+
+#endif /* __SERIALIZE_H__ */
@@ -0,0 +1,630 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "libpoly.h"
+#include "poly.h"
+#include "memstat.h"
+#include "serialize.h"
+
+#include "utils.h"
+
+/** Maksymalna liczba połączeń oczekujących na przyjęcie */
+#define SERVER_BACKLOG 64
+/** Rozmiar fragmentu wczytywanego z połączenia jednym wywołaniem `recv` */
+#define SERVER_READ_SIZE (1 << 16)
+/**
+ * Liczba bajtów nieodebranego przez klienta wyjścia (lub wczytanych,
+ * niewykonanych jeszcze wierszy), powyżej której serwer przestaje
+ * wczytywać od niego dane
+ */
+#define SERVER_MAX_PENDING (1 << 20)
+/**
+ * Przybliżona liczba bajtów wierszy sesji wykonywanych przez wątek roboczy
+ * za jednym razem (potem sesja wraca na koniec kolejki, żeby inne sesje
+ * nie czekały na wykonanie długiego skryptu)
+ */
+#define SERVER_BATCH_SIZE (1 << 16)
+/** Maksymalna liczba zdarzeń odbieranych jednym wywołaniem `epoll_wait` */
+#define SERVER_MAX_EVENTS 64
+/** Maksymalna liczba wątków roboczych */
+#define SERVER_MAX_WORKERS 256
+
+/**
+ * Połączenie z klientem (sesja kalkulatora).
+ * Pola oprócz @p calc są chronione blokadą serwera; z @p calc korzysta
+ * tylko wątek roboczy, który akurat wykonuje sesję.
+ */
+typedef struct ServerSession
+{
+	int fd; ///< deskryptor połączenia (-1 po zerwaniu połączenia)
+	PolyCalc *calc; ///< kontekst kalkulatora sesji
+	ByteBuffer input; ///< wczytane, jeszcze niewykonane wiersze
+	ByteBuffer output; ///< wyjście wykonanych wierszy czekające na wysłanie
+	size_t sent; ///< liczba już wysłanych bajtów z @p output
+	uint32_t events; ///< zdarzenia, na które połączenie jest zarejestrowane w epoll
+	bool closing; ///< czy klient zakończył wysyłanie wierszy
+	bool scheduled; ///< czy sesja czeka w kolejce lub jest wykonywana
+	bool finished; ///< czy sesja jest na liście sesji wykonanych przez wątki robocze
+	bool dead; ///< czy sesja czeka na usunięcie
+	struct ServerSession *nextScheduled; ///< następna sesja w kolejce
+	struct ServerSession *nextFinished; ///< następna sesja na liście wykonanych
+	struct ServerSession *nextDead; ///< następna sesja do usunięcia
+	struct ServerSession *prev; ///< poprzednia sesja na liście wszystkich sesji
+	struct ServerSession *next; ///< następna sesja na liście wszystkich sesji
+} ServerSession;
+
+/**
+ * Stan serwera
+ */
+typedef struct Server
+{
+	pthread_mutex_t lock; ///< blokada stanu serwera i sesji
+	pthread_cond_t work; ///< sygnalizuje wątkom roboczym sesje w kolejce
+	ServerSession *queueHead; ///< pierwsza sesja w kolejce do wykonania
+	ServerSession *queueTail; ///< ostatnia sesja w kolejce do wykonania
+	ServerSession *finished; ///< sesje wykonane przez wątki robocze od ostatniego obsłużenia
+	ServerSession *sessions; ///< wszystkie sesje
+	int epollFd; ///< deskryptor epoll
+	int notifyPipe[2]; ///< potok, którym wątki robocze budzą wątek wejścia-wyjścia
+	bool stop; ///< czy wątki robocze mają się zakończyć
+	unsigned flags; ///< flagi tworzonych sesji
+} Server;
+
+/** Czy otrzymano sygnał zakończenia pracy serwera */
+static volatile sig_atomic_t serverStop = 0;
+
+/**
+ * Obsługa sygnałów SIGINT i SIGTERM
+ * @param[in] signal : numer sygnału
+ */
+static void ServerHandleSignal(int signal)
+{
+	(void)signal;
+	serverStop = 1;
+}
+
+/**
+ * Ustawia deskryptor w tryb nieblokujący
+ * @param[in] fd : deskryptor
+ * @return Czy się udało
+ */
+static bool ServerSetNonBlocking(int fd)
+{
+	int flags = fcntl(fd, F_GETFL);
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/**
+ * Tworzy nasłuchujące gniazdo domeny uniksowej
+ * @param[in] path : ścieżka gniazda
+ * @return deskryptor gniazda lub -1 w przypadku błędu
+ */
+static int ServerListen(const char *path)
+{
+	struct sockaddr_un addr;
+	if(strlen(path) >= sizeof(addr.sun_path))
+	{
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	/* gniazdo pozostawione przez poprzedni serwer zastępujemy, inne pliki nie */
+	struct stat st;
+	if(lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+	{
+		unlink(path);
+	}
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0)
+	{
+		return -1;
+	}
+	if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SERVER_BACKLOG) != 0 ||
+		!ServerSetNonBlocking(fd))
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/**
+ * Zwraca długość początku wczytanych wierszy sesji, który należy wykonać
+ * za jednym razem: pełne wiersze mieszczące się w SERVER_BATCH_SIZE bajtach
+ * (lub pierwszy pełny wiersz, jeśli jest dłuższy), a gdy klient zakończył
+ * wysyłanie, także ostatni niepełny wiersz
+ * @param[in] session : sesja
+ * @return liczba bajtów (0, jeśli nie ma czego wykonać)
+ */
+static size_t ServerBatchSize(const ServerSession *session)
+{
+	size_t size = session->input.size;
+	if(size == 0)
+	{
+		return 0;
+	}
+	const char *data = (const char*)session->input.data;
+	size_t limit = (size < SERVER_BATCH_SIZE) ? size : SERVER_BATCH_SIZE;
+	size_t end = limit;
+	while(end > 0 && data[end - 1] != '\n')
+	{
+		end--;
+	}
+	if(end == 0)
+	{
+		const char *newline = memchr(data + limit, '\n', size - limit);
+		end = (newline != NULL) ? (size_t)(newline - data) + 1 : (session->closing ? size : 0);
+	}
+	return end;
+}
+
+/**
+ * Wstawia sesję na koniec kolejki do wykonania (wymaga blokady serwera)
+ * @param[in] server : serwer
+ * @param[in] session : sesja
+ */
+static void ServerSchedule(Server *server, ServerSession *session)
+{
+	session->scheduled = true;
+	session->nextScheduled = NULL;
+	if(server->queueTail == NULL)
+	{
+		server->queueHead = session;
+	}
+	else
+	{
+		server->queueTail->nextScheduled = session;
+	}
+	server->queueTail = session;
+	pthread_cond_signal(&(server->work));
+}
+
+/**
+ * Dopisuje sesję do listy sesji wykonanych i budzi wątek wejścia-wyjścia
+ * (wymaga blokady serwera)
+ * @param[in] server : serwer
+ * @param[in] session : sesja
+ */
+static void ServerNotify(Server *server, ServerSession *session)
+{
+	if(session->finished)
+	{
+		return;
+	}
+	session->finished = true;
+	session->nextFinished = server->finished;
+	if(server->finished == NULL)
+	{
+		char byte = 0;
+		/* pełny potok i tak obudzi wątek wejścia-wyjścia */
+		if(write(server->notifyPipe[1], &byte, 1) < 0)
+		{
+			(void)errno;
+		}
+	}
+	server->finished = session;
+}
+
+/**
+ * Funkcja wątku roboczego: wykonuje wiersze kolejnych sesji z kolejki
+ * @param[in] data : serwer
+ * @return NULL
+ */
+static void *ServerWorker(void *data)
+{
+	Server *server = data;
+	ByteBuffer script = EmptyByteBuffer();
+
+	pthread_mutex_lock(&(server->lock));
+	while(1)
+	{
+		while(!server->stop && server->queueHead == NULL)
+		{
+			pthread_cond_wait(&(server->work), &(server->lock));
+		}
+		if(server->stop)
+		{
+			break;
+		}
+		ServerSession *session = server->queueHead;
+		server->queueHead = session->nextScheduled;
+		if(server->queueHead == NULL)
+		{
+			server->queueTail = NULL;
+		}
+		size_t batch = (session->fd >= 0) ? ServerBatchSize(session) : 0;
+		ByteBufferAppend(&script, session->input.data, batch);
+		memmove(session->input.data, session->input.data + batch, session->input.size - batch);
+		session->input.size -= batch;
+		pthread_mutex_unlock(&(server->lock));
+
+		PolyCalcExecute(session->calc, (const char*)script.data, script.size);
+		script.size = 0;
+		size_t size;
+		const char *output = PolyCalcOutput(session->calc, &size);
+
+		pthread_mutex_lock(&(server->lock));
+		ByteBufferAppend(&(session->output), output, size);
+		PolyCalcClearOutput(session->calc);
+		if(session->fd >= 0 && ServerBatchSize(session) > 0)
+		{
+			ServerSchedule(server, session);
+		}
+		else
+		{
+			session->scheduled = false;
+		}
+		ServerNotify(server, session);
+	}
+	pthread_mutex_unlock(&(server->lock));
+
+	ByteBufferDestroy(&script);
+	MemStatFlush();
+	MonoPoolRelease();
+	return NULL;
+}
+
+/**
+ * Zamyka połączenie sesji po jego zerwaniu lub zakończeniu
+ * (wymaga blokady serwera)
+ * @param[in] server : serwer
+ * @param[in] session : sesja
+ */
+static void ServerDisconnect(Server *server, ServerSession *session)
+{
+	if(session->fd >= 0)
+	{
+		epoll_ctl(server->epollFd, EPOLL_CTL_DEL, session->fd, NULL);
+		close(session->fd);
+		session->fd = -1;
+	}
+}
+
+/**
+ * Wysyła tyle wyjścia sesji, ile połączenie przyjmie bez blokowania
+ * (wymaga blokady serwera)
+ * @param[in] session : sesja
+ * @return false, jeśli połączenie zostało zerwane
+ */
+static bool ServerSend(ServerSession *session)
+{
+	while(session->sent < session->output.size)
+	{
+		ssize_t res = send(session->fd, session->output.data + session->sent,
+			session->output.size - session->sent, MSG_NOSIGNAL);
+		if(res < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+		session->sent += (size_t)res;
+	}
+	session->output.size = 0;
+	session->sent = 0;
+	return true;
+}
+
+/**
+ * Po zmianie stanu sesji wysyła jej wyjście, uaktualnia zdarzenia, na które
+ * czeka jej połączenie, a zakończoną sesję przeznacza do usunięcia
+ * (wymaga blokady serwera)
+ * @param[in] server : serwer
+ * @param[in] session : sesja
+ * @param[in] dead : lista sesji do usunięcia
+ */
+static void ServerUpdate(Server *server, ServerSession *session, ServerSession **dead)
+{
+	if(session->dead)
+	{
+		return;
+	}
+	if(session->fd >= 0 && session->output.size > session->sent && !ServerSend(session))
+	{
+		ServerDisconnect(server, session);
+	}
+	size_t pending = session->output.size - session->sent;
+	if(session->fd >= 0 && session->closing && !session->scheduled && pending == 0 &&
+		ServerBatchSize(session) == 0)
+	{
+		ServerDisconnect(server, session);
+	}
+	if(session->fd < 0)
+	{
+		if(!session->scheduled)
+		{
+			session->dead = true;
+			session->nextDead = *dead;
+			*dead = session;
+		}
+		return;
+	}
+	/* długiego niepełnego wiersza nie da się wykonać, więc trzeba go wczytywać dalej */
+	bool inputFull = session->scheduled && session->input.size >= SERVER_MAX_PENDING;
+	uint32_t events = (pending > 0 ? EPOLLOUT : 0) |
+		(!session->closing && pending < SERVER_MAX_PENDING && !inputFull ? EPOLLIN : 0);
+	if(events != session->events)
+	{
+		struct epoll_event ev = {.events = events, .data.ptr = session};
+		epoll_ctl(server->epollFd, EPOLL_CTL_MOD, session->fd, &ev);
+		session->events = events;
+	}
+}
+
+/**
+ * Wczytuje dostępne dane z połączenia i, jeśli są wśród nich pełne wiersze,
+ * wstawia sesję do kolejki
+ * @param[in] server : serwer
+ * @param[in] session : sesja
+ */
+static void ServerReceive(Server *server, ServerSession *session)
+{
+	char chunk[SERVER_READ_SIZE];
+	ssize_t res = recv(session->fd, chunk, SERVER_READ_SIZE, 0);
+
+	pthread_mutex_lock(&(server->lock));
+	if(res < 0)
+	{
+		if(errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)
+		{
+			ServerDisconnect(server, session);
+		}
+	}
+	else if(res == 0)
+	{
+		session->closing = true;
+	}
+	else
+	{
+		ByteBufferAppend(&(session->input), chunk, (size_t)res);
+	}
+	if(!session->scheduled && session->fd >= 0 &&
+		((res > 0 && memchr(chunk, '\n', (size_t)res) != NULL) || (res == 0 && session->input.size > 0)))
+	{
+		ServerSchedule(server, session);
+	}
+	pthread_mutex_unlock(&(server->lock));
+}
+
+/**
+ * Przyjmuje oczekujące połączenia i tworzy dla nich sesje
+ * @param[in] server : serwer
+ * @param[in] listenFd : nasłuchujące gniazdo
+ */
+static void ServerAccept(Server *server, int listenFd)
+{
+	while(1)
+	{
+		int fd = accept(listenFd, NULL, NULL);
+		if(fd < 0)
+		{
+			return;
+		}
+		ServerSession *session = malloc(sizeof(ServerSession));
+		assert(session != NULL);
+		*session = (ServerSession) {.fd = fd, .calc = PolyCalcCreate(server->flags | POLY_CALC_MERGE_ERRORS |
+			POLY_CALC_NO_FILES),
+			.input = EmptyByteBuffer(), .output = EmptyByteBuffer(), .sent = 0, .events = EPOLLIN,
+			.closing = false, .scheduled = false, .finished = false, .dead = false,
+			.nextScheduled = NULL, .nextFinished = NULL, .nextDead = NULL, .prev = NULL, .next = NULL};
+		struct epoll_event ev = {.events = EPOLLIN, .data.ptr = session};
+		if(!ServerSetNonBlocking(fd) || epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &ev) != 0)
+		{
+			close(fd);
+			PolyCalcDestroy(session->calc);
+			free(session);
+			continue;
+		}
+		pthread_mutex_lock(&(server->lock));
+		session->next = server->sessions;
+		if(server->sessions != NULL)
+		{
+			server->sessions->prev = session;
+		}
+		server->sessions = session;
+		pthread_mutex_unlock(&(server->lock));
+	}
+}
+
+/**
+ * Usuwa sesję z listy wszystkich sesji i z pamięci (wymaga blokady serwera)
+ * @param[in] server : serwer
+ * @param[in] session : sesja
+ */
+static void ServerDestroySession(Server *server, ServerSession *session)
+{
+	ServerDisconnect(server, session);
+	if(session->prev != NULL)
+	{
+		session->prev->next = session->next;
+	}
+	else
+	{
+		server->sessions = session->next;
+	}
+	if(session->next != NULL)
+	{
+		session->next->prev = session->prev;
+	}
+	PolyCalcDestroy(session->calc);
+	ByteBufferDestroy(&(session->input));
+	ByteBufferDestroy(&(session->output));
+	free(session);
+}
+
+/**
+ * Obsługuje zdarzenia połączeń do czasu otrzymania sygnału zakończenia
+ * @param[in] server : serwer
+ * @param[in] listenFd : nasłuchujące gniazdo
+ */
+static void ServerLoop(Server *server, int listenFd)
+{
+	struct epoll_event events[SERVER_MAX_EVENTS];
+	while(!serverStop)
+	{
+		int count = epoll_wait(server->epollFd, events, SERVER_MAX_EVENTS, -1);
+		/* sesje usuwamy dopiero po obsłużeniu wszystkich zdarzeń, bo mogą ich dotyczyć */
+		ServerSession *dead = NULL;
+		for(int i = 0; i < count; i++)
+		{
+			void *ptr = events[i].data.ptr;
+			if(ptr == NULL)
+			{
+				ServerAccept(server, listenFd);
+			}
+			else if(ptr == server)
+			{
+				char drain[64];
+				while(read(server->notifyPipe[0], drain, sizeof(drain)) > 0)
+				{
+				}
+				pthread_mutex_lock(&(server->lock));
+				ServerSession *finished = server->finished;
+				server->finished = NULL;
+				for(; finished != NULL; finished = finished->nextFinished)
+				{
+					finished->finished = false;
+					ServerUpdate(server, finished, &dead);
+				}
+				pthread_mutex_unlock(&(server->lock));
+			}
+			else
+			{
+				ServerSession *session = ptr;
+				if(session->dead)
+				{
+					continue;
+				}
+				if((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !session->closing &&
+					session->fd >= 0)
+				{
+					ServerReceive(server, session);
+				}
+				else if(events[i].events & (EPOLLHUP | EPOLLERR) && !(events[i].events & EPOLLOUT))
+				{
+					pthread_mutex_lock(&(server->lock));
+					ServerDisconnect(server, session);
+					pthread_mutex_unlock(&(server->lock));
+				}
+				pthread_mutex_lock(&(server->lock));
+				ServerUpdate(server, session, &dead);
+				pthread_mutex_unlock(&(server->lock));
+			}
+		}
+		pthread_mutex_lock(&(server->lock));
+		while(dead != NULL)
+		{
+			ServerSession *next = dead->nextDead;
+			ServerDestroySession(server, dead);
+			dead = next;
+		}
+		pthread_mutex_unlock(&(server->lock));
+	}
+}
+
+/**
+ * Zwraca liczbę wątków roboczych
+ * @param[in] workers : liczba podana przez użytkownika (0 – według liczby procesorów)
+ * @return liczba wątków roboczych
+ */
+static unsigned ServerWorkerCount(unsigned workers)
+{
+	if(workers == 0)
+	{
+		long online = sysconf(_SC_NPROCESSORS_ONLN);
+		workers = (online > 0) ? (unsigned)online : 1;
+	}
+	return (workers > SERVER_MAX_WORKERS) ? SERVER_MAX_WORKERS : workers;
+}
+
+bool ServeUnixSocket(const char *path, unsigned flags, unsigned workers)
+{
+	int listenFd = ServerListen(path);
+	if(listenFd < 0)
+	{
+		return false;
+	}
+	Server server = {.queueHead = NULL, .queueTail = NULL, .finished = NULL, .sessions = NULL,
+		.epollFd = epoll_create1(0), .notifyPipe = {-1, -1}, .stop = false, .flags = flags};
+	pthread_mutex_init(&(server.lock), NULL);
+	pthread_cond_init(&(server.work), NULL);
+	struct epoll_event listenEv = {.events = EPOLLIN, .data.ptr = NULL};
+	struct epoll_event notifyEv = {.events = EPOLLIN, .data.ptr = &server};
+	bool ok = server.epollFd >= 0 && pipe(server.notifyPipe) == 0 &&
+		ServerSetNonBlocking(server.notifyPipe[0]) && ServerSetNonBlocking(server.notifyPipe[1]) &&
+		epoll_ctl(server.epollFd, EPOLL_CTL_ADD, listenFd, &listenEv) == 0 &&
+		epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.notifyPipe[0], &notifyEv) == 0;
+
+	/* sygnały zakończenia mają trafiać do wątku wejścia-wyjścia, nie do wątków roboczych */
+	sigset_t stopSignals, oldMask;
+	sigemptyset(&stopSignals);
+	sigaddset(&stopSignals, SIGINT);
+	sigaddset(&stopSignals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &stopSignals, &oldMask);
+	unsigned workerCount = ok ? ServerWorkerCount(workers) : 0;
+	pthread_t threads[SERVER_MAX_WORKERS];
+	unsigned started = 0;
+	while(started < workerCount && pthread_create(&(threads[started]), NULL, ServerWorker, &server) == 0)
+	{
+		started++;
+	}
+	pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+
+	if(started > 0)
+	{
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = ServerHandleSignal;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGINT, &action, NULL);
+		sigaction(SIGTERM, &action, NULL);
+		ServerLoop(&server, listenFd);
+	}
+
+	pthread_mutex_lock(&(server.lock));
+	server.stop = true;
+	pthread_cond_broadcast(&(server.work));
+	pthread_mutex_unlock(&(server.lock));
+	for(unsigned i = 0; i < started; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+	while(server.sessions != NULL)
+	{
+		ServerDestroySession(&server, server.sessions);
+	}
+	for(int i = 0; i < 2; i++)
+	{
+		if(server.notifyPipe[i] >= 0)
+		{
+			close(server.notifyPipe[i]);
+		}
+	}
+	if(server.epollFd >= 0)
+	{
+		close(server.epollFd);
+	}
+	pthread_cond_destroy(&(server.work));
+	pthread_mutex_destroy(&(server.lock));
+	close(listenFd);
+	unlink(path);
+	return started > 0;
+}
@@ -0,0 +1,43 @@
+/** @file
+   Interfejs trybu serwera kalkulatora wielomianów (opcja `--serve GNIAZDO`)
+
+   Serwer nasłuchuje na gnieździe domeny uniksowej i obsługuje wiele
+   połączeń naraz. Każde połączenie jest osobną sesją kalkulatora
+   (kontekstem z libpoly.h) z własnym stosem, rejestrami i tablicami
+   poleceń, która zaczyna od pustego stosu. Połączenia obsługuje jeden
+   wątek wejścia-wyjścia (epoll), a wiersze sesji wykonuje stała pula
+   wątków roboczych; każda sesja jest w danej chwili wykonywana przez
+   co najwyżej jeden wątek, a długie skrypty są wykonywane porcjami,
+   na przemian z innymi sesjami.
+
+   Klient wysyła wiersze w tym samym formacie co na standardowe wejście
+   calc_poly, a serwer odsyła na to samo połączenie
+   wyjście i komunikaty o błędach (w kolejności wykonania wierszy,
+   z numerami wierszy liczonymi od początku połączenia). Polecenia
+   operujące na plikach (SAVE, LOAD, SAVE_MAPPED, LOAD_MAPPED, CHECKPOINT
+   i RESTORE) są w sesjach niedostępne. Zamknięcie
+   połączenia do zapisu przez klienta kończy sesję: ewentualny ostatni
+   niepełny wiersz jest wykonywany, a po odesłaniu wyjścia serwer zamyka
+   połączenie. Sygnał SIGINT lub SIGTERM kończy pracę serwera.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-27
+*/
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include <stdbool.h>
+
+/**
+ * Uruchamia serwer kalkulatora na gnieździe @p path i obsługuje połączenia
+ * do czasu otrzymania sygnału SIGINT lub SIGTERM. Istniejące gniazdo
+ * o tej ścieżce jest zastępowane, a po zakończeniu pracy usuwane.
+ * @param[in] path : ścieżka gniazda
+ * @param[in] flags : flagi sesji (POLY_CALC_LAZY, zob. PolyCalcCreate())
+ * @param[in] workers : liczba wątków roboczych (0 – tyle, ile jest procesorów)
+ * @return false, jeśli nie udało się utworzyć gniazda lub wątków roboczych
+ */
+bool ServeUnixSocket(const char *path, unsigned flags, unsigned workers);
+
+#endif /* __SERVER_H__ */
@@ -0,0 +1,176 @@
+/** @file
+   Testy trybu serwera kalkulatora wielomianów (zob. server.h)
+
+   W odróżnieniu od unit_tests_poly.c testy nie podmieniają funkcji
+   biblioteki standardowej, bo serwer korzysta z wątków: korzystają
+   z biblioteki libpoly, a serwer uruchamiają w osobnym procesie
+   i rozmawiają z nim przez gniazdo, tak jak klienci calc_poly --serve.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-28
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "cmocka.h"
+
+#include "server.h"
+
+/** Ścieżka gniazda testowego serwera */
+#define TEST_SOCKET "server_tests_poly.sock"
+/** Plik, którego sesje serwera nie mogą utworzyć */
+#define TEST_FILE "server_tests_poly.tmp"
+/** Maksymalna długość odpowiedzi serwera w testach */
+#define TEST_RESPONSE_SIZE 256
+
+/** Proces serwera */
+static pid_t serverPid = -1;
+
+/**
+ * Łączy się z serwerem testowym
+ * @return deskryptor połączenia lub -1
+ */
+static int connect_to_server(void) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, TEST_SOCKET);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/**
+ * Wysyła cały napis przez połączenie
+ */
+static void send_text(int fd, const char *text) {
+    size_t size = strlen(text);
+    while (size > 0) {
+        ssize_t sent = send(fd, text, size, 0);
+        assert_true(sent > 0);
+        text += sent;
+        size -= (size_t)sent;
+    }
+}
+
+/**
+ * Kończy wysyłanie i odbiera odpowiedź serwera (do zamknięcia połączenia)
+ */
+static void finish_and_check_response(int fd, const char *expected) {
+    char response[TEST_RESPONSE_SIZE];
+    size_t size = 0;
+    ssize_t received;
+    shutdown(fd, SHUT_WR);
+    while ((received = recv(fd, response + size, sizeof(response) - 1 - size, 0)) > 0) {
+        size += (size_t)received;
+    }
+    close(fd);
+    response[size] = '\0';
+    assert_string_equal(response, expected);
+}
+
+/**
+ * Uruchamia serwer w procesie potomnym i czeka, aż zacznie przyjmować połączenia
+ */
+static int start_server(void **state) {
+    (void)state;
+
+    unlink(TEST_SOCKET);
+    serverPid = fork();
+    if (serverPid == 0) {
+        _exit(ServeUnixSocket(TEST_SOCKET, 0, 2) ? 0 : 1);
+    }
+    const struct timespec delay = {.tv_sec = 0, .tv_nsec = 10 * 1000 * 1000};
+    for (int attempt = 0; attempt < 500; attempt++) {
+        int fd = connect_to_server();
+        if (fd >= 0) {
+            finish_and_check_response(fd, "");
+            return 0;
+        }
+        nanosleep(&delay, NULL);
+    }
+    return -1;
+}
+
+/**
+ * Zatrzymuje serwer sygnałem SIGTERM i sprawdza, że zakończył się poprawnie
+ */
+static int stop_server(void **state) {
+    (void)state;
+
+    int status;
+    kill(serverPid, SIGTERM);
+    /* serwer mógł czekać na zdarzenie, gdy przyszedł sygnał – budzimy go */
+    int fd = connect_to_server();
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (waitpid(serverPid, &status, 0) != serverPid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0 || access(TEST_SOCKET, F_OK) == 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static void test_server_sessions_independent(void **state) {
+    (void)state;
+
+    int first = connect_to_server();
+    int second = connect_to_server();
+    assert_true(first >= 0 && second >= 0);
+    send_text(first, "1\n2\n");
+    send_text(second, "PRINT\n5\n");
+    send_text(first, "ADD\nPRINT\n");
+    send_text(second, "PRINT\nADD\n");
+    finish_and_check_response(second, "ERROR 1 STACK UNDERFLOW\n5\nERROR 4 STACK UNDERFLOW\n");
+    finish_and_check_response(first, "3\n");
+}
+
+static void test_server_line_without_newline(void **state) {
+    (void)state;
+
+    int fd = connect_to_server();
+    assert_true(fd >= 0);
+    send_text(fd, "(1,2)\nCLONE\nMUL\nPRI");
+    send_text(fd, "NT\nDEG");
+    finish_and_check_response(fd, "(1,4)\n4\n");
+}
+
+static void test_server_rejects_file_commands(void **state) {
+    (void)state;
+
+    int fd = connect_to_server();
+    assert_true(fd >= 0);
+    send_text(fd, "1\nSAVE " TEST_FILE "\nSAVE_MAPPED " TEST_FILE "\nCHECKPOINT " TEST_FILE "\n"
+        "LOAD " TEST_FILE "\nLOAD_MAPPED " TEST_FILE "\nRESTORE " TEST_FILE "\nPRINT\n");
+    finish_and_check_response(fd, "ERROR 2 WRONG COMMAND\nERROR 3 WRONG COMMAND\n"
+        "ERROR 4 WRONG COMMAND\nERROR 5 WRONG COMMAND\nERROR 6 WRONG COMMAND\n"
+        "ERROR 7 WRONG COMMAND\n1\n");
+    assert_true(access(TEST_FILE, F_OK) != 0);
+}
+
+int main() {
+    const struct CMUnitTest server_tests[] = {
+        cmocka_unit_test(test_server_sessions_independent),
+        cmocka_unit_test(test_server_line_without_newline),
+        cmocka_unit_test(test_server_rejects_file_commands)
+    };
+    return cmocka_run_group_tests(server_tests, start_server, stop_server);
+}
@@ -0,0 +1,320 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stats.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mapped.h"
+
+#include "utils.h"
+
+/** Maksymalna długość jednego wiersza raportu */
+#define STATS_LINE_SIZE 256
+
+/**
+ * Liczniki jednego polecenia
+ */
+typedef struct StatsEntry
+{
+	const char *name; ///< nazwa polecenia
+	uint64_t calls; ///< liczba wywołań
+	uint64_t totalNs; ///< łączny czas wykonania (w nanosekundach)
+	uint64_t maxNs; ///< najdłuższy czas wykonania (w nanosekundach)
+	uint64_t allocBytes; ///< rozmiar zaalokowanych jednomianów (w bajtach)
+	uint64_t inputTerms; ///< liczba jednomianów w argumentach
+	uint64_t outputTerms; ///< liczba jednomianów w wynikach
+	PerfCounts perf; ///< przyrosty sprzętowych liczników wydajności
+} StatsEntry;
+
+/** Format raportu (STATS_DISABLED, jeśli liczniki są wyłączone) */
+static StatsFormat statsFormat = STATS_DISABLED;
+/** Czy doliczać sprzętowe liczniki wydajności */
+static bool statsPerf = false;
+/** Liczniki kolejnych poleceń (w kolejności pierwszego wywołania) */
+static StatsEntry *statsEntries = NULL;
+/** Liczba poleceń, dla których są liczniki */
+static size_t statsCount = 0;
+/** Rozmiar zaalokowanej tablicy liczników */
+static size_t statsCapacity = 0;
+/** Blokada liczników poleceń (polecenia mogą wykonywać różne wątki) */
+static pthread_mutex_t statsLock = PTHREAD_MUTEX_INITIALIZER;
+
+void StatsEnable(StatsFormat format)
+{
+	statsFormat = format;
+}
+
+void StatsEnablePerfCounters(bool enabled)
+{
+	statsPerf = enabled;
+}
+
+bool StatsIsEnabled()
+{
+	return statsFormat != STATS_DISABLED;
+}
+
+/**
+ * Zwraca liczbę jednomianów elementu stosu
+ * @param[in] elem : element stosu
+ * @return liczba jednomianów
+ */
+static uint64_t StatsElemTerms(const PolyStackElem *elem)
+{
+	if(elem->lazy != NULL)
+	{
+		return 0;
+	}
+	if(elem->mapped != NULL)
+	{
+		return ((const MappedHeader*)elem->mapped->base)->monoCount;
+	}
+	return PolyMonoCountDeep(&(elem->p));
+}
+
+/**
+ * Zwraca liczbę jednomianów elementów stosu od pozycji @p from do szczytu
+ * @param[in] pStack : stos wielomianów
+ * @param[in] from : pozycja pierwszego elementu (licząc od dna stosu)
+ * @return liczba jednomianów
+ */
+static uint64_t StatsStackTerms(const PolyStack *pStack, size_t from)
+{
+	uint64_t terms = 0;
+	for(size_t i = from; i < pStack->size; i++)
+	{
+		terms += StatsElemTerms(&(pStack->elems[i]));
+	}
+	return terms;
+}
+
+/**
+ * Zwraca czas, który upłynął od chwili @p start (w nanosekundach)
+ * @param[in] start : chwila początkowa
+ * @return czas w nanosekundach
+ */
+static uint64_t StatsElapsedNs(const struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)(now.tv_sec - start->tv_sec) * 1000000000u +
+		(uint64_t)(now.tv_nsec - start->tv_nsec);
+}
+
+/**
+ * Znajduje liczniki polecenia @p name, w razie potrzeby je tworząc
+ * @param[in] name : nazwa polecenia
+ * @return liczniki polecenia
+ */
+static StatsEntry *StatsFind(const char *name)
+{
+	for(size_t i = 0; i < statsCount; i++)
+	{
+		if(statsEntries[i].name == name || strcmp(statsEntries[i].name, name) == 0)
+		{
+			return &(statsEntries[i]);
+		}
+	}
+	if(statsCount == statsCapacity)
+	{
+		statsCapacity = statsCapacity == 0 ? 16 : 2 * statsCapacity;
+		statsEntries = realloc(statsEntries, statsCapacity * sizeof(StatsEntry));
+		assert(statsEntries != NULL);
+	}
+	StatsEntry *entry = &(statsEntries[statsCount++]);
+	*entry = (StatsEntry) {.name = name, .calls = 0, .totalNs = 0, .maxNs = 0,
+		.allocBytes = 0, .inputTerms = 0, .outputTerms = 0};
+	memset(&(entry->perf), 0, sizeof(PerfCounts));
+	return entry;
+}
+
+void StatsBegin(StatsSample *sample, const PolyStack *pStack, long requiredStackSize)
+{
+	size_t args = PolyStackHasEnoughElements(pStack, requiredStackSize) ?
+		(size_t)requiredStackSize : 0;
+	sample->base = pStack->size - args;
+	sample->inputTerms = StatsStackTerms(pStack, sample->base);
+	sample->monoAllocs = MonoAllocCount();
+	if(statsPerf)
+	{
+		PerfCountersRead(&(sample->perf));
+	}
+	clock_gettime(CLOCK_MONOTONIC, &(sample->start));
+}
+
+void StatsEnd(const StatsSample *sample, const char *name, const PolyStack *pStack)
+{
+	uint64_t elapsed = StatsElapsedNs(&(sample->start));
+	PerfCounts perf;
+	if(statsPerf)
+	{
+		PerfCountersRead(&perf);
+	}
+	uint64_t allocs = MonoAllocCount() - sample->monoAllocs;
+	uint64_t outputTerms = StatsStackTerms(pStack, sample->base < pStack->size ? sample->base : pStack->size);
+	pthread_mutex_lock(&statsLock);
+	StatsEntry *entry = StatsFind(name);
+	if(statsPerf)
+	{
+		for(int i = 0; i < PERF_COUNTER_AMOUNT; i++)
+		{
+			entry->perf.value[i] += perf.value[i] - sample->perf.value[i];
+		}
+	}
+	entry->calls++;
+	entry->totalNs += elapsed;
+	if(elapsed > entry->maxNs)
+	{
+		entry->maxNs = elapsed;
+	}
+	entry->allocBytes += allocs * sizeof(Mono);
+	entry->inputTerms += sample->inputTerms;
+	entry->outputTerms += outputTerms;
+	pthread_mutex_unlock(&statsLock);
+}
+
+/**
+ * Porównuje liczniki dwóch poleceń według malejącego łącznego czasu wykonania
+ * @param[in] a : liczniki
+ * @param[in] b : liczniki
+ * @return wynik porównania (jak w qsort())
+ */
+static int StatsCompareByTime(const void *a, const void *b)
+{
+	const StatsEntry *x = a, *y = b;
+	if(x->totalNs != y->totalNs)
+	{
+		return x->totalNs > y->totalNs ? -1 : 1;
+	}
+	return strcmp(x->name, y->name);
+}
+
+/**
+ * Dopisuje do tablicy @p buf kolumny ze sprzętowymi licznikami polecenia:
+ * cykle, instrukcje, liczbę instrukcji na cykl oraz chybienia pamięci podręcznej
+ * i błędne przewidywania skoków na jednomian wyniku
+ * @param[in] buf : tablica bajtów
+ * @param[in] e : liczniki polecenia
+ * @param[in] json : czy dopisać pola obiektu JSON (zamiast kolumn tabeli)
+ */
+static void StatsAppendPerf(ByteBuffer *buf, const StatsEntry *e, bool json)
+{
+	const uint64_t *v = e->perf.value;
+	double ipc = v[PERF_CYCLES] > 0 ? (double)v[PERF_INSTRUCTIONS] / (double)v[PERF_CYCLES] : 0.0;
+	char cachePerTerm[32], branchPerTerm[32];
+	if(e->outputTerms > 0)
+	{
+		snprintf(cachePerTerm, sizeof(cachePerTerm), "%.3f",
+			(double)v[PERF_CACHE_MISSES] / (double)e->outputTerms);
+		snprintf(branchPerTerm, sizeof(branchPerTerm), "%.3f",
+			(double)v[PERF_BRANCH_MISSES] / (double)e->outputTerms);
+	}
+	else
+	{
+		snprintf(cachePerTerm, sizeof(cachePerTerm), json ? "null" : "-");
+		snprintf(branchPerTerm, sizeof(branchPerTerm), json ? "null" : "-");
+	}
+	char line[STATS_LINE_SIZE];
+	int length;
+	if(json)
+	{
+		length = snprintf(line, STATS_LINE_SIZE, ",\"cycles\":%llu,\"instructions\":%llu,\"ipc\":%.3f,"
+			"\"cache_misses\":%llu,\"branch_misses\":%llu,\"cache_misses_per_term\":%s,"
+			"\"branch_misses_per_term\":%s", (unsigned long long)v[PERF_CYCLES],
+			(unsigned long long)v[PERF_INSTRUCTIONS], ipc, (unsigned long long)v[PERF_CACHE_MISSES],
+			(unsigned long long)v[PERF_BRANCH_MISSES], cachePerTerm, branchPerTerm);
+	}
+	else
+	{
+		length = snprintf(line, STATS_LINE_SIZE, " %14llu %14llu %6.3f %12llu %12llu %14s %14s",
+			(unsigned long long)v[PERF_CYCLES], (unsigned long long)v[PERF_INSTRUCTIONS], ipc,
+			(unsigned long long)v[PERF_CACHE_MISSES], (unsigned long long)v[PERF_BRANCH_MISSES],
+			cachePerTerm, branchPerTerm);
+	}
+	ByteBufferAppend(buf, line, (size_t)length);
+}
+
+void StatsReport(ByteBuffer *buf)
+{
+	/* inne wątki mogą w tym czasie dopisywać liczniki, więc raport powstaje z ich kopii */
+	pthread_mutex_lock(&statsLock);
+	size_t count = statsCount;
+	StatsEntry *sorted = malloc((count + 1) * sizeof(StatsEntry));
+	assert(sorted != NULL);
+	if(count > 0)
+	{
+		memcpy(sorted, statsEntries, count * sizeof(StatsEntry));
+	}
+	pthread_mutex_unlock(&statsLock);
+	qsort(sorted, count, sizeof(StatsEntry), StatsCompareByTime);
+
+	bool json = (statsFormat == STATS_JSON);
+	char line[STATS_LINE_SIZE];
+	int length;
+	if(json)
+	{
+		ByteBufferAppend(buf, "[", 1);
+	}
+	else
+	{
+		length = snprintf(line, STATS_LINE_SIZE, "%-12s %10s %14s %12s %14s %12s %12s", "command",
+			"calls", "total_ns", "max_ns", "alloc_bytes", "terms_in", "terms_out");
+		ByteBufferAppend(buf, line, (size_t)length);
+		if(statsPerf)
+		{
+			length = snprintf(line, STATS_LINE_SIZE, " %14s %14s %6s %12s %12s %14s %14s", "cycles",
+				"instructions", "ipc", "cache_miss", "branch_miss", "cache_per_term", "branch_per_term");
+			ByteBufferAppend(buf, line, (size_t)length);
+		}
+		ByteBufferAppend(buf, "\n", 1);
+	}
+	for(size_t i = 0; i < count; i++)
+	{
+		const StatsEntry *e = &(sorted[i]);
+		if(json)
+		{
+			length = snprintf(line, STATS_LINE_SIZE, "%s{\"command\":\"%s\",\"calls\":%llu,"
+				"\"total_ns\":%llu,\"max_ns\":%llu,\"alloc_bytes\":%llu,\"terms_in\":%llu,"
+				"\"terms_out\":%llu", i == 0 ? "" : ",", e->name, (unsigned long long)e->calls,
+				(unsigned long long)e->totalNs, (unsigned long long)e->maxNs,
+				(unsigned long long)e->allocBytes, (unsigned long long)e->inputTerms,
+				(unsigned long long)e->outputTerms);
+		}
+		else
+		{
+			length = snprintf(line, STATS_LINE_SIZE, "%-12s %10llu %14llu %12llu %14llu %12llu %12llu",
+				e->name, (unsigned long long)e->calls, (unsigned long long)e->totalNs,
+				(unsigned long long)e->maxNs, (unsigned long long)e->allocBytes,
+				(unsigned long long)e->inputTerms, (unsigned long long)e->outputTerms);
+		}
+		ByteBufferAppend(buf, line, (size_t)length);
+		if(statsPerf)
+		{
+			StatsAppendPerf(buf, e, json);
+		}
+		ByteBufferAppend(buf, json ? "}" : "\n", 1);
+	}
+	if(json)
+	{
+		ByteBufferAppend(buf, "]\n", 2);
+	}
+	free(sorted);
+}
+
+void StatsFinish()
+{
+	if(StatsIsEnabled())
+	{
+		ByteBuffer buf = EmptyByteBuffer();
+		StatsReport(&buf);
+		fprintf(stderr, "%.*s", (int)buf.size, (const char*)buf.data);
+		ByteBufferDestroy(&buf);
+	}
+	pthread_mutex_lock(&statsLock);
+	free(statsEntries);
+	statsEntries = NULL;
+	statsCount = statsCapacity = 0;
+	pthread_mutex_unlock(&statsLock);
+}
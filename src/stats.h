@@ -0,0 +1,100 @@
+/** @file
+   Interfejs liczników wydajności poleceń kalkulatora wielomianów
+
+   Po włączeniu liczników (zob. StatsEnable()) każde wykonane polecenie
+   jest mierzone: dla każdej nazwy polecenia zliczane są wywołania, łączny
+   i najdłuższy czas wykonania, rozmiar zaalokowanych jednomianów oraz
+   liczba jednomianów (łącznie z jednomianami współczynników) w argumentach
+   zdjętych ze stosu i w elementach, które polecenie na nim zostawiło.
+   Nieobliczone wyrażenia trybu leniwego (zob. lazy.h) liczą się jako
+   wielomiany bez jednomianów. Wyłączone liczniki kosztują jedno
+   sprawdzenie warunku na polecenie. Opcjonalnie (zob. StatsEnablePerfCounters())
+   doliczane są też sprzętowe liczniki wydajności (zob. perfcount.h),
+   a raport zawiera liczbę instrukcji na cykl oraz chybienia pamięci
+   podręcznej i błędne przewidywania skoków na jednomian wyniku.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-23
+*/
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "polystack.h"
+#include "serialize.h"
+#include "perfcount.h"
+
+/**
+ * Formaty raportu liczników
+ */
+typedef enum StatsFormat
+{
+	STATS_DISABLED, ///< liczniki wyłączone
+	STATS_TABLE, ///< tabela
+	STATS_JSON ///< tablica obiektów JSON
+} StatsFormat;
+
+/**
+ * Pomiar wykonania jednego polecenia (zob. StatsBegin() i StatsEnd())
+ */
+typedef struct StatsSample
+{
+	struct timespec start; ///< chwila rozpoczęcia polecenia
+	uint64_t monoAllocs; ///< liczba zaalokowanych jednomianów przed poleceniem
+	uint64_t inputTerms; ///< liczba jednomianów w argumentach polecenia
+	size_t base; ///< rozmiar stosu bez argumentów polecenia
+	PerfCounts perf; ///< sprzętowe liczniki wydajności przed poleceniem
+} StatsSample;
+
+/**
+ * Włącza (lub wyłącza) liczniki i ustala format raportu
+ * @param[in] format : format raportu (STATS_DISABLED wyłącza liczniki)
+ */
+void StatsEnable(StatsFormat format);
+
+/**
+ * Włącza (lub wyłącza) doliczanie sprzętowych liczników wydajności;
+ * liczniki muszą być otwarte (zob. PerfCountersOpen())
+ * @param[in] enabled : czy doliczać sprzętowe liczniki
+ */
+void StatsEnablePerfCounters(bool enabled);
+
+/**
+ * Sprawdza, czy liczniki są włączone
+ * @return Czy liczniki są włączone
+ */
+bool StatsIsEnabled();
+
+/**
+ * Rozpoczyna pomiar polecenia
+ * @param[out] sample : pomiar
+ * @param[in] pStack : stos wielomianów
+ * @param[in] requiredStackSize : liczba argumentów polecenia na stosie
+ */
+void StatsBegin(StatsSample *sample, const PolyStack *pStack, long requiredStackSize);
+
+/**
+ * Kończy pomiar polecenia i dolicza go do liczników polecenia @p name
+ * @param[in] sample : pomiar rozpoczęty przez StatsBegin()
+ * @param[in] name : nazwa polecenia (napis o statycznym czasie życia)
+ * @param[in] pStack : stos wielomianów
+ */
+void StatsEnd(const StatsSample *sample, const char *name, const PolyStack *pStack);
+
+/**
+ * Dopisuje do tablicy @p buf raport liczników (polecenia w kolejności
+ * malejącego łącznego czasu wykonania)
+ * @param[in] buf : tablica bajtów
+ */
+void StatsReport(ByteBuffer *buf);
+
+/**
+ * Wypisuje raport liczników na standardowy strumień błędów, jeśli są włączone,
+ * a następnie usuwa je z pamięci
+ */
+void StatsFinish();
+
+#endif /* __STATS_H__ */
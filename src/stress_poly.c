@@ -0,0 +1,391 @@
+/** @file
+   Losowe testy obciążeniowe poleceń kalkulatora wielomianów
+
+   Program generuje losowe skrypty kalkulatora (wielomiany z bench_gen.h
+   i polecenia dobierane do stanu stosu: arytmetyka, COMPOSE, AT, porównania,
+   SAVE_MAPPED i LOAD_MAPPED) i wykonuje je w jednym procesie, na przemian
+   w zwykłym i leniwym trybie (zob. lazy.h), z małą pamięcią podręczną
+   wyników (zob. memo.h). Przeznaczony jest do uruchamiania w kompilacji
+   z opcją POLY_ORACLE (zob. oracle.h), w której każde wywołanie szybkiej
+   wersji operacji jest sprawdzane z implementacją wzorcową, a także
+   z AddressSanitizerem. Wyjście kalkulatora trafia do /dev/null,
+   a na standardowe wyjście program wypisuje podsumowanie.
+
+   Użycie: `stress_poly [--seed N] [--iterations N] [--lines N] [--dir KATALOG]`
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-26
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "poly.h"
+#include "polystack.h"
+#include "operation.h"
+#include "read.h"
+#include "checkpoint.h"
+#include "output.h"
+#include "memo.h"
+#include "serialize.h"
+#include "bench_gen.h"
+
+#include "utils.h"
+
+/** Domyślne ziarno generatora */
+#define STRESS_DEFAULT_SEED 2017
+/** Domyślna liczba skryptów */
+#define STRESS_DEFAULT_ITERATIONS 200
+/** Domyślna liczba wierszy skryptu */
+#define STRESS_DEFAULT_LINES 400
+/** Maksymalny rozmiar stosu w skrypcie */
+#define STRESS_MAX_STACK 12
+/** Maksymalna szacowana liczba jednomianów wielomianu na stosie */
+#define STRESS_MAX_TERMS 4000
+/** Budżet pamięci podręcznej wyników (mały, żeby wyniki były też usuwane) */
+#define STRESS_MEMO_BUDGET (64 << 10)
+/** Maksymalna długość ścieżki pliku z wielomianem odwzorowywanym w pamięci */
+#define STRESS_PATH_SIZE 4096
+
+/**
+ * Model stosu generowanego skryptu: szacowane liczby jednomianów elementów
+ */
+typedef struct StressModel
+{
+	unsigned size; ///< rozmiar stosu
+	uint64_t terms[STRESS_MAX_STACK]; ///< szacowana liczba jednomianów (od dna stosu)
+	/**
+	 * liczba plików z wielomianami odwzorowanymi w pamięci (każdy zapis
+	 * trafia do nowego pliku, bo nadpisanie odwzorowanego pliku jest niedozwolone)
+	 */
+	unsigned mappedFiles;
+} StressModel;
+
+/**
+ * Zwraca liczbę pseudolosową z przedziału [0, n)
+ * @param[in] seed : stan generatora
+ * @param[in] n : liczba możliwych wartości
+ * @return liczba pseudolosowa
+ */
+static unsigned StressRandom(uint64_t *seed, unsigned n)
+{
+	return (unsigned)(BenchRandom(seed) % n);
+}
+
+/**
+ * Dopisuje do skryptu wiersz
+ * @param[in] script : skrypt
+ * @param[in] line : wiersz (bez znaku końca wiersza)
+ */
+static void StressAppendLine(ByteBuffer *script, const char *line)
+{
+	ByteBufferAppend(script, line, strlen(line));
+	ByteBufferAppend(script, "\n", 1);
+}
+
+/**
+ * Zwraca szacowaną liczbę jednomianów @p i-tego elementu od wierzchołka stosu
+ * @param[in] model : model stosu
+ * @param[in] i : pozycja od wierzchołka
+ * @return szacowana liczba jednomianów
+ */
+static uint64_t StressTerms(const StressModel *model, unsigned i)
+{
+	return model->terms[model->size - 1 - i];
+}
+
+/**
+ * Dopisuje do skryptu losowy wielomian i wstawia go do modelu stosu
+ * @param[in] script : skrypt
+ * @param[in] model : model stosu
+ * @param[in] seed : stan generatora
+ */
+static void StressPushPoly(ByteBuffer *script, StressModel *model, uint64_t *seed)
+{
+	static const poly_coeff_t ranges[] = {3, 1000, LONG_MAX};
+	BenchShape shape = {.depth = StressRandom(seed, 4), .terms = 1 + StressRandom(seed, 5),
+		.maxExp = (poly_exp_t)StressRandom(seed, 7), .coeffRange = ranges[StressRandom(seed, 3)],
+		.dense = StressRandom(seed, 2) == 0};
+	Poly p = BenchRandomPoly(&shape, seed);
+	PolyToText(&p, script);
+	ByteBufferAppend(script, "\n", 1);
+	model->terms[model->size++] = PolyMonoCountDeep(&p) + 1;
+	PolyDestroy(&p);
+}
+
+/**
+ * Dopisuje do skryptu losowe polecenie wykonalne na modelowanym stosie
+ * i uaktualnia model
+ * @param[in] script : skrypt
+ * @param[in] model : model stosu
+ * @param[in] seed : stan generatora
+ * @param[in] mappedPrefix : początek ścieżek plików z wielomianami odwzorowanymi w pamięci
+ */
+static void StressAppendCommand(ByteBuffer *script, StressModel *model, uint64_t *seed,
+	const char *mappedPrefix)
+{
+	char line[STRESS_PATH_SIZE + 32];
+	unsigned size = model->size;
+	bool full = (size == STRESS_MAX_STACK);
+	switch(StressRandom(seed, 16))
+	{
+		case 0:
+		case 1:
+		case 2:
+			if(!full)
+			{
+				StressPushPoly(script, model, seed);
+				return;
+			}
+			break;
+		case 3:
+			if(size >= 1 && !full)
+			{
+				StressAppendLine(script, CLONE);
+				model->terms[model->size] = StressTerms(model, 0);
+				model->size++;
+				return;
+			}
+			break;
+		case 4:
+		case 5:
+			if(size >= 2)
+			{
+				StressAppendLine(script, StressRandom(seed, 2) == 0 ? ADD : SUB);
+				model->terms[size - 2] += model->terms[size - 1];
+				model->size--;
+				return;
+			}
+			break;
+		case 6:
+		case 7:
+			if(size >= 2 && StressTerms(model, 0) * StressTerms(model, 1) <= STRESS_MAX_TERMS)
+			{
+				StressAppendLine(script, MUL);
+				model->terms[size - 2] *= model->terms[size - 1];
+				model->size--;
+				return;
+			}
+			break;
+		case 8:
+			if(size >= 1)
+			{
+				unsigned count = StressRandom(seed, size < 4 ? size : 4);
+				/* podstawienia mogą zwielokrotnić liczbę jednomianów */
+				uint64_t terms = StressTerms(model, 0);
+				for(unsigned i = 1; i <= count; i++)
+				{
+					terms *= StressTerms(model, i);
+				}
+				if(terms <= STRESS_MAX_TERMS / 8)
+				{
+					snprintf(line, sizeof(line), "%s %u", COMPOSE, count);
+					StressAppendLine(script, line);
+					model->size -= count;
+					model->terms[model->size - 1] = terms * 8;
+					return;
+				}
+			}
+			break;
+		case 9:
+			if(size >= 1)
+			{
+				snprintf(line, sizeof(line), "%s %d", AT, (int)StressRandom(seed, 7) - 3);
+				StressAppendLine(script, line);
+				return;
+			}
+			break;
+		case 10:
+			if(size >= 1)
+			{
+				static const char *unary[] = {NEG, IS_ZERO, IS_COEFF, DEG, PRINT};
+				StressAppendLine(script, unary[StressRandom(seed, 5)]);
+				return;
+			}
+			break;
+		case 11:
+			if(size >= 1)
+			{
+				snprintf(line, sizeof(line), "%s %u", DEG_BY, StressRandom(seed, 4));
+				StressAppendLine(script, line);
+				return;
+			}
+			break;
+		case 12:
+			if(size >= 2)
+			{
+				StressAppendLine(script, IS_EQ);
+				return;
+			}
+			break;
+		case 13:
+			if(size >= 1 && !full)
+			{
+				/* kopia odwzorowana w pamięci – kolejne polecenia użyją operacji z mapped.h */
+				snprintf(line, sizeof(line), "%s %s%u.map", SAVE_MAPPED, mappedPrefix, model->mappedFiles);
+				StressAppendLine(script, line);
+				snprintf(line, sizeof(line), "%s %s%u.map", LOAD_MAPPED, mappedPrefix, model->mappedFiles);
+				model->mappedFiles++;
+				StressAppendLine(script, line);
+				model->terms[model->size] = StressTerms(model, 0);
+				model->size++;
+				return;
+			}
+			break;
+		case 14:
+			if(size == 0 && !full)
+			{
+				StressAppendLine(script, ZERO);
+				model->terms[model->size++] = 1;
+				return;
+			}
+			break;
+		default:
+			break;
+	}
+	if(size >= 1)
+	{
+		StressAppendLine(script, POP);
+		model->size--;
+	}
+}
+
+/**
+ * Wykonuje skrypt na nowym stosie
+ * @param[in] script : skrypt
+ * @param[in] lazy : czy wykonać go w leniwym trybie
+ * @return Czy udało się utworzyć plik tymczasowy ze skryptem
+ */
+static bool StressRun(const ByteBuffer *script, bool lazy)
+{
+	FILE *input = tmpfile();
+	if(input == NULL || fwrite(script->data, 1, script->size, input) != script->size)
+	{
+		if(input != NULL)
+		{
+			fclose(input);
+		}
+		return false;
+	}
+	rewind(input);
+
+	Operation operation[OPER_WITHOUT_ARG_AMOUNT];
+	OperationWithArg opWithArg[OPER_WITH_ARG_AMOUNT];
+	OperationWithStringArg opWithStrArg[OPER_WITH_STRING_ARG_AMOUNT];
+	InitStandardOperations(operation, opWithArg, opWithStrArg);
+	if(lazy)
+	{
+		InitLazyOperations(operation);
+	}
+	PolyStack stack = EmptyPolyStack();
+	CheckpointSetOperations(&stack, operation, opWithArg, opWithStrArg);
+	ReadSetInput(input);
+	for(int lineNumber = 1; ReadLine(&stack, lineNumber, operation, opWithArg, opWithStrArg); lineNumber++)
+	{
+	}
+	ReadSetInput(NULL);
+	DestroyStack(&stack);
+	OutputFlush();
+	fclose(input);
+	return true;
+}
+
+/**
+ * Wypisuje sposób użycia programu
+ * @param[in] programName : nazwa programu
+ */
+static void StressPrintUsage(const char *programName)
+{
+	fprintf(stderr, "Użycie: %s [--seed N] [--iterations N] [--lines N] [--dir KATALOG]\n",
+		programName);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long long seed = STRESS_DEFAULT_SEED;
+	unsigned long iterations = STRESS_DEFAULT_ITERATIONS, lines = STRESS_DEFAULT_LINES;
+	const char *dir = ".";
+	for(int i = 1; i < argc; i++)
+	{
+		char *end = NULL;
+		if(i + 1 < argc && strcmp(argv[i], "--seed") == 0)
+		{
+			seed = strtoull(argv[++i], &end, 10);
+		}
+		else if(i + 1 < argc && strcmp(argv[i], "--iterations") == 0)
+		{
+			iterations = strtoul(argv[++i], &end, 10);
+		}
+		else if(i + 1 < argc && strcmp(argv[i], "--lines") == 0)
+		{
+			lines = strtoul(argv[++i], &end, 10);
+		}
+		else if(i + 1 < argc && strcmp(argv[i], "--dir") == 0)
+		{
+			dir = argv[++i];
+			continue;
+		}
+		if(end == NULL || *end != '\0')
+		{
+			StressPrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	char mappedPrefix[STRESS_PATH_SIZE];
+	snprintf(mappedPrefix, STRESS_PATH_SIZE, "%s/stress_poly_%d_", dir, (int)getpid());
+	/* wyjście kalkulatora trafia do /dev/null, a podsumowanie na zachowane standardowe wyjście */
+	int resultFd = dup(STDOUT_FILENO);
+	int nullFd = open("/dev/null", O_WRONLY);
+	FILE *result = resultFd >= 0 ? fdopen(resultFd, "w") : NULL;
+	if(result == NULL || nullFd < 0 || dup2(nullFd, STDOUT_FILENO) < 0)
+	{
+		fprintf(stderr, "Nie udało się przekierować standardowego wyjścia\n");
+		return 1;
+	}
+	close(nullFd);
+	MemoSetBudget(STRESS_MEMO_BUDGET);
+
+	uint64_t state = seed;
+	unsigned long long totalLines = 0;
+	for(unsigned long iteration = 0; iteration < iterations; iteration++)
+	{
+		ByteBuffer script = EmptyByteBuffer();
+		StressModel model = {.size = 0, .mappedFiles = 0};
+		for(unsigned long line = 0; line < lines; line++)
+		{
+			StressAppendCommand(&script, &model, &state, mappedPrefix);
+		}
+		totalLines += lines;
+		bool ok = StressRun(&script, iteration % 2 == 1);
+		ByteBufferDestroy(&script);
+		for(unsigned i = 0; i < model.mappedFiles; i++)
+		{
+			char path[STRESS_PATH_SIZE + 16];
+			snprintf(path, sizeof(path), "%s%u.map", mappedPrefix, i);
+			remove(path);
+		}
+		if(!ok)
+		{
+			fprintf(stderr, "Nie udało się utworzyć pliku tymczasowego\n");
+			return 1;
+		}
+	}
+	MemoClear();
+
+#ifdef POLY_ORACLE
+	const char *oracle = "true";
+#else
+	const char *oracle = "false";
+#endif /* POLY_ORACLE */
+	fprintf(result, "{\"benchmark\":\"stress_poly\",\"seed\":%llu,\"iterations\":%lu,"
+		"\"lines\":%llu,\"oracle\":%s}\n", seed, iterations, totalLines, oracle);
+	fclose(result);
+	return 0;
+}
@@ -0,0 +1,158 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "trace.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+/** Maksymalna długość jednego zdarzenia */
+#define TRACE_EVENT_SIZE 256
+
+/** Czy śledzenie jest włączone */
+static bool traceEnabled = false;
+/** Plik ze zdarzeniami w formacie Chrome trace (lub NULL) */
+static FILE *traceChrome = NULL;
+/** Deskryptor pliku `trace_marker` jądra (lub -1) */
+static int traceMarker = -1;
+/** Numer procesu (zapisywany w zdarzeniach) */
+static int tracePid = 0;
+/** Liczba wątków, którym nadano już numery */
+static atomic_int traceThreadCount;
+/** Numer bieżącego wątku w śladzie (0, jeśli jeszcze go nie nadano) */
+static _Thread_local int traceTid = 0;
+/** Głębokość zagnieżdżenia zapisywanych zdarzeń w bieżącym wątku */
+static _Thread_local int traceDepth = 0;
+
+/**
+ * Włącza śledzenie przy pierwszym otwarciu pliku ze zdarzeniami
+ */
+static void TraceEnable()
+{
+	traceEnabled = true;
+	tracePid = (int)getpid();
+}
+
+bool TraceOpenChrome(const char *path)
+{
+	traceChrome = fopen(path, "w");
+	if(traceChrome == NULL)
+	{
+		return false;
+	}
+	fputs("{\"traceEvents\":[\n", traceChrome);
+	TraceEnable();
+	return true;
+}
+
+bool TraceOpenMarkers()
+{
+	const char *paths[] = TRACE_MARKER_PATHS;
+	for(size_t i = 0; i < sizeof(paths) / sizeof(paths[0]) && traceMarker < 0; i++)
+	{
+		traceMarker = open(paths[i], O_WRONLY);
+	}
+	if(traceMarker < 0)
+	{
+		return false;
+	}
+	TraceEnable();
+	return true;
+}
+
+bool TraceActive()
+{
+	return traceEnabled && traceDepth < TRACE_MAX_DEPTH;
+}
+
+/**
+ * Zapisuje zdarzenie
+ * @param[in] phase : 'B' dla początku i 'E' dla końca zdarzenia
+ * @param[in] name : nazwa zdarzenia
+ * @param[in] argName : nazwa argumentu zdarzenia
+ * @param[in] arg : wartość argumentu (TRACE_NO_ARG, jeśli go nie ma)
+ */
+static void TraceEvent(char phase, const char *name, const char *argName, long arg)
+{
+	if(traceTid == 0)
+	{
+		traceTid = atomic_fetch_add(&traceThreadCount, 1) + 1;
+	}
+	char event[TRACE_EVENT_SIZE];
+	int length;
+	if(traceChrome != NULL)
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		double ts = (double)now.tv_sec * 1e6 + (double)now.tv_nsec / 1e3;
+		if(arg == TRACE_NO_ARG)
+		{
+			length = snprintf(event, TRACE_EVENT_SIZE,
+				"{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d},\n",
+				name, phase, ts, tracePid, traceTid);
+		}
+		else
+		{
+			length = snprintf(event, TRACE_EVENT_SIZE,
+				"{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"%s\":%ld}},\n",
+				name, phase, ts, tracePid, traceTid, argName, arg);
+		}
+		/* jeden zapis na zdarzenie – zdarzenia z różnych wątków się nie przeplatają */
+		fwrite(event, 1, (size_t)length, traceChrome);
+	}
+	if(traceMarker >= 0)
+	{
+		if(phase == 'E')
+		{
+			length = snprintf(event, TRACE_EVENT_SIZE, "E|%d\n", tracePid);
+		}
+		else if(arg == TRACE_NO_ARG)
+		{
+			length = snprintf(event, TRACE_EVENT_SIZE, "B|%d|%s\n", tracePid, name);
+		}
+		else
+		{
+			length = snprintf(event, TRACE_EVENT_SIZE, "B|%d|%s %s=%ld\n", tracePid, name, argName, arg);
+		}
+		if(write(traceMarker, event, (size_t)length) < 0)
+		{
+			/* utrata znacznika nie przerywa obliczeń */
+		}
+	}
+}
+
+void TraceBegin(const char *name, const char *argName, long arg)
+{
+	traceDepth++;
+	TraceEvent('B', name, argName, arg);
+}
+
+void TraceEnd(const char *name, const char *argName, long arg)
+{
+	TraceEvent('E', name, argName, arg);
+	traceDepth--;
+}
+
+void TraceClose()
+{
+	if(traceChrome != NULL)
+	{
+		/* zdarzenie z metadanymi zamyka listę (po ostatnim zdarzeniu jest przecinek) */
+		char event[TRACE_EVENT_SIZE];
+		int length = snprintf(event, TRACE_EVENT_SIZE, "{\"name\":\"process_name\",\"ph\":\"M\","
+			"\"pid\":%d,\"args\":{\"name\":\"calc_poly\"}}\n]}\n", tracePid);
+		fwrite(event, 1, (size_t)length, traceChrome);
+		fclose(traceChrome);
+		traceChrome = NULL;
+	}
+	if(traceMarker >= 0)
+	{
+		close(traceMarker);
+		traceMarker = -1;
+	}
+	traceEnabled = false;
+}
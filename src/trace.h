@@ -0,0 +1,74 @@
+/** @file
+   Interfejs śledzenia wykonania kalkulatora wielomianów
+
+   Po włączeniu śledzenia każdy wykonany wiersz wejścia oraz wywołania
+   PolyMul(), PolyAdd(), PolyCompose() i PolyAt() wraz z ich wewnętrznymi
+   etapami (np. sortowaniem i scalaniem jednomianów) zapisywane są jako
+   pary zdarzeń początku i końca. Zdarzenia trafiają do pliku w formacie
+   Chrome trace (JSON, do obejrzenia np. w chrome://tracing lub Perfetto)
+   i/lub do pliku `trace_marker` jądra, gdzie widzi je `perf`
+   (zdarzenie `ftrace:print`) w formacie systrace `B|pid|nazwa` / `E|pid`.
+   Zapisywane są tylko zdarzenia do głębokości TRACE_MAX_DEPTH, tak by
+   rekurencyjne wywołania dla współczynników nie zalewały śladu.
+
+   @author Michał Tepper <mt386430@students.mimuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-06-24
+*/
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdbool.h>
+
+/** Maksymalna głębokość zagnieżdżenia zapisywanych zdarzeń */
+#define TRACE_MAX_DEPTH 3
+/** Ścieżki, pod którymi szukany jest plik `trace_marker` jądra */
+#define TRACE_MARKER_PATHS {"/sys/kernel/tracing/trace_marker", \
+	"/sys/kernel/debug/tracing/trace_marker"}
+/** Oznaczenie braku argumentu zdarzenia */
+#define TRACE_NO_ARG (-1L)
+
+/**
+ * Włącza zapis zdarzeń do pliku @p path w formacie Chrome trace
+ * @param[in] path : ścieżka do pliku
+ * @return Czy udało się utworzyć plik
+ */
+bool TraceOpenChrome(const char *path);
+
+/**
+ * Włącza zapis zdarzeń do pliku `trace_marker` jądra (zob. TRACE_MARKER_PATHS)
+ * @return Czy udało się otworzyć plik
+ */
+bool TraceOpenMarkers();
+
+/**
+ * Sprawdza, czy zdarzenie rozpoczęte w bieżącym miejscu zostałoby zapisane
+ * (śledzenie jest włączone i nie przekroczono TRACE_MAX_DEPTH)
+ * @return Czy zdarzenie zostałoby zapisane
+ */
+bool TraceActive();
+
+/**
+ * Zapisuje początek zdarzenia. Wolno ją wywołać tylko wtedy, gdy
+ * TraceActive() zwraca true; każde wywołanie musi zostać zamknięte
+ * wywołaniem TraceEnd() w tym samym wątku.
+ * @param[in] name : nazwa zdarzenia (napis o statycznym czasie życia)
+ * @param[in] argName : nazwa argumentu zdarzenia
+ * @param[in] arg : wartość argumentu (TRACE_NO_ARG, jeśli go nie ma)
+ */
+void TraceBegin(const char *name, const char *argName, long arg);
+
+/**
+ * Zapisuje koniec zdarzenia rozpoczętego przez TraceBegin()
+ * @param[in] name : nazwa zdarzenia
+ * @param[in] argName : nazwa argumentu zdarzenia
+ * @param[in] arg : wartość argumentu (TRACE_NO_ARG, jeśli go nie ma)
+ */
+void TraceEnd(const char *name, const char *argName, long arg);
+
+/**
+ * Kończy śledzenie i zamyka pliki ze zdarzeniami
+ */
+void TraceClose();
+
+#endif /* __TRACE_H__ */
@@ -25,22 +25,51 @@
 #include <string.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "cmocka.h"
 
 #include "poly.h"
+#include "serialize.h"
+#include "mapped.h"
+#include "read.h"
+#include "polystack.h"
+#include "parallel_parse.h"
+#include "bytecode.h"
+#include "lazy.h"
+#include "memo.h"
+#include "stats.h"
+#include "memstat.h"
+#include "trace.h"
+#include "perfcount.h"
+#include "oracle.h"
+#include "output.h"
+#include "error.h"
+#include "libpoly.h"
 
 static jmp_buf jmp_at_exit;
 static int exit_status;
 
-extern int calc_poly_main();
+extern int calc_poly_main(int argc, char *argv[]);
 
 /**
  * Atrapa funkcji main
  */
 int mock_main() {
+    char *argv[] = {"calc_poly", NULL};
     if (!setjmp(jmp_at_exit))
-        return calc_poly_main();
+        return calc_poly_main(1, argv);
+    return exit_status;
+}
+
+/**
+ * Atrapa funkcji main wywołanej z opcją --chain
+ */
+static int mock_main_chain(char *dir) {
+    char *argv[] = {"calc_poly", "--chain", dir, NULL};
+    if (!setjmp(jmp_at_exit))
+        return calc_poly_main(3, argv);
     return exit_status;
 }
 
@@ -155,19 +184,21 @@ int mock_getchar() {
 }
 /**
  * Atrapa funkcji getc używana do przechwycenia czytania z stdin.
- * Obsługiwane hest tylko standardowe wejście.
+ * Inne strumienie (np. skrypty kontekstów z libpoly.h) są czytane naprawdę.
  */
 int mock_getc(FILE *stream){
-	assert_true(stream == stdin);
+	if (stream != stdin)
+		return getc(stream);
 	return mock_getchar();
 }	
 
 /**
  * Atrapa funkcji ungetc.
- * Obsługiwane jest tylko standardowe wejście.
+ * Inne strumienie niż standardowe wejście są obsługiwane naprawdę.
  */
 int mock_ungetc(int c, FILE *stream) {
-    assert_true(stream == stdin);
+    if (stream != stdin)
+        return ungetc(c, stream);
     if (input_stream_position > 0)
         return input_stream_buffer[--input_stream_position] = c;
     else
@@ -260,6 +291,446 @@ static void test_calc_poly_arg_letters_digits_combination(void **state) {
 	run_main_and_check_outputs("", "ERROR 1 WRONG COUNT\n");
 }
 
+static void test_calc_poly_print_coeff_limits(void **state) {
+    (void)state;
+
+    init_input_stream("-9223372036854775808\nPRINT\n((9223372036854775807,10)+(-7,100),0)\nPRINT\nDEG");
+	run_main_and_check_outputs("-9223372036854775808\n((9223372036854775807,10)+(-7,100),0)\n100\n", "");
+}
+
+static void test_calc_poly_checkpoint_restore(void **state) {
+    init_input_stream("(1,2)\n3\nCHECKPOINT unit_tests_poly_checkpoint.tmp\nADD\nNEG\n");
+    run_main_and_check_outputs("", "");
+
+    test_setup(state);
+    init_input_stream("RESTORE unit_tests_poly_checkpoint.tmp\nPRINT\nPOP\nPRINT\n");
+    run_main_and_check_outputs("(-3,0)+(-1,2)\n", "ERROR 4 STACK UNDERFLOW\n");
+    remove("unit_tests_poly_checkpoint.tmp");
+    remove("unit_tests_poly_checkpoint.tmp.wal");
+}
+
+static void test_calc_poly_checkpoint_file_commands(void **state) {
+    init_input_stream("(1,2)\nSAVE unit_tests_poly_load.tmp\nCHECKPOINT unit_tests_poly_checkpoint.tmp\n"
+        "LOAD unit_tests_poly_load.tmp\nSAVE unit_tests_poly_save.tmp\n");
+    run_main_and_check_outputs("", "");
+    remove("unit_tests_poly_save.tmp");
+
+    /* odtworzenie nie może zależeć od bieżącej zawartości plików */
+    test_setup(state);
+    init_input_stream("5\nSAVE unit_tests_poly_load.tmp\n");
+    run_main_and_check_outputs("", "");
+
+    test_setup(state);
+    init_input_stream("RESTORE unit_tests_poly_checkpoint.tmp\nPRINT\nPOP\nPRINT\nPOP\nPRINT\n");
+    run_main_and_check_outputs("(1,2)\n(1,2)\n", "ERROR 6 STACK UNDERFLOW\n");
+    assert_true(fopen("unit_tests_poly_save.tmp", "r") == NULL);
+    remove("unit_tests_poly_load.tmp");
+    remove("unit_tests_poly_checkpoint.tmp");
+    remove("unit_tests_poly_checkpoint.tmp.wal");
+}
+
+/**
+ * Tworzy plik @p name w katalogu @p dir z zawartością @p content
+ */
+static void write_chain_file(const char *dir, const char *name, const char *content) {
+    char path[64];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *file = fopen(path, "w");
+    assert_true(file != NULL);
+    fputs(content, file);
+    fclose(file);
+}
+
+/**
+ * Usuwa katalog z łańcuchem testowym (także pozostawiony przez nieudany test)
+ */
+static void remove_chain_dir(void) {
+    remove("unit_tests_poly_chain.tmp/a");
+    remove("unit_tests_poly_chain.tmp/b");
+    rmdir("unit_tests_poly_chain.tmp");
+}
+
+static void test_calc_poly_chain_matches_script(void **state) {
+    (void)state;
+
+    /*
+     * oczekiwany wynik skryptu chain_poly.sh: drugi plik dostaje na wejściu
+     * wyjście pierwszego, razem z wierszem raportu MEMO_STATS
+     */
+    remove_chain_dir();
+    assert_int_equal(mkdir("unit_tests_poly_chain.tmp", 0700), 0);
+    write_chain_file("unit_tests_poly_chain.tmp", "a",
+        "START\n(1,2)\nPRINT\nMEMO_STATS\n3\nPRINT\nIS_ZERO\nFILE b\n");
+    write_chain_file("unit_tests_poly_chain.tmp", "b",
+        "ADD\nPRINT\nX\nPOP\nPOP\nPOP\nPRINT\nSTOP\n");
+    mock_main_chain("unit_tests_poly_chain.tmp");
+    assert_string_equal(printf_buffer, "3\n");
+    assert_string_equal(fprintf_buffer, "ERROR 2 WRONG COMMAND\nERROR 7 WRONG COMMAND\n"
+        "ERROR 10 STACK UNDERFLOW\nERROR 11 STACK UNDERFLOW\n");
+    remove_chain_dir();
+}
+
+static void test_calc_poly_store_recall(void **state) {
+    (void)state;
+
+    init_input_stream("(1,1)\nSTORE a\nNEG\nRECALL a\nPRINT\nPOP\nPRINT\n"
+        "RECALL b\nRECALL a\nRECALL a\nADD\nPRINT\n");
+    run_main_and_check_outputs("(1,1)\n(-1,1)\n(2,1)\n", "ERROR 8 WRONG REGISTER\n");
+}
+
+static void test_bytecode_serialize_round_trip(void **state) {
+    (void)state;
+
+    Operation operation[OPER_WITHOUT_ARG_AMOUNT];
+    OperationWithArg opWithArg[OPER_WITH_ARG_AMOUNT];
+    OperationWithStringArg opWithStrArg[OPER_WITH_STRING_ARG_AMOUNT];
+    InitStandardOperations(operation, opWithArg, opWithStrArg);
+    uint64_t operationsHash = BytecodeOperationsHash(operation, opWithArg, opWithStrArg);
+
+    init_input_stream("(1,2)+(2,0)\nCLONE\nAT -3\nSTORE a\nFOO\n(1,\nDEG_BY\n");
+    BytecodeProgram program = BytecodeCompile(stdin, operation, opWithArg, opWithStrArg);
+    assert_int_equal(program.size, 7);
+    assert_int_equal(program.constCount, 1);
+
+    const unsigned char source[] = "script";
+    ByteBuffer buf = EmptyByteBuffer();
+    assert_true(BytecodeSerialize(&program, operationsHash, source, sizeof(source), &buf));
+
+    BytecodeProgram loaded;
+    assert_false(BytecodeDeserialize(buf.data, buf.size, operationsHash, source, sizeof(source) - 1, &loaded));
+    assert_true(BytecodeDeserialize(buf.data, buf.size, operationsHash, source, sizeof(source), &loaded));
+    assert_int_equal(loaded.size, program.size);
+    assert_true(PolyIsEq(&(loaded.constants[0]), &(program.constants[0])));
+    for (size_t i = 0; i < program.size; i++) {
+        assert_int_equal(loaded.code[i].opcode, program.code[i].opcode);
+        assert_int_equal(loaded.code[i].lineNumber, program.code[i].lineNumber);
+        assert_int_equal(loaded.code[i].index, program.code[i].index);
+        assert_int_equal(loaded.code[i].arg, program.code[i].arg);
+    }
+    assert_string_equal(loaded.code[3].strArg, "a");
+    assert_string_equal(loaded.code[6].errorType, WRONG_VARIABLE);
+
+    buf.data[buf.size / 2] ^= 1;
+    BytecodeProgram corrupted;
+    assert_false(BytecodeDeserialize(buf.data, buf.size, operationsHash, source, sizeof(source), &corrupted));
+
+    ByteBufferDestroy(&buf);
+    BytecodeDestroy(&loaded);
+    BytecodeDestroy(&program);
+}
+
+/**
+ * Tworzy wielomian `(c1 * x_1^e1) * x_0^e0 + c2 * x_0^e2`
+ */
+static Poly make_nested_poly(poly_coeff_t c1, poly_exp_t e1, poly_exp_t e0, poly_coeff_t c2, poly_exp_t e2) {
+    Poly inner0 = PolyFromCoeff(c1);
+    Mono innerMono[1];
+    innerMono[0] = MonoFromPoly(&inner0, e1);
+    Poly inner = PolyAddMonos(1, innerMono);
+
+    Poly outer2 = PolyFromCoeff(c2);
+    Mono m[2];
+    m[0] = MonoFromPoly(&inner, e0);
+    m[1] = MonoFromPoly(&outer2, e2);
+    return PolyAddMonos(2, m);
+}
+
+/**
+ * Tworzy wielomian `x_0^e + 2` (zob. make_nested_poly())
+ */
+static Poly make_poly_plus_two(poly_exp_t e) {
+    return make_nested_poly(1, 0, e, 2, 0);
+}
+
+/**
+ * Przywraca wspólne dla procesu liczniki (statystyki poleceń, pamięć
+ * podręczną wyników i raport pamięci) do stanu początkowego, niezależnie
+ * od tego, co zostawiły wcześniejsze testy
+ */
+static int reset_counters_setup(void **state) {
+    (void)state;
+
+    StatsEnablePerfCounters(false);
+    StatsEnable(STATS_DISABLED);
+    StatsFinish();
+    MemoClear();
+    MemoSetBudget(0);
+    MemStatSetInterval(0);
+    MemStatFlush();
+    return 0;
+}
+
+static void test_lazy_mul_add_matches_eager(void **state) {
+    (void)state;
+
+    Poly p = make_poly_plus_two(1);
+    Poly q = PolyClone(&p);
+    PolySetInverseCoeffs(&q);
+    Poly r = PolyMul(&p, &p);
+
+    Poly mul = PolyMul(&p, &q);
+    Poly expected = PolyAdd(&mul, &r);
+    Poly fused = PolyMulAdd(&p, &q, &r);
+    assert_true(PolyIsEq(&expected, &fused));
+
+    /* (p * q + r) - r, gdzie p jest współdzielone przez dwa węzły */
+    Poly pCopy = PolyClone(&p), qCopy = PolyClone(&q), rCopy = PolyClone(&r), rCopy2 = PolyClone(&r);
+    LazyExpr *lp = LazyFromPoly(&pCopy);
+    LazyExpr *sum = LazyAdd(LazyMul(LazyRetain(lp), LazyFromPoly(&qCopy)), LazyFromPoly(&rCopy));
+    LazyExpr *diff = LazyAdd(LazyRetain(sum), LazyNeg(LazyFromPoly(&rCopy2)));
+    Poly lazySum = LazyForce(sum);
+    Poly lazyDiff = LazyForce(diff);
+    Poly lazyP = LazyForce(lp);
+    assert_true(PolyIsEq(&expected, &lazySum));
+    assert_true(PolyIsEq(&mul, &lazyDiff));
+    assert_true(PolyIsEq(&p, &lazyP));
+
+    PolyDestroy(&lazyP);
+    PolyDestroy(&lazyDiff);
+    PolyDestroy(&lazySum);
+    PolyDestroy(&fused);
+    PolyDestroy(&expected);
+    PolyDestroy(&mul);
+    PolyDestroy(&r);
+    PolyDestroy(&q);
+    PolyDestroy(&p);
+}
+
+static void test_memo_mul_compose_hits(void **state) {
+    (void)state;
+
+    Poly p = make_poly_plus_two(2);
+    Poly q = PolyClone(&p);
+    PolySetInverseCoeffs(&q);
+    Poly expected = PolyMul(&p, &q);
+    Poly expectedComposed = PolyCompose(&p, 1, &q);
+
+    MemoSetBudget(1 << 20);
+    Poly miss = MemoMul(&p, &q);
+    /* mnożenie jest przemienne – zamiana argumentów też jest trafieniem */
+    Poly hit = MemoMul(&q, &p);
+    Poly composedMiss = MemoCompose(&p, 1, &q);
+    Poly composedHit = MemoCompose(&p, 1, &q);
+    /* inny argument złożenia to inny wpis */
+    Poly composedOther = MemoCompose(&q, 1, &p);
+    MemoStats stats = MemoGetStats();
+    assert_int_equal(stats.hits, 2);
+    assert_int_equal(stats.misses, 3);
+    assert_int_equal(stats.entries, 3);
+    assert_true(PolyIsEq(&expected, &miss));
+    assert_true(PolyIsEq(&expected, &hit));
+    assert_true(PolyIsEq(&expectedComposed, &composedMiss));
+    assert_true(PolyIsEq(&expectedComposed, &composedHit));
+
+    /* budżet mniejszy niż jeden wpis – wszystko zostaje usunięte */
+    MemoSetBudget(1);
+    stats = MemoGetStats();
+    assert_int_equal(stats.entries, 0);
+    assert_int_equal(stats.bytes, 0);
+    assert_int_equal(stats.evictions, 3);
+    MemoClear();
+    MemoSetBudget(0);
+
+    PolyDestroy(&composedOther);
+    PolyDestroy(&composedHit);
+    PolyDestroy(&composedMiss);
+    PolyDestroy(&hit);
+    PolyDestroy(&miss);
+    PolyDestroy(&expectedComposed);
+    PolyDestroy(&expected);
+    PolyDestroy(&q);
+    PolyDestroy(&p);
+}
+
+static void test_stats_report_counts_terms(void **state) {
+    (void)state;
+
+    PolyStack stack = EmptyPolyStack();
+    Poly p = make_poly_plus_two(1);
+    Poly q = PolyClone(&p);
+    PolyStackPush(&stack, &p);
+    PolyStackPush(&stack, &q);
+
+    StatsEnable(STATS_JSON);
+    /* dwa argumenty po 2 jednomiany zastąpione jednym wynikiem z 3 jednomianami */
+    StatsSample sample;
+    StatsBegin(&sample, &stack, 2);
+    Poly top = PolyStackTake(&stack);
+    Poly top2 = PolyStackTake(&stack);
+    Poly mul = PolyMul(&top, &top2);
+    PolyStackPush(&stack, &mul);
+    StatsEnd(&sample, MUL, &stack);
+
+    ByteBuffer report = EmptyByteBuffer();
+    StatsReport(&report);
+    ByteBufferAppend(&report, "", 1);
+    assert_true(strstr((const char*)report.data, "\"command\":\"MUL\",\"calls\":1,") != NULL);
+    assert_true(strstr((const char*)report.data, "\"terms_in\":4,\"terms_out\":3}") != NULL);
+    assert_true(strstr((const char*)report.data, "\"alloc_bytes\":0,") == NULL);
+
+    ByteBufferDestroy(&report);
+    StatsEnable(STATS_DISABLED);
+    StatsFinish();
+    PolyDestroy(&top2);
+    PolyDestroy(&top);
+    DestroyStack(&stack);
+}
+
+static void test_memstat_live_monos_and_histogram(void **state) {
+    (void)state;
+
+    MemStats before = MemStatGet();
+    PolyStack stack = EmptyPolyStack();
+    Poly p = make_poly_plus_two(2);
+    Poly c = PolyFromCoeff(5);
+    PolyStackPush(&stack, &p);
+    PolyStackPush(&stack, &c);
+
+    MemStats during = MemStatGet();
+    assert_int_equal(during.live[MEM_MONO] - before.live[MEM_MONO], 2);
+    assert_true(during.live[MEM_STACK_ELEM] > before.live[MEM_STACK_ELEM]);
+    assert_true(during.peakBytes >= during.bytes);
+
+    size_t histogram[MEMSTAT_HISTOGRAM_SIZE];
+    assert_int_equal(MemStatHistogram(&stack, histogram), 0);
+    /* stała nie ma jednomianów, a wielomian ma ich 2 (przedział 2-3) */
+    assert_int_equal(histogram[0], 1);
+    assert_int_equal(histogram[2], 1);
+
+    DestroyStack(&stack);
+    MemStats after = MemStatGet();
+    assert_int_equal(after.live[MEM_MONO], before.live[MEM_MONO]);
+    assert_int_equal(after.live[MEM_STACK_ELEM], before.live[MEM_STACK_ELEM]);
+    assert_int_equal(after.bytes, before.bytes);
+}
+
+static void test_trace_chrome_events(void **state) {
+    (void)state;
+
+    const char *path = "unit_tests_poly_trace.tmp";
+
+    Poly p = make_poly_plus_two(1);
+    assert_true(TraceOpenChrome(path));
+    Poly mul = PolyMul(&p, &p);
+    TraceClose();
+    assert_false(TraceActive());
+
+    FILE *file = fopen(path, "r");
+    assert_true(file != NULL);
+    char content[4096];
+    size_t size = fread(content, 1, sizeof(content) - 1, file);
+    content[size] = '\0';
+    fclose(file);
+    remove(path);
+
+    assert_true(strncmp(content, "{\"traceEvents\":[", 16) == 0);
+    assert_true(strstr(content, "{\"name\":\"PolyMul\",\"ph\":\"B\"") != NULL);
+    assert_true(strstr(content, "\"args\":{\"terms_out\":3}") != NULL);
+    assert_true(strstr(content, "{\"name\":\"sort\",\"ph\":\"B\"") != NULL);
+    assert_true(strstr(content, "]}\n") != NULL);
+
+    PolyDestroy(&mul);
+    PolyDestroy(&p);
+}
+
+static void test_stats_perf_counter_columns(void **state) {
+    (void)state;
+
+    /* bez dostępu do liczników sprzętowych wszystkie przyrosty są zerowe */
+    bool opened = PerfCountersOpen();
+    StatsEnable(STATS_JSON);
+    StatsEnablePerfCounters(true);
+    PolyStack stack = EmptyPolyStack();
+    Poly c = PolyFromCoeff(3);
+    PolyStackPush(&stack, &c);
+
+    StatsSample sample;
+    StatsBegin(&sample, &stack, 1);
+    Poly top = PolyStackTake(&stack);
+    PolyDestroy(&top);
+    StatsEnd(&sample, POP, &stack);
+
+    ByteBuffer report = EmptyByteBuffer();
+    StatsReport(&report);
+    ByteBufferAppend(&report, "", 1);
+    const char *text = (const char*)report.data;
+    assert_true(strstr(text, "\"command\":\"POP\",\"calls\":1,") != NULL);
+    assert_true(strstr(text, "\"cycles\":") != NULL);
+    assert_true(strstr(text, "\"ipc\":") != NULL);
+    /* polecenie nie zostawiło jednomianów, więc chybień na jednomian nie ma */
+    assert_true(strstr(text, "\"cache_misses_per_term\":null,\"branch_misses_per_term\":null}") != NULL);
+    if(!opened)
+    {
+        assert_true(strstr(text, "\"cycles\":0,\"instructions\":0,") != NULL);
+    }
+
+    ByteBufferDestroy(&report);
+    StatsEnablePerfCounters(false);
+    StatsEnable(STATS_DISABLED);
+    StatsFinish();
+    PerfCountersClose();
+    DestroyStack(&stack);
+}
+
+static void test_oracle_matches_reference(void **state) {
+    (void)state;
+
+    /* zgodne wyniki: funkcje wyroczni zwracają wynik szybkiej wersji */
+    Poly p = make_poly_plus_two(1);
+    Poly q = PolyClone(&p);
+    Poly three = PolyFromCoeff(3);
+
+    Poly fused = OracleMulAdd(&p, &q, &three);
+    Poly product = PolyMul(&p, &q);
+    Poly expected = PolyAdd(&product, &three);
+    assert_true(PolyIsEq(&fused, &expected));
+
+    Poly memo = OracleMemoMul(&p, &q);
+    assert_true(PolyIsEq(&memo, &product));
+
+    OracleScaleInPlace(&q, -1);
+    OracleAddInPlace(&q, &p);
+    assert_true(PolyIsZero(&q));
+
+    PolyDestroy(&fused);
+    PolyDestroy(&product);
+    PolyDestroy(&expected);
+    PolyDestroy(&memo);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+}
+
+static void test_output_and_error_sinks(void **state) {
+    (void)state;
+
+    /* wyjście i komunikaty o błędach trafiają do buforów zamiast na stdout i stderr */
+    ByteBuffer output = EmptyByteBuffer();
+    ByteBuffer errors = EmptyByteBuffer();
+    assert_true(OutputSetSink(&output) == NULL);
+    assert_true(ErrorSetSink(&errors) == NULL);
+    unsigned long errorsBefore = ErrorCount();
+
+    OutputString("x_0");
+    OutputLong(-42);
+    OutputChar('\n');
+    ErrorCommand(7, STACK_UNDERFLOW);
+    ParseError error = NoParseError();
+    ErrorParse(8, 3, &error);
+    ErrorParseReport(&error);
+
+    assert_true(OutputSetSink(NULL) == &output);
+    assert_true(ErrorSetSink(NULL) == &errors);
+    assert_int_equal(ErrorCount() - errorsBefore, 2);
+    assert_int_equal(output.size, 7);
+    assert_true(memcmp(output.data, "x_0-42\n", 7) == 0);
+    const char expectedErrors[] = "ERROR 7 STACK UNDERFLOW\nERROR 8 3\n";
+    assert_int_equal(errors.size, sizeof(expectedErrors) - 1);
+    assert_true(memcmp(errors.data, expectedErrors, sizeof(expectedErrors) - 1) == 0);
+
+    ByteBufferDestroy(&output);
+    ByteBufferDestroy(&errors);
+}
+
 static void run_poly_compose_and_compare_results(Poly *p, unsigned count, Poly x[], Poly *expectedRes) {
 	Poly composeRes = PolyCompose(p, count, x);
 	assert_true(PolyIsEq(expectedRes, &composeRes));
@@ -369,6 +840,252 @@ static void test_poly_x0_count_one_x0(void **state) {
     PolyDestroy(&p);
 }
 
+static void test_serialize_round_trip(void **state) {
+    (void)state;
+
+    Poly p = make_nested_poly(LONG_MIN, 7, 3, LONG_MAX, INT_MAX);
+    ByteBuffer buf = EmptyByteBuffer();
+    PolySerialize(&p, &buf);
+
+    Poly q;
+    size_t consumed;
+    assert_true(PolyDeserialize(buf.data, buf.size, &q, &consumed));
+    assert_true(consumed == buf.size);
+    assert_true(PolyIsEq(&p, &q));
+
+    PolyDestroy(&q);
+    PolyDestroy(&p);
+    ByteBufferDestroy(&buf);
+}
+
+static void test_serialize_rejects_corrupted(void **state) {
+    (void)state;
+
+    Poly p = make_nested_poly(-3, 1, 2, 5, 4);
+    ByteBuffer buf = EmptyByteBuffer();
+    PolySerialize(&p, &buf);
+
+    Poly q;
+    buf.data[buf.size / 2] ^= 0x40;
+    assert_true(!PolyDeserialize(buf.data, buf.size, &q, NULL));
+    buf.data[buf.size / 2] ^= 0x40;
+    assert_true(!PolyDeserialize(buf.data, buf.size - 1, &q, NULL));
+
+    PolyDestroy(&p);
+    ByteBufferDestroy(&buf);
+}
+
+static void test_mapped_matches_poly(void **state) {
+    (void)state;
+
+    const char *path = "unit_tests_poly_mapped.tmp";
+    Poly p = make_nested_poly(-3, 1, 2, 5, 4);
+    Poly q = make_nested_poly(7, 2, 2, -5, 4);
+    assert_true(MappedPolySaveToFile(&p, path));
+    MappedStore *store = MappedStoreOpen(path);
+    remove(path);
+    assert_true(store != NULL);
+
+    assert_true(MappedPolyIsEq(&(store->root), &p));
+    assert_true(!MappedPolyIsEq(&(store->root), &q));
+    assert_true(MappedPolyDeg(&(store->root)) == PolyDeg(&p));
+    assert_true(MappedPolyDegBy(&(store->root), 1) == PolyDegBy(&p, 1));
+
+    Poly expected = PolyAt(&p, 3);
+    Poly res = MappedPolyAt(&(store->root), 3);
+    assert_true(PolyIsEq(&expected, &res));
+    PolyDestroy(&expected);
+    PolyDestroy(&res);
+
+    expected = PolyAdd(&q, &p);
+    res = PolyAddMapped(&q, &(store->root));
+    assert_true(PolyIsEq(&expected, &res));
+    PolyDestroy(&expected);
+    PolyDestroy(&res);
+
+    expected = PolyMul(&q, &p);
+    res = PolyMulMapped(&q, &(store->root));
+    assert_true(PolyIsEq(&expected, &res));
+    PolyDestroy(&expected);
+    PolyDestroy(&res);
+
+    MappedStoreRelease(store);
+    PolyDestroy(&q);
+    PolyDestroy(&p);
+}
+
+static void test_mapped_print_and_save_stay_mapped(void **state) {
+    (void)state;
+
+    Poly p = make_nested_poly(-3, 1, 2, 5, 4);
+    assert_true(MappedPolySaveToFile(&p, "unit_tests_poly_mapped.tmp"));
+    Operation operation[OPER_WITHOUT_ARG_AMOUNT];
+    OperationWithArg opWithArg[OPER_WITH_ARG_AMOUNT];
+    OperationWithStringArg opWithStrArg[OPER_WITH_STRING_ARG_AMOUNT];
+    InitStandardOperations(operation, opWithArg, opWithStrArg);
+    PolyStack stack = EmptyPolyStack();
+    ByteBuffer output = EmptyByteBuffer();
+    OutputSetSink(&output);
+
+    /* polecenia tylko czytające wielomian nie zamieniają go na zwykły wielomian */
+    init_input_stream("LOAD_MAPPED unit_tests_poly_mapped.tmp\nPRINT\n"
+        "SAVE unit_tests_poly_saved.tmp\nSAVE_MAPPED unit_tests_poly_saved_mapped.tmp\n");
+    for (int line = 1; ReadLine(&stack, line, operation, opWithArg, opWithStrArg); line++) {
+        assert_true(PolyStackTopMapped(&stack) != NULL);
+    }
+    OutputFlush();
+    OutputSetSink(NULL);
+    ByteBuffer expected = EmptyByteBuffer();
+    PolyToText(&p, &expected);
+    ByteBufferAppend(&expected, "\n", 1);
+    assert_int_equal(output.size, expected.size);
+    assert_true(memcmp(output.data, expected.data, expected.size) == 0);
+
+    Poly saved;
+    assert_true(PolyLoadFromFile("unit_tests_poly_saved.tmp", &saved));
+    assert_true(PolyIsEq(&saved, &p));
+    MappedStore *store = MappedStoreOpen("unit_tests_poly_saved_mapped.tmp");
+    assert_true(store != NULL && MappedPolyIsEq(&(store->root), &p));
+
+    MappedStoreRelease(store);
+    PolyDestroy(&saved);
+    ByteBufferDestroy(&expected);
+    ByteBufferDestroy(&output);
+    DestroyStack(&stack);
+    PolyDestroy(&p);
+    remove("unit_tests_poly_mapped.tmp");
+    remove("unit_tests_poly_saved.tmp");
+    remove("unit_tests_poly_saved_mapped.tmp");
+}
+
+static void test_poly_in_place_arithmetic(void **state) {
+    (void)state;
+
+    Poly p = make_nested_poly(-3, 1, 2, 5, 0);
+    Poly q = make_nested_poly(3, 1, 2, LONG_MAX, 4);
+    Poly expected = PolyAdd(&p, &q);
+    Poly qCopy = PolyClone(&q);
+    PolyAddInPlace(&p, &qCopy);
+    assert_true(PolyIsZero(&qCopy));
+    assert_true(PolyIsEq(&expected, &p));
+    PolyDestroy(&expected);
+
+    Poly c = PolyFromCoeff(LONG_MIN);
+    expected = PolyMul(&q, &c);
+    PolyScaleInPlace(&q, LONG_MIN);
+    assert_true(PolyIsEq(&expected, &q));
+    PolyDestroy(&expected);
+
+    expected = PolyNeg(&p);
+    PolySetInverseCoeffs(&p);
+    assert_true(PolyIsEq(&expected, &p));
+
+    PolyDestroy(&expected);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+}
+
+static void test_poly_stack_bulk_push_pop(void **state) {
+    (void)state;
+
+    PolyStack stack = EmptyPolyStack();
+    Poly p[100];
+    for (int i = 0; i < 100; i++) {
+        p[i] = PolyFromCoeff(i);
+    }
+    PolyStackPushMany(&stack, 100, p);
+    assert_true(PolyStackSize(&stack) == 100);
+    assert_true(PolyStackHasEnoughElements(&stack, 100));
+    assert_true(!PolyStackHasEnoughElements(&stack, 101));
+    assert_true(PolyStackTop(&stack).c == 99);
+    assert_true(PolyStackPeek(&stack, 10)->p.c == 89);
+
+    PolyStackPopMany(&stack, 60);
+    assert_true(PolyStackSize(&stack) == 40);
+    assert_true(PolyStackTop(&stack).c == 39);
+
+    Poly taken[2];
+    PolyStackTakeMany(&stack, 2, taken);
+    assert_true(taken[0].c == 39 && taken[1].c == 38);
+    PolyStackReplaceTop(&stack, &(taken[0]));
+    assert_true(PolyStackSize(&stack) == 38);
+    assert_true(PolyStackTop(&stack).c == 39);
+    DestroyStack(&stack);
+    assert_true(PolyStackIsEmpty(&stack));
+}
+
+/**
+ * Tworzy napis z sumą @p count jednomianów (z powtarzającymi się wykładnikami)
+ */
+static char *make_long_poly_text(unsigned count, size_t *size) {
+    char *text = malloc(32 * (size_t)count);
+    size_t pos = 0;
+    for (unsigned i = 0; i < count; i++) {
+        pos += sprintf(text + pos, "%s((%d,1),%u)", (i > 0) ? "+" : "", (int)(i % 7) - 3, (i * 7919) % 1000);
+    }
+    *size = pos;
+    return text;
+}
+
+static void test_parse_parallel_matches_serial(void **state) {
+    (void)state;
+
+    size_t size;
+    char *text = make_long_poly_text(PARALLEL_PARSE_MIN_LENGTH / 8, &size);
+
+    ParseError error = NoParseError();
+    int columnNumber = 1;
+    ReadSetSource(text, size);
+    Poly expected = ReadPoly(1, &columnNumber, &error);
+    assert_true(!error.hasError && ReadSourceAtEnd());
+    ReadSetSource(NULL, 0);
+
+    Poly res;
+    assert_true(ParsePolyParallel(text, size, &res));
+    assert_true(PolyIsEq(&expected, &res));
+    PolyDestroy(&res);
+
+    text[size - 2] = 'x';
+    assert_true(!ParsePolyParallel(text, size, &res));
+
+    PolyDestroy(&expected);
+    free(text);
+}
+
+/**
+ * Wykonuje skrypt w kontekście kalkulatora i sprawdza jego wyjście
+ * (kontekst musi mieć flagę POLY_CALC_MERGE_ERRORS)
+ */
+static void execute_and_check_output(PolyCalc *calc, const char *script, const char *expected) {
+    size_t size;
+    PolyCalcClearOutput(calc);
+    PolyCalcExecute(calc, script, strlen(script));
+    const char *output = PolyCalcOutput(calc, &size);
+    assert_int_equal(size, strlen(expected));
+    assert_true(memcmp(output, expected, size) == 0);
+}
+
+static void test_libpoly_contexts_separate_checkpoints(void **state) {
+    (void)state;
+
+    PolyCalc *first = PolyCalcCreate(POLY_CALC_MERGE_ERRORS);
+    PolyCalc *second = PolyCalcCreate(POLY_CALC_MERGE_ERRORS);
+    execute_and_check_output(first, "1\nCHECKPOINT unit_tests_poly_context.tmp\n", "");
+    execute_and_check_output(second, "77\n88\nCLONE\n", "");
+    execute_and_check_output(first, "CLONE\nADD\n", "");
+    assert_int_equal(PolyCalcStackSize(first), 1);
+    assert_int_equal(PolyCalcStackSize(second), 3);
+    PolyCalcDestroy(second);
+    PolyCalcDestroy(first);
+
+    PolyCalc *restored = PolyCalcCreate(POLY_CALC_MERGE_ERRORS);
+    execute_and_check_output(restored, "RESTORE unit_tests_poly_context.tmp\nPRINT\nPOP\nPRINT\n",
+        "2\nERROR 4 STACK UNDERFLOW\n");
+    PolyCalcDestroy(restored);
+    remove("unit_tests_poly_context.tmp");
+    remove("unit_tests_poly_context.tmp.wal");
+}
+
 int main() {
     const struct CMUnitTest tests_group_1[] = {
         cmocka_unit_test(test_poly_zero_count_zero),
@@ -377,7 +1094,14 @@ int main() {
         cmocka_unit_test(test_poly_coeff_count_one_coeff),
         cmocka_unit_test(test_poly_x0_count_zero),
         cmocka_unit_test(test_poly_x0_count_one_coeff),
-        cmocka_unit_test(test_poly_x0_count_one_x0)
+        cmocka_unit_test(test_poly_x0_count_one_x0),
+        cmocka_unit_test(test_serialize_round_trip),
+        cmocka_unit_test(test_serialize_rejects_corrupted),
+        cmocka_unit_test(test_mapped_matches_poly),
+        cmocka_unit_test(test_mapped_print_and_save_stay_mapped),
+        cmocka_unit_test(test_parse_parallel_matches_serial),
+        cmocka_unit_test(test_poly_stack_bulk_push_pop),
+        cmocka_unit_test(test_poly_in_place_arithmetic)
     };
     const struct CMUnitTest tests_group_2[] = {
         cmocka_unit_test_setup(test_calc_poly_no_parameter, test_setup),
@@ -387,7 +1111,22 @@ int main() {
         cmocka_unit_test_setup(test_calc_poly_max_arg_plus_one, test_setup),
         cmocka_unit_test_setup(test_calc_poly_above_max_arg, test_setup),
         cmocka_unit_test_setup(test_calc_poly_arg_word, test_setup),
-        cmocka_unit_test_setup(test_calc_poly_arg_letters_digits_combination, test_setup)
+        cmocka_unit_test_setup(test_calc_poly_arg_letters_digits_combination, test_setup),
+        cmocka_unit_test_setup(test_calc_poly_print_coeff_limits, test_setup),
+        cmocka_unit_test_setup(test_calc_poly_checkpoint_restore, test_setup),
+        cmocka_unit_test_setup(test_calc_poly_checkpoint_file_commands, test_setup),
+        cmocka_unit_test_setup(test_calc_poly_chain_matches_script, test_setup),
+        cmocka_unit_test_setup(test_calc_poly_store_recall, test_setup),
+        cmocka_unit_test_setup(test_bytecode_serialize_round_trip, test_setup),
+        cmocka_unit_test(test_lazy_mul_add_matches_eager),
+        cmocka_unit_test_setup(test_memo_mul_compose_hits, reset_counters_setup),
+        cmocka_unit_test_setup(test_stats_report_counts_terms, reset_counters_setup),
+        cmocka_unit_test_setup(test_memstat_live_monos_and_histogram, reset_counters_setup),
+        cmocka_unit_test(test_trace_chrome_events),
+        cmocka_unit_test_setup(test_stats_perf_counter_columns, reset_counters_setup),
+        cmocka_unit_test(test_oracle_matches_reference),
+        cmocka_unit_test(test_output_and_error_sinks),
+        cmocka_unit_test(test_libpoly_contexts_separate_checkpoints)
     };
     return cmocka_run_group_tests(tests_group_1, NULL, NULL) + 
     	cmocka_run_group_tests(tests_group_2, NULL, NULL);
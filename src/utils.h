@@ -118,8 +118,8 @@ void _test_free(void* const ptr, char* const file, const int line);
 
 /* Function main is defined in the unit test so redefine name of the main
  * function here. */
-#define main() calc_poly_main()
-int calc_poly_main();
+#define main calc_poly_main
+int calc_poly_main(int argc, char *argv[]);
 
 /* All functions in this object need to be exposed to the test application,
  * so redefine static to nothing. Do not do it - it dangerous! */
@@ -1,4 +1,5 @@
 #include "word.h"
+#include "memstat.h"
 #include "utils.h"
 
 bool WordIsEmpty(const Word *w)
@@ -10,6 +11,7 @@ void WordAppend(Word *w, const char c)
 {
 	WordElem *l = (WordElem*)malloc(sizeof(WordElem));
 	assert(l != NULL);
+	MemStatAlloc(MEM_WORD_ELEM, 1);
 	l->value = c;
 	l->next = NULL;
 	if(WordIsEmpty(w))
@@ -64,6 +66,24 @@ bool WordEquals(const Word *w, const char *text)
 	return true;
 }
 
+char *WordToString(const Word *w)
+{
+	char *text = (char*)malloc(WordSize(w) + 1);
+	assert(text != NULL);
+	
+	int currIndex = 0;
+	WordElem *iter = w->firstWordElem;
+	
+	while(iter != NULL)
+	{
+		text[currIndex] = iter->value;
+		iter = iter->next;
+		currIndex++;
+	}
+	text[currIndex] = '\0';
+	return text;
+}
+
 void WordDestroy(Word *w)
 {
 	WordElem *iter = w->firstWordElem;
@@ -73,6 +93,7 @@ void WordDestroy(Word *w)
 	{
 		nextIter = iter->next;
 		free(iter);
+		MemStatFree(MEM_WORD_ELEM, 1);
 		iter = nextIter;
 	}
 }
@@ -69,6 +69,12 @@ Word EmptyWord();
  * @return Czy są równe
  */
 bool WordEquals(const Word *w, const char *text);
+/**
+ * Tworzy dynamicznie zaalokowany ciąg znaków (zakończony zerem) o treści słowa @p w
+ * @param[in] w : słowo
+ * @return ciąg znaków, który należy zwolnić funkcją free
+ */
+char *WordToString(const Word *w);
 /**
  * Usuwa słowo z pamięci
  * @param[in] w : słowo